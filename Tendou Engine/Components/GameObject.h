@@ -16,6 +16,15 @@ namespace Tendou
 		using id_t = unsigned int;
 		using Map = std::unordered_map<id_t, GameObject>;
 
+		// What render systems draw with. The update stage's Transform reaches it
+		// through a FramePacket, so recording never reads state being simulated.
+		struct RenderState
+		{
+			glm::mat4 modelMatrix{ 1.0f };
+			glm::mat3 normalMatrix{ 1.0f };
+			bool render = true;
+		};
+
 		static GameObject CreateGameObject(std::string tag = std::string(), std::string name = std::string())
 		{
 			static id_t currId = 0;
@@ -34,15 +43,21 @@ namespace Tendou
 
 		bool GetRender() { return render; }
 
+		// Never moves after load, so StaticBatcher may bake it into a combined mesh
+		bool GetStatic() { return isStatic; }
+
 		std::shared_ptr<Model> GetModel() { return model; }
 		Transform& GetTransform() { return m_Transform; }
+		const RenderState& GetRenderState() const { return renderState; }
 
 
 		void SetName(std::string t) { m_Name = t; }
 		void SetTag(std::string t) { m_Tag = t; }
 		void SetRender(bool b) { render = b; }
+		void SetStatic(bool b) { isStatic = b; }
 
 		void SetModel(std::shared_ptr<Model> m) { model = m; }
+		void SetRenderState(const RenderState& s) { renderState = s; }
 
 		glm::vec3 color{};
 		
@@ -61,11 +76,14 @@ namespace Tendou
 		std::string m_Tag;
 
 		bool render = true;
+		bool isStatic = false;
 
 		std::shared_ptr<Model> model{};
 		
 		// Components
 		Transform m_Transform;
+
+		RenderState renderState;
 		
 	};
 }
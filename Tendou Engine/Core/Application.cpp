@@ -1,9 +1,11 @@
 #include "Application.h"
+#include "FramePipeline.h"
 #include "../Editor/Editor.h"
 
 #include "../Vulkan/Systems/Default.h"
 #include "../Vulkan/Systems/Offscreen.h"
 
+#include "../Rendering/RenderStats.h"
 #include "../Rendering/Texture.h"
 
 #include "../Rendering/Scenes/SimpleScene.h"
@@ -20,65 +22,358 @@
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <fstream>
+#include <iostream>
 #include <time.h>
+#include <utility>
 
 namespace Tendou
 {
-	Application::Application()
+	Application::Application(const ApplicationConfig& config_)
+		: config(config_)
 	{
-		//scene = std::make_unique<LightingScene>(appWindow, device);
-		//scene = std::make_unique<GLTFScene>(appWindow, device);
-		scene = std::make_unique<DeferredScene>(appWindow, device);
-		editor = std::make_unique<Editor>(appWindow, scene.get(), device);
+		JobSystemConfig jobConfig{};
+		jobConfig.threadCount = JOB_THREADS;
+		JobSystem::Init(jobConfig);
+
+		Profiler::SetThreadName("Main");
+		JobSystem::SetProfileHooks(&Profiler::BeginJob, &Profiler::EndJob);
+
+		// Scenes pick random light colors etc. during setup
+		srand(config.benchmarkPath.empty() ? static_cast<unsigned>(time(NULL)) : Benchmark::SEED);
+
+		CreateScene(config.sceneName);
+		scene->SetFramePacing(config.pacing);
+
+		DynamicResolutionConfig dynRes = config.dynamicResolution;
+		dynRes.enabled = dynRes.enabled && config.benchmarkPath.empty();
+		scene->GetDynamicResolution()->SetConfig(dynRes);
+
+		if (!config.headless)
+		{
+			editor = std::make_unique<Editor>(appWindow, scene.get(), device);
+		}
 	}
 
 	Application::~Application()
 	{
+		JobSystem::Shutdown();
+	}
+
+	void Application::CreateScene(const std::string& name)
+	{
+		if (name == "Simple")
+		{
+			scene = std::make_unique<SimpleScene>(appWindow, device);
+		}
+		else if (name == "Lighting")
+		{
+			scene = std::make_unique<LightingScene>(appWindow, device);
+		}
+		else if (name == "GLTF")
+		{
+			scene = std::make_unique<GLTFScene>(appWindow, device);
+		}
+		else if (name == "Deferred")
+		{
+			scene = std::make_unique<DeferredScene>(appWindow, device);
+		}
+		else
+		{
+			throw std::runtime_error("Unknown scene: " + name + "!");
+		}
 	}
 
 	void Application::Run()
 	{
-		srand(time(NULL));
-		scene->Init();
+		{
+			TENDOU_PROFILE_SCOPE("Scene::Init");
+			scene->Init();
+		}
+
+		uint32_t frameLimit = config.frameCount;
+
+		if (!config.benchmarkPath.empty())
+		{
+			uint32_t measured = config.frameCount > 0 ? config.frameCount : BENCHMARK_FRAMES;
+			float duration = static_cast<float>(Benchmark::WARMUP_FRAMES + measured) * Benchmark::TIMESTEP;
+
+			CameraPath path;
+			if (config.cameraPath.empty() || !path.LoadFromFile(config.cameraPath))
+			{
+				if (!config.cameraPath.empty())
+				{
+					std::cerr << "Failed to load camera path " << config.cameraPath << ", using an orbit" << std::endl;
+				}
+				path = CameraPath::Orbit(scene->GetCamera().cameraPos, glm::vec3(0.0f), duration);
+			}
+
+			benchmark = std::make_unique<Benchmark>(config.sceneName, measured, std::move(path));
+			frameLimit = benchmark->TotalFrames();
+
+			scene->GetGPUProfiler()->RecordFrameTimes(Benchmark::WARMUP_FRAMES);
+		}
 
 		auto currTime = std::chrono::high_resolution_clock::now();
+		uint32_t framesRendered = 0;
+
+		FramePacer* pacer = scene->GetFramePacer();
+
+		bool pipelined = config.pipelineUpdate && scene->CanPipelineUpdate();
+
+		// Benchmarks step exactly once per frame and render that step, so step n
+		// always sees the same camera whatever the machine
+		if (benchmark)
+		{
+			config.simulation.interpolate = false;
+			timestep = std::make_unique<FixedTimestep>(Benchmark::TIMESTEP, config.simulation.maxStepsPerFrame);
+		}
+		else
+		{
+			float step = config.simulation.rate > 0.0f ? 1.0f / config.simulation.rate : 0.0f;
+			timestep = std::make_unique<FixedTimestep>(step, config.simulation.maxStepsPerFrame);
+		}
+
+		// Late latching needs real input, benchmarks drive the camera themselves.
+		// A pipelined update is still reading input while the frame is submitted.
+		const char* latchBlocker = nullptr;
+		if (benchmark)
+		{
+			latchBlocker = "the benchmark drives the camera";
+		}
+		else if (pipelined)
+		{
+			latchBlocker = "the update is pipelined";
+		}
+		pacer->SetLateLatchBlocker(latchBlocker);
+
+		// update
+		// -----
+		// Runs on the update thread when pipelined, inline otherwise
+		FramePipeline frames([this](FramePacket& packet) { Simulate(packet); }, pipelined);
+
+		// The first frame has no earlier one to overlap with
+		if (pipelined)
+		{
+			frames.Kick(benchmark ? Benchmark::TIMESTEP : 0.0f);
+		}
 
 		do
 		{
-			glfwPollEvents();
+			pacer->WaitForFrameSlot();
+
+			// Waiting on the update counts towards the frame, pacing doesn't
+			auto frameStart = std::chrono::high_resolution_clock::now();
+
+			// From here until the next Kick the update thread is idle, so polling
+			// (input callbacks), the editor UI and ReadFramePacket own the scene
+			frames.Wait();
+
+			if (!config.headless)
+			{
+				TENDOU_PROFILE_SCOPE("PollEvents");
+				glfwPollEvents();
+			}
+			pacer->MarkInputSampled();
 
 			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currTime).count();
 			currTime = newTime;
+
+			// Benchmarks simulate a fixed step no matter how long the frame took
+			if (benchmark)
+			{
+				frameTime = Benchmark::TIMESTEP;
+			}
 			
+			RenderStats::Reset();
+
 			if (auto cmdBuf = scene->BeginFrame())
 			{
 				int frameIdx = scene->GetFrameIndex();
 
-				// update
-				// -----
-				scene->ProcessInput(frameTime, scene->GetCamera());
-				scene->Update();
+				// ImGui widgets write straight into scene and editor state
+				if (editor)
+				{
+					TENDOU_PROFILE_SCOPE("Editor::Setup");
+					editor.get()->Setup();
+				}
+
+				const FramePacket* packet = nullptr;
+				if (pipelined)
+				{
+					// Render what the last update wrote while the next one simulates
+					packet = &frames.Wait();
+					scene->ReadFramePacket(*packet);
+					frames.Kick(frameTime);
+				}
+				else
+				{
+					frames.Kick(frameTime);
+					packet = &frames.Wait();
+					scene->ReadFramePacket(*packet);
+				}
 
-				FrameInfo f(frameIdx, frameTime, cmdBuf);
+				FrameInfo f(frameIdx, packet->frameTime, cmdBuf);
+				f.profiler = scene->GetGPUProfiler();
 
 				//render
 				// -----
-				editor.get()->Setup();
-
-				scene->Render(cmdBuf, f);
+				{
+					TENDOU_PROFILE_SCOPE("Scene::Render");
+					scene->Render(cmdBuf, f);
+				}
 				
 				// NOTE: Render the editor AFTER all render passes;
 				// rendering the editor first draws it behind objects
-				editor.get()->Draw(cmdBuf);
+				if (editor)
+				{
+					TENDOU_PROFILE_SCOPE("Editor::Draw");
+					editor.get()->Draw(scene->GetOverlayCommandBuffer(cmdBuf));
+				}
 
 				scene->EndSwapChainRenderPass(cmdBuf);
+
+				// Sample input once more and move the camera right before submit,
+				// so recording time no longer counts towards input latency
+				if (!config.headless && !latchBlocker && pacer->GetConfig().lateLatch)
+				{
+					TENDOU_PROFILE_SCOPE("LateLatch");
+					glfwPollEvents();
+
+					float latchDt = std::chrono::duration<float, std::chrono::seconds::period>(
+						std::chrono::high_resolution_clock::now() - currTime).count();
+
+					// Predicted on top of the interpolated camera. The simulated one is left
+					// alone, its next steps still get this input and the time it covers.
+					Camera latched = scene->GetRenderCamera();
+					scene->LatchInput(latchDt, latched);
+					scene->LateLatch(latched);
+					pacer->MarkInputSampled();
+				}
 				
 				scene->EndFrame();
+
+				if (benchmark)
+				{
+					float cpuMs = std::chrono::duration<float, std::chrono::milliseconds::period>(
+						std::chrono::high_resolution_clock::now() - frameStart).count();
+					benchmark->RecordFrame(framesRendered, cpuMs,
+						RenderStats::drawCalls.load(std::memory_order_relaxed),
+						RenderStats::triangles.load(std::memory_order_relaxed),
+						RenderStats::bindsRequested.load(std::memory_order_relaxed),
+						RenderStats::bindsIssued.load(std::memory_order_relaxed));
+				}
+
+				if (frameLimit > 0 && ++framesRendered >= frameLimit)
+				{
+					appWindow.RequestClose();
+				}
 			}
 		} 
 		while (appWindow.ShouldClose());
+
+		// An update may still be running for a frame that won't be rendered
+		frames.Wait();
 		
 		vkDeviceWaitIdle(device.Device());
+
+		if (benchmark)
+		{
+			WriteBenchmarkReport();
+		}
+
+		if (config.headless && !config.capturePath.empty())
+		{
+			if (!SaveCapture(config.capturePath))
+			{
+				std::cerr << "Failed to write capture to " << config.capturePath << std::endl;
+			}
+		}
+	}
+
+	void Application::Simulate(FramePacket& packet)
+	{
+		// What the first frames show, before a step has run
+		if (!stepsCaptured)
+		{
+			scene->WriteFramePacket(stepAfter);
+			stepsCaptured = true;
+		}
+
+		uint32_t steps = timestep->Advance(packet.frameTime);
+		uint64_t firstStep = timestep->StepCount() - steps;
+
+		for (uint32_t i = 0; i < steps; ++i)
+		{
+			// Frames blend towards the last step from the state right before it
+			if (i + 1 == steps)
+			{
+				if (i == 0)
+				{
+					std::swap(stepBefore, stepAfter);
+				}
+				else
+				{
+					stepBefore.Clear();
+					scene->WriteFramePacket(stepBefore);
+				}
+			}
+
+			if (benchmark)
+			{
+				benchmark->ApplyCamera(static_cast<uint32_t>(firstStep + i), scene->GetCamera());
+			}
+			else
+			{
+				scene->ProcessInput(timestep->StepTime(), scene->GetCamera());
+			}
+			scene->Update();
+		}
+
+		if (steps > 0)
+		{
+			stepAfter.Clear();
+			scene->WriteFramePacket(stepAfter);
+		}
+
+		packet.Interpolate(stepBefore, stepAfter, config.simulation.interpolate ? timestep->Alpha() : 1.0f);
+	}
+
+	void Application::WriteBenchmarkReport()
+	{
+		GPUProfiler* profiler = scene->GetGPUProfiler();
+		profiler->Flush();
+
+		if (!benchmark->WriteReport(config.benchmarkPath, profiler->GetFrameTimes(),
+			device.AllocatedBytes(), scene->graph->TransientMemory(), device.properties.deviceName))
+		{
+			std::cerr << "Failed to write benchmark report to " << config.benchmarkPath << std::endl;
+		}
+	}
+
+	bool Application::SaveCapture(const std::string& path)
+	{
+		SwapChain* swapChain = scene->GetSwapChain();
+
+		std::vector<uint8_t> pixels;
+		if (!swapChain->ReadbackImage(swapChain->LastPresentedImage(), pixels))
+		{
+			return false;
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file << "P6\n" << swapChain->Width() << " " << swapChain->Height() << "\n255\n";
+		for (size_t i = 0; i < pixels.size(); i += 4)
+		{
+			file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+		}
+
+		return file.good();
 	}
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define APPLICATION_H
 
 #include "Window.h"
+#include "Benchmark.h"
+#include "FixedTimestep.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 #include "../Vulkan/Descriptor.h"
 #include "../Vulkan/TendouDevice.h"
@@ -11,9 +15,11 @@
 #include "../Components/GameObject.h"
 #include "../Rendering/Scenes/Scene.h"
 
+#include "../Rendering/FramePacket.h"
 #include "../Rendering/UniformBuffer.hpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace Tendou
@@ -21,10 +27,56 @@ namespace Tendou
 	static constexpr int WIDTH = 1280;
 	static constexpr int HEIGHT = 720;
 
+	// Worker threads for the job system, 0 = one per core (minus the main thread)
+	static constexpr uint32_t JOB_THREADS = 0;
+
+	// Frames rendered by a headless run when no count is given
+	static constexpr uint32_t HEADLESS_FRAMES = 60;
+
+	// Measured frames in a benchmark run when no count is given
+	static constexpr uint32_t BENCHMARK_FRAMES = 1000;
+
+	struct ApplicationConfig
+	{
+		// No GLFW, no surface and no editor - the scene renders into offscreen images
+		bool headless = false;
+
+		// Stop after this many frames, 0 = until the window is closed
+		uint32_t frameCount = 0;
+
+		// Headless only: the last frame is read back and written here as a binary PPM
+		std::string capturePath;
+
+		// Simple, Lighting, GLTF or Deferred
+		std::string sceneName = "Deferred";
+
+		// Non-empty runs a benchmark and writes its JSON report here.
+		// frameCount is then the number of measured frames.
+		std::string benchmarkPath;
+
+		// Benchmark camera keys (see CameraPath::LoadFromFile), empty = orbit
+		std::string cameraPath;
+
+		// Frames in flight, present mode, frame rate cap and late latching
+		FramePacingConfig pacing;
+
+		// Simulate frame N+1 on an update thread while frame N records, for scenes
+		// that support it (Scene::CanPipelineUpdate). Turns late latching off.
+		bool pipelineUpdate = true;
+
+		// Step rate, catch-up limit and interpolation. A fixed rate turns late latching off;
+		// benchmarks always step once per frame by Benchmark::TIMESTEP.
+		SimulationConfig simulation;
+
+		// GPU budget and scale range for scenes that render at a dynamic resolution.
+		// Benchmarks always run at full resolution so their timings stay comparable.
+		DynamicResolutionConfig dynamicResolution;
+	};
+
 	class Application
 	{
 	public:
-		Application();
+		Application(const ApplicationConfig& config = ApplicationConfig());
 		~Application();
 
 		Application(const Application&) = delete;
@@ -33,11 +85,28 @@ namespace Tendou
 		void Run();
 
 	private:
-		Window appWindow{ Tendou::WIDTH, Tendou::HEIGHT, "Tendou Engine" };
+		bool SaveCapture(const std::string& path);
+		void CreateScene(const std::string& name);
+		void WriteBenchmarkReport();
+
+		// Update stage of a frame: the simulation steps it's due, then the
+		// packet it renders, blended between the last two steps
+		void Simulate(FramePacket& packet);
+
+		ApplicationConfig config;
+
+		Window appWindow{ Tendou::WIDTH, Tendou::HEIGHT, "Tendou Engine", config.headless };
 		TendouDevice device{ appWindow };
 
 		std::unique_ptr<Editor> editor;
 		std::unique_ptr<Scene> scene;
+		std::unique_ptr<Benchmark> benchmark;
+
+		// Only touched by the update stage
+		std::unique_ptr<FixedTimestep> timestep;
+		FramePacket stepBefore;
+		FramePacket stepAfter;
+		bool stepsCaptured = false;
 	};
 }
 
@@ -0,0 +1,307 @@
+#include "Benchmark.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace Tendou
+{
+	namespace
+	{
+		struct Summary
+		{
+			double mean = 0.0;
+			double median = 0.0;
+			double p95 = 0.0;
+			double p99 = 0.0;
+			double min = 0.0;
+			double max = 0.0;
+			double stddev = 0.0;
+			size_t count = 0;
+		};
+
+		template <typename T>
+		Summary Summarize(const std::vector<T>& values)
+		{
+			Summary s{};
+			s.count = values.size();
+			if (values.empty())
+			{
+				return s;
+			}
+
+			std::vector<double> sorted(values.begin(), values.end());
+			std::sort(sorted.begin(), sorted.end());
+
+			double sum = 0.0;
+			for (double v : sorted)
+			{
+				sum += v;
+			}
+			s.mean = sum / static_cast<double>(sorted.size());
+
+			double var = 0.0;
+			for (double v : sorted)
+			{
+				var += (v - s.mean) * (v - s.mean);
+			}
+			s.stddev = std::sqrt(var / static_cast<double>(sorted.size()));
+
+			// Nearest-rank, so every reported value is an actual sample
+			auto percentile = [&sorted](double p)
+			{
+				size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+				return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+			};
+
+			s.median = percentile(0.50);
+			s.p95 = percentile(0.95);
+			s.p99 = percentile(0.99);
+			s.min = sorted.front();
+			s.max = sorted.back();
+
+			return s;
+		}
+
+		void WriteSummary(std::ofstream& file, const char* name, const Summary& s)
+		{
+			file << "    \"" << name << "\": { \"samples\": " << s.count
+				<< ", \"mean\": " << s.mean
+				<< ", \"median\": " << s.median
+				<< ", \"p95\": " << s.p95
+				<< ", \"p99\": " << s.p99
+				<< ", \"min\": " << s.min
+				<< ", \"max\": " << s.max
+				<< ", \"stddev\": " << s.stddev << " }";
+		}
+
+		uint64_t PeakProcessMemory()
+		{
+#ifdef _WIN32
+			PROCESS_MEMORY_COUNTERS counters{};
+			if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			{
+				return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+			}
+			return 0;
+#else
+			rusage usage{};
+			getrusage(RUSAGE_SELF, &usage);
+			return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+		}
+
+		void WriteEscaped(std::ofstream& file, const std::string& str)
+		{
+			for (char c : str)
+			{
+				if (c == '"' || c == '\\')
+				{
+					file << '\\';
+				}
+				file << c;
+			}
+		}
+	}
+
+	CameraPath CameraPath::Orbit(const glm::vec3& start, const glm::vec3& center,
+		float duration, uint32_t keyCount)
+	{
+		CameraPath p;
+
+		glm::vec3 offset = start - center;
+		float radius = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+		float startAngle = radius > 0.0f ? std::atan2(offset.z, offset.x) : 0.0f;
+		radius = radius > 0.0f ? radius : 6.0f;
+
+		keyCount = std::max(keyCount, 4u);
+		for (uint32_t i = 0; i <= keyCount; ++i)
+		{
+			float u = static_cast<float>(i) / static_cast<float>(keyCount);
+			float angle = startAngle + u * glm::two_pi<float>();
+
+			CameraKey k{};
+			k.time = u * duration;
+			k.position = center + glm::vec3(std::cos(angle) * radius, offset.y, std::sin(angle) * radius);
+			k.target = center;
+			p.AddKey(k);
+		}
+
+		return p;
+	}
+
+	bool CameraPath::LoadFromFile(const std::string& filePath)
+	{
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		keys.clear();
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			line = line.substr(0, line.find('#'));
+
+			std::istringstream in(line);
+			CameraKey k{};
+			if (in >> k.time
+				>> k.position.x >> k.position.y >> k.position.z
+				>> k.target.x >> k.target.y >> k.target.z)
+			{
+				AddKey(k);
+			}
+		}
+
+		return !keys.empty();
+	}
+
+	void CameraPath::AddKey(const CameraKey& key)
+	{
+		keys.push_back(key);
+	}
+
+	void CameraPath::Apply(float time, Camera& c) const
+	{
+		if (keys.empty())
+		{
+			return;
+		}
+
+		if (keys.size() == 1 || time <= keys.front().time)
+		{
+			c.cameraPos = keys.front().position;
+			c.LookAt(keys.front().target);
+			return;
+		}
+
+		if (time >= keys.back().time)
+		{
+			c.cameraPos = keys.back().position;
+			c.LookAt(keys.back().target);
+			return;
+		}
+
+		size_t i = 0;
+		while (i + 2 < keys.size() && keys[i + 1].time <= time)
+		{
+			++i;
+		}
+
+		const CameraKey& k0 = keys[i > 0 ? i - 1 : i];
+		const CameraKey& k1 = keys[i];
+		const CameraKey& k2 = keys[i + 1];
+		const CameraKey& k3 = keys[std::min(i + 2, keys.size() - 1)];
+
+		float span = k2.time - k1.time;
+		float u = span > 0.0f ? (time - k1.time) / span : 0.0f;
+		float u2 = u * u;
+		float u3 = u2 * u;
+
+		auto catmullRom = [u, u2, u3](const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3)
+		{
+			return 0.5f * ((2.0f * p1) + (-p0 + p2) * u
+				+ (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2
+				+ (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * u3);
+		};
+
+		c.cameraPos = catmullRom(k0.position, k1.position, k2.position, k3.position);
+		c.LookAt(catmullRom(k0.target, k1.target, k2.target, k3.target));
+	}
+
+	Benchmark::Benchmark(const std::string& sceneName_, uint32_t frameCount_, CameraPath path_)
+		: sceneName(sceneName_)
+		, frameCount(frameCount_)
+		, path(std::move(path_))
+	{
+		cpuMs.reserve(frameCount);
+		drawCalls.reserve(frameCount);
+		triangles.reserve(frameCount);
+		bindsRequested.reserve(frameCount);
+		bindsIssued.reserve(frameCount);
+	}
+
+	void Benchmark::ApplyCamera(uint32_t frame, Camera& c) const
+	{
+		path.Apply(TimeAt(frame), c);
+	}
+
+	void Benchmark::RecordFrame(uint32_t frame, float cpu, uint32_t draws, uint64_t tris,
+		uint32_t requested, uint32_t issued)
+	{
+		if (frame < WARMUP_FRAMES)
+		{
+			return;
+		}
+
+		cpuMs.push_back(cpu);
+		drawCalls.push_back(draws);
+		triangles.push_back(tris);
+		bindsRequested.push_back(requested);
+		bindsIssued.push_back(issued);
+	}
+
+	bool Benchmark::WriteReport(const std::string& reportPath, const std::vector<float>& gpuMs,
+		uint64_t deviceBytes, uint64_t transientBytes, const std::string& deviceName) const
+	{
+		std::ofstream file(reportPath);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file.setf(std::ios::fixed);
+		file.precision(4);
+
+		file << "{\n";
+		file << "  \"scene\": \"";
+		WriteEscaped(file, sceneName);
+		file << "\",\n";
+		file << "  \"device\": \"";
+		WriteEscaped(file, deviceName);
+		file << "\",\n";
+		file << "  \"frames\": " << frameCount << ",\n";
+		file << "  \"warmupFrames\": " << WARMUP_FRAMES << ",\n";
+		file << "  \"timestep\": " << TIMESTEP << ",\n";
+		file << "  \"seed\": " << SEED << ",\n";
+
+		file << "  \"timings\": {\n";
+		WriteSummary(file, "cpuFrameMs", Summarize(cpuMs));
+		file << ",\n";
+		WriteSummary(file, "gpuFrameMs", Summarize(gpuMs));
+		file << "\n  },\n";
+
+		file << "  \"draws\": {\n";
+		WriteSummary(file, "drawCalls", Summarize(drawCalls));
+		file << ",\n";
+		WriteSummary(file, "triangles", Summarize(triangles));
+		file << ",\n";
+		WriteSummary(file, "bindsRequested", Summarize(bindsRequested));
+		file << ",\n";
+		WriteSummary(file, "bindsIssued", Summarize(bindsIssued));
+		file << "\n  },\n";
+
+		file << "  \"memory\": {\n";
+		file << "    \"deviceAllocatedBytes\": " << deviceBytes << ",\n";
+		file << "    \"renderGraphTransientBytes\": " << transientBytes << ",\n";
+		file << "    \"peakProcessBytes\": " << PeakProcessMemory() << "\n";
+		file << "  }\n";
+		file << "}\n";
+
+		return file.good();
+	}
+}
\ No newline at end of file
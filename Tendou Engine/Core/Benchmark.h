@@ -0,0 +1,82 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "../Rendering/Camera.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tendou
+{
+	struct CameraKey
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+
+	// Catmull-Rom spline through camera keys, sampled by time in seconds
+	class CameraPath
+	{
+	public:
+		// One full turn around center's vertical axis, starting at start
+		static CameraPath Orbit(const glm::vec3& start, const glm::vec3& center,
+			float duration, uint32_t keyCount = 16);
+
+		// One key per line: "time px py pz tx ty tz", '#' starts a comment.
+		// Keys must be in increasing time order.
+		bool LoadFromFile(const std::string& path);
+
+		void AddKey(const CameraKey& key);
+		void Apply(float time, Camera& c) const;
+
+		__inline bool Empty() const { return keys.empty(); }
+		__inline float Duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+	private:
+		std::vector<CameraKey> keys;
+	};
+
+	// Fixed-timestep performance run. Frame n always simulates n * TIMESTEP
+	// seconds and sees the same camera, so two runs of the same build
+	// render the same frames and their timings can be compared.
+	class Benchmark
+	{
+	public:
+		static constexpr float TIMESTEP = 1.0f / 60.0f;
+
+		// Replaces srand(time(NULL)) so scene setup is reproducible
+		static constexpr unsigned SEED = 1337;
+
+		// Run before measuring so pipelines, caches and the GPU clock settle
+		static constexpr uint32_t WARMUP_FRAMES = 60;
+
+		Benchmark(const std::string& sceneName, uint32_t frameCount, CameraPath path);
+
+		__inline uint32_t TotalFrames() const { return WARMUP_FRAMES + frameCount; }
+		__inline float TimeAt(uint32_t frame) const { return static_cast<float>(frame) * TIMESTEP; }
+
+		void ApplyCamera(uint32_t frame, Camera& c) const;
+
+		// Warmup frames are ignored
+		void RecordFrame(uint32_t frame, float cpuMs, uint32_t drawCalls, uint64_t triangles,
+			uint32_t bindsRequested, uint32_t bindsIssued);
+
+		bool WriteReport(const std::string& path, const std::vector<float>& gpuMs,
+			uint64_t deviceBytes, uint64_t transientBytes, const std::string& deviceName) const;
+
+	private:
+		std::string sceneName;
+		uint32_t frameCount;
+		CameraPath path;
+
+		std::vector<float> cpuMs;
+		std::vector<uint32_t> drawCalls;
+		std::vector<uint64_t> triangles;
+		std::vector<uint32_t> bindsRequested;
+		std::vector<uint32_t> bindsIssued;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,15 +1,172 @@
 #include "Application.h"
+#include "MicroBench.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
-int main() 
+// --headless              render without a window into offscreen images
+// --frames N              stop after N frames
+// --capture file.ppm      (headless) write the last frame to disk
+// --scene Name            Simple, Lighting, GLTF or Deferred
+// --benchmark out.json    fixed-timestep run along a camera path, N measured frames
+// --camera-path keys.txt  (benchmark) camera keys instead of the default orbit
+// --frames-in-flight N    frames the CPU may run ahead of the GPU, 1 = lowest latency
+// --present-mode mode     fifo, mailbox or immediate (falls back to fifo)
+// --fps-cap N             limit the frame rate, 0 = uncapped
+// --no-late-latch         don't re-sample input right before submit
+// --no-pipeline           update and render each frame in turn on the main thread
+// --sim-rate N            simulation steps per second, 0 = one step per frame
+// --max-steps N           simulation steps a frame may run to catch up
+// --no-interpolation      render the newest simulation step as is
+// --gpu-budget ms         GPU frame time dynamic resolution aims for
+// --min-scale 0.5         lowest dynamic resolution scale per axis
+// --no-dynamic-res        always render at full resolution
+// --microbench            CPU microbenchmarks only, no window or GPU needed
+//   --filter str          only cases whose name contains str
+//   --save out.json       write the results
+//   --baseline in.json    compare against saved results, exit code 1 on a regression
+//   --tolerance 0.1       slowdown allowed before a case counts as regressed
+int main(int argc, char** argv) 
 {
-	Tendou::Application app{};
-	
+	Tendou::ApplicationConfig config{};
+	Tendou::MicroBenchConfig microBench{};
+	bool runMicroBench = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			config.headless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			config.frameCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+		{
+			config.capturePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			config.sceneName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+		{
+			config.benchmarkPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc)
+		{
+			config.cameraPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+		{
+			config.pacing.swapChain.framesInFlight = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+		{
+			const char* mode = argv[++i];
+			if (strcmp(mode, "fifo") == 0)
+			{
+				config.pacing.swapChain.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+			}
+			else if (strcmp(mode, "mailbox") == 0)
+			{
+				config.pacing.swapChain.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+			}
+			else if (strcmp(mode, "immediate") == 0)
+			{
+				config.pacing.swapChain.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			}
+			else
+			{
+				std::cerr << "Unknown present mode: " << mode << std::endl;
+			}
+		}
+		else if (strcmp(argv[i], "--fps-cap") == 0 && i + 1 < argc)
+		{
+			config.pacing.maxFrameRate = static_cast<float>(strtod(argv[++i], nullptr));
+		}
+		else if (strcmp(argv[i], "--no-late-latch") == 0)
+		{
+			config.pacing.lateLatch = false;
+		}
+		else if (strcmp(argv[i], "--no-pipeline") == 0)
+		{
+			config.pipelineUpdate = false;
+		}
+		else if (strcmp(argv[i], "--sim-rate") == 0 && i + 1 < argc)
+		{
+			config.simulation.rate = static_cast<float>(strtod(argv[++i], nullptr));
+		}
+		else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc)
+		{
+			config.simulation.maxStepsPerFrame = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--no-interpolation") == 0)
+		{
+			config.simulation.interpolate = false;
+		}
+		else if (strcmp(argv[i], "--gpu-budget") == 0 && i + 1 < argc)
+		{
+			config.dynamicResolution.targetFrameTime = static_cast<float>(strtod(argv[++i], nullptr));
+		}
+		else if (strcmp(argv[i], "--min-scale") == 0 && i + 1 < argc)
+		{
+			config.dynamicResolution.minScale = static_cast<float>(strtod(argv[++i], nullptr));
+		}
+		else if (strcmp(argv[i], "--no-dynamic-res") == 0)
+		{
+			config.dynamicResolution.enabled = false;
+		}
+		else if (strcmp(argv[i], "--microbench") == 0)
+		{
+			runMicroBench = true;
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			microBench.filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+		{
+			microBench.outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+		{
+			microBench.baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+		{
+			microBench.tolerance = strtod(argv[++i], nullptr);
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	if (runMicroBench)
+	{
+		try
+		{
+			return Tendou::MicroBench::Run(microBench);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (config.headless && config.benchmarkPath.empty() && config.frameCount == 0)
+	{
+		config.frameCount = Tendou::HEADLESS_FRAMES;
+	}
+
 	try
 	{
+		Tendou::Application app{ config };
 		app.Run();
 	}
 	catch (const std::exception& e)
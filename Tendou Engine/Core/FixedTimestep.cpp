@@ -0,0 +1,42 @@
+#include "FixedTimestep.h"
+
+#include <cmath>
+
+namespace Tendou
+{
+	FixedTimestep::FixedTimestep(float step_, uint32_t maxSteps_)
+		: step(step_)
+		, maxSteps(maxSteps_ > 0 ? maxSteps_ : 1)
+	{
+	}
+
+	uint32_t FixedTimestep::Advance(float frameTime)
+	{
+		if (!IsFixed())
+		{
+			lastFrameTime = frameTime;
+			++stepCount;
+			return 1;
+		}
+
+		accumulator += frameTime;
+
+		uint32_t steps = 0;
+		while (accumulator >= step && steps < maxSteps)
+		{
+			accumulator -= step;
+			++steps;
+		}
+
+		// Keep the phase within a step, drop the whole steps that didn't fit
+		if (accumulator >= step)
+		{
+			double behind = std::floor(accumulator / step);
+			dropped += static_cast<uint64_t>(behind);
+			accumulator -= behind * step;
+		}
+
+		stepCount += steps;
+		return steps;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+#include <cstdint>
+
+namespace Tendou
+{
+	struct SimulationConfig
+	{
+		// Simulation steps per second, independent of the frame rate.
+		// 0 steps once per frame by however long it took.
+		float rate = 60.0f;
+
+		// Steps one frame may run to catch up; anything beyond is dropped, so a
+		// stall slows the simulation down instead of snowballing into longer frames
+		uint32_t maxStepsPerFrame = 5;
+
+		// Render between the last two steps instead of snapping to the newest,
+		// which shows the simulation up to one step late
+		bool interpolate = true;
+	};
+
+	// Accumulates frame time and hands it out in whole steps.
+	// The remainder is what frames interpolate by.
+	class FixedTimestep
+	{
+	public:
+		// step <= 0 gives one step per frame of whatever the frame took
+		FixedTimestep(float step, uint32_t maxSteps);
+
+		// Adds a frame's time, returns the steps to simulate for it
+		uint32_t Advance(float frameTime);
+
+		__inline bool IsFixed() const { return step > 0.0; }
+
+		// Seconds every step simulates
+		__inline float StepTime() const { return static_cast<float>(IsFixed() ? step : lastFrameTime); }
+
+		// How far past the last step this frame is, 0 to 1
+		__inline float Alpha() const { return IsFixed() ? static_cast<float>(accumulator / step) : 1.0f; }
+
+		// Steps simulated so far, and steps skipped by the catch-up limit
+		__inline uint64_t StepCount() const { return stepCount; }
+		__inline uint64_t DroppedSteps() const { return dropped; }
+
+	private:
+		// Doubles, so a long run doesn't drift off the step grid
+		double step;
+		double accumulator = 0.0;
+		double lastFrameTime = 0.0;
+
+		uint32_t maxSteps;
+		uint64_t stepCount = 0;
+		uint64_t dropped = 0;
+	};
+}
+
+#endif
\ No newline at end of file
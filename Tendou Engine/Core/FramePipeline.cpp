@@ -0,0 +1,122 @@
+#include "FramePipeline.h"
+
+#include "Profiler.h"
+
+#include <cassert>
+
+namespace Tendou
+{
+	FramePipeline::FramePipeline(UpdateFunc update_, bool threaded_)
+		: update(std::move(update_))
+		, threaded(threaded_)
+	{
+		if (threaded)
+		{
+			worker = std::thread([this]() { Loop(); });
+		}
+	}
+
+	FramePipeline::~FramePipeline()
+	{
+		if (!threaded)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> l(lock);
+			quit = true;
+		}
+		wake.notify_one();
+		worker.join();
+	}
+
+	void FramePipeline::Kick(float frameTime)
+	{
+		assert(!pending && "Wait for the previous update before kicking the next one!");
+
+		uint32_t next = (latest + 1) % PACKET_COUNT;
+		packets[next].frame = updates++;
+		packets[next].frameTime = frameTime;
+
+		if (!threaded)
+		{
+			Run(next);
+			latest = next;
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> l(lock);
+			writing = next;
+			pending = true;
+		}
+		wake.notify_one();
+	}
+
+	const FramePacket& FramePipeline::Wait()
+	{
+		if (threaded)
+		{
+			TENDOU_PROFILE_SCOPE("FramePipeline::Wait");
+
+			std::unique_lock<std::mutex> l(lock);
+			done.wait(l, [this]() { return !pending; });
+
+			if (error)
+			{
+				std::exception_ptr e = error;
+				error = nullptr;
+				std::rethrow_exception(e);
+			}
+		}
+
+		return packets[latest];
+	}
+
+	void FramePipeline::Loop()
+	{
+		Profiler::SetThreadName("Update");
+
+		for (;;)
+		{
+			uint32_t idx;
+			{
+				std::unique_lock<std::mutex> l(lock);
+				wake.wait(l, [this]() { return pending || quit; });
+				if (quit)
+				{
+					return;
+				}
+				idx = writing;
+			}
+
+			std::exception_ptr e;
+			try
+			{
+				Run(idx);
+			}
+			catch (...)
+			{
+				e = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> l(lock);
+				latest = idx;
+				error = e;
+				pending = false;
+			}
+			done.notify_one();
+		}
+	}
+
+	void FramePipeline::Run(uint32_t idx)
+	{
+		TENDOU_PROFILE_SCOPE("Update");
+
+		FramePacket& packet = packets[idx];
+		packet.Clear();
+		update(packet);
+	}
+}
\ No newline at end of file
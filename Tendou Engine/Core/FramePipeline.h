@@ -0,0 +1,68 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include "../Rendering/FramePacket.h"
+
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Tendou
+{
+	// Runs the update stage of a frame on its own thread while the main thread
+	// records the previous one. Each update writes the next of two packets, so
+	// the packet being rendered is never the one being written.
+	//
+	// Kick and Wait bracket the only time both threads touch the scene: between
+	// Wait returning and the next Kick the update thread is idle, which is where
+	// the main thread polls input, builds the editor UI and reads the packet.
+	class FramePipeline
+	{
+	public:
+		static constexpr uint32_t PACKET_COUNT = 2;
+
+		using UpdateFunc = std::function<void(FramePacket&)>;
+
+		// Unthreaded pipelines run each update inline inside Kick
+		FramePipeline(UpdateFunc update, bool threaded);
+		~FramePipeline();
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+
+		// Starts the update that writes the next packet. The previous update must have been waited on.
+		void Kick(float frameTime);
+
+		// Blocks until the last kicked update is done and returns the newest packet,
+		// returns straight away if none is in flight. Rethrows anything the update threw.
+		const FramePacket& Wait();
+
+		__inline bool IsThreaded() const { return threaded; }
+
+	private:
+		void Loop();
+		void Run(uint32_t idx);
+
+		UpdateFunc update;
+		bool threaded;
+
+		std::array<FramePacket, PACKET_COUNT> packets;
+		uint32_t latest = PACKET_COUNT - 1;
+		uint32_t writing = 0;
+		uint64_t updates = 0;
+
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		bool pending = false;
+		bool quit = false;
+		std::exception_ptr error;
+
+		std::thread worker;
+	};
+}
+
+#endif
\ No newline at end of file
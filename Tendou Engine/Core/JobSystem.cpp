@@ -0,0 +1,351 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace Tendou
+{
+	struct JobSystem::State
+	{
+		struct WorkQueue
+		{
+			std::mutex lock;
+			std::deque<Job> jobs;
+		};
+
+		// queues[0] belongs to the thread that called Init
+		std::vector<std::unique_ptr<WorkQueue>> queues;
+		std::vector<std::thread> workers;
+
+		// Only used to park idle workers; the queues themselves are per-thread
+		std::atomic<int> queued{ 0 };
+		std::mutex wakeLock;
+		std::condition_variable wakeCv;
+	};
+
+	JobSystem::State* JobSystem::state = nullptr;
+	std::atomic<bool> JobSystem::running{ false };
+	JobSystem::ProfileHook JobSystem::profileBegin = nullptr;
+	JobSystem::ProfileHook JobSystem::profileEnd = nullptr;
+
+	static thread_local uint32_t threadIdx = ~0u;
+
+	void JobSystem::Init(const JobSystemConfig& config)
+	{
+		if (state)
+		{
+			throw std::runtime_error("Job system already initialized!");
+		}
+
+		uint32_t workerCount = config.threadCount;
+		if (workerCount == 0)
+		{
+			uint32_t hw = std::thread::hardware_concurrency();
+			workerCount = hw > 1 ? hw - 1 : 0;
+		}
+
+		state = new State();
+		state->queues.reserve(workerCount + 1);
+		for (uint32_t i = 0; i < workerCount + 1; ++i)
+		{
+			state->queues.push_back(std::make_unique<State::WorkQueue>());
+		}
+
+		threadIdx = 0;
+		running.store(true, std::memory_order_release);
+
+		state->workers.reserve(workerCount);
+		for (uint32_t i = 1; i <= workerCount; ++i)
+		{
+			state->workers.emplace_back(&JobSystem::WorkerLoop, i);
+		}
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (!state)
+		{
+			return;
+		}
+
+		// Drain whatever is left so nothing referencing a counter is dropped
+		while (TryRunOne(0)) {}
+
+		running.store(false, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> l(state->wakeLock);
+		}
+		state->wakeCv.notify_all();
+
+		for (auto& t : state->workers)
+		{
+			t.join();
+		}
+
+		delete state;
+		state = nullptr;
+		threadIdx = ~0u;
+	}
+
+	void JobSystem::Run(JobFunc func, JobCounter* counter, const char* name)
+	{
+		if (counter)
+		{
+			counter->pending.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		Job job{ std::move(func), counter, name };
+
+		// No workers to hand it to - just run it here
+		if (!state || state->workers.empty())
+		{
+			Execute(job, ThreadIndex());
+			return;
+		}
+
+		Push(std::move(job));
+	}
+
+	void JobSystem::RunAfter(JobCounter& dependency, JobFunc func, JobCounter* counter, const char* name)
+	{
+		if (counter)
+		{
+			counter->pending.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		{
+			std::lock_guard<std::mutex> l(dependency.continuationLock);
+			if (!dependency.IsDone())
+			{
+				dependency.continuations.push_back({ std::move(func), counter, name });
+				return;
+			}
+		}
+
+		Job job{ std::move(func), counter, name };
+		if (!state || state->workers.empty())
+		{
+			Execute(job, ThreadIndex());
+			return;
+		}
+
+		Push(std::move(job));
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		uint32_t idx = ThreadIndex();
+
+		while (!counter.IsDone())
+		{
+			if (!TryRunOne(idx))
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		// The last Finish() on this counter may still be holding the lock;
+		// make sure it's released before the caller is allowed to destroy the counter
+		std::lock_guard<std::mutex> l(counter.continuationLock);
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize,
+		const std::function<void(uint32_t, uint32_t)>& func, const char* name)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		batchSize = std::max(batchSize, 1u);
+
+		if (!state || state->workers.empty() || count <= batchSize)
+		{
+			func(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t begin = 0; begin < count; begin += batchSize)
+		{
+			uint32_t end = std::min(begin + batchSize, count);
+			Run([&func, begin, end]() { func(begin, end); }, &counter, name);
+		}
+
+		Wait(counter);
+	}
+
+	void JobSystem::SetProfileHooks(ProfileHook onBegin, ProfileHook onEnd)
+	{
+		profileBegin = onBegin;
+		profileEnd = onEnd;
+	}
+
+	uint32_t JobSystem::ThreadCount()
+	{
+		return state ? static_cast<uint32_t>(state->queues.size()) : 1;
+	}
+
+	uint32_t JobSystem::ThreadIndex()
+	{
+		return threadIdx;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t idx)
+	{
+		threadIdx = idx;
+
+		while (running.load(std::memory_order_acquire))
+		{
+			if (TryRunOne(idx))
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> l(state->wakeLock);
+			state->wakeCv.wait(l, []()
+				{
+					return state->queued.load(std::memory_order_acquire) > 0 ||
+						!running.load(std::memory_order_acquire);
+				});
+		}
+	}
+
+	void JobSystem::Push(Job&& job)
+	{
+		// Foreign threads (not the main thread or a worker) feed the main queue
+		uint32_t idx = ThreadIndex();
+		if (idx >= state->queues.size())
+		{
+			idx = 0;
+		}
+
+		{
+			std::lock_guard<std::mutex> l(state->queues[idx]->lock);
+			state->queues[idx]->jobs.push_back(std::move(job));
+		}
+		state->queued.fetch_add(1, std::memory_order_acq_rel);
+
+		{
+			std::lock_guard<std::mutex> l(state->wakeLock);
+		}
+		state->wakeCv.notify_one();
+	}
+
+	bool JobSystem::TryRunOne(uint32_t idx)
+	{
+		if (!state)
+		{
+			return false;
+		}
+
+		Job job{};
+		bool found = false;
+		uint32_t queueCount = static_cast<uint32_t>(state->queues.size());
+
+		// Own queue first, newest job (LIFO keeps the cache warm)
+		if (idx < queueCount)
+		{
+			auto& q = *state->queues[idx];
+			std::lock_guard<std::mutex> l(q.lock);
+			if (!q.jobs.empty())
+			{
+				job = std::move(q.jobs.back());
+				q.jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Then steal the oldest job from someone else
+		for (uint32_t i = 1; !found && i <= queueCount; ++i)
+		{
+			uint32_t victim = (idx + i) % queueCount;
+			if (victim == idx)
+			{
+				continue;
+			}
+
+			auto& q = *state->queues[victim];
+			std::lock_guard<std::mutex> l(q.lock);
+			if (!q.jobs.empty())
+			{
+				job = std::move(q.jobs.front());
+				q.jobs.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found)
+		{
+			return false;
+		}
+
+		state->queued.fetch_sub(1, std::memory_order_acq_rel);
+		Execute(job, idx);
+		return true;
+	}
+
+	void JobSystem::Execute(Job& job, uint32_t idx)
+	{
+		if (profileBegin)
+		{
+			profileBegin(job.name, idx);
+		}
+
+		job.func();
+
+		if (profileEnd)
+		{
+			profileEnd(job.name, idx);
+		}
+
+		Finish(job.counter);
+	}
+
+	void JobSystem::Finish(JobCounter* counter)
+	{
+		if (!counter)
+		{
+			return;
+		}
+
+		// Fast path: not the last job on this counter, nobody can be waiting on us
+		int curr = counter->pending.load(std::memory_order_acquire);
+		while (curr > 1)
+		{
+			if (counter->pending.compare_exchange_weak(curr, curr - 1, std::memory_order_acq_rel))
+			{
+				return;
+			}
+		}
+
+		// Dropping to zero always happens under the lock so RunAfter/Wait see a consistent state
+		std::vector<JobCounter::Continuation> ready;
+		{
+			std::lock_guard<std::mutex> l(counter->continuationLock);
+			if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				ready.swap(counter->continuations);
+			}
+		}
+
+		// NOTE: counter may already be destroyed here, don't touch it
+		for (auto& c : ready)
+		{
+			Job job{ std::move(c.func), c.counter, c.name };
+			if (!state || state->workers.empty())
+			{
+				Execute(job, ThreadIndex());
+			}
+			else
+			{
+				Push(std::move(job));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Tendou
+{
+	using JobFunc = std::function<void()>;
+
+	// Counts outstanding jobs. Anything waiting on a counter (JobSystem::Wait or
+	// a continuation queued with JobSystem::RunAfter) fires once it drops to zero.
+	// Counters must outlive every job that references them.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		__inline bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+		__inline int Pending() const { return pending.load(std::memory_order_acquire); }
+
+	private:
+		struct Continuation
+		{
+			JobFunc func;
+			JobCounter* counter;
+			const char* name;
+		};
+
+		std::atomic<int> pending{ 0 };
+
+		std::mutex continuationLock;
+		std::vector<Continuation> continuations;
+
+		friend class JobSystem;
+	};
+
+	struct JobSystemConfig
+	{
+		// Number of worker threads spawned in addition to the calling (main) thread.
+		// 0 picks hardware_concurrency - 1.
+		uint32_t threadCount = 0;
+	};
+
+	// Work-stealing job scheduler.
+	// Every thread (main thread included) owns a deque; the owner pushes/pops
+	// at the back, idle threads steal from the front of someone else's deque.
+	// Waiting never blocks a thread outright - Wait() keeps executing queued
+	// jobs until its counter drains, so jobs can spawn and wait on children.
+	class JobSystem
+	{
+	public:
+		using ProfileHook = void(*)(const char* name, uint32_t threadIdx);
+
+		static void Init(const JobSystemConfig& config = JobSystemConfig());
+		static void Shutdown();
+
+		// Queues a job. If counter is non-null it's incremented now and
+		// decremented once the job has finished.
+		static void Run(JobFunc func, JobCounter* counter = nullptr, const char* name = nullptr);
+
+		// Queues func once dependency reaches zero (or immediately if it already has).
+		static void RunAfter(JobCounter& dependency, JobFunc func,
+			JobCounter* counter = nullptr, const char* name = nullptr);
+
+		// Helps execute jobs until counter reaches zero
+		static void Wait(JobCounter& counter);
+
+		// Splits [0, count) into batches of batchSize and runs func(begin, end)
+		// for each batch across all threads. Returns once every batch is done.
+		static void ParallelFor(uint32_t count, uint32_t batchSize,
+			const std::function<void(uint32_t, uint32_t)>& func, const char* name = nullptr);
+
+		// Called around every job on the thread that executes it
+		static void SetProfileHooks(ProfileHook onBegin, ProfileHook onEnd);
+
+		__inline static bool IsRunning() { return running.load(std::memory_order_acquire); }
+
+		// Worker threads + the main thread
+		static uint32_t ThreadCount();
+
+		// 0 for the thread that called Init, 1..N for workers, ~0u for foreign threads
+		static uint32_t ThreadIndex();
+
+	private:
+		struct Job
+		{
+			JobFunc func;
+			JobCounter* counter;
+			const char* name;
+		};
+
+		struct State;
+
+		static void WorkerLoop(uint32_t idx);
+		static void Push(Job&& job);
+		static bool TryRunOne(uint32_t idx);
+		static void Execute(Job& job, uint32_t idx);
+		static void Finish(JobCounter* counter);
+
+		static State* state;
+		static std::atomic<bool> running;
+		static ProfileHook profileBegin;
+		static ProfileHook profileEnd;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Tendou
+{
+	MappedFile::MappedFile(const std::string& path)
+	{
+		Open(path);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+
+			std::swap(data, other.data);
+			std::swap(size, other.size);
+#ifdef _WIN32
+			std::swap(file, other.file);
+			std::swap(mapping, other.mapping);
+#else
+			std::swap(fd, other.fd);
+#endif
+		}
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (f == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(f, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(f);
+			return false;
+		}
+
+		HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m)
+		{
+			CloseHandle(f);
+			return false;
+		}
+
+		void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			CloseHandle(m);
+			CloseHandle(f);
+			return false;
+		}
+
+		file = f;
+		mapping = m;
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data)
+		{
+			UnmapViewOfFile(data);
+		}
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+		if (file)
+		{
+			CloseHandle(file);
+		}
+
+		data = nullptr;
+		size = 0;
+		mapping = nullptr;
+		file = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		int f = open(path.c_str(), O_RDONLY);
+		if (f < 0)
+		{
+			return false;
+		}
+
+		struct stat st{};
+		if (fstat(f, &st) != 0 || st.st_size == 0)
+		{
+			close(f);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, f, 0);
+		if (view == MAP_FAILED)
+		{
+			close(f);
+			return false;
+		}
+
+		fd = f;
+		data = static_cast<const uint8_t*>(view);
+		size = static_cast<size_t>(st.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (data)
+		{
+			munmap(const_cast<uint8_t*>(data), size);
+		}
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+
+		data = nullptr;
+		size = 0;
+		fd = -1;
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Tendou
+{
+	// Read-only view of a whole file through the OS page cache.
+	// Nothing is read up front; pages come in as they are touched.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// Returns false if the file is missing, empty or can't be mapped
+		bool Open(const std::string& path);
+		void Close();
+
+		__inline bool IsOpen() const { return data != nullptr; }
+		__inline const uint8_t* Data() const { return data; }
+		__inline size_t Size() const { return size; }
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#else
+		int fd = -1;
+#endif
+	};
+}
+
+#endif
\ No newline at end of file
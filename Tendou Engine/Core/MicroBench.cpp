@@ -0,0 +1,810 @@
+#include "MicroBench.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+// Cases that go through Model need the Vulkan headers. The standalone
+// CPU-only build (Tools/MicroBench) sets this to 0 and skips them.
+#ifndef TENDOU_MICROBENCH_MODEL
+#define TENDOU_MICROBENCH_MODEL 1
+#endif
+
+#include "../Components/Transform.h"
+#include "../Rendering/GLTFAsset.h"
+#include "../Rendering/OBJReader.h"
+#if TENDOU_MICROBENCH_MODEL
+#include "../Rendering/Model.h"
+#include "../Utilities/VertexWelder.hpp"
+#endif
+
+// Only the benchmarks still use tinyobjloader, as the baseline for OBJReader
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+// Likewise tinygltf, as the baseline for GLTFAsset
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#include <tiny_gltf.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+namespace Tendou
+{
+	namespace
+	{
+		// Fixture assets, relative to the working directory like every other asset path
+#if TENDOU_MICROBENCH_MODEL
+		const char* OBJ_FIXTURES[] =
+		{
+			"Materials/Models/cube.obj",
+			"Materials/Models/rhino.obj",
+			"Materials/Models/starwars1.obj",
+			"Materials/Models/smooth_vase.obj",
+		};
+
+		// No normals in the file, so LoadOBJ has to generate them
+		const char* OBJ_GENERATED_NORMALS = "Materials/Models/bunny.obj";
+#endif
+
+		// Larger meshes for comparing OBJReader against tinyobjloader
+		const char* OBJ_PARSE_FIXTURES[] =
+		{
+			"Materials/Models/starwars1.obj",
+			"Materials/Models/4Sphere.obj",
+			"Materials/Models/bunny_high_poly.obj",
+		};
+
+#if TENDOU_MICROBENCH_MODEL
+		// Mesh used for the dedup/hash cases
+		const char* DEDUP_FIXTURE = "Materials/Models/starwars1.obj";
+#endif
+
+		const char* GLTF_FIXTURES[] =
+		{
+			"Materials/Models/GLTF/OrientationTest/glTF/OrientationTest.gltf",
+			"Materials/Models/GLTF/Lantern/glTF/Lantern.gltf",
+			"Materials/Models/GLTF/Hoshino/scene.gltf",
+		};
+
+		// Binary and quantized variants only GLTFAsset reads
+		const char* GLTF_ASSET_FIXTURES[] =
+		{
+			"Materials/Models/GLTF/OrientationTest/glTF-Binary/OrientationTest.glb",
+			"Materials/Models/GLTF/Lantern/glTF-Quantized/Lantern.gltf",
+		};
+
+		constexpr uint32_t TRANSFORM_COUNT = 4096;
+
+		// Job system scaling: enough work per call that batches outnumber threads
+		constexpr uint32_t SCALING_TRANSFORMS = 1 << 16;
+		constexpr uint32_t SCALING_BATCH = 256;
+
+		// Empty batches, so only the scheduling itself is timed
+		constexpr uint32_t SCHEDULING_BATCHES = 4096;
+
+		std::string FileName(const std::string& path)
+		{
+			size_t slash = path.find_last_of("/\\");
+			return slash == std::string::npos ? path : path.substr(slash + 1);
+		}
+
+		bool FileExists(const std::string& path)
+		{
+			std::ifstream file(path);
+			return file.good();
+		}
+
+		double Median(std::vector<double> v)
+		{
+			std::sort(v.begin(), v.end());
+			size_t mid = v.size() / 2;
+			return v.size() % 2 ? v[mid] : 0.5 * (v[mid - 1] + v[mid]);
+		}
+
+		std::string FormatTime(double ns)
+		{
+			char buf[32];
+			if (ns >= 1e6)
+			{
+				snprintf(buf, sizeof(buf), "%.3f ms", ns / 1e6);
+			}
+			else if (ns >= 1e3)
+			{
+				snprintf(buf, sizeof(buf), "%.3f us", ns / 1e3);
+			}
+			else
+			{
+				snprintf(buf, sizeof(buf), "%.1f ns", ns);
+			}
+			return buf;
+		}
+
+		// Keeps results observable so the work can't be optimized away
+		volatile uint64_t sink = 0;
+	}
+
+	std::vector<MicroBench::Case> MicroBench::BuildCases()
+	{
+		std::vector<Case> cases;
+
+		// Loaders
+		// -----
+#if TENDOU_MICROBENCH_MODEL
+		for (const char* path : OBJ_FIXTURES)
+		{
+			if (!FileExists(path))
+			{
+				std::cerr << "Missing fixture " << path << ", skipping" << std::endl;
+				continue;
+			}
+
+			Model::Builder<Model::Vertex> probe{};
+			probe.LoadOBJ(path, false);
+
+			std::string file = path;
+			cases.push_back({ "LoadOBJ/" + FileName(file), probe.indices.size(), [file]()
+				{
+					Model::Builder<Model::Vertex> b{};
+					b.LoadOBJ(file, false);
+					return static_cast<uint64_t>(b.vertices.size());
+				} });
+		}
+
+		if (FileExists(OBJ_GENERATED_NORMALS))
+		{
+			Model::Builder<Model::Vertex> probe{};
+			probe.LoadOBJ(OBJ_GENERATED_NORMALS, false);
+
+			std::string file = OBJ_GENERATED_NORMALS;
+			cases.push_back({ "LoadOBJ/" + FileName(file) + " (generated normals)", probe.indices.size(), [file]()
+				{
+					Model::Builder<Model::Vertex> b{};
+					b.LoadOBJ(file, false);
+					return static_cast<uint64_t>(b.vertices.size());
+				} });
+		}
+#endif
+
+		// Parsing only, no welding. "threads" cases split the file across the job system.
+		for (const char* path : OBJ_PARSE_FIXTURES)
+		{
+			if (!FileExists(path))
+			{
+				std::cerr << "Missing fixture " << path << ", skipping" << std::endl;
+				continue;
+			}
+
+			std::string file = path;
+			uint64_t corners = OBJReader::Read(file, false).indices.size();
+
+			cases.push_back({ "tinyobj::LoadObj/" + FileName(file), corners, [file]()
+				{
+					tinyobj::attrib_t attrib;
+					std::vector<tinyobj::shape_t> shapes;
+					std::vector<tinyobj::material_t> materials;
+					std::string warn, err;
+					tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, file.c_str());
+					return static_cast<uint64_t>(attrib.vertices.size());
+				} });
+
+			cases.push_back({ "OBJReader/" + FileName(file) + " (1 thread)", corners, [file]()
+				{
+					return static_cast<uint64_t>(OBJReader::Read(file, false).positions.size());
+				} });
+
+			// Same as the case above without workers, and would share its name
+			if (JobSystem::ThreadCount() > 1)
+			{
+				cases.push_back({ "OBJReader/" + FileName(file) + " (" + std::to_string(JobSystem::ThreadCount()) + " threads)",
+					corners, [file]()
+					{
+						return static_cast<uint64_t>(OBJReader::Read(file, true).positions.size());
+					} });
+			}
+		}
+
+		for (const char* path : GLTF_FIXTURES)
+		{
+			if (!FileExists(path))
+			{
+				std::cerr << "Missing fixture " << path << ", skipping" << std::endl;
+				continue;
+			}
+
+			std::string file = path;
+			cases.push_back({ "tinygltf::LoadASCIIFromFile/" + FileName(file), 1, [file]()
+				{
+					tinygltf::Model model;
+					tinygltf::TinyGLTF context;
+					std::string error, warning;
+					context.LoadASCIIFromFile(&model, &error, &warning, file);
+					return static_cast<uint64_t>(model.accessors.size());
+				} });
+
+			cases.push_back({ "GLTFAsset::Load/" + FileName(file), 1, [file]()
+				{
+					GLTFAsset asset;
+					asset.Load(file);
+					return static_cast<uint64_t>(asset.accessors.size());
+				} });
+		}
+
+		// Load plus converting every primitive's attributes the way GLTF::LoadMeshes does
+		for (const char* path : GLTF_ASSET_FIXTURES)
+		{
+			if (!FileExists(path))
+			{
+				std::cerr << "Missing fixture " << path << ", skipping" << std::endl;
+				continue;
+			}
+
+			std::string file = path;
+			GLTFAsset probe;
+			probe.Load(file);
+
+			uint64_t vertices = 0;
+			for (const GLTFAsset::Mesh& mesh : probe.meshes)
+			{
+				for (const GLTFAsset::Primitive& p : mesh.primitives)
+				{
+					vertices += p.position >= 0 ? probe.accessors[p.position].count : 0;
+				}
+			}
+
+			cases.push_back({ "GLTFAsset::Load + ReadFloats/" + FileName(file), vertices, [file]()
+				{
+					GLTFAsset asset;
+					asset.Load(file);
+
+					// pos, normal, uv, tangent
+					constexpr uint32_t FLOATS = 12;
+					std::vector<float> out;
+					uint64_t checksum = 0;
+					for (const GLTFAsset::Mesh& mesh : asset.meshes)
+					{
+						for (const GLTFAsset::Primitive& p : mesh.primitives)
+						{
+							if (p.position < 0)
+							{
+								continue;
+							}
+
+							size_t count = asset.accessors[p.position].count;
+							out.assign(count * FLOATS, 0.0f);
+							asset.ReadFloats(p.position, 0, count, out.data(), FLOATS * sizeof(float), 3);
+							asset.ReadFloats(p.normal, 0, count, out.data() + 3, FLOATS * sizeof(float), 3);
+							asset.ReadFloats(p.texcoord0, 0, count, out.data() + 6, FLOATS * sizeof(float), 2);
+							asset.ReadFloats(p.tangent, 0, count, out.data() + 8, FLOATS * sizeof(float), 4);
+							checksum += static_cast<uint64_t>(out[0] * 1000.0f);
+						}
+					}
+					return checksum;
+				} });
+		}
+
+		// Vertex dedup and hashing - the inner loop of LoadOBJ, without the parsing
+		// -----
+#if TENDOU_MICROBENCH_MODEL
+		if (FileExists(DEDUP_FIXTURE))
+		{
+			Model::Builder<Model::Vertex> b{};
+			b.LoadOBJ(DEDUP_FIXTURE, false);
+
+			// Un-indexed, the way OBJReader's corners expand in LoadOBJ
+			auto expanded = std::make_shared<std::vector<Model::Vertex>>();
+			expanded->reserve(b.indices.size());
+			for (uint32_t i : b.indices)
+			{
+				expanded->push_back(b.vertices[i]);
+			}
+
+			std::string name = FileName(DEDUP_FIXTURE);
+			cases.push_back({ "VertexDedup/" + name, expanded->size(), [expanded]()
+				{
+					std::unordered_map<Model::Vertex, uint32_t> unique{};
+					std::vector<uint32_t> indices;
+					indices.reserve(expanded->size());
+
+					for (const auto& v : *expanded)
+					{
+						auto found = unique.find(v);
+						if (found == unique.end())
+						{
+							found = unique.emplace(v, static_cast<uint32_t>(unique.size())).first;
+						}
+						indices.push_back(found->second);
+					}
+					return static_cast<uint64_t>(unique.size());
+				} });
+
+			cases.push_back({ "VertexWelder/" + name, expanded->size(), [expanded]()
+				{
+					std::vector<Model::Vertex> vertices;
+					VertexWelder<Model::Vertex> welder(vertices, expanded->size() / 4);
+
+					uint64_t acc = 0;
+					for (const auto& v : *expanded)
+					{
+						acc += welder.Weld(v);
+					}
+					return acc + vertices.size();
+				} });
+
+			cases.push_back({ "HashCombine/Model::Vertex", expanded->size(), [expanded]()
+				{
+					std::hash<Model::Vertex> hasher;
+					uint64_t h = 0;
+					for (const auto& v : *expanded)
+					{
+						h ^= hasher(v);
+					}
+					return h;
+				} });
+
+			cases.push_back({ "Hash64/Model::Vertex", expanded->size(), [expanded]()
+				{
+					uint64_t h = 0;
+					for (const auto& v : *expanded)
+					{
+						h ^= Hash64(&v, sizeof(v));
+					}
+					return h;
+				} });
+		}
+#endif
+
+		// Transforms
+		// -----
+		auto transforms = std::make_shared<std::vector<Transform>>();
+		{
+			// Fixed seed so every run transforms the same values
+			std::mt19937 rng(1337);
+			std::uniform_real_distribution<float> pos(-50.0f, 50.0f);
+			std::uniform_real_distribution<float> rot(-3.14159f, 3.14159f);
+			std::uniform_real_distribution<float> scl(0.1f, 4.0f);
+
+			transforms->reserve(TRANSFORM_COUNT);
+			for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i)
+			{
+				transforms->emplace_back(glm::vec3(pos(rng), pos(rng), pos(rng)),
+					glm::vec3(rot(rng), rot(rng), rot(rng)),
+					glm::vec3(scl(rng), scl(rng), scl(rng)));
+			}
+		}
+
+		cases.push_back({ "Transform::Mat4", TRANSFORM_COUNT, [transforms]()
+			{
+				float acc = 0.0f;
+				for (auto& t : *transforms)
+				{
+					glm::mat4 m = t.Mat4();
+					acc += m[0][0] + m[3][2];
+				}
+				return static_cast<uint64_t>(std::abs(acc));
+			} });
+
+		cases.push_back({ "Transform::NormalMatrix", TRANSFORM_COUNT, [transforms]()
+			{
+				float acc = 0.0f;
+				for (auto& t : *transforms)
+				{
+					glm::mat3 m = t.NormalMatrix();
+					acc += m[0][0] + m[2][1];
+				}
+				return static_cast<uint64_t>(std::abs(acc));
+			} });
+
+		cases.push_back({ "Transform::Update", TRANSFORM_COUNT, [transforms]()
+			{
+				float acc = 0.0f;
+				for (auto& t : *transforms)
+				{
+					t.Update(true);
+					acc += t.ModelMat()[3][0];
+				}
+				return static_cast<uint64_t>(std::abs(acc));
+			} });
+
+		// Job system scaling
+		// -----
+		auto scaling = std::make_shared<std::vector<Transform>>();
+		scaling->reserve(SCALING_TRANSFORMS);
+		for (uint32_t i = 0; i < SCALING_TRANSFORMS; ++i)
+		{
+			scaling->push_back((*transforms)[i % TRANSFORM_COUNT]);
+		}
+
+		auto batches = std::make_shared<std::vector<uint32_t>>(SCHEDULING_BATCHES, 0);
+
+		for (uint32_t threads : ScalingThreadCounts())
+		{
+			std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+
+			cases.push_back({ "ParallelFor/Transform::Update" + suffix, SCALING_TRANSFORMS, [scaling]()
+				{
+					JobSystem::ParallelFor(SCALING_TRANSFORMS, SCALING_BATCH, [&scaling](uint32_t begin, uint32_t end)
+						{
+							for (uint32_t i = begin; i < end; ++i)
+							{
+								(*scaling)[i].Update(true);
+							}
+						});
+					return static_cast<uint64_t>(std::abs((*scaling)[0].ModelMat()[3][0]));
+				}, threads });
+
+			cases.push_back({ "ParallelFor/empty batches" + suffix, SCHEDULING_BATCHES, [batches]()
+				{
+					JobSystem::ParallelFor(SCHEDULING_BATCHES, 1, [&batches](uint32_t begin, uint32_t)
+						{
+							(*batches)[begin] = begin;
+						});
+					return static_cast<uint64_t>(batches->back());
+				}, threads });
+		}
+
+		return cases;
+	}
+
+	std::vector<uint32_t> MicroBench::ScalingThreadCounts()
+	{
+		uint32_t hw = std::max(std::thread::hardware_concurrency(), 1u);
+
+		std::vector<uint32_t> counts;
+		for (uint32_t t = 1; t < hw; t *= 2)
+		{
+			counts.push_back(t);
+		}
+		counts.push_back(hw);
+		return counts;
+	}
+
+	void MicroBench::RestartJobSystem(uint32_t threads)
+	{
+		JobSystem::Shutdown();
+
+		// Without a job system Run and ParallelFor execute inline, the true single thread baseline
+		if (threads > 1)
+		{
+			JobSystemConfig config{};
+			config.threadCount = threads - 1;
+			JobSystem::Init(config);
+		}
+	}
+
+	bool MicroBench::CheckJobSystem()
+	{
+		bool ok = true;
+		auto check = [&ok](bool condition, const char* what)
+		{
+			if (!condition)
+			{
+				std::cerr << "JobSystem check failed: " << what << std::endl;
+				ok = false;
+			}
+		};
+
+		// Counters: Wait only returns once every job ran, and leaves the counter at zero
+		{
+			constexpr int JOBS = 1000;
+			std::atomic<int> runs{ 0 };
+			JobCounter counter;
+			for (int i = 0; i < JOBS; ++i)
+			{
+				JobSystem::Run([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			}
+			JobSystem::Wait(counter);
+
+			check(runs.load() == JOBS, "Wait returned before every job ran");
+			check(counter.IsDone() && counter.Pending() == 0, "counter didn't drain to zero");
+		}
+
+		// RunAfter: a continuation sees all of its dependency's work, chained ones
+		// run in order, and one queued on a finished counter runs right away
+		{
+			constexpr int JOBS = 256;
+			std::atomic<int> runs{ 0 };
+			int seenFirst = -1;
+			int seenSecond = -1;
+
+			JobCounter first;
+			JobCounter second;
+			JobCounter done;
+			for (int i = 0; i < JOBS; ++i)
+			{
+				JobSystem::Run([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); }, &first);
+			}
+			JobSystem::RunAfter(first, [&runs, &seenFirst]() { seenFirst = runs.load(); }, &second);
+			JobSystem::RunAfter(second, [&seenFirst, &seenSecond]() { seenSecond = seenFirst + 1; }, &done);
+			JobSystem::Wait(done);
+
+			check(seenFirst == JOBS, "continuation ran before its dependency finished");
+			check(seenSecond == JOBS + 1, "chained continuation ran out of order");
+
+			bool immediate = false;
+			JobCounter after;
+			JobSystem::RunAfter(first, [&immediate]() { immediate = true; }, &after);
+			JobSystem::Wait(after);
+
+			check(immediate, "continuation on a finished counter never ran");
+		}
+
+		// Nested waits: more waiting parents than threads must still drain,
+		// since a waiting thread keeps running other jobs
+		{
+			constexpr int PARENTS = 32;
+			constexpr int CHILDREN = 32;
+			std::atomic<int> runs{ 0 };
+
+			JobCounter parents;
+			for (int p = 0; p < PARENTS; ++p)
+			{
+				JobSystem::Run([&runs]()
+					{
+						JobCounter children;
+						for (int c = 0; c < CHILDREN; ++c)
+						{
+							JobSystem::Run([&runs]() { runs.fetch_add(1, std::memory_order_relaxed); }, &children);
+						}
+						JobSystem::Wait(children);
+
+						JobSystem::ParallelFor(CHILDREN, 4, [&runs](uint32_t begin, uint32_t end)
+							{
+								runs.fetch_add(static_cast<int>(end - begin), std::memory_order_relaxed);
+							});
+					}, &parents);
+			}
+			JobSystem::Wait(parents);
+
+			check(runs.load() == PARENTS * CHILDREN * 2, "nested waits lost jobs");
+		}
+
+		// ParallelFor: every index exactly once, including a partial last batch
+		{
+			constexpr uint32_t COUNT = 10007;
+			std::vector<uint32_t> visits(COUNT, 0);
+			JobSystem::ParallelFor(COUNT, 64, [&visits](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i = begin; i < end; ++i)
+					{
+						++visits[i];
+					}
+				});
+
+			check(std::all_of(visits.begin(), visits.end(), [](uint32_t v) { return v == 1; }),
+				"ParallelFor skipped or repeated an index");
+		}
+
+		return ok;
+	}
+
+	MicroBench::Result MicroBench::Measure(const Case& c)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Warm caches and find how many calls fill one sample
+		auto start = Clock::now();
+		sink = sink + c.func();
+		double once = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		uint32_t iterations = once > 0.0 ? static_cast<uint32_t>(std::ceil(MIN_SAMPLE_MS / once)) : 1000;
+		iterations = std::max(iterations, 1u);
+
+		std::vector<double> samples;
+		samples.reserve(SAMPLES);
+
+		for (uint32_t s = 0; s < SAMPLES; ++s)
+		{
+			start = Clock::now();
+			for (uint32_t i = 0; i < iterations; ++i)
+			{
+				sink = sink + c.func();
+			}
+			double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			samples.push_back(ns / iterations);
+		}
+
+		Result r{};
+		r.name = c.name;
+		r.medianNs = Median(samples);
+		r.minNs = *std::min_element(samples.begin(), samples.end());
+
+		// Median absolute deviation - unlike stddev, one preempted sample barely moves it
+		std::vector<double> deviations;
+		for (double s : samples)
+		{
+			deviations.push_back(std::abs(s - r.medianNs));
+		}
+		r.madPercent = r.medianNs > 0.0 ? 100.0 * Median(deviations) / r.medianNs : 0.0;
+		r.nsPerItem = c.items > 0 ? r.medianNs / static_cast<double>(c.items) : r.medianNs;
+
+		return r;
+	}
+
+	int MicroBench::Run(const MicroBenchConfig& config)
+	{
+		// Zones inside the measured code would otherwise be part of the timings
+		Profiler::SetEnabled(false);
+
+		// Parallel cases need workers; the application isn't around to start them
+		bool ownsJobSystem = !JobSystem::IsRunning();
+		if (ownsJobSystem)
+		{
+			JobSystem::Init();
+		}
+		uint32_t startThreads = JobSystem::ThreadCount();
+
+		int status = 0;
+
+		// At every thread count the scaling cases use; the application's job system can only be checked as is
+		std::vector<uint32_t> checkCounts = ownsJobSystem ? ScalingThreadCounts() : std::vector<uint32_t>{ startThreads };
+		for (uint32_t threads : checkCounts)
+		{
+			if (ownsJobSystem)
+			{
+				RestartJobSystem(threads);
+			}
+
+			if (!CheckJobSystem())
+			{
+				std::cerr << "Job system checks failed with " << threads << " threads" << std::endl;
+				status = 1;
+			}
+		}
+
+		if (ownsJobSystem)
+		{
+			RestartJobSystem(startThreads);
+		}
+
+		std::vector<Result> baseline;
+		if (!config.baselinePath.empty() && !Load(config.baselinePath, baseline))
+		{
+			std::cerr << "Failed to load baseline " << config.baselinePath << std::endl;
+		}
+
+		std::vector<Result> results;
+
+		printf("%-52s %12s %12s %8s %12s %10s\n", "Case", "Median", "Min", "MAD", "Per item", "Baseline");
+
+		for (const Case& c : BuildCases())
+		{
+			if (!config.filter.empty() && c.name.find(config.filter) == std::string::npos)
+			{
+				continue;
+			}
+
+			uint32_t threads = c.threads > 0 ? c.threads : startThreads;
+			if (threads != JobSystem::ThreadCount())
+			{
+				if (!ownsJobSystem)
+				{
+					printf("%-52s skipped, the job system is the application's\n", c.name.c_str());
+					continue;
+				}
+				RestartJobSystem(threads);
+			}
+
+			Result r = Measure(c);
+			results.push_back(r);
+
+			std::string compare = "-";
+			auto found = std::find_if(baseline.begin(), baseline.end(),
+				[&r](const Result& b) { return b.name == r.name; });
+
+			if (found != baseline.end() && found->medianNs > 0.0)
+			{
+				double delta = r.medianNs / found->medianNs - 1.0;
+
+				char buf[32];
+				snprintf(buf, sizeof(buf), "%+.1f%%", delta * 100.0);
+				compare = buf;
+
+				if (delta > config.tolerance)
+				{
+					compare += " REGRESSED";
+					status = 1;
+				}
+			}
+
+			printf("%-52s %12s %12s %7.1f%% %12s %10s\n", r.name.c_str(),
+				FormatTime(r.medianNs).c_str(), FormatTime(r.minNs).c_str(),
+				r.madPercent, FormatTime(r.nsPerItem).c_str(), compare.c_str());
+		}
+
+		if (!config.outputPath.empty() && !Save(config.outputPath, results))
+		{
+			std::cerr << "Failed to write results to " << config.outputPath << std::endl;
+		}
+
+		if (ownsJobSystem)
+		{
+			JobSystem::Shutdown();
+		}
+
+		return status;
+	}
+
+	bool MicroBench::Save(const std::string& path, const std::vector<Result>& results)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file.setf(std::ios::fixed);
+		file.precision(3);
+
+		// One case per line so Load doesn't need a JSON parser
+		file << "{\"benchmarks\":[\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& r = results[i];
+			file << "{\"name\":\"" << r.name << "\""
+				<< ",\"medianNs\":" << r.medianNs
+				<< ",\"minNs\":" << r.minNs
+				<< ",\"madPercent\":" << r.madPercent
+				<< ",\"nsPerItem\":" << r.nsPerItem << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		file << "]}\n";
+
+		return file.good();
+	}
+
+	bool MicroBench::Load(const std::string& path, std::vector<Result>& results)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		auto readNumber = [](const std::string& line, const char* key)
+		{
+			size_t at = line.find(key);
+			return at == std::string::npos ? 0.0 : strtod(line.c_str() + at + strlen(key), nullptr);
+		};
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			const char* nameKey = "\"name\":\"";
+			size_t at = line.find(nameKey);
+			if (at == std::string::npos)
+			{
+				continue;
+			}
+
+			size_t begin = at + strlen(nameKey);
+			size_t end = line.find('"', begin);
+			if (end == std::string::npos)
+			{
+				continue;
+			}
+
+			Result r{};
+			r.name = line.substr(begin, end - begin);
+			r.medianNs = readNumber(line, "\"medianNs\":");
+			r.minNs = readNumber(line, "\"minNs\":");
+			r.madPercent = readNumber(line, "\"madPercent\":");
+			r.nsPerItem = readNumber(line, "\"nsPerItem\":");
+			results.push_back(r);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Tendou
+{
+	struct MicroBenchConfig
+	{
+		// Only run cases whose name contains this
+		std::string filter;
+
+		// Results are written here as JSON, empty = don't save
+		std::string outputPath;
+
+		// Saved results to compare against, empty = no comparison
+		std::string baselinePath;
+
+		// A case regresses when its median is this much slower than the baseline
+		double tolerance = 0.10;
+	};
+
+	// CPU-only microbenchmarks for engine hot paths. Nothing here touches
+	// Vulkan or GLFW, so it runs on machines without a GPU or a display.
+	// Tools/MicroBench builds it on its own, without the cases that need Model.
+	class MicroBench
+	{
+	public:
+		// Timed samples per case, the median is what gets reported
+		static constexpr uint32_t SAMPLES = 15;
+
+		// Each sample repeats the case until it runs at least this long
+		static constexpr double MIN_SAMPLE_MS = 20.0;
+
+		// Returns 0, or 1 if a job system check failed or anything regressed against the baseline
+		static int Run(const MicroBenchConfig& config);
+
+	private:
+		struct Case
+		{
+			std::string name;
+
+			// Work per call, used to report time per item
+			uint64_t items;
+
+			// Returns something derived from its work so it can't be optimized out
+			std::function<uint64_t()> func;
+
+			// Threads the job system runs with for this case, 0 = as started
+			uint32_t threads = 0;
+		};
+
+		struct Result
+		{
+			std::string name;
+			double medianNs;
+			double minNs;
+			double madPercent;
+			double nsPerItem;
+		};
+
+		static std::vector<Case> BuildCases();
+		static Result Measure(const Case& c);
+
+		// Thread counts the scaling cases run at: powers of two up to the hardware's, and the hardware's
+		static std::vector<uint32_t> ScalingThreadCounts();
+
+		// Restarts the job system with threads threads in total, 1 = shut down so
+		// everything runs inline. Only valid while Run owns the job system.
+		static void RestartJobSystem(uint32_t threads);
+
+		// Scheduler self-checks: counters, RunAfter continuations, nested waits and
+		// ParallelFor coverage. Timings from a broken scheduler would mean nothing.
+		static bool CheckJobSystem();
+
+		static bool Save(const std::string& path, const std::vector<Result>& results);
+		static bool Load(const std::string& path, std::vector<Result>& results);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tendou
+{
+	namespace
+	{
+		struct Event
+		{
+			std::atomic<const char*> name{ nullptr };
+			std::atomic<uint64_t> start{ 0 };
+			std::atomic<uint64_t> end{ 0 };
+			std::atomic<uint32_t> depth{ 0 };
+		};
+
+		// Single writer (the owning thread), any number of readers.
+		// reserved is bumped before a slot is overwritten and head after,
+		// so a reader can tell which slots changed under it.
+		struct ThreadBuffer
+		{
+			std::atomic<const char*> name{ nullptr };
+			std::atomic<uint32_t> workerIdx{ ~0u };
+			uint32_t tid = 0;
+
+			std::atomic<uint64_t> reserved{ 0 };
+			std::atomic<uint64_t> head{ 0 };
+			std::unique_ptr<Event[]> events{ new Event[Profiler::RING_SIZE] };
+
+			// Owner only
+			const char* stackName[Profiler::MAX_DEPTH] = {};
+			uint64_t stackStart[Profiler::MAX_DEPTH] = {};
+			uint32_t depth = 0;
+
+			// Bit per nested job, set when BeginJob opened a zone for it. Profiling
+			// may be toggled while a job runs, so EndJob must not check again
+			uint64_t jobOpened = 0;
+			uint32_t jobDepth = 0;
+		};
+		static_assert(Profiler::MAX_DEPTH <= 64, "jobOpened holds a bit per depth");
+
+		struct Snapshot
+		{
+			const char* name;
+			uint64_t start;
+			uint64_t end;
+			uint32_t depth;
+		};
+
+		std::mutex registryLock;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		thread_local ThreadBuffer* localBuffer = nullptr;
+
+		std::atomic<uint64_t> frameMarks[Profiler::FRAME_RING_SIZE];
+		std::atomic<uint64_t> frameReserved{ 0 };
+		std::atomic<uint64_t> frameHead{ 0 };
+
+		// Anything that started before this is hidden from the export
+		std::atomic<uint64_t> clearTime{ 0 };
+
+		const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		__inline uint64_t Now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - epoch).count());
+		}
+
+		ThreadBuffer& GetLocalBuffer()
+		{
+			if (!localBuffer)
+			{
+				// Once per thread; buffers outlive their threads so they can still be exported
+				std::lock_guard<std::mutex> l(registryLock);
+				buffers.push_back(std::make_unique<ThreadBuffer>());
+				localBuffer = buffers.back().get();
+				localBuffer->tid = static_cast<uint32_t>(buffers.size());
+			}
+			return *localBuffer;
+		}
+
+		void WriteEscaped(std::ofstream& file, const char* str)
+		{
+			for (const char* c = str; *c; ++c)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					file << '\\';
+				}
+				file << *c;
+			}
+		}
+	}
+
+	std::atomic<bool> Profiler::enabled{ true };
+
+	void Profiler::SetEnabled(bool e)
+	{
+		enabled.store(e, std::memory_order_relaxed);
+	}
+
+	void Profiler::BeginZone(const char* name)
+	{
+		ThreadBuffer& b = GetLocalBuffer();
+		if (b.depth < MAX_DEPTH)
+		{
+			b.stackName[b.depth] = name;
+			b.stackStart[b.depth] = Now();
+		}
+		++b.depth;
+	}
+
+	void Profiler::EndZone()
+	{
+		ThreadBuffer& b = GetLocalBuffer();
+		if (b.depth == 0)
+		{
+			return;
+		}
+
+		--b.depth;
+		if (b.depth >= MAX_DEPTH)
+		{
+			return;
+		}
+
+		uint64_t end = Now();
+		uint64_t idx = b.head.load(std::memory_order_relaxed);
+
+		b.reserved.store(idx + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Event& e = b.events[idx & (RING_SIZE - 1)];
+		e.name.store(b.stackName[b.depth], std::memory_order_relaxed);
+		e.start.store(b.stackStart[b.depth], std::memory_order_relaxed);
+		e.end.store(end, std::memory_order_relaxed);
+		e.depth.store(b.depth, std::memory_order_relaxed);
+
+		b.head.store(idx + 1, std::memory_order_release);
+	}
+
+	void Profiler::FrameMark()
+	{
+		if (!IsEnabled())
+		{
+			return;
+		}
+
+		uint64_t idx = frameHead.load(std::memory_order_relaxed);
+
+		frameReserved.store(idx + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		frameMarks[idx & (FRAME_RING_SIZE - 1)].store(Now(), std::memory_order_relaxed);
+		frameHead.store(idx + 1, std::memory_order_release);
+	}
+
+	void Profiler::SetThreadName(const char* name)
+	{
+		GetLocalBuffer().name.store(name, std::memory_order_relaxed);
+	}
+
+	void Profiler::BeginJob(const char* name, uint32_t threadIdx)
+	{
+		ThreadBuffer& b = GetLocalBuffer();
+		uint32_t bit = b.jobDepth++;
+		if (bit >= MAX_DEPTH)
+		{
+			return;
+		}
+
+		b.jobOpened &= ~(1ull << bit);
+		if (!IsEnabled())
+		{
+			return;
+		}
+
+		b.jobOpened |= 1ull << bit;
+		b.workerIdx.store(threadIdx, std::memory_order_relaxed);
+		BeginZone(name ? name : "Job");
+	}
+
+	void Profiler::EndJob(const char*, uint32_t)
+	{
+		ThreadBuffer& b = GetLocalBuffer();
+		if (b.jobDepth == 0)
+		{
+			return;
+		}
+
+		uint32_t bit = --b.jobDepth;
+		if (bit < MAX_DEPTH && (b.jobOpened & (1ull << bit)))
+		{
+			EndZone();
+		}
+	}
+
+	void Profiler::Clear()
+	{
+		clearTime.store(Now(), std::memory_order_relaxed);
+	}
+
+	bool Profiler::ExportTrace(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		uint64_t cutoff = clearTime.load(std::memory_order_relaxed);
+
+		file.setf(std::ios::fixed);
+		file.precision(3);
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Tendou Engine\"}},\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+
+		// Frame track - one bar per frame, from one mark to the next
+		{
+			uint64_t head = frameHead.load(std::memory_order_acquire);
+			uint64_t first = head > FRAME_RING_SIZE ? head - FRAME_RING_SIZE : 0;
+
+			std::vector<uint64_t> marks;
+			marks.reserve(static_cast<size_t>(head - first));
+			for (uint64_t i = first; i < head; ++i)
+			{
+				marks.push_back(frameMarks[i & (FRAME_RING_SIZE - 1)].load(std::memory_order_relaxed));
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t reserved = frameReserved.load(std::memory_order_relaxed);
+			uint64_t valid = reserved > FRAME_RING_SIZE ? reserved - FRAME_RING_SIZE : 0;
+
+			for (uint64_t i = first; i + 1 < head; ++i)
+			{
+				uint64_t start = marks[static_cast<size_t>(i - first)];
+				uint64_t end = marks[static_cast<size_t>(i + 1 - first)];
+				if (i < valid || start < cutoff || end < start)
+				{
+					continue;
+				}
+
+				file << ",\n{\"name\":\"Frame " << i << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+					<< ",\"ts\":" << start / 1e3 << ",\"dur\":" << (end - start) / 1e3 << "}";
+			}
+		}
+
+		std::vector<ThreadBuffer*> threads;
+		{
+			std::lock_guard<std::mutex> l(registryLock);
+			for (auto& b : buffers)
+			{
+				threads.push_back(b.get());
+			}
+		}
+
+		std::vector<Snapshot> events;
+		for (ThreadBuffer* b : threads)
+		{
+			const char* name = b->name.load(std::memory_order_relaxed);
+			uint32_t workerIdx = b->workerIdx.load(std::memory_order_relaxed);
+
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid << ",\"args\":{\"name\":\"";
+			if (name)
+			{
+				WriteEscaped(file, name);
+			}
+			else if (workerIdx != ~0u)
+			{
+				file << "Worker " << workerIdx;
+			}
+			else
+			{
+				file << "Thread " << b->tid;
+			}
+			file << "\"}}";
+
+			uint64_t head = b->head.load(std::memory_order_acquire);
+			uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+
+			events.clear();
+			events.reserve(static_cast<size_t>(head - first));
+			for (uint64_t i = first; i < head; ++i)
+			{
+				const Event& e = b->events[i & (RING_SIZE - 1)];
+				events.push_back({
+					e.name.load(std::memory_order_relaxed),
+					e.start.load(std::memory_order_relaxed),
+					e.end.load(std::memory_order_relaxed),
+					e.depth.load(std::memory_order_relaxed) });
+			}
+
+			// Slots the owner started overwriting while we copied are garbage
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t reserved = b->reserved.load(std::memory_order_relaxed);
+			uint64_t valid = reserved > RING_SIZE ? reserved - RING_SIZE : 0;
+
+			for (uint64_t i = std::max(first, valid); i < head; ++i)
+			{
+				const Snapshot& e = events[static_cast<size_t>(i - first)];
+				if (!e.name || e.start < cutoff || e.end < e.start)
+				{
+					continue;
+				}
+
+				file << ",\n{\"name\":\"";
+				WriteEscaped(file, e.name);
+				file << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+					<< ",\"ts\":" << e.start / 1e3 << ",\"dur\":" << (e.end - e.start) / 1e3
+					<< ",\"args\":{\"depth\":" << e.depth << "}}";
+			}
+		}
+
+		file << "\n]}\n";
+		return file.good();
+	}
+}
\ No newline at end of file
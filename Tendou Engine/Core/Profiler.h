@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Set to 0 to compile every zone macro out entirely
+#ifndef TENDOU_PROFILING
+#define TENDOU_PROFILING 1
+#endif
+
+#define TENDOU_PROFILE_CONCAT_INNER(a, b) a##b
+#define TENDOU_PROFILE_CONCAT(a, b) TENDOU_PROFILE_CONCAT_INNER(a, b)
+
+#if TENDOU_PROFILING
+// name must have static storage duration (a string literal, __FUNCTION__, ...)
+#define TENDOU_PROFILE_SCOPE(name) ::Tendou::ProfileZone TENDOU_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define TENDOU_PROFILE_FUNCTION() TENDOU_PROFILE_SCOPE(__FUNCTION__)
+#define TENDOU_PROFILE_FRAME() ::Tendou::Profiler::FrameMark()
+#else
+#define TENDOU_PROFILE_SCOPE(name)
+#define TENDOU_PROFILE_FUNCTION()
+#define TENDOU_PROFILE_FRAME()
+#endif
+
+namespace Tendou
+{
+	// CPU zone profiler.
+	// Every thread writes finished zones into its own fixed-size ring, so
+	// recording never takes a lock; the exporter reads the rings from the
+	// outside and drops anything that was overwritten while it was reading.
+	// When disabled, a zone costs one relaxed atomic load.
+	class Profiler
+	{
+	public:
+		// Zones kept per thread; older ones are overwritten
+		static constexpr uint32_t RING_SIZE = 1 << 14;
+
+		// Frame boundaries kept for the frame track
+		static constexpr uint32_t FRAME_RING_SIZE = 1 << 10;
+
+		// Zones nested deeper than this on one thread are dropped
+		static constexpr uint32_t MAX_DEPTH = 64;
+
+		__inline static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+		static void SetEnabled(bool e);
+
+		static void BeginZone(const char* name);
+		static void EndZone();
+
+		// Start of a new frame on the timeline
+		static void FrameMark();
+
+		// Label for the calling thread's track, must have static storage duration
+		static void SetThreadName(const char* name);
+
+		// Matches JobSystem::ProfileHook so jobs show up on the worker tracks.
+		// EndJob closes a zone only if the matching BeginJob opened one
+		static void BeginJob(const char* name, uint32_t threadIdx);
+		static void EndJob(const char* name, uint32_t threadIdx);
+
+		// Chrome trace event JSON; loads in chrome://tracing and ui.perfetto.dev
+		static bool ExportTrace(const std::string& path);
+
+		// Drops everything recorded so far
+		static void Clear();
+
+	private:
+		static std::atomic<bool> enabled;
+	};
+
+	class ProfileZone
+	{
+	public:
+		__inline explicit ProfileZone(const char* name)
+			: active(Profiler::IsEnabled())
+		{
+			if (active)
+			{
+				Profiler::BeginZone(name);
+			}
+		}
+
+		__inline ~ProfileZone()
+		{
+			if (active)
+			{
+				Profiler::EndZone();
+			}
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		bool active;
+	};
+}
+
+#endif
\ No newline at end of file
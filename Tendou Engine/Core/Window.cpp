@@ -9,18 +9,25 @@
 namespace Tendou
 {
 
-	Window::Window(int w, int h, std::string name)
+	Window::Window(int w, int h, std::string name, bool headless_)
 		: width(w)
 		, height(h)
+		, headless(headless_)
 		, windowName(name)
 	{
-		InitWindow();
+		if (!headless)
+		{
+			InitWindow();
+		}
 	}
 
 	Window::~Window()
 	{
-		glfwDestroyWindow(window);
-		glfwTerminate();
+		if (!headless)
+		{
+			glfwDestroyWindow(window);
+			glfwTerminate();
+		}
 	}
 
 	void Window::InitWindow()
@@ -41,6 +48,11 @@ namespace Tendou
 
 	void Window::CreateWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
 	{
+		if (headless)
+		{
+			throw std::runtime_error("Headless windows don't have a surface!");
+		}
+
 		if (glfwCreateWindowSurface(instance, window, nullptr, surface) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create window surface!");
@@ -11,14 +11,18 @@ namespace Tendou
 	class Window
 	{
 	public:
-		Window(int w, int h, std::string name);
+		// A headless window never touches GLFW; it only carries the extent and
+		// the close request, so the rest of the engine can run without a display
+		Window(int w, int h, std::string name, bool headless = false);
 		~Window();
 
 		Window(const Window&) = delete;
 		Window& operator=(const Window&) = delete;
 
-		__inline bool ShouldClose() { return glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS 
-			&& glfwWindowShouldClose(window) == 0; };
+		__inline bool ShouldClose() { return headless ? !closeRequested : glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS
+			&& glfwWindowShouldClose(window) == 0 && !closeRequested; };
+		__inline void RequestClose() { closeRequested = true; }
+		__inline bool IsHeadless() { return headless; }
 		__inline VkExtent2D GetExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
 		__inline bool WasWindowResized() { return frameBufferResized; }
 		__inline void ResetWindowResizedFlag() { frameBufferResized = false; }
@@ -33,9 +37,11 @@ namespace Tendou
 		int width;
 		int height;
 		bool frameBufferResized = false;
+		bool headless = false;
+		bool closeRequested = false;
 
 		std::string windowName;
-		GLFWwindow* window;
+		GLFWwindow* window = nullptr;
 	};
 }
 
@@ -1,5 +1,8 @@
 #include "Editor.h"
 
+#include "../Core/Profiler.h"
+#include "../Rendering/GeometryArena.h"
+
 #include <stdexcept>
 #include <array>
 #include <cassert>
@@ -99,9 +102,53 @@ namespace Tendou
 				}
 				ImGui::EndMenu();
 			}
+			if (ImGui::BeginMenu("Tools"))
+			{
+				ImGui::MenuItem("GPU Profiler", nullptr, &showGPUProfiler);
+				ImGui::MenuItem("Frame Pacing", nullptr, &showFramePacing);
+				ImGui::MenuItem("Dynamic Resolution", nullptr, &showDynamicResolution);
+				ImGui::MenuItem("Geometry Arena", nullptr, &showGeometryArena);
+				ImGui::MenuItem("Command Cache", nullptr, &showCommandCache);
+
+				bool cpuProfiling = Profiler::IsEnabled();
+				if (ImGui::MenuItem("CPU Profiling", nullptr, &cpuProfiling))
+				{
+					Profiler::SetEnabled(cpuProfiling);
+				}
+				if (ImGui::MenuItem("Export CPU Trace"))
+				{
+					Profiler::ExportTrace("cpu_trace.json");
+				}
+				ImGui::EndMenu();
+			}
 			activeScene->PreUpdate();
 			ImGui::EndMainMenuBar();
 		}
+
+		if (showGPUProfiler)
+		{
+			activeScene->GetGPUProfiler()->DrawPanel(&showGPUProfiler);
+		}
+
+		if (showFramePacing)
+		{
+			activeScene->GetFramePacer()->DrawPanel(activeScene->GetSwapChain()->PresentMode(), &showFramePacing);
+		}
+
+		if (showDynamicResolution)
+		{
+			activeScene->GetDynamicResolution()->DrawPanel(&showDynamicResolution);
+		}
+
+		if (showGeometryArena)
+		{
+			td.Geometry().DrawPanel(&showGeometryArena);
+		}
+
+		if (showCommandCache)
+		{
+			activeScene->GetCommandCache()->DrawPanel(&showCommandCache);
+		}
 		
 		// DEMO WINDOW
 		// TODO: Remove this when you don't need it anymore
@@ -21,6 +21,12 @@ namespace Tendou
 		VkDescriptorPool imguiPool;
 		TendouDevice& td;
 		Scene* activeScene;
+
+		bool showGPUProfiler = true;
+		bool showFramePacing = false;
+		bool showDynamicResolution = false;
+		bool showGeometryArena = false;
+		bool showCommandCache = false;
 	};
 }
 
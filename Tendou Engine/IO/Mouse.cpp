@@ -32,8 +32,9 @@ namespace Tendou
 			firstMouse = false;
 		}
 
-		dx = x - lastX;
-		dy = lastY - y;
+		// Summed until read, frames without a simulation step mustn't lose movement
+		dx += x - lastX;
+		dy += lastY - y;
 		lastX = x;
 		lastY = y;
 	}
@@ -57,8 +58,8 @@ namespace Tendou
 
 	void Mouse::MouseWheelCallback(GLFWwindow* window, double dx, double dy)
 	{
-		scrollDX = dx;
-		scrollDY = dy;
+		scrollDX += dx;
+		scrollDY += dy;
 	}
 
 
@@ -86,6 +87,16 @@ namespace Tendou
 		return dy_;
 	}
 
+	double Mouse::PeekDX()
+	{
+		return dx;
+	}
+
+	double Mouse::PeekDY()
+	{
+		return dy;
+	}
+
 	double Mouse::GetScrollDX()
 	{
 		double dx = scrollDX;
@@ -18,6 +18,10 @@ namespace Tendou
 		static double GetDX();
 		static double GetDY();
 
+		// Movement since the last GetDX/GetDY, left for them to read
+		static double PeekDX();
+		static double PeekDY();
+
 		static double GetScrollDX();
 		static double GetScrollDY();
 
@@ -26,9 +26,13 @@ layout (binding = 3) uniform LightPass
 
 void main()
 {
-	vec3 fragPos = texture(gPos, outTex).rgb;
-	vec3 normal = texture(gNorm, outTex).rgb;
-	vec4 albedo = texture(gAlbedo, outTex);
+	// Only part of the G-buffer is rendered at reduced resolution, and this
+	// pass has the same viewport, so address it by pixel rather than by outTex
+	vec2 uv = gl_FragCoord.xy / vec2(textureSize(gPos, 0));
+
+	vec3 fragPos = texture(gPos, uv).rgb;
+	vec3 normal = texture(gNorm, uv).rgb;
+	vec4 albedo = texture(gAlbedo, uv);
 	
 	if (lightPass.displayTarget > 0)
 	{
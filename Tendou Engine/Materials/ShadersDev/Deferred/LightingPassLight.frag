@@ -20,9 +20,11 @@ layout(push_constant) uniform Push
 
 void main()
 {
-	vec3 fragPos = texture(gPos, gl_FragCoord.xy / vec2(1280, 720)).rgb;
-	vec3 normal = texture(gNorm, gl_FragCoord.xy / vec2(1280, 720)).rgb;
-	vec4 albedo = texture(gAlbedo, gl_FragCoord.xy / vec2(1280, 720));
+	vec2 uv = gl_FragCoord.xy / vec2(textureSize(gPos, 0));
+
+	vec3 fragPos = texture(gPos, uv).rgb;
+	vec3 normal = texture(gNorm, uv).rgb;
+	vec4 albedo = texture(gAlbedo, uv);
 	
 	vec3 L = push.pos.xyz - fragPos;
 	float dist = length(L);
@@ -3,7 +3,6 @@
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inUV;
-layout (location = 3) in vec3 inColor;
 layout (location = 4) in vec4 inTangent;
 
 layout (set = 0, binding = 0) uniform UBOScene 
@@ -14,8 +13,10 @@ layout (set = 0, binding = 0) uniform UBOScene
 	vec4 viewPos;
 } uboScene;
 
+// model includes the mesh's dequantization, uvTransform the primitive's
 layout(push_constant) uniform PushConsts {
 	mat4 model;
+	vec4 uvTransform;
 } primitive;
 
 layout (location = 0) out vec3 outNormal;
@@ -28,12 +29,13 @@ layout (location = 5) out vec4 outTangent;
 void main() 
 {
 	outNormal = inNormal;
-	outColor = inColor;
-	outUV = inUV;
+	outColor = vec3(1.0);
+	outUV = inUV * primitive.uvTransform.xy + primitive.uvTransform.zw;
 	outTangent = inTangent;
 	gl_Position = uboScene.projection * uboScene.view * primitive.model * vec4(inPos.xyz, 1.0);
 	
-	outNormal = mat3(primitive.model) * inNormal;
+	// The dequantization scale would otherwise stretch the normal
+	outNormal = normalize(mat3(primitive.model) * inNormal);
 	vec4 pos = primitive.model * vec4(inPos, 1.0);
 	outLightVec = uboScene.lightPos.xyz - pos.xyz;
 	outViewVec = uboScene.viewPos.xyz - pos.xyz;
@@ -0,0 +1,64 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Every texture of the scene, indexed through the material table
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+struct Material
+{
+	uint colorTexture;
+	uint normalTexture;
+	float alphaCutoff;
+	uint pad;
+};
+
+layout (std430, set = 2, binding = 0) readonly buffer Materials
+{
+	Material materials[];
+};
+
+// Shared with the vertex stage; constant across a draw, so indexing with it stays uniform
+layout(push_constant) uniform PushConsts {
+	mat4 model;
+	vec4 uvTransform;
+	uint materialIndex;
+} primitive;
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec3 inColor;
+layout (location = 2) in vec2 inUV;
+layout (location = 3) in vec3 inViewVec;
+layout (location = 4) in vec3 inLightVec;
+layout (location = 5) in vec4 inTangent;
+
+layout (location = 0) out vec4 outFragColor;
+
+layout (constant_id = 0) const bool ALPHA_MASK = false;
+
+void main() 
+{
+	Material material = materials[primitive.materialIndex];
+	vec4 color = texture(textures[material.colorTexture], inUV) * vec4(inColor, 1.0);
+
+	if (ALPHA_MASK) {
+		if (color.a < material.alphaCutoff) {
+			discard;
+		}
+	}
+
+	vec3 N = normalize(inNormal);
+	vec3 T = normalize(inTangent.xyz);
+	vec3 B = cross(inNormal, inTangent.xyz) * inTangent.w;
+	mat3 TBN = mat3(T, B, N);
+	// Normal maps are cooked to BC5, which only keeps XY
+	vec2 nXY = texture(textures[material.normalTexture], inUV).xy * 2.0 - vec2(1.0);
+	N = TBN * normalize(vec3(nXY, sqrt(max(1.0 - dot(nXY, nXY), 0.0))));
+
+	const float ambient = 0.1;
+	vec3 L = normalize(inLightVec);
+	vec3 V = normalize(inViewVec);
+	vec3 R = reflect(-L, N);
+	vec3 diffuse = max(dot(N, L), ambient).rrr;
+	float specular = pow(max(dot(R, V), 0.0), 32.0);
+	outFragColor = vec4(color.rgb, color.a);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 450
+
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+layout (location = 4) in vec4 inTangent;
+
+layout (set = 0, binding = 0) uniform UBOScene 
+{
+	mat4 projection;
+	mat4 view;
+	vec4 lightPos;
+	vec4 viewPos;
+} uboScene;
+
+// model includes the mesh's dequantization, uvTransform the primitive's
+layout(push_constant) uniform PushConsts {
+	mat4 model;
+	vec4 uvTransform;
+	uint materialIndex;
+} primitive;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+layout (location = 3) out vec3 outViewVec;
+layout (location = 4) out vec3 outLightVec;
+layout (location = 5) out vec4 outTangent;
+
+void main() 
+{
+	outNormal = inNormal;
+	outColor = vec3(1.0);
+	outUV = inUV * primitive.uvTransform.xy + primitive.uvTransform.zw;
+	outTangent = inTangent;
+	gl_Position = uboScene.projection * uboScene.view * primitive.model * vec4(inPos.xyz, 1.0);
+	
+	// The dequantization scale would otherwise stretch the normal
+	outNormal = normalize(mat3(primitive.model) * inNormal);
+	vec4 pos = primitive.model * vec4(inPos, 1.0);
+	outLightVec = uboScene.lightPos.xyz - pos.xyz;
+	outViewVec = uboScene.viewPos.xyz - pos.xyz;
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_multiview : require
 
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
@@ -15,16 +16,19 @@ layout(set = 0, binding = 0) uniform WorldUBO
 	vec2 nearFar;
 } worldUBO;
 
-layout(set = 0, binding = 5) uniform RenderUBO
+// One view per cubemap face. Multiview passes render consecutive faces
+// starting at faceBase, single face passes only have view 0.
+layout(set = 0, binding = 5) uniform CaptureUBO
 {
 	mat4 proj;
-	mat4 view;
+	mat4 views[6];
 } captureUBO;
 
 layout(push_constant) uniform Push
 {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
+	uint faceBase;
 } push;
 
 void main()
@@ -32,7 +36,7 @@ void main()
 	vec4 viewPos = push.modelMatrix * vec4(aPos, 1.0);
 	
 	// TODO: View calculation is expensive. Do it on the CPU
-	gl_Position = captureUBO.proj * mat4(mat3(captureUBO.view)) * viewPos;
+	gl_Position = captureUBO.proj * mat4(mat3(captureUBO.views[push.faceBase + gl_ViewIndex])) * viewPos;
 	
 	fragPos = aPos;
 	texCoords = aTexCoord;
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_multiview : require
 
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
@@ -15,23 +16,26 @@ layout(set = 0, binding = 0) uniform WorldUBO
 	mat4 view;
 } worldUBO;
 
-layout(set = 0, binding = 5) uniform RenderUBO
+// One view per cubemap face. Multiview passes render consecutive faces
+// starting at faceBase, single face passes only have view 0.
+layout(set = 0, binding = 5) uniform CaptureUBO
 {
 	mat4 proj;
-	mat4 view;
+	mat4 views[6];
 } captureUBO;
 
 layout(push_constant) uniform Push
 {
 	mat4 modelMatrix; // projection * view * model
 	mat4 normalMatrix;
+	uint faceBase;
 } push;
 
 
 void main()
 {
 	vec4 viewPos = push.modelMatrix * vec4(aPos, 1.0);
-	gl_Position = captureUBO.proj * captureUBO.view * viewPos;
+	gl_Position = captureUBO.proj * captureUBO.views[push.faceBase + gl_ViewIndex] * viewPos;
 	
 	fragNormalWorld = normalize(mat3(push.normalMatrix) * aNormal);
 	fragPosWorld = viewPos.xyz;
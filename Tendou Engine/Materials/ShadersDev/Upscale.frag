@@ -0,0 +1,21 @@
+#version 450
+
+layout (binding = 0) uniform sampler2D source;
+
+layout (location = 0) in vec2 outTex;
+
+layout (location = 0) out vec4 fragColor;
+
+// The source is allocated at its largest size and only the top-left
+// uvScale part of it was rendered this frame
+layout (push_constant) uniform Push
+{
+	vec2 uvScale;
+	vec2 uvMax;
+} push;
+
+void main()
+{
+	vec2 uv = min(outTex * push.uvScale, push.uvMax);
+	fragColor = vec4(texture(source, uv).rgb, 1.0f);
+}
\ No newline at end of file
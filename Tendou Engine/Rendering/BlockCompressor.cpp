@@ -0,0 +1,523 @@
+#include "BlockCompressor.h"
+
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace Tendou
+{
+	namespace
+	{
+		constexpr uint32_t BLOCK_TEXELS = 16;
+
+		// BC7 interpolation weights for 4 bit indices
+		constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		struct BitWriter
+		{
+			uint8_t* out;
+			uint32_t pos = 0;
+
+			void Write(uint32_t value, uint32_t bits)
+			{
+				for (uint32_t b = 0; b < bits; ++b, ++pos)
+				{
+					if ((value >> b) & 1)
+					{
+						out[pos >> 3] |= static_cast<uint8_t>(1 << (pos & 7));
+					}
+				}
+			}
+		};
+
+		// Endpoints of the block's spread along its principal axis, for the
+		// first N channels. Falls back to the bounding box diagonal for flat blocks.
+		template <uint32_t N>
+		void FitEndpoints(const uint8_t* block, float (&lo)[N], float (&hi)[N])
+		{
+			float mean[N] = {};
+			float minC[N], maxC[N];
+			for (uint32_t c = 0; c < N; ++c)
+			{
+				minC[c] = 255.0f;
+				maxC[c] = 0.0f;
+			}
+
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				for (uint32_t c = 0; c < N; ++c)
+				{
+					float v = block[i * 4 + c];
+					mean[c] += v;
+					minC[c] = std::min(minC[c], v);
+					maxC[c] = std::max(maxC[c], v);
+				}
+			}
+
+			for (uint32_t c = 0; c < N; ++c)
+			{
+				mean[c] /= BLOCK_TEXELS;
+			}
+
+			float cov[N][N] = {};
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				float d[N];
+				for (uint32_t c = 0; c < N; ++c)
+				{
+					d[c] = block[i * 4 + c] - mean[c];
+				}
+				for (uint32_t a = 0; a < N; ++a)
+				{
+					for (uint32_t b = 0; b < N; ++b)
+					{
+						cov[a][b] += d[a] * d[b];
+					}
+				}
+			}
+
+			// Power iteration, seeded with the bounding box diagonal
+			float axis[N];
+			for (uint32_t c = 0; c < N; ++c)
+			{
+				axis[c] = maxC[c] - minC[c];
+			}
+
+			for (uint32_t iter = 0; iter < 8; ++iter)
+			{
+				float next[N] = {};
+				float len = 0.0f;
+				for (uint32_t a = 0; a < N; ++a)
+				{
+					for (uint32_t b = 0; b < N; ++b)
+					{
+						next[a] += cov[a][b] * axis[b];
+					}
+					len = std::max(len, std::abs(next[a]));
+				}
+
+				if (len < 1e-6f)
+				{
+					break;
+				}
+
+				for (uint32_t c = 0; c < N; ++c)
+				{
+					axis[c] = next[c] / len;
+				}
+			}
+
+			float len2 = 0.0f;
+			for (uint32_t c = 0; c < N; ++c)
+			{
+				len2 += axis[c] * axis[c];
+			}
+
+			if (len2 < 1e-6f)
+			{
+				for (uint32_t c = 0; c < N; ++c)
+				{
+					lo[c] = minC[c];
+					hi[c] = maxC[c];
+				}
+				return;
+			}
+
+			float minT = 0.0f, maxT = 0.0f;
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < N; ++c)
+				{
+					t += (block[i * 4 + c] - mean[c]) * axis[c];
+				}
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+
+			for (uint32_t c = 0; c < N; ++c)
+			{
+				lo[c] = std::clamp(mean[c] + axis[c] * minT / len2, 0.0f, 255.0f);
+				hi[c] = std::clamp(mean[c] + axis[c] * maxT / len2, 0.0f, 255.0f);
+			}
+		}
+
+		uint16_t Pack565(const float (&c)[3])
+		{
+			uint32_t r = static_cast<uint32_t>(c[0] * 31.0f / 255.0f + 0.5f);
+			uint32_t g = static_cast<uint32_t>(c[1] * 63.0f / 255.0f + 0.5f);
+			uint32_t b = static_cast<uint32_t>(c[2] * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void Unpack565(uint16_t c, int (&out)[3])
+		{
+			int r = (c >> 11) & 31;
+			int g = (c >> 5) & 63;
+			int b = c & 31;
+			out[0] = (r << 3) | (r >> 2);
+			out[1] = (g << 2) | (g >> 4);
+			out[2] = (b << 3) | (b >> 2);
+		}
+
+		void WriteLE16(uint8_t* out, uint16_t v)
+		{
+			out[0] = static_cast<uint8_t>(v);
+			out[1] = static_cast<uint8_t>(v >> 8);
+		}
+
+		// 7 bit endpoint + shared p-bit, picking the p-bit that lands closest
+		void QuantizeBC7Endpoint(const float (&e)[4], uint32_t (&q)[4], uint32_t& pbit)
+		{
+			float bestErr = 1e30f;
+			for (uint32_t p = 0; p < 2; ++p)
+			{
+				uint32_t candidate[4];
+				float err = 0.0f;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					int v = static_cast<int>(std::lround((e[c] - p) * 0.5f));
+					candidate[c] = static_cast<uint32_t>(std::clamp(v, 0, 127));
+					float d = static_cast<float>((candidate[c] << 1) | p) - e[c];
+					err += d * d;
+				}
+
+				if (err < bestErr)
+				{
+					bestErr = err;
+					pbit = p;
+					std::copy(candidate, candidate + 4, q);
+				}
+			}
+		}
+
+		void GatherBlock(const uint8_t* src, uint32_t width, uint32_t height,
+			uint32_t bx, uint32_t by, uint8_t* block)
+		{
+			// Partial edge blocks repeat the last row/column
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				uint32_t sy = std::min(by * 4 + y, height - 1);
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					uint32_t sx = std::min(bx * 4 + x, width - 1);
+					std::memcpy(block + (y * 4 + x) * 4, src + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+				}
+			}
+		}
+	}
+
+	void BlockCompressor::EncodeBC1(const uint8_t* block, uint8_t* out)
+	{
+		float lo[3], hi[3];
+		FitEndpoints<3>(block, lo, hi);
+
+		uint16_t c0 = Pack565(hi);
+		uint16_t c1 = Pack565(lo);
+
+		// c0 > c1 selects four color mode, which BC3 assumes as well
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+		}
+
+		WriteLE16(out, c0);
+		WriteLE16(out + 2, c1);
+
+		uint32_t indices = 0;
+		if (c0 != c1)
+		{
+			int palette[4][3];
+			Unpack565(c0, palette[0]);
+			Unpack565(c1, palette[1]);
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				uint32_t best = 0;
+				int bestErr = 1 << 30;
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					int err = 0;
+					for (uint32_t c = 0; c < 3; ++c)
+					{
+						int d = block[i * 4 + c] - palette[p][c];
+						err += d * d;
+					}
+					if (err < bestErr)
+					{
+						bestErr = err;
+						best = p;
+					}
+				}
+				indices |= best << (i * 2);
+			}
+		}
+
+		out[4] = static_cast<uint8_t>(indices);
+		out[5] = static_cast<uint8_t>(indices >> 8);
+		out[6] = static_cast<uint8_t>(indices >> 16);
+		out[7] = static_cast<uint8_t>(indices >> 24);
+	}
+
+	void BlockCompressor::EncodeBC3(const uint8_t* block, uint8_t* out)
+	{
+		EncodeBC4(block, 3, out);
+		EncodeBC1(block, out + 8);
+	}
+
+	void BlockCompressor::EncodeBC4(const uint8_t* block, uint32_t channel, uint8_t* out)
+	{
+		int lo = 255, hi = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int v = block[i * 4 + channel];
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+		}
+
+		// hi > lo selects the eight value mode
+		out[0] = static_cast<uint8_t>(hi);
+		out[1] = static_cast<uint8_t>(lo);
+
+		uint64_t indices = 0;
+		if (hi != lo)
+		{
+			int palette[8];
+			palette[0] = hi;
+			palette[1] = lo;
+			for (int p = 2; p < 8; ++p)
+			{
+				palette[p] = ((8 - p) * hi + (p - 1) * lo) / 7;
+			}
+
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				int v = block[i * 4 + channel];
+				uint64_t best = 0;
+				int bestErr = 1 << 30;
+				for (uint32_t p = 0; p < 8; ++p)
+				{
+					int err = std::abs(v - palette[p]);
+					if (err < bestErr)
+					{
+						bestErr = err;
+						best = p;
+					}
+				}
+				indices |= best << (i * 3);
+			}
+		}
+
+		for (uint32_t b = 0; b < 6; ++b)
+		{
+			out[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+		}
+	}
+
+	void BlockCompressor::EncodeBC5(const uint8_t* block, uint8_t* out)
+	{
+		EncodeBC4(block, 0, out);
+		EncodeBC4(block, 1, out + 8);
+	}
+
+	void BlockCompressor::EncodeBC7(const uint8_t* block, uint8_t* out)
+	{
+		float lo[4], hi[4];
+		FitEndpoints<4>(block, lo, hi);
+
+		uint32_t q[2][4];
+		uint32_t pbit[2];
+		QuantizeBC7Endpoint(lo, q[0], pbit[0]);
+		QuantizeBC7Endpoint(hi, q[1], pbit[1]);
+
+		int e[2][4];
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				e[i][c] = static_cast<int>((q[i][c] << 1) | pbit[i]);
+			}
+		}
+
+		int palette[16][4];
+		for (uint32_t p = 0; p < 16; ++p)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				palette[p][c] = ((64 - BC7_WEIGHTS[p]) * e[0][c] + BC7_WEIGHTS[p] * e[1][c] + 32) >> 6;
+			}
+		}
+
+		uint32_t indices[BLOCK_TEXELS];
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			uint32_t best = 0;
+			int bestErr = 1 << 30;
+			for (uint32_t p = 0; p < 16; ++p)
+			{
+				int err = 0;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					int d = block[i * 4 + c] - palette[p][c];
+					err += d * d;
+				}
+				if (err < bestErr)
+				{
+					bestErr = err;
+					best = p;
+				}
+			}
+			indices[i] = best;
+		}
+
+		// The first index drops its top bit, so it has to be in the lower half
+		if (indices[0] & 8)
+		{
+			std::swap(q[0], q[1]);
+			std::swap(pbit[0], pbit[1]);
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		std::memset(out, 0, 16);
+		BitWriter bits{ out };
+
+		bits.Write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			bits.Write(q[0][c], 7);
+			bits.Write(q[1][c], 7);
+		}
+		bits.Write(pbit[0], 1);
+		bits.Write(pbit[1], 1);
+
+		bits.Write(indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_TEXELS; ++i)
+		{
+			bits.Write(indices[i], 4);
+		}
+	}
+
+	bool BlockCompressor::IsCompressed(VkFormat format)
+	{
+		return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	uint32_t BlockCompressor::BlockSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return 8;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	VkDeviceSize BlockCompressor::LevelSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		if (IsCompressed(format))
+		{
+			return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+		}
+		return static_cast<VkDeviceSize>(width) * height * BlockSize(format);
+	}
+
+	MipChain BlockCompressor::Compress(const MipChain& rgba, VkFormat format)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		void (*encode)(const uint8_t*, uint8_t*) = nullptr;
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			encode = &EncodeBC1;
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			encode = &EncodeBC3;
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			encode = [](const uint8_t* block, uint8_t* out) { EncodeBC4(block, 0, out); };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			encode = &EncodeBC5;
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			encode = &EncodeBC7;
+			break;
+		default:
+			throw std::runtime_error("Failed to compress texture, unsupported block format!");
+		}
+
+		MipChain out;
+		out.width = rgba.width;
+		out.height = rgba.height;
+		out.format = format;
+		out.offsets.resize(rgba.LevelCount());
+
+		VkDeviceSize total = 0;
+		for (uint32_t i = 0; i < rgba.LevelCount(); ++i)
+		{
+			out.offsets[i] = total;
+			total += LevelSize(format, std::max(rgba.width >> i, 1u), std::max(rgba.height >> i, 1u));
+		}
+		out.data.resize(static_cast<size_t>(total));
+
+		uint32_t blockSize = BlockSize(format);
+		for (uint32_t i = 0; i < rgba.LevelCount(); ++i)
+		{
+			uint32_t w = std::max(rgba.width >> i, 1u);
+			uint32_t h = std::max(rgba.height >> i, 1u);
+			uint32_t blocksX = (w + 3) / 4;
+			uint32_t blocksY = (h + 3) / 4;
+
+			const uint8_t* src = rgba.data.data() + rgba.offsets[i];
+			uint8_t* dst = out.data.data() + out.offsets[i];
+
+			JobSystem::ParallelFor(blocksY, 8, [=](uint32_t begin, uint32_t end)
+				{
+					uint8_t block[BLOCK_TEXELS * 4];
+					for (uint32_t by = begin; by < end; ++by)
+					{
+						for (uint32_t bx = 0; bx < blocksX; ++bx)
+						{
+							GatherBlock(src, w, h, bx, by, block);
+							encode(block, dst + (static_cast<size_t>(by) * blocksX + bx) * blockSize);
+						}
+					}
+				}, "BlockCompress");
+		}
+
+		return out;
+	}
+}
\ No newline at end of file
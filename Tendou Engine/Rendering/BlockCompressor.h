@@ -0,0 +1,46 @@
+#ifndef BLOCKCOMPRESSOR_H
+#define BLOCKCOMPRESSOR_H
+
+#include "Texture.h"
+
+#include <cstdint>
+
+namespace Tendou
+{
+	// CPU encoders for the BCn formats the texture cooker writes.
+	// Every encoder takes one 4x4 block of RGBA8 texels, row major, and
+	// writes BlockSize() bytes. Quality sits between "fast" and "normal"
+	// presets of the usual offline tools: endpoints come from the block's
+	// principal axis, indices from a nearest-palette search.
+	class BlockCompressor
+	{
+	public:
+		// RGB, 1 bit of alpha ignored; 8 bytes
+		static void EncodeBC1(const uint8_t* block, uint8_t* out);
+
+		// BC1 color + BC4 alpha; 16 bytes
+		static void EncodeBC3(const uint8_t* block, uint8_t* out);
+
+		// A single channel; 8 bytes
+		static void EncodeBC4(const uint8_t* block, uint32_t channel, uint8_t* out);
+
+		// Red and green as two BC4 blocks; 16 bytes
+		static void EncodeBC5(const uint8_t* block, uint8_t* out);
+
+		// Mode 6 only (one subset, RGBA, 4 bit indices); 16 bytes
+		static void EncodeBC7(const uint8_t* block, uint8_t* out);
+
+		static bool IsCompressed(VkFormat format);
+
+		// Bytes per 4x4 block, or per texel for uncompressed RGBA8
+		static uint32_t BlockSize(VkFormat format);
+
+		// Bytes one mip level of format takes
+		static VkDeviceSize LevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+		// Encodes every level of an RGBA8 chain into format, split across the job system
+		static MipChain Compress(const MipChain& rgba, VkFormat format);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Camera.h"
 
 #include <cassert>
+#include <cmath>
 #include <limits>
 
 namespace Tendou
@@ -84,6 +85,21 @@ namespace Tendou
 		}
 	}
 
+	void Camera::LookAt(const glm::vec3& target)
+	{
+		glm::vec3 dir = target - cameraPos;
+		if (glm::dot(dir, dir) <= std::numeric_limits<float>::epsilon())
+		{
+			return;
+		}
+
+		dir = glm::normalize(dir);
+		yaw = glm::degrees(std::atan2(dir.z, dir.x));
+		pitch = glm::clamp(glm::degrees(std::asin(dir.y)), -89.0f, 89.0f);
+
+		UpdateCameraVectors();
+	}
+
 	void Camera::UpdateCameraVectors()
 	{
 		glm::vec3 dir;
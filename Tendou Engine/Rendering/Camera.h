@@ -40,6 +40,9 @@ namespace Tendou
 		void UpdateCameraPos(CameraDirection d, double dt);
 		void UpdateCameraZoom(double dy);
 
+		// Points the camera at target, keeping yaw/pitch in sync for mouse look
+		void LookAt(const glm::vec3& target);
+
 		__inline glm::mat4 view() const { return glm::lookAt(cameraPos, cameraPos + front, up); };
 		__inline glm::mat4 perspective() const
 		{
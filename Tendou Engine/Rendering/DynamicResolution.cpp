@@ -0,0 +1,256 @@
+#include "DynamicResolution.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+namespace Tendou
+{
+	DynamicResolution::DynamicResolution(TendouDevice& device_, uint32_t framesInFlight, const DynamicResolutionConfig& config_)
+		: device(device_)
+	{
+		slots.resize(framesInFlight);
+		history.reserve(HISTORY);
+		SetConfig(config_);
+		scale = config.maxScale;
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		if (vkCreateSampler(device.Device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upscale sampler!");
+		}
+
+		// Same requirements as the GPU profiler
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, families.data());
+
+		uint32_t validBits = families[device.FindPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+		supported = validBits > 0 && device.properties.limits.timestampPeriod > 0.0f;
+
+		if (!supported)
+		{
+			return;
+		}
+
+		timestampPeriod = static_cast<double>(device.properties.limits.timestampPeriod);
+		timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = framesInFlight * 2;
+
+		if (vkCreateQueryPool(device.Device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create dynamic resolution query pool!");
+		}
+	}
+
+	DynamicResolution::~DynamicResolution()
+	{
+		if (queryPool)
+		{
+			vkDestroyQueryPool(device.Device(), queryPool, nullptr);
+		}
+		vkDestroySampler(device.Device(), sampler, nullptr);
+	}
+
+	void DynamicResolution::SetConfig(const DynamicResolutionConfig& c)
+	{
+		config = c;
+
+		// Targets are allocated at the maximum extent, so rendering can't go above 1
+		config.maxScale = std::clamp(config.maxScale, SCALE_STEP, 1.0f);
+		config.minScale = std::clamp(config.minScale, SCALE_STEP, config.maxScale);
+		config.targetFrameTime = std::max(config.targetFrameTime, 0.1f);
+		config.headroom = std::clamp(config.headroom, 0.1f, 1.0f);
+
+		scale = config.enabled ? std::clamp(scale, config.minScale, config.maxScale) : config.maxScale;
+	}
+
+	void DynamicResolution::SetMaxExtent(VkExtent2D extent)
+	{
+		maxExtent = extent;
+	}
+
+	void DynamicResolution::BeginFrame(VkCommandBuffer cmdBuf, uint32_t frameIdx, VkExtent2D outputExtent)
+	{
+		assert(frameIdx < slots.size() && "Frame index out of range!");
+
+		currSlot = frameIdx;
+
+		FrameSlot& slot = slots[frameIdx];
+		if (slot.pending)
+		{
+			Collect(slot, frameIdx);
+		}
+
+		if (!IsActive())
+		{
+			renderExtent = outputExtent;
+			return;
+		}
+
+		// The window may have grown past the targets since they were allocated
+		renderExtent.width = std::clamp(static_cast<uint32_t>(std::lround(outputExtent.width * scale)), 1u, maxExtent.width);
+		renderExtent.height = std::clamp(static_cast<uint32_t>(std::lround(outputExtent.height * scale)), 1u, maxExtent.height);
+
+		if (!supported)
+		{
+			return;
+		}
+
+		vkCmdResetQueryPool(cmdBuf, queryPool, frameIdx * 2, 2);
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, frameIdx * 2);
+
+		slot.scale = scale;
+		slot.pending = true;
+	}
+
+	void DynamicResolution::EndFrame(VkCommandBuffer cmdBuf)
+	{
+		if (!slots[currSlot].pending)
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currSlot * 2 + 1);
+	}
+
+	void DynamicResolution::Collect(FrameSlot& slot, uint32_t frameIdx)
+	{
+		slot.pending = false;
+
+		// {timestamp, availability} for the start and end of the frame. No WAIT,
+		// the slot's fence has signalled, and a missing result just drops a sample.
+		uint64_t results[4] = {};
+		VkResult res = vkGetQueryPoolResults(device.Device(), queryPool,
+			frameIdx * 2, 2, sizeof(results), results, 2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if ((res != VK_SUCCESS && res != VK_NOT_READY) || results[1] == 0 || results[3] == 0)
+		{
+			return;
+		}
+
+		uint64_t begin = results[0] & timestampMask;
+		uint64_t end = results[2] & timestampMask;
+		if (end < begin)
+		{
+			return;
+		}
+
+		lastFrameTime = static_cast<float>(static_cast<double>(end - begin) * timestampPeriod / 1e6);
+
+		if (history.size() < HISTORY)
+		{
+			history.push_back(lastFrameTime);
+		}
+		else
+		{
+			history[nextSample] = lastFrameTime;
+		}
+		nextSample = (nextSample + 1) % HISTORY;
+
+		if (config.enabled)
+		{
+			Adjust(lastFrameTime, slot.scale);
+		}
+	}
+
+	void DynamicResolution::Adjust(float frameMs, float renderedScale)
+	{
+		// Frames recorded before the last change still report the old cost
+		if (renderedScale != scale)
+		{
+			return;
+		}
+
+		smoothed = smoothed > 0.0f ? smoothed + (frameMs - smoothed) * 0.2f : frameMs;
+
+		// Cost is roughly proportional to the pixel count, i.e. to scale squared
+		float wanted = scale;
+		if (smoothed > config.targetFrameTime)
+		{
+			wanted = scale * std::sqrt(config.targetFrameTime / smoothed);
+			wanted = std::floor(wanted / SCALE_STEP) * SCALE_STEP;
+		}
+		else
+		{
+			float next = scale + SCALE_STEP;
+			if (smoothed * (next * next) / (scale * scale) < config.targetFrameTime * config.headroom)
+			{
+				wanted = next;
+			}
+		}
+
+		wanted = std::clamp(wanted, config.minScale, config.maxScale);
+		if (wanted == scale)
+		{
+			return;
+		}
+
+		// Predicted cost at the new scale, until frames rendered at it report back
+		smoothed *= (wanted * wanted) / (scale * scale);
+		scale = wanted;
+	}
+
+	void DynamicResolution::DrawPanel(bool* open)
+	{
+		if (!ImGui::Begin("Dynamic Resolution", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!supported)
+		{
+			ImGui::Text("Timestamp queries aren't supported on this queue");
+		}
+		else if (!IsActive())
+		{
+			ImGui::Text("The active scene always renders at full resolution");
+		}
+
+		DynamicResolutionConfig edited = config;
+		ImGui::Checkbox("Enabled", &edited.enabled);
+		ImGui::SliderFloat("GPU budget (ms)", &edited.targetFrameTime, 1.0f, 50.0f, "%.1f");
+		ImGui::SliderFloat("Min scale", &edited.minScale, 0.25f, 1.0f, "%.2f");
+		ImGui::SliderFloat("Max scale", &edited.maxScale, 0.25f, 1.0f, "%.2f");
+		ImGui::SliderFloat("Headroom", &edited.headroom, 0.5f, 1.0f, "%.2f");
+		SetConfig(edited);
+
+		ImGui::Separator();
+		ImGui::Text("Scale %.3f  Render %ux%u  Targets %ux%u", scale,
+			renderExtent.width, renderExtent.height, maxExtent.width, maxExtent.height);
+		ImGui::Text("GPU frame %.2f ms  Smoothed %.2f ms", lastFrameTime, smoothed);
+
+		if (!history.empty())
+		{
+			ImGui::PlotLines("##gpuTime", history.data(), static_cast<int>(history.size()),
+				static_cast<int>(history.size() < HISTORY ? 0 : nextSample), nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+		}
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
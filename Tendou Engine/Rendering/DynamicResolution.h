@@ -0,0 +1,109 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include "../Vulkan/TendouDevice.h"
+
+#include <vector>
+
+namespace Tendou
+{
+	struct DynamicResolutionConfig
+	{
+		bool enabled = true;
+
+		// GPU time per frame the controller steers towards, in milliseconds
+		float targetFrameTime = 16.0f;
+
+		// Fraction of the output resolution per axis
+		float minScale = 0.5f;
+		float maxScale = 1.0f;
+
+		// The scale only grows again once the frame fits in this much of the budget,
+		// so it doesn't oscillate around the target
+		float headroom = 0.85f;
+	};
+
+	// Picks the resolution scenes render at from measured GPU frame time.
+	// Render targets are allocated once at the maximum extent and each frame
+	// renders into the top-left sub-rect of them; an upscale pass then
+	// stretches that rect over the swapchain.
+	//
+	// The frame is timed with its own two timestamps per frame slot, read back
+	// when the slot comes around again, so the controller reacts a few frames late
+	// but never stalls.
+	class DynamicResolution
+	{
+	public:
+		// Scale changes are snapped to this, so small timing noise doesn't move the viewport
+		static constexpr float SCALE_STEP = 1.0f / 32.0f;
+
+		// GPU times kept for the panel
+		static constexpr uint32_t HISTORY = 240;
+
+		DynamicResolution(TendouDevice& device, uint32_t framesInFlight, const DynamicResolutionConfig& config = DynamicResolutionConfig());
+		~DynamicResolution();
+
+		DynamicResolution(const DynamicResolution&) = delete;
+		DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+		// Size render targets are allocated at. Scenes that don't set one
+		// render at full resolution and the controller stays idle.
+		void SetMaxExtent(VkExtent2D extent);
+
+		// Collects the last timing for frameIdx, updates the scale and starts timing this frame.
+		// Call right after vkBeginCommandBuffer, outside of any render pass.
+		void BeginFrame(VkCommandBuffer cmdBuf, uint32_t frameIdx, VkExtent2D outputExtent);
+		void EndFrame(VkCommandBuffer cmdBuf);
+
+		__inline bool IsActive() const { return maxExtent.width > 0 && maxExtent.height > 0; }
+		__inline bool IsSupported() const { return supported; }
+
+		__inline VkExtent2D GetMaxExtent() const { return maxExtent; }
+		__inline VkExtent2D GetRenderExtent() const { return renderExtent; }
+		__inline float GetScale() const { return scale; }
+		__inline float LastFrameTime() const { return lastFrameTime; }
+
+		__inline const DynamicResolutionConfig& GetConfig() const { return config; }
+		void SetConfig(const DynamicResolutionConfig& c);
+
+		// Linear clamp sampler for reading the scaled targets back at output resolution
+		__inline VkSampler GetSampler() const { return sampler; }
+
+		void DrawPanel(bool* open = nullptr);
+
+	private:
+		struct FrameSlot
+		{
+			float scale = 1.0f;
+			bool pending = false;
+		};
+
+		void Collect(FrameSlot& slot, uint32_t frameIdx);
+		void Adjust(float frameMs, float renderedScale);
+
+		TendouDevice& device;
+		DynamicResolutionConfig config;
+
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
+		std::vector<FrameSlot> slots;
+		uint32_t currSlot = 0;
+
+		double timestampPeriod = 1.0;
+		uint64_t timestampMask = ~0ull;
+		bool supported = false;
+
+		VkExtent2D maxExtent{};
+		VkExtent2D renderExtent{};
+		float scale = 1.0f;
+
+		// Smoothed GPU time at the current scale, 0 until the first sample
+		float smoothed = 0.0f;
+		float lastFrameTime = 0.0f;
+
+		std::vector<float> history;
+		uint32_t nextSample = 0;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -7,6 +7,9 @@
 
 namespace Tendou
 {
+	struct SecondaryContext;
+	class GPUProfiler;
+
 	struct FrameInfo
 	{
 		FrameInfo(int a, float b, 
@@ -22,6 +25,13 @@ namespace Tendou
 		float frameTime;
 		VkCommandBuffer commandBuffer;
 		uint32_t dynamicOffset;
+
+		// Set while the current render pass expects secondary command buffers,
+		// otherwise systems record inline into commandBuffer
+		SecondaryContext* secondary = nullptr;
+
+		// Timestamp profiler for this frame, null if profiling is off
+		GPUProfiler* profiler = nullptr;
 	};
 
 	struct SceneInfo
@@ -34,6 +44,9 @@ namespace Tendou
 
 		std::vector<VkDescriptorSet> descriptorSets;
 		GameObject::Map& gameObjects;
+
+		// Eye for systems that sort front to back, the rest ignore it
+		const Camera* camera = nullptr;
 	};
 }
 
@@ -0,0 +1,180 @@
+#include "FramePacer.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+
+namespace Tendou
+{
+	FramePacer::FramePacer(TendouDevice& device_, const FramePacingConfig& config_)
+		: device(device_)
+		, config(config_)
+		, nextFrame(Clock::now())
+		, inputTime(Clock::now())
+	{
+		pending.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		samples.reserve(HISTORY);
+	}
+
+	void FramePacer::SetConfig(const FramePacingConfig& c)
+	{
+		swapChainDirty = swapChainDirty ||
+			c.swapChain.framesInFlight != config.swapChain.framesInFlight ||
+			c.swapChain.presentMode != config.swapChain.presentMode;
+		config = c;
+	}
+
+	void FramePacer::WaitForFrameSlot()
+	{
+		if (config.maxFrameRate <= 0.0f)
+		{
+			return;
+		}
+
+		auto interval = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / config.maxFrameRate));
+
+		// Sleeping overshoots by up to a scheduler tick, so spin the last stretch
+		const auto spin = std::chrono::milliseconds(2);
+		auto now = Clock::now();
+		if (nextFrame - now > spin)
+		{
+			std::this_thread::sleep_for(nextFrame - now - spin);
+		}
+		while (Clock::now() < nextFrame)
+		{
+			std::this_thread::yield();
+		}
+
+		// A frame that ran long moves the schedule instead of bursting to catch up
+		now = Clock::now();
+		nextFrame = nextFrame + interval < now ? now + interval : nextFrame + interval;
+	}
+
+	void FramePacer::MarkInputSampled()
+	{
+		inputTime = Clock::now();
+	}
+
+	void FramePacer::FrameSubmitted(uint32_t frameIdx, VkFence fence)
+	{
+		pending[frameIdx].inputTime = inputTime;
+		pending[frameIdx].fence = fence;
+	}
+
+	void FramePacer::Poll()
+	{
+		auto now = Clock::now();
+		for (PendingFrame& frame : pending)
+		{
+			if (frame.fence == VK_NULL_HANDLE || vkGetFenceStatus(device.Device(), frame.fence) != VK_SUCCESS)
+			{
+				continue;
+			}
+
+			lastSample = std::chrono::duration<float, std::milli>(now - frame.inputTime).count();
+			if (samples.size() < HISTORY)
+			{
+				samples.push_back(lastSample);
+			}
+			else
+			{
+				samples[nextSample] = lastSample;
+			}
+			nextSample = (nextSample + 1) % HISTORY;
+
+			frame.fence = VK_NULL_HANDLE;
+		}
+	}
+
+	float FramePacer::LastLatency() const
+	{
+		return lastSample;
+	}
+
+	float FramePacer::AverageLatency() const
+	{
+		if (samples.empty())
+		{
+			return 0.0f;
+		}
+
+		float sum = 0.0f;
+		for (float s : samples)
+		{
+			sum += s;
+		}
+		return sum / samples.size();
+	}
+
+	float FramePacer::LatencyPercentile(float p) const
+	{
+		if (samples.empty())
+		{
+			return 0.0f;
+		}
+
+		std::vector<float> sorted = samples;
+		size_t idx = std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5f));
+		std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+		return sorted[idx];
+	}
+
+	void FramePacer::DrawPanel(VkPresentModeKHR activeMode, bool* open)
+	{
+		if (!ImGui::Begin("Frame Pacing", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		FramePacingConfig edited = config;
+
+		int framesInFlight = static_cast<int>(edited.swapChain.framesInFlight);
+		if (ImGui::SliderInt("Frames in flight", &framesInFlight, 1, SwapChain::MAX_FRAMES_IN_FLIGHT))
+		{
+			edited.swapChain.framesInFlight = static_cast<uint32_t>(framesInFlight);
+		}
+
+		const char* modeNames[] = { "FIFO", "Mailbox", "Immediate" };
+		const VkPresentModeKHR modes[] = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+
+		int mode = static_cast<int>(std::find(modes, modes + 3, edited.swapChain.presentMode) - modes) % 3;
+		if (ImGui::Combo("Present mode", &mode, modeNames, 3))
+		{
+			edited.swapChain.presentMode = modes[mode];
+		}
+
+		int active = static_cast<int>(std::find(modes, modes + 3, activeMode) - modes);
+		ImGui::Text("Active: %s", active < 3 ? modeNames[active] : "Other");
+
+		ImGui::InputFloat("FPS cap (0 = off)", &edited.maxFrameRate, 10.0f, 30.0f, "%.0f");
+		edited.maxFrameRate = std::max(edited.maxFrameRate, 0.0f);
+
+		ImGui::BeginDisabled(lateLatchBlocker != nullptr);
+		ImGui::Checkbox("Late latch camera", &edited.lateLatch);
+		ImGui::EndDisabled();
+		if (lateLatchBlocker)
+		{
+			ImGui::SameLine();
+			ImGui::TextDisabled("(off, %s)", lateLatchBlocker);
+		}
+
+		SetConfig(edited);
+
+		ImGui::Separator();
+		ImGui::Text("Input to GPU done, ms over the last %u frames", HISTORY);
+		ImGui::Text("Last %.2f  Avg %.2f  P50 %.2f  P99 %.2f", LastLatency(), AverageLatency(),
+			LatencyPercentile(0.5f), LatencyPercentile(0.99f));
+
+		if (!samples.empty())
+		{
+			ImGui::PlotLines("##latency", samples.data(), static_cast<int>(samples.size()),
+				static_cast<int>(samples.size() < HISTORY ? 0 : nextSample), nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+		}
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
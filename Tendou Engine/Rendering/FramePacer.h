@@ -0,0 +1,93 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include "../Vulkan/SwapChain.h"
+
+#include <chrono>
+#include <vector>
+
+namespace Tendou
+{
+	struct FramePacingConfig
+	{
+		// Frames the CPU may record ahead of the GPU, and the preferred present mode
+		SwapChainConfig swapChain;
+
+		// 0 = uncapped. The wait happens before input is sampled, so a cap
+		// trades throughput for latency instead of queueing frames.
+		float maxFrameRate = 0.0f;
+
+		// Sample input again right before submit and rewrite the camera uniforms
+		bool lateLatch = true;
+	};
+
+	// Frame rate cap and input-to-GPU latency tracking.
+	// Latency runs from the last input sample of a frame to the point its
+	// fence is seen signaled, which is checked every BeginFrame - so it's an
+	// upper bound that also covers the time the frame spent queued.
+	class FramePacer
+	{
+	public:
+		// Latency samples kept for the stats
+		static constexpr uint32_t HISTORY = 240;
+
+		FramePacer(TendouDevice& device, const FramePacingConfig& config = FramePacingConfig());
+
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		// Sleeps until the frame cap lets the next frame start. Call before polling input.
+		void WaitForFrameSlot();
+
+		// Input for the frame being built was just sampled
+		void MarkInputSampled();
+
+		// The frame in slot frameIdx was submitted and signals fence when done
+		void FrameSubmitted(uint32_t frameIdx, VkFence fence);
+
+		// Records the latency of every submitted frame whose fence has signaled
+		void Poll();
+
+		__inline const FramePacingConfig& GetConfig() const { return config; }
+		void SetConfig(const FramePacingConfig& c);
+
+		// Why the application can't late latch, nullptr when it can. The panel
+		// greys the checkbox out and shows the reason.
+		__inline void SetLateLatchBlocker(const char* reason) { lateLatchBlocker = reason; }
+
+		// Set when DrawPanel changed something the swap chain has to be rebuilt for
+		__inline bool SwapChainDirty() const { return swapChainDirty; }
+		__inline void ClearSwapChainDirty() { swapChainDirty = false; }
+
+		// In milliseconds, 0 without samples
+		float LastLatency() const;
+		float AverageLatency() const;
+		float LatencyPercentile(float p) const;
+
+		void DrawPanel(VkPresentModeKHR activeMode, bool* open = nullptr);
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct PendingFrame
+		{
+			Clock::time_point inputTime;
+			VkFence fence = VK_NULL_HANDLE;
+		};
+
+		TendouDevice& device;
+		FramePacingConfig config;
+		bool swapChainDirty = false;
+		const char* lateLatchBlocker = nullptr;
+
+		Clock::time_point nextFrame;
+		Clock::time_point inputTime;
+
+		std::vector<PendingFrame> pending;
+		std::vector<float> samples;
+		uint32_t nextSample = 0;
+		float lastSample = 0.0f;
+	};
+}
+
+#endif
\ No newline at end of file
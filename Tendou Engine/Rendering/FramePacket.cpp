@@ -0,0 +1,130 @@
+#include "FramePacket.h"
+
+#include "../Core/Profiler.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstring>
+
+namespace Tendou
+{
+	namespace
+	{
+		Camera Lerp(const Camera& a, const Camera& b, float t)
+		{
+			Camera c = b;
+			c.cameraPos = glm::mix(a.cameraPos, b.cameraPos, t);
+			c.front = glm::normalize(glm::mix(a.front, b.front, t));
+			c.up = glm::normalize(glm::mix(a.up, b.up, t));
+			c.right = glm::normalize(glm::mix(a.right, b.right, t));
+			c.yaw = glm::mix(a.yaw, b.yaw, t);
+			c.pitch = glm::mix(a.pitch, b.pitch, t);
+			c.zoom = glm::mix(a.zoom, b.zoom, t);
+
+			return c;
+		}
+
+		// Splits a translate * rotate * scale matrix, false if a column collapsed
+		bool Decompose(const glm::mat4& m, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale)
+		{
+			scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+			if (scale.x < 1e-6f || scale.y < 1e-6f || scale.z < 1e-6f)
+			{
+				return false;
+			}
+
+			glm::mat3 r(glm::vec3(m[0]) / scale.x, glm::vec3(m[1]) / scale.y, glm::vec3(m[2]) / scale.z);
+			if (glm::determinant(r) < 0.0f)
+			{
+				scale.x = -scale.x;
+				r[0] = -r[0];
+			}
+
+			translation = glm::vec3(m[3]);
+			rotation = glm::quat_cast(r);
+			return true;
+		}
+
+		// Rotation is slerped, lerping the matrix would shrink anything turning between steps
+		glm::mat4 Blend(const glm::mat4& a, const glm::mat4& b, float t)
+		{
+			glm::vec3 translationA, translationB, scaleA, scaleB;
+			glm::quat rotationA, rotationB;
+			if (!Decompose(a, translationA, rotationA, scaleA) || !Decompose(b, translationB, rotationB, scaleB))
+			{
+				return b;
+			}
+
+			glm::mat4 m = glm::mat4_cast(glm::slerp(rotationA, rotationB, t));
+			glm::vec3 scale = glm::mix(scaleA, scaleB, t);
+			m[0] *= scale.x;
+			m[1] *= scale.y;
+			m[2] *= scale.z;
+			m[3] = glm::vec4(glm::mix(translationA, translationB, t), 1.0f);
+
+			return m;
+		}
+	}
+
+	void FramePacket::Clear()
+	{
+		objects.clear();
+	}
+
+	void FramePacket::Capture(GameObject::Map& map)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		objects.reserve(objects.size() + map.size());
+		for (auto& kv : map)
+		{
+			GameObject& obj = kv.second;
+
+			Object& o = objects.emplace_back();
+			o.object = &obj;
+			o.state.modelMatrix = obj.GetTransform().ModelMat();
+			o.state.normalMatrix = obj.GetTransform().NormalMatrix();
+			o.state.render = obj.GetRender();
+		}
+	}
+
+	void FramePacket::Interpolate(const FramePacket& from, const FramePacket& to, float alpha)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		camera = alpha < 1.0f ? Lerp(from.camera, to.camera, alpha) : to.camera;
+		objects = to.objects;
+
+		if (alpha >= 1.0f || from.objects.size() != to.objects.size())
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			const Object& a = from.objects[i];
+			Object& o = objects[i];
+
+			// Most objects didn't move between the two steps
+			if (a.object != o.object || memcmp(&a.state.modelMatrix, &o.state.modelMatrix, sizeof(glm::mat4)) == 0)
+			{
+				continue;
+			}
+
+			o.state.modelMatrix = Blend(a.state.modelMatrix, o.state.modelMatrix, alpha);
+
+			// Shaders renormalize, a plain blend is close enough over one step
+			o.state.normalMatrix = a.state.normalMatrix + (o.state.normalMatrix - a.state.normalMatrix) * alpha;
+		}
+	}
+
+	void FramePacket::Apply() const
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		for (const Object& o : objects)
+		{
+			o.object->SetRenderState(o.state);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef FRAMEPACKET_H
+#define FRAMEPACKET_H
+
+#include "Camera.h"
+#include "../Components/GameObject.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tendou
+{
+	// Everything one update hands to rendering, written by Scene::WriteFramePacket
+	// and left untouched until Scene::ReadFramePacket has copied it out.
+	// Objects are referenced by pointer, so maps captured into a packet must not
+	// lose elements while a pipelined update is in flight.
+	struct FramePacket
+	{
+		struct Object
+		{
+			GameObject* object = nullptr;
+			GameObject::RenderState state;
+		};
+
+		// Update that wrote it, counted from 0
+		uint64_t frame = 0;
+		float frameTime = 0.0f;
+
+		Camera camera;
+		std::vector<Object> objects;
+
+		void Clear();
+
+		// Appends the current transform and render flag of every object in objects
+		void Capture(GameObject::Map& objects);
+
+		// Blends two captures of the same objects, alpha 0 being from and 1 being to.
+		// Objects only one of them captured take to's state.
+		void Interpolate(const FramePacket& from, const FramePacket& to, float alpha);
+
+		// Hands every captured state to its object's render side
+		void Apply() const;
+	};
+}
+
+#endif
\ No newline at end of file
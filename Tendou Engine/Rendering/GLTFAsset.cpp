@@ -0,0 +1,1015 @@
+#include "GLTFAsset.h"
+
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Tendou
+{
+	namespace
+	{
+		using Json = nlohmann::json;
+
+		constexpr uint32_t GLB_MAGIC = 0x46546C67;		// "glTF"
+		constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+		constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;	// "BIN\0"
+		constexpr size_t GLB_HEADER_SIZE = 12;
+		constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+		// Extensions a file may require: quantized attributes read through any
+		// component type, meshopt views are decoded and texture transforms applied
+		const char* const SUPPORTED_EXTENSIONS[] =
+		{
+			"KHR_mesh_quantization",
+			"KHR_texture_transform",
+			"EXT_meshopt_compression",
+		};
+
+		__inline uint32_t ReadU32(const uint8_t* p)
+		{
+			uint32_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		int32_t GetIndex(const Json& object, const char* key)
+		{
+			auto it = object.find(key);
+			return it != object.end() ? it->get<int32_t>() : -1;
+		}
+
+		// Index of a textureInfo object such as "normalTexture": { "index": 2 }
+		int32_t GetTextureIndex(const Json& object, const char* key)
+		{
+			auto it = object.find(key);
+			return it != object.end() ? GetIndex(*it, "index") : -1;
+		}
+
+		// Extension object of a glTF object, nullptr when it doesn't have it
+		const Json* FindExtension(const Json& object, const char* name)
+		{
+			auto extensions = object.find("extensions");
+			if (extensions == object.end())
+			{
+				return nullptr;
+			}
+			auto it = extensions->find(name);
+			return it != extensions->end() ? &*it : nullptr;
+		}
+
+		// KHR_texture_transform of a textureInfo object, as scale.xy, offset.xy
+		glm::vec4 GetTextureTransform(const Json& object, const char* key)
+		{
+			glm::vec4 transform(1.0f, 1.0f, 0.0f, 0.0f);
+
+			auto info = object.find(key);
+			const Json* ext = info != object.end() ? FindExtension(*info, "KHR_texture_transform") : nullptr;
+			if (ext)
+			{
+				std::vector<float> scale = ext->value("scale", std::vector<float>{ 1.0f, 1.0f });
+				std::vector<float> offset = ext->value("offset", std::vector<float>{ 0.0f, 0.0f });
+				transform = glm::vec4(scale.at(0), scale.at(1), offset.at(0), offset.at(1));
+			}
+			return transform;
+		}
+
+		GLTFAsset::MeshoptMode GetMeshoptMode(const std::string& mode)
+		{
+			if (mode == "ATTRIBUTES") return GLTFAsset::MeshoptMode::Attributes;
+			if (mode == "TRIANGLES") return GLTFAsset::MeshoptMode::Triangles;
+			if (mode == "INDICES") return GLTFAsset::MeshoptMode::Indices;
+			throw std::runtime_error("Failed to load glTF file, unknown meshopt mode " + mode + "!");
+		}
+
+		MeshoptDecoder::Filter GetMeshoptFilter(const std::string& filter)
+		{
+			if (filter == "NONE") return MeshoptDecoder::Filter::None;
+			if (filter == "OCTAHEDRAL") return MeshoptDecoder::Filter::Octahedral;
+			if (filter == "QUATERNION") return MeshoptDecoder::Filter::Quaternion;
+			if (filter == "EXPONENTIAL") return MeshoptDecoder::Filter::Exponential;
+			throw std::runtime_error("Failed to load glTF file, unknown meshopt filter " + filter + "!");
+		}
+
+		uint32_t ComponentCount(const std::string& type)
+		{
+			if (type == "SCALAR") return 1;
+			if (type == "VEC2") return 2;
+			if (type == "VEC3") return 3;
+			if (type == "VEC4") return 4;
+			if (type == "MAT2") return 4;
+			if (type == "MAT3") return 9;
+			if (type == "MAT4") return 16;
+			throw std::runtime_error("Failed to load glTF file, unknown accessor type " + type + "!");
+		}
+
+		bool IsDataURI(const std::string& uri)
+		{
+			return uri.compare(0, 5, "data:") == 0;
+		}
+
+		// "data:<mime>;base64,<payload>"
+		std::vector<uint8_t> DecodeDataURI(const std::string& uri)
+		{
+			size_t comma = uri.find(',');
+			if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos)
+			{
+				throw std::runtime_error("Failed to load glTF file, only base64 data URIs are supported!");
+			}
+
+			static const auto table = []()
+			{
+				std::array<uint8_t, 256> t;
+				t.fill(0xFF);
+				const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+				for (uint8_t i = 0; i < 64; ++i)
+				{
+					t[static_cast<uint8_t>(alphabet[i])] = i;
+				}
+				return t;
+			}();
+
+			std::vector<uint8_t> out;
+			out.reserve((uri.size() - comma) / 4 * 3);
+
+			uint32_t bits = 0;
+			int32_t count = 0;
+			for (size_t i = comma + 1; i < uri.size(); ++i)
+			{
+				uint8_t v = table[static_cast<uint8_t>(uri[i])];
+				if (v == 0xFF)
+				{
+					// Padding ends the payload, anything else unknown is skipped like whitespace
+					if (uri[i] == '=')
+					{
+						break;
+					}
+					continue;
+				}
+
+				bits = (bits << 6) | v;
+				count += 6;
+				if (count >= 8)
+				{
+					count -= 8;
+					out.push_back(static_cast<uint8_t>(bits >> count));
+				}
+			}
+
+			return out;
+		}
+
+		// File URIs may escape spaces and other characters as %XX
+		std::string DecodeURI(const std::string& uri)
+		{
+			std::string out;
+			out.reserve(uri.size());
+			for (size_t i = 0; i < uri.size(); ++i)
+			{
+				if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(uri[i + 1]) && isxdigit(uri[i + 2]))
+				{
+					out.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+					i += 2;
+				}
+				else
+				{
+					out.push_back(uri[i]);
+				}
+			}
+			return out;
+		}
+
+		// The spec maps the most negative signed value to -1 as well, hence the clamp
+		template <typename T>
+		void ConvertElements(const uint8_t* src, size_t srcStride, size_t count, uint32_t components,
+			bool normalized, float* dst, size_t dstStride)
+		{
+			constexpr float scale = std::is_floating_point<T>::value ? 1.0f :
+				1.0f / static_cast<float>(std::numeric_limits<T>::max());
+
+			uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+			for (size_t i = 0; i < count; ++i, src += srcStride, out += dstStride)
+			{
+				float* d = reinterpret_cast<float*>(out);
+				for (uint32_t c = 0; c < components; ++c)
+				{
+					T v;
+					memcpy(&v, src + c * sizeof(T), sizeof(T));
+					float f = static_cast<float>(v);
+					d[c] = normalized ? std::max(f * scale, -1.0f) : f;
+				}
+			}
+		}
+
+		void Convert(uint32_t componentType, const uint8_t* src, size_t srcStride, size_t count,
+			uint32_t components, bool normalized, float* dst, size_t dstStride)
+		{
+			switch (componentType)
+			{
+			case GLTFAsset::BYTE:
+				ConvertElements<int8_t>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			case GLTFAsset::UNSIGNED_BYTE:
+				ConvertElements<uint8_t>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			case GLTFAsset::SHORT:
+				ConvertElements<int16_t>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			case GLTFAsset::UNSIGNED_SHORT:
+				ConvertElements<uint16_t>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			case GLTFAsset::UNSIGNED_INT:
+				ConvertElements<uint32_t>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			default:
+				ConvertElements<float>(src, srcStride, count, components, normalized, dst, dstStride);
+				break;
+			}
+		}
+
+		template <typename T>
+		uint32_t CopyIndices(const uint8_t* src, size_t srcStride, size_t count, uint32_t base, uint32_t* dst)
+		{
+			uint32_t largest = 0;
+			for (size_t i = 0; i < count; ++i, src += srcStride)
+			{
+				T v;
+				memcpy(&v, src, sizeof(T));
+				largest = std::max<uint32_t>(largest, v);
+				dst[i] = static_cast<uint32_t>(v) + base;
+			}
+			return largest;
+		}
+
+		__inline uint32_t ReadIndex(const uint8_t* src, size_t i, uint32_t componentType)
+		{
+			switch (componentType)
+			{
+			case GLTFAsset::UNSIGNED_BYTE:
+				return src[i];
+			case GLTFAsset::UNSIGNED_SHORT:
+			{
+				uint16_t v;
+				memcpy(&v, src + i * sizeof(v), sizeof(v));
+				return v;
+			}
+			default:
+				return ReadU32(src + i * sizeof(uint32_t));
+			}
+		}
+
+		bool IsIndexType(uint32_t componentType)
+		{
+			return componentType == GLTFAsset::UNSIGNED_BYTE ||
+				componentType == GLTFAsset::UNSIGNED_SHORT ||
+				componentType == GLTFAsset::UNSIGNED_INT;
+		}
+	}
+
+	void GLTFAsset::Load(const std::string& path)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		if (!file.Open(path))
+		{
+			throw std::runtime_error("Failed to open glTF file " + path + "!");
+		}
+
+		size_t slash = path.find_last_of("/\\");
+		std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+
+		const uint8_t* data = file.Data();
+		size_t size = file.Size();
+
+		const char* json = reinterpret_cast<const char*>(data);
+		size_t jsonSize = size;
+		Buffer glbBuffer;
+
+		// Binary container: header, JSON chunk, then an optional BIN chunk that stays in the mapping
+		if (size >= GLB_HEADER_SIZE && ReadU32(data) == GLB_MAGIC)
+		{
+			uint32_t version = ReadU32(data + 4);
+			size_t length = std::min<size_t>(ReadU32(data + 8), size);
+			size_t jsonStart = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+
+			if (version != 2 || length < jsonStart || ReadU32(data + 16) != GLB_CHUNK_JSON)
+			{
+				throw std::runtime_error("Failed to load " + path + ", not a glTF 2.0 binary!");
+			}
+
+			jsonSize = ReadU32(data + 12);
+			if (jsonSize > length - jsonStart)
+			{
+				throw std::runtime_error("Failed to load " + path + ", the JSON chunk is truncated!");
+			}
+			json = reinterpret_cast<const char*>(data + jsonStart);
+
+			size_t binHeader = jsonStart + jsonSize;
+			if (length - binHeader >= GLB_CHUNK_HEADER_SIZE && ReadU32(data + binHeader + 4) == GLB_CHUNK_BIN)
+			{
+				glbBuffer.data = data + binHeader + GLB_CHUNK_HEADER_SIZE;
+				glbBuffer.size = std::min<size_t>(ReadU32(data + binHeader), length - binHeader - GLB_CHUNK_HEADER_SIZE);
+			}
+		}
+
+		try
+		{
+			Parse(json, jsonSize, glbBuffer, directory);
+		}
+		catch (const Json::exception& e)
+		{
+			throw std::runtime_error("Failed to parse glTF file " + path + ": " + e.what());
+		}
+
+		ResolveViews();
+		Validate();
+	}
+
+	void GLTFAsset::Parse(const char* json, size_t size, const Buffer& glbBuffer, const std::string& directory)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		Json doc = Json::parse(json, json + size);
+
+		const Json& asset = doc.at("asset");
+		if (asset.value("version", std::string()).compare(0, 2, "2.") != 0)
+		{
+			throw std::runtime_error("Failed to load glTF file, only version 2 is supported!");
+		}
+
+		const Json empty = Json::array();
+		auto list = [&](const char* key) -> const Json&
+		{
+			auto it = doc.find(key);
+			return it != doc.end() ? *it : empty;
+		};
+
+		for (const Json& e : list("extensionsRequired"))
+		{
+			std::string name = e.get<std::string>();
+			if (std::find(std::begin(SUPPORTED_EXTENSIONS), std::end(SUPPORTED_EXTENSIONS), name) == std::end(SUPPORTED_EXTENSIONS))
+			{
+				throw std::runtime_error("Failed to load glTF file, required extension " + name + " isn't supported!");
+			}
+		}
+
+		for (const Json& b : list("buffers"))
+		{
+			Buffer buffer;
+			size_t byteLength = b.at("byteLength").get<size_t>();
+
+			// Only there for loaders without meshopt support, every view on it is compressed
+			const Json* meshopt = FindExtension(b, "EXT_meshopt_compression");
+			bool fallback = meshopt && meshopt->value("fallback", false);
+
+			auto uri = b.find("uri");
+			if (fallback)
+			{
+				buffer.size = byteLength;
+			}
+			else if (uri == b.end())
+			{
+				buffer = glbBuffer;
+			}
+			else if (IsDataURI(uri->get<std::string>()))
+			{
+				decoded.push_back(DecodeDataURI(uri->get<std::string>()));
+				buffer.data = decoded.back().data();
+				buffer.size = decoded.back().size();
+			}
+			else
+			{
+				std::string bufferPath = directory + DecodeURI(uri->get<std::string>());
+
+				MappedFile mapping;
+				if (!mapping.Open(bufferPath))
+				{
+					throw std::runtime_error("Failed to open glTF buffer " + bufferPath + "!");
+				}
+				buffer.data = mapping.Data();
+				buffer.size = mapping.Size();
+				externalFiles.push_back(std::move(mapping));
+			}
+
+			if (buffer.size < byteLength)
+			{
+				throw std::runtime_error("Failed to load glTF file, a buffer is shorter than its byteLength!");
+			}
+			buffer.size = byteLength;
+			buffers.push_back(buffer);
+		}
+
+		for (const Json& v : list("bufferViews"))
+		{
+			BufferView view;
+			view.buffer = v.at("buffer").get<int32_t>();
+			view.byteOffset = v.value("byteOffset", size_t(0));
+			view.byteLength = v.at("byteLength").get<size_t>();
+			view.byteStride = v.value("byteStride", size_t(0));
+
+			const Json* meshopt = FindExtension(v, "EXT_meshopt_compression");
+			if (meshopt)
+			{
+				view.meshopt.buffer = meshopt->at("buffer").get<int32_t>();
+				view.meshopt.byteOffset = meshopt->value("byteOffset", size_t(0));
+				view.meshopt.byteLength = meshopt->at("byteLength").get<size_t>();
+				view.meshopt.count = meshopt->at("count").get<size_t>();
+				view.meshopt.mode = GetMeshoptMode(meshopt->at("mode").get<std::string>());
+				view.meshopt.filter = GetMeshoptFilter(meshopt->value("filter", std::string("NONE")));
+
+				// The stride lives in the extension and is required there
+				view.byteStride = meshopt->at("byteStride").get<size_t>();
+			}
+
+			bufferViews.push_back(view);
+		}
+
+		for (const Json& a : list("accessors"))
+		{
+			Accessor accessor;
+			accessor.bufferView = GetIndex(a, "bufferView");
+			accessor.byteOffset = a.value("byteOffset", size_t(0));
+			accessor.count = a.at("count").get<size_t>();
+			accessor.componentType = a.at("componentType").get<uint32_t>();
+			accessor.components = ComponentCount(a.at("type").get<std::string>());
+			accessor.normalized = a.value("normalized", false);
+
+			auto sparse = a.find("sparse");
+			if (sparse != a.end())
+			{
+				const Json& indices = sparse->at("indices");
+				const Json& values = sparse->at("values");
+				accessor.sparse.count = sparse->at("count").get<size_t>();
+				accessor.sparse.indicesView = indices.at("bufferView").get<int32_t>();
+				accessor.sparse.indicesOffset = indices.value("byteOffset", size_t(0));
+				accessor.sparse.indicesType = indices.at("componentType").get<uint32_t>();
+				accessor.sparse.valuesView = values.at("bufferView").get<int32_t>();
+				accessor.sparse.valuesOffset = values.value("byteOffset", size_t(0));
+			}
+
+			accessors.push_back(accessor);
+		}
+
+		for (const Json& m : list("meshes"))
+		{
+			Mesh mesh;
+			for (const Json& p : m.at("primitives"))
+			{
+				const Json& attributes = p.at("attributes");
+
+				Primitive primitive;
+				primitive.position = GetIndex(attributes, "POSITION");
+				primitive.normal = GetIndex(attributes, "NORMAL");
+				primitive.texcoord0 = GetIndex(attributes, "TEXCOORD_0");
+				primitive.tangent = GetIndex(attributes, "TANGENT");
+				primitive.indices = GetIndex(p, "indices");
+				primitive.material = GetIndex(p, "material");
+				primitive.mode = p.value("mode", static_cast<uint32_t>(TRIANGLES));
+				mesh.primitives.push_back(primitive);
+			}
+			meshes.push_back(std::move(mesh));
+		}
+
+		for (const Json& n : list("nodes"))
+		{
+			Node node;
+			node.name = n.value("name", std::string());
+			node.mesh = GetIndex(n, "mesh");
+			node.children = n.value("children", std::vector<int32_t>());
+
+			auto matrix = n.find("matrix");
+			if (matrix != n.end())
+			{
+				std::vector<float> m = matrix->get<std::vector<float>>();
+				for (size_t i = 0; i < 16 && i < m.size(); ++i)
+				{
+					node.matrix[static_cast<int>(i / 4)][static_cast<int>(i % 4)] = m[i];
+				}
+			}
+			else
+			{
+				auto t = n.find("translation");
+				auto r = n.find("rotation");
+				auto s = n.find("scale");
+				if (t != n.end())
+				{
+					std::vector<float> v = t->get<std::vector<float>>();
+					node.matrix = glm::translate(node.matrix, glm::vec3(v.at(0), v.at(1), v.at(2)));
+				}
+				if (r != n.end())
+				{
+					// Stored x, y, z, w
+					std::vector<float> v = r->get<std::vector<float>>();
+					node.matrix *= glm::mat4(glm::quat(v.at(3), v.at(0), v.at(1), v.at(2)));
+				}
+				if (s != n.end())
+				{
+					std::vector<float> v = s->get<std::vector<float>>();
+					node.matrix = glm::scale(node.matrix, glm::vec3(v.at(0), v.at(1), v.at(2)));
+				}
+			}
+
+			nodes.push_back(std::move(node));
+		}
+
+		for (const Json& m : list("materials"))
+		{
+			Material material;
+
+			auto pbr = m.find("pbrMetallicRoughness");
+			if (pbr != m.end())
+			{
+				auto factor = pbr->find("baseColorFactor");
+				if (factor != pbr->end())
+				{
+					std::vector<float> v = factor->get<std::vector<float>>();
+					material.baseColorFactor = glm::vec4(v.at(0), v.at(1), v.at(2), v.at(3));
+				}
+				material.baseColorTexture = GetTextureIndex(*pbr, "baseColorTexture");
+				material.metallicRoughnessTexture = GetTextureIndex(*pbr, "metallicRoughnessTexture");
+				material.uvTransform = GetTextureTransform(*pbr, "baseColorTexture");
+			}
+
+			material.normalTexture = GetTextureIndex(m, "normalTexture");
+			material.occlusionTexture = GetTextureIndex(m, "occlusionTexture");
+			material.alphaMode = m.value("alphaMode", std::string("OPAQUE"));
+			material.alphaCutoff = m.value("alphaCutoff", 0.5f);
+			material.doubleSided = m.value("doubleSided", false);
+			materials.push_back(std::move(material));
+		}
+
+		for (const Json& t : list("textures"))
+		{
+			Texture texture;
+			texture.source = GetIndex(t, "source");
+			textures.push_back(texture);
+		}
+
+		for (const Json& i : list("images"))
+		{
+			Image image;
+			image.mimeType = i.value("mimeType", std::string());
+
+			std::string uri = i.value("uri", std::string());
+			if (IsDataURI(uri))
+			{
+				// "data:image/png;base64,..."
+				if (image.mimeType.empty())
+				{
+					image.mimeType = uri.substr(5, uri.find(';') - 5);
+				}
+				decoded.push_back(DecodeDataURI(uri));
+				image.data = decoded.back().data();
+				image.size = decoded.back().size();
+			}
+			else if (!uri.empty())
+			{
+				image.uri = DecodeURI(uri);
+			}
+			else
+			{
+				// Pointed at its view's data once the views are resolved
+				image.view = GetIndex(i, "bufferView");
+				if (image.view < 0 || image.view >= static_cast<int32_t>(bufferViews.size()))
+				{
+					throw std::runtime_error("Failed to load glTF file, an image has no data!");
+				}
+			}
+
+			images.push_back(std::move(image));
+		}
+
+		// Without a scene, every node nobody parents is a root
+		auto scenes = doc.find("scenes");
+		if (scenes != doc.end() && !scenes->empty())
+		{
+			size_t scene = doc.value("scene", size_t(0));
+			sceneNodes = scenes->at(scene).value("nodes", std::vector<int32_t>());
+		}
+		else
+		{
+			std::vector<char> parented(nodes.size(), 0);
+			for (const Node& node : nodes)
+			{
+				for (int32_t child : node.children)
+				{
+					if (child >= 0 && child < static_cast<int32_t>(nodes.size()))
+					{
+						parented[child] = 1;
+					}
+				}
+			}
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				if (!parented[i])
+				{
+					sceneNodes.push_back(static_cast<int32_t>(i));
+				}
+			}
+		}
+	}
+
+	void GLTFAsset::ResolveViews()
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		auto inRange = [](int32_t index, size_t size) { return index >= 0 && static_cast<size_t>(index) < size; };
+		auto fail = [](const char* what) { throw std::runtime_error(std::string("Failed to load glTF file, ") + what + "!"); };
+
+		struct Pending
+		{
+			const BufferView* view;
+			uint8_t* dst;
+		};
+		std::vector<Pending> compressed;
+		for (BufferView& view : bufferViews)
+		{
+			// Plain views are range checked by Validate
+			if (view.meshopt.buffer < 0)
+			{
+				if (inRange(view.buffer, buffers.size()) && buffers[view.buffer].data)
+				{
+					view.data = buffers[view.buffer].data + view.byteOffset;
+				}
+				continue;
+			}
+
+			const auto& m = view.meshopt;
+			if (!inRange(m.buffer, buffers.size()) || !buffers[m.buffer].data ||
+				m.byteOffset > buffers[m.buffer].size || m.byteLength > buffers[m.buffer].size - m.byteOffset)
+			{
+				fail("a compressed buffer view is outside of its buffer");
+			}
+
+			bool valid = view.byteStride > 0 && m.count <= view.byteLength / view.byteStride;
+			switch (m.mode)
+			{
+			case MeshoptMode::Attributes:
+				valid = valid && view.byteStride % 4 == 0 && view.byteStride <= 256;
+				break;
+			case MeshoptMode::Triangles:
+				valid = valid && m.count % 3 == 0;
+				[[fallthrough]];
+			case MeshoptMode::Indices:
+				valid = valid && (view.byteStride == 2 || view.byteStride == 4) &&
+					m.filter == MeshoptDecoder::Filter::None;
+				break;
+			}
+			if (!valid)
+			{
+				fail("a compressed buffer view has an invalid count, stride or filter");
+			}
+
+			decoded.emplace_back(view.byteLength);
+			view.data = decoded.back().data();
+			compressed.push_back({ &view, decoded.back().data() });
+		}
+
+		// Views are independent, and a large one is usually a whole attribute stream
+		std::vector<char> valid(compressed.size(), 1);
+		JobSystem::ParallelFor(static_cast<uint32_t>(compressed.size()), 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					TENDOU_PROFILE_SCOPE("GLTFAsset::DecodeMeshopt");
+
+					const BufferView& view = *compressed[i].view;
+					const auto& m = view.meshopt;
+					uint8_t* dst = compressed[i].dst;
+					const uint8_t* src = buffers[m.buffer].data + m.byteOffset;
+
+					bool ok = false;
+					switch (m.mode)
+					{
+					case MeshoptMode::Attributes:
+						ok = MeshoptDecoder::DecodeVertexBuffer(dst, m.count, view.byteStride, src, m.byteLength) &&
+							MeshoptDecoder::ApplyFilter(m.filter, dst, m.count, view.byteStride);
+						break;
+					case MeshoptMode::Triangles:
+						ok = MeshoptDecoder::DecodeIndexBuffer(dst, m.count, view.byteStride, src, m.byteLength);
+						break;
+					case MeshoptMode::Indices:
+						ok = MeshoptDecoder::DecodeIndexSequence(dst, m.count, view.byteStride, src, m.byteLength);
+						break;
+					}
+					valid[i] = ok ? 1 : 0;
+				}
+			}, "GLTFAsset::DecodeMeshopt");
+
+		if (std::find(valid.begin(), valid.end(), 0) != valid.end())
+		{
+			fail("a compressed buffer view is corrupt");
+		}
+
+		for (Image& image : images)
+		{
+			if (image.view >= 0)
+			{
+				image.data = bufferViews[image.view].data;
+				image.size = bufferViews[image.view].byteLength;
+			}
+		}
+	}
+
+	void GLTFAsset::Validate() const
+	{
+		auto inRange = [](int32_t index, size_t size) { return index >= 0 && static_cast<size_t>(index) < size; };
+		auto fail = [](const char* what) { throw std::runtime_error(std::string("Failed to load glTF file, ") + what + "!"); };
+
+		for (const BufferView& view : bufferViews)
+		{
+			if (!inRange(view.buffer, buffers.size()) ||
+				view.byteOffset > buffers[view.buffer].size ||
+				view.byteLength > buffers[view.buffer].size - view.byteOffset)
+			{
+				fail("a buffer view is outside of its buffer");
+			}
+
+			if (!view.data && view.byteLength > 0)
+			{
+				fail("a buffer view only has meshopt fallback data");
+			}
+		}
+
+		for (const Accessor& a : accessors)
+		{
+			uint32_t componentSize = ComponentSize(a.componentType);
+			if (componentSize == 0)
+			{
+				fail("an accessor has an unknown component type");
+			}
+
+			size_t elementSize = static_cast<size_t>(componentSize) * a.components;
+
+			if (a.bufferView >= 0 && a.count > 0)
+			{
+				if (!inRange(a.bufferView, bufferViews.size()))
+				{
+					fail("an accessor references a missing buffer view");
+				}
+
+				const BufferView& view = bufferViews[a.bufferView];
+				size_t stride = view.byteStride ? view.byteStride : elementSize;
+				if (a.byteOffset > view.byteLength ||
+					(view.byteLength - a.byteOffset) < elementSize ||
+					(view.byteLength - a.byteOffset - elementSize) / stride < a.count - 1)
+				{
+					fail("an accessor reads past the end of its buffer view");
+				}
+			}
+
+			if (a.sparse.count > 0)
+			{
+				if (!inRange(a.sparse.indicesView, bufferViews.size()) ||
+					!inRange(a.sparse.valuesView, bufferViews.size()) ||
+					!IsIndexType(a.sparse.indicesType))
+				{
+					fail("a sparse accessor is malformed");
+				}
+
+				const BufferView& indices = bufferViews[a.sparse.indicesView];
+				const BufferView& values = bufferViews[a.sparse.valuesView];
+				if (a.sparse.indicesOffset > indices.byteLength ||
+					(indices.byteLength - a.sparse.indicesOffset) / ComponentSize(a.sparse.indicesType) < a.sparse.count ||
+					a.sparse.valuesOffset > values.byteLength ||
+					(values.byteLength - a.sparse.valuesOffset) / elementSize < a.sparse.count)
+				{
+					fail("a sparse accessor reads past the end of its buffer view");
+				}
+			}
+		}
+
+		for (const Mesh& mesh : meshes)
+		{
+			for (const Primitive& p : mesh.primitives)
+			{
+				for (int32_t attribute : { p.position, p.normal, p.texcoord0, p.tangent, p.indices })
+				{
+					if (attribute != -1 && !inRange(attribute, accessors.size()))
+					{
+						fail("a primitive references a missing accessor");
+					}
+				}
+
+				if (p.position >= 0)
+				{
+					size_t count = accessors[p.position].count;
+					for (int32_t attribute : { p.normal, p.texcoord0, p.tangent })
+					{
+						if (attribute >= 0 && accessors[attribute].count != count)
+						{
+							fail("a primitive's attributes have different counts");
+						}
+					}
+				}
+
+				if (p.indices >= 0 &&
+					(!IsIndexType(accessors[p.indices].componentType) || accessors[p.indices].components != 1))
+				{
+					fail("an index accessor isn't unsigned scalars");
+				}
+
+				if (p.material != -1 && !inRange(p.material, materials.size()))
+				{
+					fail("a primitive references a missing material");
+				}
+			}
+		}
+
+		for (const Node& node : nodes)
+		{
+			if (node.mesh != -1 && !inRange(node.mesh, meshes.size()))
+			{
+				fail("a node references a missing mesh");
+			}
+			for (int32_t child : node.children)
+			{
+				if (!inRange(child, nodes.size()))
+				{
+					fail("a node references a missing child");
+				}
+			}
+		}
+
+		// Nodes form strict trees: one parent at most, roots have none, so walks can't loop
+		std::vector<char> parented(nodes.size(), 0);
+		for (const Node& node : nodes)
+		{
+			for (int32_t child : node.children)
+			{
+				if (parented[child]++)
+				{
+					fail("a node has more than one parent");
+				}
+			}
+		}
+
+		for (int32_t root : sceneNodes)
+		{
+			if (!inRange(root, nodes.size()) || parented[root])
+			{
+				fail("the scene references a missing or parented node");
+			}
+		}
+
+		for (const Material& material : materials)
+		{
+			for (int32_t texture : { material.baseColorTexture, material.metallicRoughnessTexture,
+				material.normalTexture, material.occlusionTexture })
+			{
+				if (texture != -1 && !inRange(texture, textures.size()))
+				{
+					fail("a material references a missing texture");
+				}
+			}
+		}
+
+		for (const Texture& texture : textures)
+		{
+			if (texture.source != -1 && !inRange(texture.source, images.size()))
+			{
+				fail("a texture references a missing image");
+			}
+		}
+	}
+
+	void GLTFAsset::ReadFloats(int32_t accessor, size_t first, size_t count,
+		float* dst, size_t dstStride, uint32_t components) const
+	{
+		if (accessor < 0 || count == 0)
+		{
+			return;
+		}
+
+		const Accessor& a = accessors[accessor];
+		assert(first + count <= a.count && "Accessor read out of range!");
+
+		uint32_t n = std::min(a.components, components);
+
+		if (a.bufferView >= 0)
+		{
+			size_t stride;
+			const uint8_t* src = Elements(a, stride) + first * stride;
+			Convert(a.componentType, src, stride, count, n, a.normalized, dst, dstStride);
+		}
+		else
+		{
+			uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+			for (size_t i = 0; i < count; ++i, out += dstStride)
+			{
+				memset(out, 0, n * sizeof(float));
+			}
+		}
+
+		// Sparse indices are sorted, but ranges are small enough that a scan is fine
+		if (a.sparse.count > 0)
+		{
+			const uint8_t* indices = ViewData(a.sparse.indicesView) + a.sparse.indicesOffset;
+			const uint8_t* values = ViewData(a.sparse.valuesView) + a.sparse.valuesOffset;
+			size_t elementSize = static_cast<size_t>(ComponentSize(a.componentType)) * a.components;
+
+			for (size_t s = 0; s < a.sparse.count; ++s)
+			{
+				size_t target = ReadIndex(indices, s, a.sparse.indicesType);
+				if (target < first || target >= first + count)
+				{
+					continue;
+				}
+
+				float* out = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(dst) + (target - first) * dstStride);
+				Convert(a.componentType, values + s * elementSize, elementSize, 1, n, a.normalized, out, dstStride);
+			}
+		}
+	}
+
+	uint32_t GLTFAsset::ReadIndices(int32_t accessor, uint32_t* dst, uint32_t baseVertex) const
+	{
+		const Accessor& a = accessors[accessor];
+
+		uint32_t largest = 0;
+		if (a.bufferView >= 0)
+		{
+			size_t stride;
+			const uint8_t* src = Elements(a, stride);
+
+			switch (a.componentType)
+			{
+			case UNSIGNED_BYTE:
+				largest = CopyIndices<uint8_t>(src, stride, a.count, baseVertex, dst);
+				break;
+			case UNSIGNED_SHORT:
+				largest = CopyIndices<uint16_t>(src, stride, a.count, baseVertex, dst);
+				break;
+			default:
+				largest = CopyIndices<uint32_t>(src, stride, a.count, baseVertex, dst);
+				break;
+			}
+		}
+		else
+		{
+			std::fill(dst, dst + a.count, baseVertex);
+		}
+
+		if (a.sparse.count > 0)
+		{
+			const uint8_t* indices = ViewData(a.sparse.indicesView) + a.sparse.indicesOffset;
+			const uint8_t* values = ViewData(a.sparse.valuesView) + a.sparse.valuesOffset;
+
+			for (size_t s = 0; s < a.sparse.count; ++s)
+			{
+				size_t target = ReadIndex(indices, s, a.sparse.indicesType);
+				if (target < a.count)
+				{
+					uint32_t v = ReadIndex(values, s, a.componentType);
+					largest = std::max(largest, v);
+					dst[target] = v + baseVertex;
+				}
+			}
+		}
+
+		return largest;
+	}
+
+	uint32_t GLTFAsset::ComponentSize(uint32_t componentType)
+	{
+		switch (componentType)
+		{
+		case BYTE:
+		case UNSIGNED_BYTE:
+			return 1;
+		case SHORT:
+		case UNSIGNED_SHORT:
+			return 2;
+		case UNSIGNED_INT:
+		case FLOAT:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	const uint8_t* GLTFAsset::ViewData(int32_t view) const
+	{
+		return bufferViews[view].data;
+	}
+
+	const uint8_t* GLTFAsset::Elements(const Accessor& a, size_t& stride) const
+	{
+		const BufferView& view = bufferViews[a.bufferView];
+		size_t elementSize = static_cast<size_t>(ComponentSize(a.componentType)) * a.components;
+		stride = view.byteStride ? view.byteStride : elementSize;
+		return ViewData(a.bufferView) + a.byteOffset;
+	}
+}
\ No newline at end of file
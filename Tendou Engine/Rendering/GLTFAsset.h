@@ -0,0 +1,220 @@
+#ifndef GLTFASSET_H
+#define GLTFASSET_H
+
+#include "MeshoptDecoder.h"
+#include "../Core/MappedFile.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tendou
+{
+	// glTF 2.0 document that leaves the binary data where it is. .glb files and
+	// external buffers are memory mapped and accessors are read straight out of
+	// the mapping; only base64 data: URIs are decoded into memory. The JSON is
+	// reduced to the objects the renderer uses.
+	//
+	// Accessors are read with their buffer view's stride and any component type,
+	// normalized or not (KHR_mesh_quantization), sparse ones included, and written
+	// into the caller's interleaved layout in one pass. EXT_meshopt_compression
+	// views are decoded once at load, one job per view.
+	class GLTFAsset
+	{
+	public:
+		enum ComponentType : uint32_t
+		{
+			BYTE = 5120,
+			UNSIGNED_BYTE = 5121,
+			SHORT = 5122,
+			UNSIGNED_SHORT = 5123,
+			UNSIGNED_INT = 5125,
+			FLOAT = 5126,
+		};
+
+		enum PrimitiveMode : uint32_t
+		{
+			POINTS = 0,
+			LINES = 1,
+			TRIANGLES = 4,
+		};
+
+		enum class MeshoptMode : uint32_t
+		{
+			Attributes,
+			Triangles,
+			Indices,
+		};
+
+		struct BufferView
+		{
+			int32_t buffer = -1;
+			size_t byteOffset = 0;
+			size_t byteLength = 0;
+
+			// 0 when elements are tightly packed
+			size_t byteStride = 0;
+
+			// Start of the view, or of its decoded copy when it's compressed
+			const uint8_t* data = nullptr;
+
+			// EXT_meshopt_compression source, buffer is -1 when the view isn't compressed
+			struct
+			{
+				int32_t buffer = -1;
+				size_t byteOffset = 0;
+				size_t byteLength = 0;
+				size_t count = 0;
+				MeshoptMode mode = MeshoptMode::Attributes;
+				MeshoptDecoder::Filter filter = MeshoptDecoder::Filter::None;
+			} meshopt;
+		};
+
+		struct Accessor
+		{
+			int32_t bufferView = -1;
+			size_t byteOffset = 0;
+			size_t count = 0;
+			uint32_t componentType = FLOAT;
+			uint32_t components = 1;
+			bool normalized = false;
+
+			// Elements replaced on top of the dense data (or on top of zeros without a view)
+			struct
+			{
+				size_t count = 0;
+				int32_t indicesView = -1;
+				size_t indicesOffset = 0;
+				uint32_t indicesType = UNSIGNED_INT;
+				int32_t valuesView = -1;
+				size_t valuesOffset = 0;
+			} sparse;
+		};
+
+		// Attributes are accessor indices, -1 when the primitive doesn't have them
+		struct Primitive
+		{
+			int32_t position = -1;
+			int32_t normal = -1;
+			int32_t texcoord0 = -1;
+			int32_t tangent = -1;
+			int32_t indices = -1;
+			int32_t material = -1;
+			uint32_t mode = TRIANGLES;
+		};
+
+		struct Mesh
+		{
+			std::vector<Primitive> primitives;
+		};
+
+		struct Node
+		{
+			std::string name;
+			int32_t mesh = -1;
+			std::vector<int32_t> children;
+
+			// Either the node's matrix or its translation * rotation * scale
+			glm::mat4 matrix = glm::mat4(1.0f);
+		};
+
+		struct Material
+		{
+			glm::vec4 baseColorFactor = glm::vec4(1.0f);
+			int32_t baseColorTexture = -1;
+			int32_t metallicRoughnessTexture = -1;
+			int32_t normalTexture = -1;
+			int32_t occlusionTexture = -1;
+			std::string alphaMode = "OPAQUE";
+			float alphaCutoff = 0.5f;
+			bool doubleSided = false;
+
+			// KHR_texture_transform of the base color texture as scale.xy, offset.xy.
+			// Every texture shares the first UV set, so the others reuse it. Rotation is ignored.
+			glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+		};
+
+		struct Texture
+		{
+			int32_t source = -1;
+		};
+
+		struct Image
+		{
+			// Relative to the asset's directory, empty when the image is embedded
+			std::string uri;
+			std::string mimeType;
+
+			// Embedded images, pointing into a mapping or a decoded data: URI
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+
+			// Buffer view the data comes from, -1 for URIs
+			int32_t view = -1;
+		};
+
+		GLTFAsset() = default;
+
+		GLTFAsset(const GLTFAsset&) = delete;
+		GLTFAsset& operator=(const GLTFAsset&) = delete;
+
+		// Throws if the file can't be read, isn't glTF 2.0 or references data it
+		// doesn't have, so the reads below never need to check. Call once per asset.
+		void Load(const std::string& path);
+
+		// Converts elements [first, first + count) of accessor to float - integer
+		// components are scaled to [0, 1] or [-1, 1] when normalized - and writes up to
+		// components of each into dst, dstStride bytes apart. Components the accessor
+		// doesn't have are left untouched; an accessor of -1 writes nothing.
+		void ReadFloats(int32_t accessor, size_t first, size_t count,
+			float* dst, size_t dstStride, uint32_t components) const;
+
+		// Every index of accessor plus baseVertex, tightly packed. Returns the
+		// largest index read, before baseVertex is added.
+		uint32_t ReadIndices(int32_t accessor, uint32_t* dst, uint32_t baseVertex) const;
+
+		static uint32_t ComponentSize(uint32_t componentType);
+
+		std::vector<BufferView> bufferViews;
+		std::vector<Accessor> accessors;
+		std::vector<Mesh> meshes;
+		std::vector<Node> nodes;
+		std::vector<Material> materials;
+		std::vector<Texture> textures;
+		std::vector<Image> images;
+
+		// Root nodes of the default scene
+		std::vector<int32_t> sceneNodes;
+
+	private:
+		// Meshopt fallback buffers keep their size but have no data
+		struct Buffer
+		{
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+		};
+
+		void Parse(const char* json, size_t size, const Buffer& glbBuffer, const std::string& directory);
+		void Validate() const;
+
+		// Points every view at its data, decoding the compressed ones in parallel
+		void ResolveViews();
+
+		const uint8_t* ViewData(int32_t view) const;
+
+		// Start of an accessor's elements and the distance between them
+		const uint8_t* Elements(const Accessor& a, size_t& stride) const;
+
+		MappedFile file;
+		std::vector<MappedFile> externalFiles;
+		std::vector<std::vector<uint8_t>> decoded;
+		std::vector<Buffer> buffers;
+	};
+}
+
+#endif
\ No newline at end of file
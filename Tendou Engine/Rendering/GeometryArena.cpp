@@ -0,0 +1,443 @@
+#include "GeometryArena.h"
+
+#include "../Core/Profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace Tendou
+{
+	namespace
+	{
+		constexpr VkBufferUsageFlags VERTEX_USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		constexpr VkBufferUsageFlags INDEX_USAGE = VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+		__inline VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		std::unique_ptr<Buffer> CreatePool(TendouDevice& device, VkDeviceSize bytes, VkBufferUsageFlags usage)
+		{
+			if (bytes > UINT32_MAX)
+			{
+				throw std::runtime_error("Failed to grow geometry arena, a pool would exceed 4 GB!");
+			}
+
+			return std::make_unique<Buffer>(device, 1, static_cast<uint32_t>(bytes), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+	}
+
+	void GeometryArena::FreeList::Reset(VkDeviceSize capacity_, VkDeviceSize used)
+	{
+		assert(used <= capacity_ && "Free list reset below its used size!");
+
+		blocks.clear();
+		capacity = capacity_;
+		freeBytes = capacity_ - used;
+		if (freeBytes > 0)
+		{
+			blocks.emplace(used, freeBytes);
+		}
+	}
+
+	VkDeviceSize GeometryArena::FreeList::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		for (auto it = blocks.begin(); it != blocks.end(); ++it)
+		{
+			VkDeviceSize blockStart = it->first;
+			VkDeviceSize blockEnd = it->first + it->second;
+			VkDeviceSize start = AlignUp(blockStart, alignment);
+			if (start + size > blockEnd)
+			{
+				continue;
+			}
+
+			// The block's unaligned head stays free, the tail after the range too
+			blocks.erase(it);
+			if (start > blockStart)
+			{
+				blocks.emplace(blockStart, start - blockStart);
+			}
+			if (start + size < blockEnd)
+			{
+				blocks.emplace(start + size, blockEnd - start - size);
+			}
+
+			freeBytes -= size;
+			return start;
+		}
+
+		return NO_SPACE;
+	}
+
+	void GeometryArena::FreeList::Release(VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		freeBytes += size;
+
+		auto next = blocks.lower_bound(offset);
+		if (next != blocks.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = blocks.erase(next);
+		}
+
+		if (next != blocks.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				prev->second += size;
+				return;
+			}
+		}
+
+		blocks.emplace_hint(next, offset, size);
+	}
+
+	GeometryArena::GeometryArena(TendouDevice& device_, const GeometryArenaConfig& config)
+		: device(device_)
+	{
+		vertexBuffer = CreatePool(device, config.vertexBytes, VERTEX_USAGE);
+		indexBuffer = CreatePool(device, static_cast<VkDeviceSize>(config.indexCount) * sizeof(uint32_t), INDEX_USAGE);
+		vertexSpace.Reset(config.vertexBytes, 0);
+		indexSpace.Reset(config.indexCount, 0);
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+	}
+
+	GeometryArena::Handle GeometryArena::Allocate(uint32_t vertexStride, uint32_t vertexCount, uint32_t indexCount)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		assert(vertexStride > 0 && vertexCount > 0 && "Geometry needs vertices!");
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexStride) * vertexCount;
+		VkDeviceSize vertexOffset = vertexSpace.Allocate(vertexBytes, vertexStride);
+		VkDeviceSize firstIndex = indexCount > 0 ? indexSpace.Allocate(indexCount, 1) : 0;
+
+		if (vertexOffset == FreeList::NO_SPACE || firstIndex == FreeList::NO_SPACE)
+		{
+			if (vertexOffset != FreeList::NO_SPACE)
+			{
+				vertexSpace.Release(vertexOffset, vertexBytes);
+			}
+			if (indexCount > 0 && firstIndex != FreeList::NO_SPACE)
+			{
+				indexSpace.Release(firstIndex, indexCount);
+			}
+
+			// Packed, the live ranges need at most their sizes plus one stride of padding each
+			VkDeviceSize vertexNeeded = vertexBytes + vertexStride;
+			for (const Allocation& a : allocations)
+			{
+				if (a.live)
+				{
+					vertexNeeded += static_cast<VkDeviceSize>(a.vertexStride) * (a.range.vertexCount + 1);
+				}
+			}
+			VkDeviceSize indexNeeded = indexSpace.Capacity() - indexSpace.FreeBytes() + indexCount;
+
+			VkDeviceSize vertexCapacity = vertexSpace.Capacity();
+			VkDeviceSize indexCapacity = indexSpace.Capacity();
+			while (vertexCapacity < vertexNeeded)
+			{
+				vertexCapacity *= 2;
+			}
+			while (indexCapacity < indexNeeded)
+			{
+				indexCapacity *= 2;
+			}
+
+			Rebuild(vertexCapacity, indexCapacity);
+
+			vertexOffset = vertexSpace.Allocate(vertexBytes, vertexStride);
+			firstIndex = indexCount > 0 ? indexSpace.Allocate(indexCount, 1) : 0;
+			assert(vertexOffset != FreeList::NO_SPACE && firstIndex != FreeList::NO_SPACE && "Geometry arena grew too little!");
+		}
+
+		Handle handle;
+		if (!freeHandles.empty())
+		{
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<Handle>(allocations.size());
+			allocations.emplace_back();
+		}
+
+		Allocation& a = allocations[handle];
+		a.range.vertexOffset = static_cast<uint32_t>(vertexOffset / vertexStride);
+		a.range.vertexCount = vertexCount;
+		a.range.firstIndex = static_cast<uint32_t>(firstIndex);
+		a.range.indexCount = indexCount;
+		a.vertexStride = vertexStride;
+		a.live = true;
+
+		return handle;
+	}
+
+	void GeometryArena::Free(Handle handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		Allocation& a = allocations[handle];
+		assert(a.live && "Geometry freed twice!");
+
+		vertexSpace.Release(static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexOffset,
+			static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexCount);
+		indexSpace.Release(a.range.firstIndex, a.range.indexCount);
+
+		a = Allocation();
+		freeHandles.push_back(handle);
+	}
+
+	void GeometryArena::Upload(Handle handle, const void* vertices, const uint32_t* indices)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		const Allocation& a = allocations[handle];
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexCount;
+		VkDeviceSize indexBytes = static_cast<VkDeviceSize>(a.range.indexCount) * sizeof(uint32_t);
+
+		Buffer staging
+		{
+			device,
+			1,
+			static_cast<uint32_t>(vertexBytes + indexBytes),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+		staging.Map();
+
+		uint8_t* mapped = static_cast<uint8_t*>(staging.GetMappedMemory());
+		memcpy(mapped, vertices, vertexBytes);
+		if (indexBytes > 0)
+		{
+			memcpy(mapped + vertexBytes, indices, indexBytes);
+		}
+
+		VkCommandBuffer commandBuffer = device.BeginSingleTimeCommands();
+
+		VkBufferCopy vertexCopy{};
+		vertexCopy.srcOffset = 0;
+		vertexCopy.dstOffset = static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexOffset;
+		vertexCopy.size = vertexBytes;
+		vkCmdCopyBuffer(commandBuffer, staging.GetBuffer(), vertexBuffer->GetBuffer(), 1, &vertexCopy);
+
+		if (indexBytes > 0)
+		{
+			VkBufferCopy indexCopy{};
+			indexCopy.srcOffset = vertexBytes;
+			indexCopy.dstOffset = static_cast<VkDeviceSize>(a.range.firstIndex) * sizeof(uint32_t);
+			indexCopy.size = indexBytes;
+			vkCmdCopyBuffer(commandBuffer, staging.GetBuffer(), indexBuffer->GetBuffer(), 1, &indexCopy);
+		}
+
+		device.EndSingleTimeCommands(commandBuffer);
+	}
+
+	void GeometryArena::Download(Handle handle, void* vertices, uint32_t* indices)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		const Allocation& a = allocations[handle];
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexCount;
+		VkDeviceSize indexBytes = static_cast<VkDeviceSize>(a.range.indexCount) * sizeof(uint32_t);
+
+		Buffer staging
+		{
+			device,
+			1,
+			static_cast<uint32_t>(vertexBytes + indexBytes),
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+		staging.Map();
+
+		VkCommandBuffer commandBuffer = device.BeginSingleTimeCommands();
+
+		VkBufferCopy vertexCopy{};
+		vertexCopy.srcOffset = static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexOffset;
+		vertexCopy.dstOffset = 0;
+		vertexCopy.size = vertexBytes;
+		vkCmdCopyBuffer(commandBuffer, vertexBuffer->GetBuffer(), staging.GetBuffer(), 1, &vertexCopy);
+
+		if (indexBytes > 0)
+		{
+			VkBufferCopy indexCopy{};
+			indexCopy.srcOffset = static_cast<VkDeviceSize>(a.range.firstIndex) * sizeof(uint32_t);
+			indexCopy.dstOffset = vertexBytes;
+			indexCopy.size = indexBytes;
+			vkCmdCopyBuffer(commandBuffer, indexBuffer->GetBuffer(), staging.GetBuffer(), 1, &indexCopy);
+		}
+
+		device.EndSingleTimeCommands(commandBuffer);
+
+		const uint8_t* mapped = static_cast<const uint8_t*>(staging.GetMappedMemory());
+		memcpy(vertices, mapped, vertexBytes);
+		if (indexBytes > 0)
+		{
+			memcpy(indices, mapped + vertexBytes, indexBytes);
+		}
+	}
+
+	void GeometryArena::Compact()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		Rebuild(vertexSpace.Capacity(), indexSpace.Capacity());
+	}
+
+	void GeometryArena::Rebuild(VkDeviceSize vertexBytes, VkDeviceSize indexCount)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		// Packed in their current order, so the copies never overlap and stay sorted
+		std::vector<Handle> live;
+		for (Handle h = 0; h < allocations.size(); ++h)
+		{
+			if (allocations[h].live)
+			{
+				live.push_back(h);
+			}
+		}
+
+		auto vertexStart = [&](Handle h)
+		{
+			return static_cast<VkDeviceSize>(allocations[h].vertexStride) * allocations[h].range.vertexOffset;
+		};
+		std::sort(live.begin(), live.end(), [&](Handle a, Handle b) { return vertexStart(a) < vertexStart(b); });
+
+		std::vector<VkBufferCopy> vertexCopies;
+		std::vector<VkBufferCopy> indexCopies;
+		std::vector<Range> packed(live.size());
+		std::vector<std::pair<VkDeviceSize, VkDeviceSize>> padding;
+
+		VkDeviceSize vertexCursor = 0;
+		VkDeviceSize indexCursor = 0;
+		for (size_t i = 0; i < live.size(); ++i)
+		{
+			const Allocation& a = allocations[live[i]];
+			VkDeviceSize size = static_cast<VkDeviceSize>(a.vertexStride) * a.range.vertexCount;
+
+			VkDeviceSize aligned = AlignUp(vertexCursor, a.vertexStride);
+			if (aligned > vertexCursor)
+			{
+				padding.emplace_back(vertexCursor, aligned - vertexCursor);
+			}
+			vertexCursor = aligned;
+			vertexCopies.push_back({ vertexStart(live[i]), vertexCursor, size });
+
+			packed[i] = a.range;
+			packed[i].vertexOffset = static_cast<uint32_t>(vertexCursor / a.vertexStride);
+			vertexCursor += size;
+
+			if (a.range.indexCount > 0)
+			{
+				indexCopies.push_back({ static_cast<VkDeviceSize>(a.range.firstIndex) * sizeof(uint32_t),
+					indexCursor * sizeof(uint32_t), static_cast<VkDeviceSize>(a.range.indexCount) * sizeof(uint32_t) });
+				packed[i].firstIndex = static_cast<uint32_t>(indexCursor);
+				indexCursor += a.range.indexCount;
+			}
+		}
+
+		assert(vertexCursor <= vertexBytes && indexCursor <= indexCount && "Geometry arena rebuilt too small!");
+
+		std::unique_ptr<Buffer> vertices = CreatePool(device, vertexBytes, VERTEX_USAGE);
+		std::unique_ptr<Buffer> indices = CreatePool(device, indexCount * sizeof(uint32_t), INDEX_USAGE);
+
+		// Frames in flight may still read the old buffers
+		vkDeviceWaitIdle(device.Device());
+
+		if (!vertexCopies.empty() || !indexCopies.empty())
+		{
+			VkCommandBuffer commandBuffer = device.BeginSingleTimeCommands();
+			if (!vertexCopies.empty())
+			{
+				vkCmdCopyBuffer(commandBuffer, vertexBuffer->GetBuffer(), vertices->GetBuffer(),
+					static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+			}
+			if (!indexCopies.empty())
+			{
+				vkCmdCopyBuffer(commandBuffer, indexBuffer->GetBuffer(), indices->GetBuffer(),
+					static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+			}
+			device.EndSingleTimeCommands(commandBuffer);
+		}
+
+		vertexBuffer = std::move(vertices);
+		indexBuffer = std::move(indices);
+		vertexSpace.Reset(vertexBytes, vertexCursor);
+		indexSpace.Reset(indexCount, indexCursor);
+
+		// Gaps left by stride alignment can still fit smaller vertices
+		for (const auto& gap : padding)
+		{
+			vertexSpace.Release(gap.first, gap.second);
+		}
+
+		for (size_t i = 0; i < live.size(); ++i)
+		{
+			allocations[live[i]].range = packed[i];
+		}
+		++generation;
+	}
+
+	void GeometryArena::Bind(VkCommandBuffer commandBuffer) const
+	{
+		VkBuffer buffers[] = { vertexBuffer->GetBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	void GeometryArena::DrawPanel(bool* open)
+	{
+		if (!ImGui::Begin("Geometry Arena", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		size_t live = allocations.size() - freeHandles.size();
+		VkDeviceSize vertexUsed = vertexSpace.Capacity() - vertexSpace.FreeBytes();
+		VkDeviceSize indexUsed = indexSpace.Capacity() - indexSpace.FreeBytes();
+
+		ImGui::Text("Allocations: %zu  Generation: %llu", live, static_cast<unsigned long long>(generation));
+		ImGui::Text("Vertices: %.1f / %.1f MB in %zu free blocks", vertexUsed / (1024.0 * 1024.0),
+			vertexSpace.Capacity() / (1024.0 * 1024.0), vertexSpace.BlockCount());
+		ImGui::Text("Indices: %.1f / %.1f M in %zu free blocks", indexUsed / 1e6,
+			indexSpace.Capacity() / 1e6, indexSpace.BlockCount());
+
+		if (ImGui::Button("Compact"))
+		{
+			Rebuild(vertexSpace.Capacity(), indexSpace.Capacity());
+		}
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
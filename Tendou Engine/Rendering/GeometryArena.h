@@ -0,0 +1,118 @@
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include "Buffer.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tendou
+{
+	struct GeometryArenaConfig
+	{
+		VkDeviceSize vertexBytes = 32ull << 20;
+		uint32_t indexCount = 8u << 20;
+	};
+
+	// One device local vertex buffer and one index buffer that every Model
+	// sub-allocates from, so a pass binds geometry once instead of per object.
+	// Ranges come from first-fit free lists; when a pool runs out both buffers
+	// are rebuilt larger with the live ranges packed to the front, which is also
+	// what Compact() does at the current size.
+	//
+	// Vertex ranges are aligned to their own stride, so differently sized
+	// vertices share the buffer and still draw with it bound at offset 0.
+	// Allocate, Upload, Free and Compact may relocate ranges and must not run
+	// while command buffers that use the arena are being recorded.
+	class GeometryArena
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = ~0u;
+
+		// Where an allocation currently lives, in vertices of its stride and in indices
+		struct Range
+		{
+			uint32_t vertexOffset = 0;
+			uint32_t vertexCount = 0;
+			uint32_t firstIndex = 0;
+			uint32_t indexCount = 0;
+		};
+
+		GeometryArena(TendouDevice& device, const GeometryArenaConfig& config = GeometryArenaConfig());
+		~GeometryArena();
+
+		GeometryArena(const GeometryArena&) = delete;
+		GeometryArena& operator=(const GeometryArena&) = delete;
+
+		Handle Allocate(uint32_t vertexStride, uint32_t vertexCount, uint32_t indexCount);
+		void Free(Handle handle);
+
+		// Copies the allocation's data in through a staging buffer; indices are local to its vertices
+		void Upload(Handle handle, const void* vertices, const uint32_t* indices);
+
+		// Reads the allocation back, stalls on the copy so it's meant for load time
+		void Download(Handle handle, void* vertices, uint32_t* indices);
+
+		// Packs every live range to the front of freshly allocated buffers
+		void Compact();
+
+		void Bind(VkCommandBuffer commandBuffer) const;
+
+		__inline const Range& Get(Handle handle) const { return allocations[handle].range; }
+
+		// Bumped whenever ranges move, so anything holding recorded offsets can tell
+		__inline uint64_t Generation() const { return generation; }
+
+		void DrawPanel(bool* open);
+
+	private:
+		// First-fit over sorted free blocks, merged with their neighbours on release
+		class FreeList
+		{
+		public:
+			static constexpr VkDeviceSize NO_SPACE = ~0ull;
+
+			void Reset(VkDeviceSize capacity, VkDeviceSize used);
+			VkDeviceSize Allocate(VkDeviceSize size, VkDeviceSize alignment);
+			void Release(VkDeviceSize offset, VkDeviceSize size);
+
+			__inline VkDeviceSize Capacity() const { return capacity; }
+			__inline VkDeviceSize FreeBytes() const { return freeBytes; }
+			__inline size_t BlockCount() const { return blocks.size(); }
+
+		private:
+			std::map<VkDeviceSize, VkDeviceSize> blocks;
+			VkDeviceSize capacity = 0;
+			VkDeviceSize freeBytes = 0;
+		};
+
+		struct Allocation
+		{
+			Range range;
+			uint32_t vertexStride = 0;
+			bool live = false;
+		};
+
+		// Recreates both buffers at the given sizes, copying the live ranges over packed
+		void Rebuild(VkDeviceSize vertexBytes, VkDeviceSize indexCount);
+
+		TendouDevice& device;
+
+		std::unique_ptr<Buffer> vertexBuffer;
+		std::unique_ptr<Buffer> indexBuffer;
+		FreeList vertexSpace;
+		FreeList indexSpace;
+
+		std::vector<Allocation> allocations;
+		std::vector<Handle> freeHandles;
+		uint64_t generation = 0;
+
+		std::mutex lock;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,516 @@
+#include "MeshoptDecoder.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace Tendou
+{
+	namespace
+	{
+		constexpr uint8_t VERTEX_HEADER = 0xA0;
+		constexpr uint8_t INDEX_HEADER = 0xE0;
+		constexpr uint8_t SEQUENCE_HEADER = 0xD0;
+
+		// Vertex codec: blocks of up to 256 vertices, each byte of the vertex stored
+		// as its own stream of zigzag deltas in groups of 16
+		constexpr size_t VERTEX_BLOCK_BYTES = 8192;
+		constexpr size_t VERTEX_BLOCK_MAX = 256;
+		constexpr size_t BYTE_GROUP_SIZE = 16;
+		constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+		constexpr size_t TAIL_MIN_SIZE = 32;
+
+		__inline uint8_t Unzigzag8(uint8_t v)
+		{
+			return static_cast<uint8_t>((0 - (v & 1)) ^ (v >> 1));
+		}
+
+		size_t VertexBlockSize(size_t stride)
+		{
+			size_t result = (VERTEX_BLOCK_BYTES / stride) & ~(BYTE_GROUP_SIZE - 1);
+			return result < VERTEX_BLOCK_MAX ? result : VERTEX_BLOCK_MAX;
+		}
+
+		// One group of 16 bytes, 0, 2, 4 or 8 bits each. A value with every bit set
+		// is an escape, the real byte follows the packed bits.
+		const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* out, int bitsLog2)
+		{
+			switch (bitsLog2)
+			{
+			case 0:
+				memset(out, 0, BYTE_GROUP_SIZE);
+				return data;
+			case 1:
+			case 2:
+			{
+				const uint32_t bits = 1u << bitsLog2;
+				const uint32_t escape = (1u << bits) - 1;
+				const uint8_t* extra = data + bits * BYTE_GROUP_SIZE / 8;
+
+				for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i)
+				{
+					uint32_t shift = 8 - bits - static_cast<uint32_t>(i * bits % 8);
+					uint32_t enc = (data[i * bits / 8] >> shift) & escape;
+					out[i] = enc == escape ? *extra++ : static_cast<uint8_t>(enc);
+				}
+				return extra;
+			}
+			default:
+				memcpy(out, data, BYTE_GROUP_SIZE);
+				return data + BYTE_GROUP_SIZE;
+			}
+		}
+
+		const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* end, uint8_t* out, size_t size)
+		{
+			// Two header bits per group
+			const uint8_t* header = data;
+			size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+			if (static_cast<size_t>(end - data) < headerSize)
+			{
+				return nullptr;
+			}
+			data += headerSize;
+
+			for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE)
+			{
+				// A group reads at most 24 bytes, and the stream always ends in a longer tail
+				if (static_cast<size_t>(end - data) < BYTE_GROUP_DECODE_LIMIT)
+				{
+					return nullptr;
+				}
+
+				size_t group = i / BYTE_GROUP_SIZE;
+				int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+				data = DecodeBytesGroup(data, out + i, bitsLog2);
+			}
+
+			return data;
+		}
+
+		const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* end, uint8_t* dst,
+			size_t count, size_t stride, uint8_t* last)
+		{
+			uint8_t buffer[VERTEX_BLOCK_MAX];
+			size_t alignedCount = (count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+
+			for (size_t k = 0; k < stride; ++k)
+			{
+				data = DecodeBytes(data, end, buffer, alignedCount);
+				if (!data)
+				{
+					return nullptr;
+				}
+
+				uint8_t p = last[k];
+				for (size_t i = 0; i < count; ++i)
+				{
+					p = static_cast<uint8_t>(Unzigzag8(buffer[i]) + p);
+					dst[i * stride + k] = p;
+				}
+				last[k] = p;
+			}
+
+			return data;
+		}
+
+		__inline void WriteIndex(uint8_t* dst, size_t i, size_t indexSize, uint32_t v)
+		{
+			if (indexSize == 2)
+			{
+				uint16_t s = static_cast<uint16_t>(v);
+				memcpy(dst + i * 2, &s, 2);
+			}
+			else
+			{
+				memcpy(dst + i * 4, &v, 4);
+			}
+		}
+
+		__inline void WriteTriangle(uint8_t* dst, size_t i, size_t indexSize, uint32_t a, uint32_t b, uint32_t c)
+		{
+			WriteIndex(dst, i + 0, indexSize, a);
+			WriteIndex(dst, i + 1, indexSize, b);
+			WriteIndex(dst, i + 2, indexSize, c);
+		}
+
+		__inline uint32_t DecodeVByte(const uint8_t*& data)
+		{
+			uint8_t lead = *data++;
+			if (lead < 128)
+			{
+				return lead;
+			}
+
+			uint32_t result = lead & 127;
+			uint32_t shift = 7;
+			for (int i = 0; i < 4; ++i)
+			{
+				uint8_t group = *data++;
+				result |= static_cast<uint32_t>(group & 127) << shift;
+				shift += 7;
+				if (group < 128)
+				{
+					break;
+				}
+			}
+			return result;
+		}
+
+		__inline uint32_t DecodeIndex(const uint8_t*& data, uint32_t last)
+		{
+			uint32_t v = DecodeVByte(data);
+			uint32_t d = (v >> 1) ^ (0u - (v & 1));
+			return last + d;
+		}
+
+		struct IndexFifos
+		{
+			uint32_t edges[16][2];
+			uint32_t vertices[16];
+			size_t edgeOffset = 0;
+			size_t vertexOffset = 0;
+
+			IndexFifos()
+			{
+				memset(edges, -1, sizeof(edges));
+				memset(vertices, -1, sizeof(vertices));
+			}
+
+			__inline void PushEdge(uint32_t a, uint32_t b)
+			{
+				edges[edgeOffset][0] = a;
+				edges[edgeOffset][1] = b;
+				edgeOffset = (edgeOffset + 1) & 15;
+			}
+
+			__inline void PushVertex(uint32_t v, bool advance = true)
+			{
+				vertices[vertexOffset] = v;
+				vertexOffset = (vertexOffset + (advance ? 1 : 0)) & 15;
+			}
+		};
+
+		template <typename T>
+		void DecodeOctahedral(T* data, size_t count, size_t stride)
+		{
+			const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+			const size_t step = stride / sizeof(T);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				T* v = data + i * step;
+
+				// z is stored as 1 minus the other two, so the octahedron folds back for z < 0
+				float x = static_cast<float>(v[0]);
+				float y = static_cast<float>(v[1]);
+				float z = static_cast<float>(v[2]) - std::fabs(x) - std::fabs(y);
+
+				float t = z < 0.0f ? z : 0.0f;
+				x += x >= 0.0f ? t : -t;
+				y += y >= 0.0f ? t : -t;
+
+				float l = std::sqrt(x * x + y * y + z * z);
+				float s = l > 0.0f ? max / l : 0.0f;
+
+				v[0] = static_cast<T>(static_cast<int>(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+				v[1] = static_cast<T>(static_cast<int>(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+				v[2] = static_cast<T>(static_cast<int>(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+			}
+		}
+
+		void DecodeQuaternion(int16_t* data, size_t count)
+		{
+			const float scale = 1.0f / std::sqrt(2.0f);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				int16_t* q = data + i * 4;
+
+				// The low two bits of w say which component was dropped, the rest scale the others
+				int sf = q[3] | 3;
+				float ss = scale / static_cast<float>(sf);
+
+				float x = static_cast<float>(q[0]) * ss;
+				float y = static_cast<float>(q[1]) * ss;
+				float z = static_cast<float>(q[2]) * ss;
+
+				float ww = 1.0f - x * x - y * y - z * z;
+				float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+				int xf = static_cast<int>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+				int yf = static_cast<int>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+				int zf = static_cast<int>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+				int wf = static_cast<int>(w * 32767.0f + 0.5f);
+
+				int qc = q[3] & 3;
+				q[(qc + 1) & 3] = static_cast<int16_t>(xf);
+				q[(qc + 2) & 3] = static_cast<int16_t>(yf);
+				q[(qc + 3) & 3] = static_cast<int16_t>(zf);
+				q[(qc + 0) & 3] = static_cast<int16_t>(wf);
+			}
+		}
+
+		void DecodeExponential(uint32_t* data, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint32_t v = data[i];
+
+				int32_t m = static_cast<int32_t>(v << 8) >> 8;
+				int32_t e = static_cast<int32_t>(v) >> 24;
+
+				// ldexp(m, e) without the library call
+				uint32_t bits = static_cast<uint32_t>(e + 127) << 23;
+				float f;
+				memcpy(&f, &bits, sizeof(f));
+				f *= static_cast<float>(m);
+				memcpy(&data[i], &f, sizeof(f));
+			}
+		}
+	}
+
+	bool MeshoptDecoder::DecodeVertexBuffer(uint8_t* dst, size_t count, size_t stride, const uint8_t* src, size_t size)
+	{
+		if (stride == 0 || stride > 256 || stride % 4 != 0)
+		{
+			return false;
+		}
+
+		const uint8_t* data = src;
+		const uint8_t* end = src + size;
+
+		if (size < 1 + stride || (*data & 0xF0) != VERTEX_HEADER || (*data & 0x0F) > 0)
+		{
+			return false;
+		}
+		++data;
+
+		// The tail holds the first vertex's baseline
+		uint8_t last[256];
+		memcpy(last, end - stride, stride);
+
+		size_t blockSize = VertexBlockSize(stride);
+		for (size_t offset = 0; offset < count; offset += blockSize)
+		{
+			size_t block = offset + blockSize < count ? blockSize : count - offset;
+			data = DecodeVertexBlock(data, end, dst + offset * stride, block, stride, last);
+			if (!data)
+			{
+				return false;
+			}
+		}
+
+		size_t tailSize = stride < TAIL_MIN_SIZE ? TAIL_MIN_SIZE : stride;
+		return static_cast<size_t>(end - data) == tailSize;
+	}
+
+	bool MeshoptDecoder::DecodeIndexBuffer(uint8_t* dst, size_t count, size_t indexSize, const uint8_t* src, size_t size)
+	{
+		if (count % 3 != 0 || (indexSize != 2 && indexSize != 4))
+		{
+			return false;
+		}
+
+		// Header, at least a code byte per triangle, then the 16 byte codeaux table
+		if (size < 1 + count / 3 + 16 || (src[0] & 0xF0) != INDEX_HEADER || (src[0] & 0x0F) > 1)
+		{
+			return false;
+		}
+
+		const int version = src[0] & 0x0F;
+		const int fecMax = version >= 1 ? 13 : 15;
+
+		IndexFifos fifo;
+		uint32_t next = 0;
+		uint32_t last = 0;
+
+		const uint8_t* code = src + 1;
+		const uint8_t* data = code + count / 3;
+		// The encoder's codeaux table is stored in the last 16 bytes
+		const uint8_t* safeEnd = src + size - 16;
+		const uint8_t* codeAux = safeEnd;
+
+		for (size_t i = 0; i < count; i += 3)
+		{
+			// A triangle reads at most 16 bytes, which the codeaux table always covers
+			if (data > safeEnd)
+			{
+				return false;
+			}
+
+			uint8_t codeTri = *code++;
+
+			if (codeTri < 0xF0)
+			{
+				// Edge from the edge fifo, third vertex new, from the vertex fifo or explicit
+				int fe = codeTri >> 4;
+				uint32_t a = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][0];
+				uint32_t b = fifo.edges[(fifo.edgeOffset - 1 - fe) & 15][1];
+
+				int fec = codeTri & 15;
+				if (fec < fecMax)
+				{
+					uint32_t c = fec == 0 ? next : fifo.vertices[(fifo.vertexOffset - 1 - fec) & 15];
+					bool fresh = fec == 0;
+					next += fresh ? 1 : 0;
+
+					WriteTriangle(dst, i, indexSize, a, b, c);
+					fifo.PushVertex(c, fresh);
+					fifo.PushEdge(c, b);
+					fifo.PushEdge(a, c);
+				}
+				else
+				{
+					// 13 and 14 are the last explicit index -1 and +1
+					uint32_t c = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+					last = c;
+
+					WriteTriangle(dst, i, indexSize, a, b, c);
+					fifo.PushVertex(c);
+					fifo.PushEdge(c, b);
+					fifo.PushEdge(a, c);
+				}
+			}
+			else if (codeTri < 0xFE)
+			{
+				// No shared edge, fifo positions of b and c from the table
+				uint8_t aux = codeAux[codeTri & 15];
+				int feb = aux >> 4;
+				int fec = aux & 15;
+
+				uint32_t a = next++;
+
+				uint32_t b = feb == 0 ? next : fifo.vertices[(fifo.vertexOffset - feb) & 15];
+				next += feb == 0 ? 1 : 0;
+
+				uint32_t c = fec == 0 ? next : fifo.vertices[(fifo.vertexOffset - fec) & 15];
+				next += fec == 0 ? 1 : 0;
+
+				WriteTriangle(dst, i, indexSize, a, b, c);
+				fifo.PushVertex(a);
+				fifo.PushVertex(b, feb == 0);
+				fifo.PushVertex(c, fec == 0);
+				fifo.PushEdge(b, a);
+				fifo.PushEdge(c, b);
+				fifo.PushEdge(a, c);
+			}
+			else
+			{
+				// Same, with codeaux spelled out and any vertex possibly explicit
+				uint8_t aux = *data++;
+				int fea = codeTri == 0xFE ? 0 : 15;
+				int feb = aux >> 4;
+				int fec = aux & 15;
+
+				if (aux == 0)
+				{
+					next = 0;
+				}
+
+				uint32_t a = fea == 0 ? next++ : 0;
+				uint32_t b = feb == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - feb) & 15];
+				uint32_t c = fec == 0 ? next++ : fifo.vertices[(fifo.vertexOffset - fec) & 15];
+
+				if (fea == 15)
+				{
+					last = a = DecodeIndex(data, last);
+				}
+				if (feb == 15)
+				{
+					last = b = DecodeIndex(data, last);
+				}
+				if (fec == 15)
+				{
+					last = c = DecodeIndex(data, last);
+				}
+
+				WriteTriangle(dst, i, indexSize, a, b, c);
+				fifo.PushVertex(a);
+				fifo.PushVertex(b, feb == 0 || feb == 15);
+				fifo.PushVertex(c, fec == 0 || fec == 15);
+				fifo.PushEdge(b, a);
+				fifo.PushEdge(c, b);
+				fifo.PushEdge(a, c);
+			}
+		}
+
+		return data == safeEnd;
+	}
+
+	bool MeshoptDecoder::DecodeIndexSequence(uint8_t* dst, size_t count, size_t indexSize, const uint8_t* src, size_t size)
+	{
+		if (indexSize != 2 && indexSize != 4)
+		{
+			return false;
+		}
+
+		// Header, at least a byte per index, then a 4 byte tail
+		if (size < 1 + count + 4 || (src[0] & 0xF0) != SEQUENCE_HEADER || (src[0] & 0x0F) > 1)
+		{
+			return false;
+		}
+
+		const uint8_t* data = src + 1;
+		const uint8_t* safeEnd = src + size - 4;
+
+		// Deltas alternate between two baselines, picked by the low bit
+		uint32_t last[2] = {};
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (data >= safeEnd)
+			{
+				return false;
+			}
+
+			uint32_t v = DecodeVByte(data);
+			uint32_t current = v & 1;
+			v >>= 1;
+
+			uint32_t d = (v >> 1) ^ (0u - (v & 1));
+			uint32_t index = last[current] + d;
+			last[current] = index;
+
+			WriteIndex(dst, i, indexSize, index);
+		}
+
+		return data == safeEnd;
+	}
+
+	bool MeshoptDecoder::ApplyFilter(Filter filter, uint8_t* data, size_t count, size_t stride)
+	{
+		switch (filter)
+		{
+		case Filter::None:
+			return true;
+		case Filter::Octahedral:
+			if (stride == 4)
+			{
+				DecodeOctahedral(reinterpret_cast<int8_t*>(data), count, stride);
+				return true;
+			}
+			if (stride == 8)
+			{
+				DecodeOctahedral(reinterpret_cast<int16_t*>(data), count, stride);
+				return true;
+			}
+			return false;
+		case Filter::Quaternion:
+			if (stride != 8)
+			{
+				return false;
+			}
+			DecodeQuaternion(reinterpret_cast<int16_t*>(data), count);
+			return true;
+		case Filter::Exponential:
+			if (stride % 4 != 0)
+			{
+				return false;
+			}
+			DecodeExponential(reinterpret_cast<uint32_t*>(data), count * stride / 4);
+			return true;
+		default:
+			return false;
+		}
+	}
+}
\ No newline at end of file
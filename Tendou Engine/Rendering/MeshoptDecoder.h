@@ -0,0 +1,38 @@
+#ifndef MESHOPTDECODER_H
+#define MESHOPTDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tendou
+{
+	// Decoders for the EXT_meshopt_compression bitstreams (meshoptimizer's
+	// vertex codec v0, index codec v1 and index sequence codec v1) and its
+	// post-decode filters. Every decoder checks the stream against its own
+	// size and returns false on malformed input instead of reading past it.
+	class MeshoptDecoder
+	{
+	public:
+		enum class Filter : uint32_t
+		{
+			None,
+			Octahedral,	// snorm8/16 xyz unit vectors with free w
+			Quaternion,	// snorm16 unit quaternions, largest component dropped
+			Exponential,	// 24 bit mantissa + 8 bit exponent floats
+		};
+
+		// count elements of stride bytes, stride a multiple of 4 up to 256
+		static bool DecodeVertexBuffer(uint8_t* dst, size_t count, size_t stride, const uint8_t* src, size_t size);
+
+		// Triangle lists, count a multiple of 3, indexSize 2 or 4
+		static bool DecodeIndexBuffer(uint8_t* dst, size_t count, size_t indexSize, const uint8_t* src, size_t size);
+
+		// Any other index data, indexSize 2 or 4
+		static bool DecodeIndexSequence(uint8_t* dst, size_t count, size_t indexSize, const uint8_t* src, size_t size);
+
+		// Runs in place over decoded attribute data. False if the stride doesn't suit the filter.
+		static bool ApplyFilter(Filter filter, uint8_t* data, size_t count, size_t stride);
+	};
+}
+
+#endif
\ No newline at end of file
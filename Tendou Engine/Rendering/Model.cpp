@@ -1,35 +1,18 @@
 #include "Model.h"
 
-#include "../Utilities/Hasher.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "../Core/Profiler.h"
+#include "../Utilities/VertexWelder.hpp"
+#include "OBJReader.h"
+#include "RenderStats.h"
 
 #include <iostream>
 #include <cassert>
 #include <iostream>
-#include <unordered_map>
-
-namespace std
-{
-	template<>
-	struct hash<Tendou::Model::Vertex>
-	{
-		size_t operator()(Tendou::Model::Vertex const& v) const
-		{
-			size_t seed = 0;
-			Tendou::HashCombine(seed, v.position, v.color, v.normal, v.uv);
-
-			return seed;
-		}
-	};
-}
 
 namespace Tendou
 {
+	static_assert(sizeof(Model::Vertex) == 11 * sizeof(float), "Vertices are welded bytewise, they can't have padding!");
+
 	std::vector<VkVertexInputBindingDescription> Model::Vertex::GetBindingDescriptions()
 	{
 		std::vector< VkVertexInputBindingDescription> bindingDesc(1);
@@ -56,13 +39,19 @@ namespace Tendou
 	Model::Model(TendouDevice& device, const Model::Builder<T>& builder)
 		: device_(device)
 	{
-		CreateVertexBuffers(builder.vertices);
-		CreateIndexBuffers(builder.indices);
+		uint32_t vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		assert(vertexCount >= 3 && "Vertex count must be at least 3!");
+
+		GeometryArena& arena = device_.Geometry();
+		handle = arena.Allocate(sizeof(T), vertexCount, static_cast<uint32_t>(builder.indices.size()));
+		arena.Upload(handle, builder.vertices.data(), builder.indices.data());
 	}
 
 	std::unique_ptr<Model> Model::CreateModelFromFile(TendouDevice& device, Type type,
 		const std::string& filePath, const std::string& mtlPath, bool flipY)
 	{
+		TENDOU_PROFILE_FUNCTION();
+
 		std::unique_ptr<Model> res(nullptr);
 
 		switch (type)
@@ -90,168 +79,80 @@ namespace Tendou
 
 	Model::~Model()
 	{
+		device_.Geometry().Free(handle);
 	}
 
-	void Model::CreateVertexBuffers(const std::vector<Vertex>& verts)
+	void Model::Bind(VkCommandBuffer commandBuffer)
 	{
-		vertexCount = static_cast<uint32_t>(verts.size());
-		assert(vertexCount >= 3 && "Vertex count must be at least 3!");
-
-		VkDeviceSize bufSize = sizeof(verts[0]) * vertexCount;
-		uint32_t vertexSize = sizeof(verts[0]);
-
-		Buffer stagingBuffer
-		{
-			device_,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)verts.data());
-
-		vertexBuffer = std::make_unique<Buffer>(
-			device_,
-			vertexSize,
-			vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		device_.CopyBuffer(stagingBuffer.GetBuffer(), vertexBuffer->GetBuffer(), bufSize);
+		device_.Geometry().Bind(commandBuffer);
 	}
 
-	void Model::CreateIndexBuffers(const std::vector<uint32_t>& indices)
+	void Model::Draw(VkCommandBuffer commandBuffer)
 	{
-		indexCount = static_cast<uint32_t>(indices.size());
-		hasIndexBuffer = indexCount > 0;
+		const GeometryArena::Range& range = GetRange();
 
-		if (!hasIndexBuffer)
+		if (range.indexCount > 0)
 		{
-			return;
+			vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, static_cast<int32_t>(range.vertexOffset), 0);
+			RenderStats::CountDraw(range.indexCount);
 		}
-
-		VkDeviceSize bufSize = sizeof(indices[0]) * indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		Buffer stagingBuffer
-		{
-			device_,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)indices.data());
-
-		indexBuffer = std::make_unique<Buffer>(
-			device_,
-			indexSize,
-			indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-		device_.CopyBuffer(stagingBuffer.GetBuffer(), indexBuffer->GetBuffer(), bufSize);
-	}
-
-	void Model::Bind(VkCommandBuffer commandBuffer)
-	{
-		VkBuffer buffers[] = { vertexBuffer->GetBuffer() };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
-
-		if (hasIndexBuffer)
+		else
 		{
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDraw(commandBuffer, range.vertexCount, 1, range.vertexOffset, 0);
+			RenderStats::CountDraw(range.vertexCount);
 		}
 	}
 
-	void Model::Draw(VkCommandBuffer commandBuffer)
+	void Model::ReadBack(Builder<Vertex>& builder) const
 	{
-		if (hasIndexBuffer)
-		{
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-		}
-		else
-		{
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
-		}
+		const GeometryArena::Range& range = GetRange();
+
+		builder.vertices.resize(range.vertexCount);
+		builder.indices.resize(range.indexCount);
+		device_.Geometry().Download(handle, builder.vertices.data(), builder.indices.data());
 	}
 
 	template <typename T>
 	void Model::Builder<T>::LoadOBJ(const std::string& f, bool flipY, const std::string& m)
 	{
-		int multiplier = !flipY ? 1 : -1;
+		TENDOU_PROFILE_SCOPE("Model::Builder::LoadOBJ");
 
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
+		float multiplier = !flipY ? 1.0f : -1.0f;
 
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, f.c_str(), m.c_str()))
-		{
-			throw std::runtime_error(warn + err);
-		}
+		// Materials aren't used by Model, so the MTL file (m) isn't read
+		OBJData obj = OBJReader::Read(f);
 
 		vertices.clear();
 		indices.clear();
+		hasNormals = obj.hasNormals;
 
-		std::unordered_map<T, uint32_t> uniqueVerts{};
+		indices.reserve(obj.indices.size());
 
-		for (const auto& shape : shapes)
-		{
-			for (const auto& index : shape.mesh.indices)
-			{
-				Vertex v{};
-
-				if (index.vertex_index >= 0)
-				{
-					v.position =
-					{
-						attrib.vertices[3 * index.vertex_index + 0],
-						multiplier * attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2],
-					};
+		// Most corners are shared by several faces
+		VertexWelder<T> welder(vertices, obj.indices.size() / 4);
 
-					v.color =
-					{
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2],
-					};
-
-				}
+		for (const OBJIndex& index : obj.indices)
+		{
+			Vertex v{};
 
-				if (index.normal_index >= 0)
-				{
-					hasNormals = true;
-					v.normal =
-					{
-						attrib.normals[3 * index.normal_index + 0],
-						multiplier * attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2],
-					};
-				}
+			const float* pos = &obj.positions[3 * index.position];
+			const float* col = &obj.colors[3 * index.position];
+			v.position = { pos[0], multiplier * pos[1], pos[2] };
+			v.color = { col[0], col[1], col[2] };
 
-				if (index.texcoord_index >= 0)
-				{
-					v.uv =
-					{
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						1 - attrib.texcoords[2 * index.texcoord_index + 1],
-					};
-				}
+			if (index.normal >= 0)
+			{
+				const float* n = &obj.normals[3 * index.normal];
+				v.normal = { n[0], multiplier * n[1], n[2] };
+			}
 
-				if (uniqueVerts.count(v) == 0)
-				{
-					uniqueVerts[v] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(v);
-				}
-				indices.push_back(uniqueVerts[v]);
+			if (index.texcoord >= 0)
+			{
+				const float* uv = &obj.texcoords[2 * index.texcoord];
+				v.uv = { uv[0], 1 - uv[1] };
 			}
+
+			indices.push_back(welder.Weld(v));
 		}
 
 		if (!hasNormals)
@@ -363,4 +264,7 @@ namespace Tendou
 	//		assert((scene.nodes[i] >= 0) && (scene.nodes[i] < model.nodes.size()));
 	//	}
 	//}
-}
+
+	template struct Model::Builder<Model::Vertex>;
+	template Model::Model(TendouDevice&, const Model::Builder<Model::Vertex>&);
+}
\ No newline at end of file
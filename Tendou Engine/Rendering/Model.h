@@ -2,17 +2,22 @@
 #define MODEL_H
 
 #include "../Vulkan/TendouDevice.h"
+#include "../Utilities/Hasher.hpp"
 #include "Buffer.h"
+#include "GeometryArena.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 
 #include <memory>
 #include <vector>
 
 namespace Tendou
 {
+	// A range of the device's GeometryArena; Draw expects the arena to be bound
 	class Model
 	{
 	public:
@@ -62,21 +67,34 @@ namespace Tendou
 		static std::unique_ptr<Model> CreateModelFromFile(TendouDevice& device, Type type,
 			const std::string& filePath, const std::string& mtlPath = std::string(), bool flipY = false);
 
+		// Binds the whole arena, passes that draw several models only need it once
 		void Bind(VkCommandBuffer commandBuffer);
 		void Draw(VkCommandBuffer commandBuffer);
 
-	private:
-		void CreateVertexBuffers(const std::vector<Vertex>& verts);
-		void CreateIndexBuffers(const std::vector<uint32_t>& indices);
+		// Copies the uploaded vertices and indices back out of the arena
+		void ReadBack(Builder<Vertex>& builder) const;
+
+		__inline GeometryArena::Handle GetHandle() const { return handle; }
+		__inline const GeometryArena::Range& GetRange() const { return device_.Geometry().Get(handle); }
 
+	private:
 		TendouDevice& device_;
+		GeometryArena::Handle handle = GeometryArena::INVALID_HANDLE;
+	};
+}
 
-		std::unique_ptr<Buffer> vertexBuffer;
-		uint32_t vertexCount;
+namespace std
+{
+	template<>
+	struct hash<Tendou::Model::Vertex>
+	{
+		size_t operator()(Tendou::Model::Vertex const& v) const
+		{
+			size_t seed = 0;
+			Tendou::HashCombine(seed, v.position, v.color, v.normal, v.uv);
 
-		bool hasIndexBuffer = false;
-		std::unique_ptr<Buffer> indexBuffer;
-		uint32_t indexCount;
+			return seed;
+		}
 	};
 }
 
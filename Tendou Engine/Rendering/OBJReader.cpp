@@ -0,0 +1,515 @@
+#include "OBJReader.h"
+
+#include "../Core/JobSystem.h"
+#include "../Core/MappedFile.h"
+#include "../Core/Profiler.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace Tendou
+{
+	namespace
+	{
+		// Index slots inside a chunk: absolute indices are stored 0-based, relative ones
+		// as an offset from the chunk's first attribute minus RELATIVE_BIAS, so they stay
+		// negative until the chunk is rebased
+		constexpr int32_t ABSENT = INT32_MIN;
+		constexpr int32_t RELATIVE_BIAS = 1 << 30;
+
+		const double POW10[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		__inline bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		__inline bool IsDigit(char c)
+		{
+			return static_cast<unsigned>(c - '0') < 10u;
+		}
+
+		__inline const char* SkipSpace(const char* p, const char* end)
+		{
+			while (p < end && IsSpace(*p))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		__inline const char* SkipLine(const char* p, const char* end)
+		{
+			const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+			return eol ? eol + 1 : end;
+		}
+
+		// Decimal and scientific notation. Digits past the 19th can't change a float,
+		// they only move the exponent.
+		bool ParseFloat(const char*& p, const char* end, float& out)
+		{
+			const char* s = p;
+
+			bool negative = false;
+			if (s < end && (*s == '-' || *s == '+'))
+			{
+				negative = *s == '-';
+				++s;
+			}
+
+			uint64_t mantissa = 0;
+			int digits = 0;
+			int exponent = 0;
+			bool any = false;
+
+			for (; s < end && IsDigit(*s); ++s)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+					digits += mantissa != 0;
+				}
+				else
+				{
+					++exponent;
+				}
+			}
+
+			if (s < end && *s == '.')
+			{
+				for (++s; s < end && IsDigit(*s); ++s)
+				{
+					any = true;
+					if (digits < 19)
+					{
+						mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+						digits += mantissa != 0;
+						--exponent;
+					}
+				}
+			}
+
+			if (!any)
+			{
+				return false;
+			}
+
+			if (s < end && (*s == 'e' || *s == 'E'))
+			{
+				const char* e = s + 1;
+
+				bool negativeExp = false;
+				if (e < end && (*e == '-' || *e == '+'))
+				{
+					negativeExp = *e == '-';
+					++e;
+				}
+
+				if (e < end && IsDigit(*e))
+				{
+					int value = 0;
+					for (; e < end && IsDigit(*e); ++e)
+					{
+						value = std::min(value * 10 + (*e - '0'), 9999);
+					}
+
+					exponent += negativeExp ? -value : value;
+					s = e;
+				}
+			}
+
+			double v = static_cast<double>(mantissa);
+			if (exponent < 0)
+			{
+				v = exponent >= -22 ? v / POW10[-exponent] : v * std::pow(10.0, exponent);
+			}
+			else if (exponent > 0)
+			{
+				v = exponent <= 22 ? v * POW10[exponent] : v * std::pow(10.0, exponent);
+			}
+
+			out = static_cast<float>(negative ? -v : v);
+			p = s;
+			return true;
+		}
+
+		bool ParseInt(const char*& p, const char* end, int64_t& out)
+		{
+			const char* s = p;
+
+			bool negative = false;
+			if (s < end && (*s == '-' || *s == '+'))
+			{
+				negative = *s == '-';
+				++s;
+			}
+
+			if (s >= end || !IsDigit(*s))
+			{
+				return false;
+			}
+
+			int64_t value = 0;
+			for (; s < end && IsDigit(*s); ++s)
+			{
+				value = std::min<int64_t>(value * 10 + (*s - '0'), INT32_MAX);
+			}
+
+			out = negative ? -value : value;
+			p = s;
+			return true;
+		}
+
+		// Reads up to max floats, returns how many there were
+		uint32_t ParseFloats(const char*& p, const char* end, float* out, uint32_t max)
+		{
+			uint32_t count = 0;
+			while (count < max)
+			{
+				p = SkipSpace(p, end);
+				if (!ParseFloat(p, end, out[count]))
+				{
+					break;
+				}
+				++count;
+			}
+			return count;
+		}
+
+		// 1-based absolute or negative relative index, 0 is invalid
+		__inline int32_t EncodeIndex(int64_t value, size_t localCount)
+		{
+			if (value > 0)
+			{
+				return static_cast<int32_t>(value - 1);
+			}
+			if (value < 0)
+			{
+				return static_cast<int32_t>(static_cast<int64_t>(localCount) + value - RELATIVE_BIAS);
+			}
+			return ABSENT;
+		}
+
+		// Returns false if the index points outside [0, count)
+		__inline bool DecodeIndex(int32_t& index, size_t base, size_t count)
+		{
+			if (index == ABSENT)
+			{
+				index = -1;
+				return true;
+			}
+
+			int64_t value = index < 0 ? static_cast<int64_t>(base) + index + RELATIVE_BIAS : index;
+			if (value < 0 || value >= static_cast<int64_t>(count))
+			{
+				return false;
+			}
+
+			index = static_cast<int32_t>(value);
+			return true;
+		}
+	}
+
+	OBJData OBJReader::Read(const std::string& path, bool parallel)
+	{
+		TENDOU_PROFILE_SCOPE("OBJReader::Read");
+
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			throw std::runtime_error("Failed to open OBJ file " + path + "!");
+		}
+
+		return Parse(reinterpret_cast<const char*>(file.Data()), file.Size(), parallel);
+	}
+
+	OBJData OBJReader::Parse(const char* text, size_t size, bool parallel)
+	{
+		uint32_t chunkCount = 1;
+		if (parallel && JobSystem::IsRunning())
+		{
+			size_t bySize = std::max<size_t>(size / MIN_CHUNK_SIZE, 1);
+			chunkCount = static_cast<uint32_t>(std::min<size_t>(bySize, JobSystem::ThreadCount() * CHUNKS_PER_THREAD));
+		}
+
+		// Chunk boundaries are moved forward to the next line start
+		std::vector<const char*> bounds(chunkCount + 1);
+		const char* end = text + size;
+		bounds[0] = text;
+		bounds[chunkCount] = end;
+		for (uint32_t i = 1; i < chunkCount; ++i)
+		{
+			const char* split = std::max(text + size / chunkCount * i, bounds[i - 1]);
+			bounds[i] = split > text && split[-1] == '\n' ? split : SkipLine(split, end);
+		}
+
+		std::vector<Chunk> chunks(chunkCount);
+		JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t last)
+			{
+				for (uint32_t i = begin; i < last; ++i)
+				{
+					ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+				}
+			}, "OBJReader::ParseChunk");
+
+		// Every chunk's place in the file is only known now
+		OBJData data;
+		size_t positions = 0, normals = 0, texcoords = 0, indices = 0;
+		for (Chunk& c : chunks)
+		{
+			c.positionBase = positions;
+			c.normalBase = normals;
+			c.texcoordBase = texcoords;
+			c.indexBase = indices;
+
+			positions += c.positions.size() / 3;
+			normals += c.normals.size() / 3;
+			texcoords += c.texcoords.size() / 2;
+			indices += c.triangleCorners;
+
+			data.hasNormals |= c.hasNormals;
+		}
+
+		data.positions.resize(positions * 3);
+		data.colors.resize(positions * 3);
+		data.normals.resize(normals * 3);
+		data.texcoords.resize(texcoords * 2);
+		data.indices.resize(indices);
+
+		JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t last)
+			{
+				for (uint32_t i = begin; i < last; ++i)
+				{
+					CopyAttributes(chunks[i], data);
+				}
+			}, "OBJReader::CopyAttributes");
+
+		std::vector<char> valid(chunkCount, 1);
+		JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t last)
+			{
+				for (uint32_t i = begin; i < last; ++i)
+				{
+					valid[i] = Triangulate(chunks[i], data) ? 1 : 0;
+				}
+			}, "OBJReader::Triangulate");
+
+		if (std::find(valid.begin(), valid.end(), 0) != valid.end())
+		{
+			throw std::runtime_error("Failed to read OBJ file, a face references a missing vertex attribute!");
+		}
+
+		return data;
+	}
+
+	void OBJReader::ParseChunk(const char* p, const char* end, Chunk& chunk)
+	{
+		TENDOU_PROFILE_SCOPE("OBJReader::ParseChunk");
+
+		// Rough guess at what a line costs, so the vectors don't regrow from scratch
+		size_t expected = static_cast<size_t>(end - p) / 32;
+		chunk.positions.reserve(expected);
+		chunk.corners.reserve(expected);
+
+		float values[7];
+
+		while (p < end)
+		{
+			p = SkipSpace(p, end);
+			if (end - p < 2)
+			{
+				break;
+			}
+
+			if (p[0] == 'v' && IsSpace(p[1]))
+			{
+				p += 2;
+				uint32_t count = ParseFloats(p, end, values, 7);
+
+				for (uint32_t i = count; i < 3; ++i)
+				{
+					values[i] = 0.0f;
+				}
+				chunk.positions.insert(chunk.positions.end(), values, values + 3);
+
+				// x y z r g b; a fourth value alone is w, which is ignored
+				if (count >= 6)
+				{
+					chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+				}
+				else
+				{
+					chunk.colors.insert(chunk.colors.end(), { 1.0f, 1.0f, 1.0f });
+				}
+			}
+			else if (p[0] == 'v' && p[1] == 'n')
+			{
+				p += 2;
+				uint32_t count = ParseFloats(p, end, values, 3);
+
+				for (uint32_t i = count; i < 3; ++i)
+				{
+					values[i] = 0.0f;
+				}
+				chunk.normals.insert(chunk.normals.end(), values, values + 3);
+			}
+			else if (p[0] == 'v' && p[1] == 't')
+			{
+				p += 2;
+				uint32_t count = ParseFloats(p, end, values, 3);
+
+				for (uint32_t i = count; i < 2; ++i)
+				{
+					values[i] = 0.0f;
+				}
+				chunk.texcoords.insert(chunk.texcoords.end(), values, values + 2);
+			}
+			else if (p[0] == 'f' && IsSpace(p[1]))
+			{
+				p += 2;
+				uint32_t count = 0;
+
+				size_t positionCount = chunk.positions.size() / 3;
+				size_t normalCount = chunk.normals.size() / 3;
+				size_t texcoordCount = chunk.texcoords.size() / 2;
+
+				// v, v/vt, v//vn or v/vt/vn
+				for (;;)
+				{
+					p = SkipSpace(p, end);
+
+					int64_t v = 0;
+					if (!ParseInt(p, end, v))
+					{
+						break;
+					}
+
+					OBJIndex corner{ EncodeIndex(v, positionCount), ABSENT, ABSENT };
+
+					if (p < end && *p == '/')
+					{
+						++p;
+
+						int64_t vt = 0;
+						if (ParseInt(p, end, vt))
+						{
+							corner.texcoord = EncodeIndex(vt, texcoordCount);
+						}
+
+						if (p < end && *p == '/')
+						{
+							++p;
+
+							int64_t vn = 0;
+							if (ParseInt(p, end, vn))
+							{
+								corner.normal = EncodeIndex(vn, normalCount);
+								chunk.hasNormals = true;
+							}
+						}
+					}
+
+					chunk.corners.push_back(corner);
+					++count;
+				}
+
+				// Points and lines don't make triangles
+				if (count < 3)
+				{
+					chunk.corners.resize(chunk.corners.size() - count);
+				}
+				else
+				{
+					chunk.faces.push_back(count);
+					chunk.triangleCorners += 3 * (count - 2);
+				}
+			}
+
+			p = SkipLine(p, end);
+		}
+	}
+
+	void OBJReader::CopyAttributes(const Chunk& chunk, OBJData& data)
+	{
+		std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + chunk.positionBase * 3);
+		std::copy(chunk.colors.begin(), chunk.colors.end(), data.colors.begin() + chunk.positionBase * 3);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + chunk.normalBase * 3);
+		std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), data.texcoords.begin() + chunk.texcoordBase * 2);
+	}
+
+	bool OBJReader::Triangulate(Chunk& chunk, OBJData& data)
+	{
+		size_t positions = data.positions.size() / 3;
+		size_t normals = data.normals.size() / 3;
+		size_t texcoords = data.texcoords.size() / 2;
+
+		bool valid = true;
+		for (OBJIndex& idx : chunk.corners)
+		{
+			valid &= idx.position != ABSENT && DecodeIndex(idx.position, chunk.positionBase, positions);
+			valid &= DecodeIndex(idx.texcoord, chunk.texcoordBase, texcoords);
+			valid &= DecodeIndex(idx.normal, chunk.normalBase, normals);
+		}
+
+		// The positions of bad corners can't be looked at
+		if (!valid)
+		{
+			return false;
+		}
+
+		auto position = [&data](const OBJIndex& idx)
+		{
+			const float* p = &data.positions[3 * idx.position];
+			return glm::vec3(p[0], p[1], p[2]);
+		};
+
+		OBJIndex* out = data.indices.data() + chunk.indexBase;
+		const OBJIndex* in = chunk.corners.data();
+
+		for (uint32_t count : chunk.faces)
+		{
+			// Quads are split along their shorter diagonal like tinyobjloader does,
+			// anything bigger is fanned
+			if (count == 4)
+			{
+				glm::vec3 d02 = position(in[2]) - position(in[0]);
+				glm::vec3 d13 = position(in[3]) - position(in[1]);
+
+				if (glm::dot(d02, d02) < glm::dot(d13, d13))
+				{
+					*out++ = in[0]; *out++ = in[1]; *out++ = in[2];
+					*out++ = in[0]; *out++ = in[2]; *out++ = in[3];
+				}
+				else
+				{
+					*out++ = in[0]; *out++ = in[1]; *out++ = in[3];
+					*out++ = in[1]; *out++ = in[2]; *out++ = in[3];
+				}
+			}
+			else
+			{
+				for (uint32_t i = 2; i < count; ++i)
+				{
+					*out++ = in[0];
+					*out++ = in[i - 1];
+					*out++ = in[i];
+				}
+			}
+
+			in += count;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
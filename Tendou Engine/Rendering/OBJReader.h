@@ -0,0 +1,82 @@
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tendou
+{
+	// Attribute indices of one face corner, 0-based, -1 when the face doesn't reference one
+	struct OBJIndex
+	{
+		int32_t position;
+		int32_t texcoord;
+		int32_t normal;
+	};
+
+	// Geometry of an OBJ file with every face fanned into triangles
+	struct OBJData
+	{
+		std::vector<float> positions;  // xyz
+		std::vector<float> colors;     // rgb per position, white unless the file has vertex colors
+		std::vector<float> normals;    // xyz
+		std::vector<float> texcoords;  // uv
+		std::vector<OBJIndex> indices; // three per triangle
+
+		bool hasNormals = false;
+	};
+
+	// OBJ reader for large meshes. The file is memory mapped and split at line
+	// boundaries into chunks, which are parsed on the job system; relative
+	// indices are resolved per chunk and rebased once every chunk's attribute
+	// counts are known. Faces are triangulated after that, since a quad's split
+	// depends on positions that may be anywhere in the file.
+	//
+	// Only geometry is read - objects, groups, smoothing groups and materials
+	// are skipped, since nothing downstream of Model uses them.
+	class OBJReader
+	{
+	public:
+		// Chunks smaller than this aren't worth a job
+		static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+		// Chunks per thread, so threads that finish early can take more
+		static constexpr uint32_t CHUNKS_PER_THREAD = 4;
+
+		// Throws if the file can't be opened or references attributes it doesn't have
+		static OBJData Read(const std::string& path, bool parallel = true);
+		static OBJData Parse(const char* text, size_t size, bool parallel = true);
+
+	private:
+		struct Chunk
+		{
+			std::vector<float> positions;
+			std::vector<float> colors;
+			std::vector<float> normals;
+			std::vector<float> texcoords;
+
+			// Polygon corners, and how many corners each face has
+			std::vector<OBJIndex> corners;
+			std::vector<uint32_t> faces;
+			size_t triangleCorners = 0;
+
+			// First attribute of the chunk in the whole file
+			size_t positionBase = 0;
+			size_t normalBase = 0;
+			size_t texcoordBase = 0;
+			size_t indexBase = 0;
+
+			bool hasNormals = false;
+		};
+
+		static void ParseChunk(const char* begin, const char* end, Chunk& chunk);
+		static void CopyAttributes(const Chunk& chunk, OBJData& data);
+
+		// Writes the chunk's triangles into data, false if an index was out of range
+		static bool Triangulate(Chunk& chunk, OBJData& data);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace Tendou
+{
+	// Counters bumped at every draw site. Secondaries are recorded on
+	// worker threads, so everything is atomic; reset once per frame.
+	struct RenderStats
+	{
+		static inline std::atomic<uint32_t> drawCalls{ 0 };
+		static inline std::atomic<uint64_t> triangles{ 0 };
+
+		// State binds of packets replayed through a DrawQueue: one per packet and
+		// kind if each recorded its own, against those left after filtering
+		static inline std::atomic<uint32_t> bindsRequested{ 0 };
+		static inline std::atomic<uint32_t> bindsIssued{ 0 };
+
+		__inline static void CountDraw(uint32_t vertexCount, uint32_t instanceCount = 1)
+		{
+			drawCalls.fetch_add(1, std::memory_order_relaxed);
+			triangles.fetch_add(static_cast<uint64_t>(vertexCount / 3) * instanceCount, std::memory_order_relaxed);
+		}
+
+		__inline static void CountBinds(uint32_t requested, uint32_t issued)
+		{
+			bindsRequested.fetch_add(requested, std::memory_order_relaxed);
+			bindsIssued.fetch_add(issued, std::memory_order_relaxed);
+		}
+
+		__inline static void Reset()
+		{
+			drawCalls.store(0, std::memory_order_relaxed);
+			triangles.store(0, std::memory_order_relaxed);
+			bindsRequested.store(0, std::memory_order_relaxed);
+			bindsIssued.store(0, std::memory_order_relaxed);
+		}
+	};
+}
+
+#endif
\ No newline at end of file
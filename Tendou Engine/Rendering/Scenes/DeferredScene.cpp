@@ -16,33 +16,8 @@ namespace Tendou
 		CreateRenderPasses();
 	}
 
-	// TODO: More abstraction
 	DeferredScene::~DeferredScene()
 	{
-		// Position
-		vkDestroyImageView(device.Device(), renderPasses["Geometry"].position.view, nullptr);
-		vkDestroyImage(device.Device(), renderPasses["Geometry"].position.image, nullptr);
-		vkFreeMemory(device.Device(), renderPasses["Geometry"].position.memory, nullptr);
-
-		// Normal
-		vkDestroyImageView(device.Device(), renderPasses["Geometry"].normal.view, nullptr);
-		vkDestroyImage(device.Device(), renderPasses["Geometry"].normal.image, nullptr);
-		vkFreeMemory(device.Device(), renderPasses["Geometry"].normal.memory, nullptr);
-
-		// Albedo
-		vkDestroyImageView(device.Device(), renderPasses["Geometry"].albedo.view, nullptr);
-		vkDestroyImage(device.Device(), renderPasses["Geometry"].albedo.image, nullptr);
-		vkFreeMemory(device.Device(), renderPasses["Geometry"].albedo.memory, nullptr);
-
-		// Depth attachment
-		vkDestroyImageView(device.Device(), renderPasses["Geometry"].depth.view, nullptr);
-		vkDestroyImage(device.Device(), renderPasses["Geometry"].depth.image, nullptr);
-		vkFreeMemory(device.Device(), renderPasses["Geometry"].depth.memory, nullptr);
-
-		// Render pass/frame buffer
-		vkDestroyRenderPass(device.Device(), renderPasses["Geometry"].renderPass, nullptr);
-		vkDestroySampler(device.Device(), renderPasses["Geometry"].sampler, nullptr);
-		vkDestroyFramebuffer(device.Device(), renderPasses["Geometry"].frameBuffer, nullptr);
 	}
 
 	float RandomNum(float min, float max)
@@ -56,17 +31,8 @@ namespace Tendou
 		CreateSetLayouts();
 		CreateRenderSystems();
 
-		LightPassUBO passUBO{};
-		passUBO.eyePos = glm::vec4(c.cameraPos, 1.0f);
-
-		for (unsigned i = 0; i < MAX_LIGHTS; ++i)
-		{
-			passUBO.lights[i].pos = lightValues[i].pos;
-			passUBO.lights[i].color = lightValues[i].color;
-			passUBO.lights[i].radius = lightValues[i].radius;
-		}
-		lightingPass->WriteToBuffer(&passUBO);
-		lightingPass->Flush();
+		renderCamera = c;
+		WriteLightPassUBO();
 
 		//for (unsigned i = 0; i < MAX_LIGHTS; ++i)
 		//{
@@ -136,31 +102,14 @@ namespace Tendou
 		static float angle = 0.0f;
 		int idx = 0;
 
-		LightPassUBO passUBO{};
-		passUBO.eyePos = glm::vec4(c.cameraPos, 1.0f);
-
-		for (unsigned i = 0; i < MAX_LIGHTS; ++i)
-		{
-			passUBO.lights[i].pos = lightValues[i].pos;
-			passUBO.lights[i].color = lightValues[i].color;
-			passUBO.lights[i].radius = lightValues[i].radius;
-		}
-		lightingPass->WriteToBuffer(&passUBO);
-		lightingPass->Flush();
-
+		// The uniforms are written from the frame packet, the GPU may still be
+		// reading them for the frame recording alongside this update
 		for (auto& a : gameObjects)
 		{
 			auto& obj = a.second;
 			obj.GetTransform().Update();
 		}
 
-		WorldUBO localUBO{};
-		localUBO.proj = c.perspective();
-		localUBO.view = c.view();
-		localUBO.nearFar = glm::vec2(editorVars.nearFar.x, editorVars.nearFar.y);
-		worldUBO->WriteToBuffer(&localUBO);
-		worldUBO->Flush();
-
 		//lightUbo.lightColor[0] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 		//lightUbo.lightPos[0] = glm::vec4(-2.0f, -1.0f, 1.0f, 1.0f);
 		//lightUBO->WriteToBuffer(&lightUbo);
@@ -179,6 +128,51 @@ namespace Tendou
 		return 0;
 	}
 
+	void DeferredScene::LateLatch(const Camera& camera)
+	{
+		renderCamera = camera;
+		WriteWorldUBO();
+	}
+
+	void DeferredScene::WriteFramePacket(FramePacket& packet)
+	{
+		Scene::WriteFramePacket(packet);
+		packet.Capture(localLights);
+	}
+
+	void DeferredScene::ReadFramePacket(const FramePacket& packet)
+	{
+		Scene::ReadFramePacket(packet);
+
+		WriteLightPassUBO();
+		WriteWorldUBO();
+	}
+
+	void DeferredScene::WriteLightPassUBO()
+	{
+		LightPassUBO passUBO{};
+		passUBO.eyePos = glm::vec4(renderCamera.cameraPos, 1.0f);
+
+		for (unsigned i = 0; i < MAX_LIGHTS; ++i)
+		{
+			passUBO.lights[i].pos = lightValues[i].pos;
+			passUBO.lights[i].color = lightValues[i].color;
+			passUBO.lights[i].radius = lightValues[i].radius;
+		}
+		lightingPass->WriteToBuffer(&passUBO);
+		lightingPass->Flush();
+	}
+
+	void DeferredScene::WriteWorldUBO()
+	{
+		WorldUBO localUBO{};
+		localUBO.proj = renderCamera.perspective();
+		localUBO.view = renderCamera.view();
+		localUBO.nearFar = glm::vec2(editorVars.nearFar.x, editorVars.nearFar.y);
+		worldUBO->WriteToBuffer(&localUBO);
+		worldUBO->Flush();
+	}
+
 	int DeferredScene::PostUpdate()
 	{
 		return 0;
@@ -186,29 +180,17 @@ namespace Tendou
 
 	int DeferredScene::Render(VkCommandBuffer buf, FrameInfo& f)
 	{
-		SceneInfo lighting(GetDescriptorSet("Lighting"), GetGameObjects());
-		SceneInfo geometry(GetDescriptorSet("Geometry"), GetGameObjects());
-		SceneInfo lights(GetDescriptorSet("LocalLights"), localLights);
-
-		std::vector<VkClearValue> clearValues(4);
-		clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[1].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[2].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-		clearValues[3].depthStencil = { 1.0f, 0 };
-
-		BeginRenderPass(buf, "Geometry", clearValues);
-		renderSystems["Geometry"][0].get()->Render(f, geometry);
-		EndRenderPass(buf);
+		SceneInfo upscale(GetDescriptorSet("Upscale"), GetGameObjects());
 
-		//BeginRenderPass(buf, "Lighting", clearValues);
-		//renderSystems["Lighting"][0].get()->Render(f, lighting);
-		//EndRenderPass(buf);
+		// G-buffer and lighting, at the resolution picked for this frame
+		graph->Execute(f);
 
 		// Render the actual scene (swapchain)
 		BeginSwapChainRenderPass(buf);
 
-		renderSystems["Lighting"][0].get()->Render(f, lighting);
-		renderSystems["LocalLights"][0].get()->Render(f, lights);
+		auto upscaleSystem = static_cast<UpscaleSystem*>(renderSystems["Upscale"][0].get());
+		upscaleSystem->SetSourceRect(dynamicResolution->GetRenderExtent(), dynamicResolution->GetMaxExtent());
+		upscaleSystem->Render(f, upscale);
 
 		return 0;
 	}
@@ -226,10 +208,15 @@ namespace Tendou
 			whiteFang.GetTransform().SetTranslation(glm::vec3((i % 3) * 10.0f + 0.f, 0.0f, i >= 3 ? 0.0f : 5.0f));
 			whiteFang.GetTransform().SetRotation(glm::vec3(0.0f, 0.5f, 0.0f));
 			whiteFang.GetTransform().SetScale(glm::vec3(10.0f));
+			whiteFang.GetTransform().Update();
+			whiteFang.SetStatic(true);
 
 			gameObjects.emplace(whiteFang.GetID(), std::move(whiteFang));
 		}
 
+		// The weapons never move, so they're drawn as a few pre-transformed meshes
+		staticBatches = StaticBatcher::Build(device, gameObjects);
+
 		for (int i = 0; i < MAX_LIGHTS; ++i)
 		{
 			float xPos = RandomNum(-20.0f, 20.0f);
@@ -280,7 +267,7 @@ namespace Tendou
 
 	void DeferredScene::CreateSetLayouts()
 	{
-		textures.push_back(std::make_unique<Texture>(device, "Materials/Models/BA/Misaki/Texture2D/Misaki_Original_Weapon.png"));
+		textures.push_back(TextureCache::Load(device, "Materials/Models/BA/Misaki/Texture2D/Misaki_Original_Weapon.png"));
 		auto texInfo = textures[0]->DescriptorInfo();
 
 		setLayouts["Geometry"] = DescriptorSetLayout::Builder(device)
@@ -301,6 +288,10 @@ namespace Tendou
 			//.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
 			.Build();
 
+		setLayouts["Upscale"] = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.Build();
+
 		setLayouts["LocalLights"] = DescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.AddBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
@@ -322,6 +313,7 @@ namespace Tendou
 		descriptorSets["Geometry"].resize(1);
 		descriptorSets["Lighting"].resize(1);
 		descriptorSets["LocalLights"].resize(1);
+		descriptorSets["Upscale"].resize(1);
 
 		// Object set
 		DescriptorWriter(*setLayouts["Geometry"], *globalPool)
@@ -332,14 +324,14 @@ namespace Tendou
 			.Build(descriptorSets["Geometry"][0]);
 
 
-		auto posTex = VkDescriptorImageInfo{ renderPasses["Geometry"].sampler,
-			renderPasses["Geometry"].position.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		auto posTex = VkDescriptorImageInfo{ graph->GetSampler(),
+			graph->GetImageView(gPosition), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
-		auto normalTex = VkDescriptorImageInfo{ renderPasses["Geometry"].sampler,
-			renderPasses["Geometry"].normal.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		auto normalTex = VkDescriptorImageInfo{ graph->GetSampler(),
+			graph->GetImageView(gNormal), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
-		auto albedoTex = VkDescriptorImageInfo{ renderPasses["Geometry"].sampler,
-			renderPasses["Geometry"].albedo.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		auto albedoTex = VkDescriptorImageInfo{ graph->GetSampler(),
+			graph->GetImageView(gAlbedo), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
 		DescriptorWriter(*setLayouts["Lighting"], *globalPool)
 			.WriteImage(0, &posTex)
@@ -359,17 +351,64 @@ namespace Tendou
 			//.WriteBuffer(1, &lightBuf)
 			//.WriteImage(2, &emptyMap)
 			.Build(descriptorSets["LocalLights"][0]);
+
+		auto sceneTex = VkDescriptorImageInfo{ dynamicResolution->GetSampler(),
+			graph->GetImageView(sceneColor), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+		DescriptorWriter(*setLayouts["Upscale"], *globalPool)
+			.WriteImage(0, &sceneTex)
+			.Build(descriptorSets["Upscale"][0]);
 	}
 
 	void DeferredScene::CreateRenderPasses()
 	{
-		renderPasses["Geometry"] = device.CreateDeferredPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		// Allocated once at full resolution; each frame renders into the
+		// part of them dynamic resolution picks, then gets upscaled
+		uint32_t width = swapChain.get()->GetSwapChainExtent().width;
+		uint32_t height = swapChain.get()->GetSwapChainExtent().height;
+		dynamicResolution->SetMaxExtent({ width, height });
+
+		gPosition = graph->CreateImage("Position", { width, height, VK_FORMAT_R16G16B16A16_SFLOAT });
+		gNormal = graph->CreateImage("Normal", { width, height, VK_FORMAT_R16G16B16A16_SFLOAT });
+		gAlbedo = graph->CreateImage("Albedo", { width, height, VK_FORMAT_R8G8B8A8_UNORM });
+		RenderGraph::Handle depth = graph->CreateImage("Depth", { width, height, graph->DepthFormat() });
+		sceneColor = graph->CreateImage("SceneColor", { width, height, VK_FORMAT_R16G16B16A16_SFLOAT });
+
+		// G-buffer draws are recorded in parallel into secondaries
+		graph->AddPass("Geometry")
+			.WriteColor(gPosition)
+			.WriteColor(gNormal)
+			.WriteColor(gAlbedo)
+			.WriteDepth(depth)
+			.RecordSecondary()
+			.ScaleToRenderArea()
+			.Execute([this](FrameInfo& f)
+				{
+					SceneInfo geometry(GetDescriptorSet("Geometry"), GetGameObjects());
+					renderSystems["Geometry"][0].get()->Render(f, geometry);
+				});
+
+		// Lighting cost scales with the pixel count too, so it runs at the same resolution
+		graph->AddPass("Lighting")
+			.WriteColor(sceneColor)
+			.ReadTexture(gPosition)
+			.ReadTexture(gNormal)
+			.ReadTexture(gAlbedo)
+			.ScaleToRenderArea()
+			.Execute([this](FrameInfo& f)
+				{
+					SceneInfo lighting(GetDescriptorSet("Lighting"), GetGameObjects());
+					SceneInfo lights(GetDescriptorSet("LocalLights"), localLights);
+
+					renderSystems["Lighting"][0].get()->Render(f, lighting);
+					renderSystems["LocalLights"][0].get()->Render(f, lights);
+				});
+
+		// Sampled by the upscale inside the swapchain pass
+		graph->MarkOutput(sceneColor);
 
-		renderPasses["Lighting"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		graph->Compile();
+		graph->ExportRenderPasses(renderPasses);
 	}
 
 	void DeferredScene::CreateRenderSystems()
@@ -377,6 +416,7 @@ namespace Tendou
 		renderSystems["Geometry"].reserve(1);
 		renderSystems["Lighting"].reserve(1);
 		renderSystems["LocalLights"].reserve(1);
+		renderSystems["Upscale"].reserve(1);
 
 		renderSystems["Geometry"].emplace_back(std::make_unique<GeometrySystem>(
 			device,
@@ -386,14 +426,20 @@ namespace Tendou
 
 		renderSystems["Lighting"].emplace_back(std::make_unique<DeferredSystem>(
 			device,
-			GetSwapChainRenderPass(),
+			renderPasses["Lighting"].renderPass,
 			GetSetLayout("Lighting")->GetDescriptorSetLayout()
 			));
 
 		renderSystems["LocalLights"].emplace_back(std::make_unique<LocalLightSystem>(
 			device,
-			GetSwapChainRenderPass(),
+			renderPasses["Lighting"].renderPass,
 			GetSetLayout("LocalLights")->GetDescriptorSetLayout()
 			));
+
+		renderSystems["Upscale"].emplace_back(std::make_unique<UpscaleSystem>(
+			device,
+			GetSwapChainRenderPass(),
+			GetSetLayout("Upscale")->GetDescriptorSetLayout()
+			));
 	}
 }
\ No newline at end of file
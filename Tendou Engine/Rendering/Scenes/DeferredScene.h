@@ -3,7 +3,9 @@
 
 #include "Scene.h"
 
+#include "../../Rendering/StaticBatcher.h"
 #include "../../Rendering/Texture.h"
+#include "../../Rendering/TextureCache.h"
 #include "../../Rendering/UniformBuffer.hpp"
 
 #include <memory>
@@ -41,6 +43,12 @@ namespace Tendou
 		int Update() override;
 		int PostUpdate() override;
 
+		void LateLatch(const Camera& camera) override;
+
+		void WriteFramePacket(FramePacket& packet) override;
+		void ReadFramePacket(const FramePacket& packet) override;
+		bool CanPipelineUpdate() const override { return true; }
+
 		int Render(VkCommandBuffer buf, FrameInfo& f) override;
 
 
@@ -48,6 +56,8 @@ namespace Tendou
 
 	private:
 		void LoadGameObjects();
+		void WriteWorldUBO();
+		void WriteLightPassUBO();
 
 		void CreateUBOs();
 		void CreateSetLayouts();
@@ -58,7 +68,18 @@ namespace Tendou
 		std::unique_ptr<UniformBuffer<LightPassUBO>> lightingPass;
 		std::vector<std::unique_ptr<Texture>> textures;
 
+		// G-buffer targets, owned by the render graph
+		RenderGraph::Handle gPosition = RenderGraph::INVALID_HANDLE;
+		RenderGraph::Handle gNormal = RenderGraph::INVALID_HANDLE;
+		RenderGraph::Handle gAlbedo = RenderGraph::INVALID_HANDLE;
+
+		// Lit image at render resolution, upscaled into the swapchain pass
+		RenderGraph::Handle sceneColor = RenderGraph::INVALID_HANDLE;
+
 		GameObject::Map localLights;
+
+		// Combined meshes the static weapons were merged into, with their bounds
+		std::vector<StaticBatch> staticBatches;
 		Tendou::Light lightValues[MAX_LIGHTS];
 	};
 }
@@ -1,19 +1,221 @@
-#define TINYGLTF_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#define TINYGLTF_NO_STB_IMAGE_WRITE
-#define TINYGLTF_NO_STB_IMAGE
-#define TINYGLTF_NO_EXTERNAL_IMAGE
-#ifdef VK_USE_PLATFORM_ANDROID_KHR
-#define TINYGLTF_ANDROID_LOAD_FROM_ASSETS
-#endif
 #include "GLTFScene.h"
 
+#include "../RenderStats.h"
+#include "../../Core/JobSystem.h"
+#include "../../Utilities/Hasher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <sstream>
 
 namespace Tendou
 {
+	namespace
+	{
+		// Vertices are assembled this many at a time and copied out whole, since the
+		// destination is staging memory that is usually write-combined and shouldn't be read
+		constexpr size_t CONVERT_BLOCK = 256;
+
+		// A block of vertices as read from the asset, before quantization
+		struct Attributes
+		{
+			glm::vec3 pos;
+			glm::vec3 normal;
+			glm::vec2 uv;
+			glm::vec4 tangent;
+		};
+
+		// What a primitive's vertices span, after the y flip
+		struct Ranges
+		{
+			glm::vec3 posMin = glm::vec3(0.0f);
+			glm::vec3 posMax = glm::vec3(0.0f);
+			glm::vec2 uvMin = glm::vec2(0.0f);
+			glm::vec2 uvMax = glm::vec2(0.0f);
+		};
+
+		// Maps a primitive's vertices into the ranges of GLTF::Vertex
+		struct Quantization
+		{
+			glm::vec3 center;
+			float invExtent;
+			glm::vec2 uvMin;
+			glm::vec2 invUVRange;
+		};
+
+		__inline int16_t Snorm16(float v)
+		{
+			return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		__inline int8_t Snorm8(float v)
+		{
+			return static_cast<int8_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f));
+		}
+
+		__inline uint16_t Unorm16(float v)
+		{
+			return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 65535.0f));
+		}
+
+		// Quantization needs the whole mesh's bounds before any vertex is written,
+		// so the positions and uvs are read once up front
+		void MeasurePrimitive(const GLTFAsset& input, const GLTFAsset::Primitive& source,
+			uint32_t vertexCount, GLTF::Primitive& primitive, Ranges& ranges)
+		{
+			TENDOU_PROFILE_FUNCTION();
+
+			constexpr size_t stride = sizeof(Attributes);
+
+			std::array<Attributes, CONVERT_BLOCK> block;
+			Ranges r;
+			r.posMin = glm::vec3(std::numeric_limits<float>::max());
+			r.posMax = glm::vec3(std::numeric_limits<float>::lowest());
+			r.uvMin = glm::vec2(std::numeric_limits<float>::max());
+			r.uvMax = glm::vec2(std::numeric_limits<float>::lowest());
+
+			for (size_t first = 0; first < vertexCount; first += CONVERT_BLOCK)
+			{
+				size_t count = std::min<size_t>(CONVERT_BLOCK, vertexCount - first);
+
+				for (size_t v = 0; v < count; ++v)
+				{
+					block[v].pos = glm::vec3(0.0f);
+					block[v].uv = glm::vec2(0.0f);
+				}
+
+				input.ReadFloats(source.position, first, count, &block[0].pos.x, stride, 3);
+				input.ReadFloats(source.texcoord0, first, count, &block[0].uv.x, stride, 2);
+
+				for (size_t v = 0; v < count; ++v)
+				{
+					glm::vec3 pos = block[v].pos * glm::vec3(1.0f, -1.0f, 1.0f);
+					r.posMin = glm::min(r.posMin, pos);
+					r.posMax = glm::max(r.posMax, pos);
+					r.uvMin = glm::min(r.uvMin, block[v].uv);
+					r.uvMax = glm::max(r.uvMax, block[v].uv);
+				}
+			}
+
+			// Bounding sphere around the primitive's box
+			if (vertexCount > 0)
+			{
+				primitive.center = (r.posMin + r.posMax) * 0.5f;
+				primitive.radius = glm::length(r.posMax - r.posMin) * 0.5f;
+				ranges = r;
+			}
+		}
+
+		// Converts one primitive into its slots of the shared buffers.
+		// False if its indices reach past its own vertices.
+		bool ConvertPrimitive(const GLTFAsset& input, const GLTFAsset::Primitive& source,
+			uint32_t vertexStart, uint32_t vertexCount, const Quantization& q, const GLTF::Primitive& primitive,
+			GLTF::Vertex* vertices, uint32_t* indices)
+		{
+			TENDOU_PROFILE_FUNCTION();
+
+			constexpr size_t stride = sizeof(Attributes);
+
+			std::array<Attributes, CONVERT_BLOCK> block;
+			std::array<GLTF::Vertex, CONVERT_BLOCK> out;
+
+			for (size_t first = 0; first < vertexCount; first += CONVERT_BLOCK)
+			{
+				size_t count = std::min<size_t>(CONVERT_BLOCK, vertexCount - first);
+
+				for (size_t v = 0; v < count; ++v)
+				{
+					block[v] = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec4(0.0f) };
+				}
+
+				// glTF supports multiple texture coordinate sets, we only load the first one
+				input.ReadFloats(source.position, first, count, &block[0].pos.x, stride, 3);
+				input.ReadFloats(source.normal, first, count, &block[0].normal.x, stride, 3);
+				input.ReadFloats(source.texcoord0, first, count, &block[0].uv.x, stride, 2);
+				input.ReadFloats(source.tangent, first, count, &block[0].tangent.x, stride, 4);
+
+				for (size_t v = 0; v < count; ++v)
+				{
+					const Attributes& a = block[v];
+					GLTF::Vertex& vert = out[v];
+
+					glm::vec3 pos = (a.pos * glm::vec3(1.0f, -1.0f, 1.0f) - q.center) * q.invExtent;
+					vert.pos[0] = Snorm16(pos.x);
+					vert.pos[1] = Snorm16(pos.y);
+					vert.pos[2] = Snorm16(pos.z);
+					vert.pos[3] = 0;
+
+					glm::vec3 normal = a.normal;
+					float length = glm::length(normal);
+					if (length > 0.0f)
+					{
+						normal /= length;
+					}
+					vert.normal[0] = Snorm8(normal.x);
+					vert.normal[1] = Snorm8(-normal.y);
+					vert.normal[2] = Snorm8(normal.z);
+					vert.normal[3] = 0;
+
+					glm::vec2 uv = (a.uv - q.uvMin) * q.invUVRange;
+					vert.uv[0] = Unorm16(uv.x);
+					vert.uv[1] = Unorm16(uv.y);
+
+					vert.tangent[0] = Snorm8(a.tangent.x);
+					vert.tangent[1] = Snorm8(a.tangent.y);
+					vert.tangent[2] = Snorm8(a.tangent.z);
+					vert.tangent[3] = Snorm8(a.tangent.w);
+				}
+
+				memcpy(vertices + vertexStart + first, out.data(), count * sizeof(GLTF::Vertex));
+			}
+
+			uint32_t* dst = indices + primitive.firstIndex;
+			if (source.indices < 0)
+			{
+				for (uint32_t i = 0; i < primitive.indexCount; ++i)
+				{
+					dst[i] = vertexStart + i;
+				}
+				return true;
+			}
+
+			uint32_t largest = input.ReadIndices(source.indices, dst, vertexStart);
+			return primitive.indexCount == 0 || largest < vertexCount;
+		}
+
+		// The texture cache reads images from disk, so embedded ones are written out next
+		// to the cooked textures first. Rewritten only when the bytes changed size.
+		std::string ExtractImage(const GLTFAsset::Image& image, const std::string& directory, size_t index)
+		{
+			const char* extension = image.mimeType == "image/png" ? ".png" :
+				image.mimeType == "image/jpeg" ? ".jpg" : ".img";
+
+			std::ostringstream name;
+			name << TextureCache::DIRECTORY << "/" << std::filesystem::path(directory).filename().string()
+				<< "_" << std::hex << std::hash<std::string>{}(directory) << std::dec
+				<< "_image" << index << extension;
+			std::string file = name.str();
+
+			std::error_code ec;
+			if (std::filesystem::file_size(file, ec) != image.size || ec)
+			{
+				std::filesystem::create_directories(TextureCache::DIRECTORY, ec);
+				std::ofstream out(file, std::ios::binary | std::ios::trunc);
+				out.write(reinterpret_cast<const char*>(image.data), static_cast<std::streamsize>(image.size));
+			}
+
+			return file;
+		}
+	}
+
 	GLTF::GLTF(TendouDevice& device)
 		: device_(device)
+		, streamer(device)
 	{
 	}
 
@@ -37,29 +239,61 @@ namespace Tendou
 		{
 			vkDestroyPipeline(device_.Device(), material.pipeline, nullptr);
 		}
+
+		for (VkPipeline pipeline : bindlessPipelines)
+		{
+			vkDestroyPipeline(device_.Device(), pipeline, nullptr);
+		}
 	}
 
 	VkDescriptorImageInfo GLTF::GetTextureDescriptor(const size_t index)
 	{
-		return images[index].texture.get()->DescriptorInfo();
+		return streamer.Get(images[index].texture).DescriptorInfo();
 	}
 
-	void GLTF::LoadImages(tinygltf::Model& input)
+	void GLTF::LoadImages(const GLTFAsset& input)
 	{
-		// POI: The textures for the glTF file used in this sample are stored as external ktx files, so we can directly load them from disk without the need for conversion
 		images.resize(input.images.size());
 
+		// The cooked format depends on what the materials use each image for
+		std::vector<TextureRole> roles(input.images.size(), TextureRole::Color);
+		auto assignRole = [&](int32_t textureIndex, TextureRole role)
+		{
+			if (textureIndex >= 0)
+			{
+				int32_t source = input.textures[textureIndex].source;
+				if (source >= 0)
+				{
+					roles[source] = role;
+				}
+			}
+		};
+
+		for (const GLTFAsset::Material& material : input.materials)
+		{
+			assignRole(material.normalTexture, TextureRole::Normal);
+			assignRole(material.occlusionTexture, TextureRole::ORM);
+			assignRole(material.metallicRoughnessTexture, TextureRole::ORM);
+		}
+
 		for (size_t i = 0; i < input.images.size(); ++i) 
 		{
-			tinygltf::Image& glTFImage = input.images[i];
-			//images[i].texture.loadFromFile(path + "/" + glTFImage.uri, VK_FORMAT_R8G8B8A8_UNORM, vulkanDevice, copyQueue);
-			images[i].texture = std::make_unique<Texture>(device_, path + "/" + glTFImage.uri);
-			images[i].path = glTFImage.uri;
+			const GLTFAsset::Image& glTFImage = input.images[i];
+			if (glTFImage.uri.empty())
+			{
+				images[i].path = ExtractImage(glTFImage, path, i);
+				images[i].texture = streamer.Register(images[i].path, roles[i]);
+			}
+			else
+			{
+				images[i].texture = streamer.Register(path + "/" + glTFImage.uri, roles[i]);
+				images[i].path = glTFImage.uri;
+			}
 		}
 
 	}
 
-	void GLTF::LoadTextures(tinygltf::Model& input)
+	void GLTF::LoadTextures(const GLTFAsset& input)
 	{
 		textures.resize(input.textures.size());
 
@@ -69,194 +303,237 @@ namespace Tendou
 		}
 	}
 
-	void GLTF::LoadMaterials(tinygltf::Model& input)
+	void GLTF::LoadMaterials(const GLTFAsset& input)
 	{
 		materials.resize(input.materials.size());
 
 		for (size_t i = 0; i < input.materials.size(); ++i) 
 		{
 			// We only read the most basic properties required for our sample
-			tinygltf::Material glTFMaterial = input.materials[i];
+			const GLTFAsset::Material& glTFMaterial = input.materials[i];
 
-			// Get the base color factor
-			if (glTFMaterial.values.find("baseColorFactor") != glTFMaterial.values.end()) 
-			{
-				materials[i].baseColorFactor = glm::make_vec4(glTFMaterial.values["baseColorFactor"].ColorFactor().data());
-			}
+			materials[i].baseColorFactor = glTFMaterial.baseColorFactor;
 
-			// Get base color texture index
-			if (glTFMaterial.values.find("baseColorTexture") != glTFMaterial.values.end()) 
+			if (glTFMaterial.baseColorTexture >= 0)
 			{
-				materials[i].baseColorTextureIndex = glTFMaterial.values["baseColorTexture"].TextureIndex();
+				materials[i].baseColorTextureIndex = glTFMaterial.baseColorTexture;
 			}
 
-			// Get the normal map texture index
-			if (glTFMaterial.additionalValues.find("normalTexture") != glTFMaterial.additionalValues.end()) 
+			if (glTFMaterial.normalTexture >= 0)
 			{
-				materials[i].normalTextureIndex = glTFMaterial.additionalValues["normalTexture"].TextureIndex();
+				materials[i].normalTextureIndex = glTFMaterial.normalTexture;
 			}
 
 			// Get some additonal material parameters that are used in this sample
 			materials[i].alphaMode = glTFMaterial.alphaMode;
-			materials[i].alphaCutOff = static_cast<float>(glTFMaterial.alphaCutoff);
+			materials[i].alphaCutOff = glTFMaterial.alphaCutoff;
 			materials[i].doubleSided = glTFMaterial.doubleSided;
 		}
 	}
 
-	void GLTF::LoadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, 
-		GLTF::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<GLTF::Vertex>& vertexBuffer)
+	std::vector<GLTF::Mesh> GLTF::LoadMeshes(const GLTFAsset& input)
 	{
-		GLTF::Node node{};
-		node.name = inputNode.name;
+		TENDOU_PROFILE_FUNCTION();
 
-		// Get the local node matrix
-		// It's either made up from translation, rotation, scale or a 4x4 matrix
-		node.matrix = glm::mat4(1.0f);
-		if (inputNode.translation.size() == 3) 
+		// Only meshes the scene reaches are loaded, and each only once however many nodes use it
+		std::vector<char> used(input.meshes.size(), 0);
+		std::vector<int32_t> pending(input.sceneNodes);
+		while (!pending.empty())
 		{
-			node.matrix = glm::translate(node.matrix, glm::vec3(glm::make_vec3(inputNode.translation.data())));
+			const GLTFAsset::Node& node = input.nodes[pending.back()];
+			pending.pop_back();
+
+			if (node.mesh >= 0)
+			{
+				used[node.mesh] = 1;
+			}
+			pending.insert(pending.end(), node.children.begin(), node.children.end());
 		}
-		if (inputNode.rotation.size() == 4) 
+
+		// Every primitive's place in the shared buffers is known before any data is
+		// read, so they can all be converted at once straight into the staging buffers
+		struct Source
+		{
+			const GLTFAsset::Primitive* input;
+			uint32_t mesh;
+			uint32_t primitive;
+			uint32_t vertexStart;
+			uint32_t vertexCount;
+		};
+
+		std::vector<Mesh> meshes(input.meshes.size());
+		std::vector<Source> sources;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+
+		for (size_t m = 0; m < input.meshes.size(); ++m)
 		{
-			glm::quat q = glm::make_quat(inputNode.rotation.data());
-			node.matrix *= glm::mat4(q);
+			if (!used[m])
+			{
+				continue;
+			}
+
+			for (const GLTFAsset::Primitive& glTFPrimitive : input.meshes[m].primitives)
+			{
+				// Points and lines have no pipeline here
+				if (glTFPrimitive.mode != GLTFAsset::TRIANGLES || glTFPrimitive.position < 0)
+				{
+					continue;
+				}
+
+				size_t count = input.accessors[glTFPrimitive.position].count;
+
+				Primitive primitive{};
+				primitive.firstIndex = static_cast<uint32_t>(indexCount);
+				primitive.indexCount = static_cast<uint32_t>(glTFPrimitive.indices >= 0 ?
+					input.accessors[glTFPrimitive.indices].count : count);
+				primitive.materialIndex = glTFPrimitive.material;
+
+				sources.push_back({ &glTFPrimitive, static_cast<uint32_t>(m),
+					static_cast<uint32_t>(meshes[m].primitives.size()),
+					static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(count) });
+				meshes[m].primitives.push_back(primitive);
+
+				vertexCount += count;
+				indexCount += primitive.indexCount;
+			}
 		}
-		if (inputNode.scale.size() == 3) 
+
+		if (vertexCount == 0 || indexCount == 0)
 		{
-			node.matrix = glm::scale(node.matrix, glm::vec3(glm::make_vec3(inputNode.scale.data())));
+			throw std::runtime_error("Failed to load glTF file, the scene has no triangles!");
 		}
-		if (inputNode.matrix.size() == 16) 
+
+		if (vertexCount > std::numeric_limits<uint32_t>::max() || indexCount > std::numeric_limits<uint32_t>::max())
 		{
-			node.matrix = glm::make_mat4x4(inputNode.matrix.data());
-		};
+			throw std::runtime_error("Failed to load glTF file, the scene doesn't fit 32 bit indices!");
+		}
 
-		// Load node's children
-		if (inputNode.children.size() > 0) {
-			for (size_t i = 0; i < inputNode.children.size(); i++) {
-				LoadNode(input.nodes[inputNode.children[i]], input, &node, indexBuffer, vertexBuffer);
+		std::vector<Ranges> ranges(sources.size());
+		JobSystem::ParallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const Source& s = sources[i];
+					MeasurePrimitive(input, *s.input, s.vertexCount, meshes[s.mesh].primitives[s.primitive], ranges[i]);
+				}
+			}, "GLTF::MeasurePrimitive");
+
+		// Each mesh's primitives share its bounding cube, so one matrix per node dequantizes them all
+		std::vector<glm::vec3> meshMin(meshes.size(), glm::vec3(std::numeric_limits<float>::max()));
+		std::vector<glm::vec3> meshMax(meshes.size(), glm::vec3(std::numeric_limits<float>::lowest()));
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			meshMin[sources[i].mesh] = glm::min(meshMin[sources[i].mesh], ranges[i].posMin);
+			meshMax[sources[i].mesh] = glm::max(meshMax[sources[i].mesh], ranges[i].posMax);
+		}
+
+		std::vector<Quantization> quantization(sources.size());
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			const Source& s = sources[i];
+			glm::vec3 center = (meshMin[s.mesh] + meshMax[s.mesh]) * 0.5f;
+			glm::vec3 half = (meshMax[s.mesh] - meshMin[s.mesh]) * 0.5f;
+			float extent = std::max({ half.x, half.y, half.z });
+			extent = extent > 0.0f ? extent : 1.0f;
+
+			meshes[s.mesh].dequantize = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(extent));
+
+			glm::vec2 uvRange = ranges[i].uvMax - ranges[i].uvMin;
+			uvRange = glm::vec2(uvRange.x > 0.0f ? uvRange.x : 1.0f, uvRange.y > 0.0f ? uvRange.y : 1.0f);
+			quantization[i] = { center, 1.0f / extent, ranges[i].uvMin, 1.0f / uvRange };
+
+			// The material's transform applies to the dequantized uv
+			glm::vec4 material(1.0f, 1.0f, 0.0f, 0.0f);
+			if (s.input->material >= 0)
+			{
+				material = input.materials[s.input->material].uvTransform;
 			}
+			glm::vec2 scale = glm::vec2(material) * uvRange;
+			glm::vec2 offset = glm::vec2(material) * ranges[i].uvMin + glm::vec2(material.z, material.w);
+			meshes[s.mesh].primitives[s.primitive].uvTransform = glm::vec4(scale, offset);
 		}
 
-		// If the node contains mesh data, we load vertices and indices from the the buffers
-		// In glTF this is done via accessors and buffer views
-		if (inputNode.mesh > -1) 
+		Buffer vertexStaging
+		{
+			device_,
+			sizeof(GLTF::Vertex),
+			static_cast<uint32_t>(vertexCount),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+		vertexStaging.Map();
+
+		Buffer indexStaging
 		{
-			const tinygltf::Mesh mesh = input.meshes[inputNode.mesh];
-			// Iterate through all primitives of this node's mesh
-			for (size_t i = 0; i < mesh.primitives.size(); ++i) 
+			device_,
+			sizeof(uint32_t),
+			static_cast<uint32_t>(indexCount),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+		indexStaging.Map();
+
+		Vertex* vertexOut = static_cast<Vertex*>(vertexStaging.GetMappedMemory());
+		uint32_t* indexOut = static_cast<uint32_t*>(indexStaging.GetMappedMemory());
+
+		std::vector<char> valid(sources.size(), 1);
+		JobSystem::ParallelFor(static_cast<uint32_t>(sources.size()), 1, [&](uint32_t begin, uint32_t end)
 			{
-				const tinygltf::Primitive& glTFPrimitive = mesh.primitives[i];
-				uint32_t firstIndex = static_cast<uint32_t>(indexBuffer.size());
-				uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
-				uint32_t indexCount = 0;
-				// Vertices
+				for (uint32_t i = begin; i < end; ++i)
 				{
-					const float* positionBuffer = nullptr;
-					const float* normalsBuffer = nullptr;
-					const float* texCoordsBuffer = nullptr;
-					const float* tangentsBuffer = nullptr;
-					size_t vertexCount = 0;
-
-					// Get buffer data for vertex normals
-					if (glTFPrimitive.attributes.find("POSITION") != glTFPrimitive.attributes.end()) 
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("POSITION")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						positionBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-						vertexCount = accessor.count;
-					}
-					// Get buffer data for vertex normals
-					if (glTFPrimitive.attributes.find("NORMAL") != glTFPrimitive.attributes.end()) 
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("NORMAL")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						normalsBuffer = reinterpret_cast<const float*>
-							(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
+					const Source& s = sources[i];
+					valid[i] = ConvertPrimitive(input, *s.input, s.vertexStart, s.vertexCount, quantization[i],
+						meshes[s.mesh].primitives[s.primitive], vertexOut, indexOut) ? 1 : 0;
+				}
+			}, "GLTF::ConvertPrimitive");
 
-					// Get buffer data for vertex texture coordinates
-					// glTF supports multiple sets, we only load the first one
-					if (glTFPrimitive.attributes.find("TEXCOORD_0") != glTFPrimitive.attributes.end()) 
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("TEXCOORD_0")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						texCoordsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
+		if (std::find(valid.begin(), valid.end(), 0) != valid.end())
+		{
+			throw std::runtime_error("Failed to load glTF file, a primitive indexes past its vertices!");
+		}
 
-					// POI: This sample uses normal mapping, so we also need to load the tangents from the glTF file
-					if (glTFPrimitive.attributes.find("TANGENT") != glTFPrimitive.attributes.end()) 
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("TANGENT")->second];
-						const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-						tangentsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					}
+		// Single vertex buffer and single index buffer for the whole scene,
+		// primitives index into them with offsets
+		vertices.buffer = std::make_unique<Buffer>(
+			device_,
+			sizeof(GLTF::Vertex),
+			static_cast<uint32_t>(vertexCount),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-					// Append data to model's vertex buffer
-					for (size_t v = 0; v < vertexCount; ++v) 
-					{
-						Vertex vert{};
-						vert.pos = glm::vec4(glm::make_vec3(&positionBuffer[v * 3]), 1.0f);
-						vert.pos.y *= -1.0f;
-
-						vert.normal = glm::normalize(glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f)));
-						vert.normal.y *= -1.0f;
-						
-						vert.uv = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec3(0.0f);
-
-						vert.color = glm::vec3(1.0f);
-						vert.tangent = tangentsBuffer ? glm::make_vec4(&tangentsBuffer[v * 4]) : glm::vec4(0.0f);
-						vertexBuffer.push_back(vert);
-					}
-				}
-				
-				// Indices
-				{
-					const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
-					const tinygltf::BufferView& bufferView = input.bufferViews[accessor.bufferView];
-					const tinygltf::Buffer& buffer = input.buffers[bufferView.buffer];
+		indices.buffer = std::make_unique<Buffer>(
+			device_,
+			sizeof(uint32_t),
+			static_cast<uint32_t>(indexCount),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		indices.count = static_cast<int>(indexCount);
 
-					indexCount += static_cast<uint32_t>(accessor.count);
+		device_.CopyBuffer(vertexStaging.GetBuffer(), vertices.buffer->GetBuffer(), vertexCount * sizeof(GLTF::Vertex));
+		device_.CopyBuffer(indexStaging.GetBuffer(), indices.buffer->GetBuffer(), indexCount * sizeof(uint32_t));
 
-					// glTF supports different component types of indices
-					switch (accessor.componentType) {
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: 
-					{
-						uint32_t* buf = new uint32_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-						for (size_t index = 0; index < accessor.count; index++) {
-							indexBuffer.push_back(buf[index] + vertexStart);
-						}
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: 
-					{
-						uint16_t* buf = new uint16_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-						for (size_t index = 0; index < accessor.count; index++) {
-							indexBuffer.push_back(buf[index] + vertexStart);
-						}
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: 
-					{
-						uint8_t* buf = new uint8_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-						for (size_t index = 0; index < accessor.count; index++) {
-							indexBuffer.push_back(buf[index] + vertexStart);
-						}
-						break;
-					}
-					default:
-						std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
-						return;
-					}
-				}
-				Primitive primitive{};
-				primitive.firstIndex = firstIndex;
-				primitive.indexCount = indexCount;
-				primitive.materialIndex = glTFPrimitive.material;
-				node.mesh.primitives.push_back(primitive);
-			}
+		return meshes;
+	}
+
+	void GLTF::LoadNode(const GLTFAsset& input, int32_t nodeIndex, GLTF::Node* parent, const std::vector<Mesh>& meshes)
+	{
+		const GLTFAsset::Node& inputNode = input.nodes[nodeIndex];
+
+		GLTF::Node node{};
+		node.name = inputNode.name;
+		node.matrix = inputNode.matrix;
+
+		// Load node's children
+		for (int32_t child : inputNode.children)
+		{
+			LoadNode(input, child, &node, meshes);
+		}
+
+		// Geometry was converted by LoadMeshes, nodes only refer to it
+		if (inputNode.mesh > -1) 
+		{
+			node.mesh = meshes[inputNode.mesh];
 		}
 
 		if (parent) 
@@ -289,16 +566,21 @@ namespace Tendou
 				currentParent = currentParent->parent;
 			}
 			// Pass the final matrix to the vertex shader using push constants
-			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &nodeMatrix);
+			nodeMatrix *= node.mesh.dequantize;
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+				offsetof(PushConstants, model), sizeof(glm::mat4), &nodeMatrix);
 			for (GLTF::Primitive& primitive : node.mesh.primitives) 
 			{
 				if (primitive.indexCount > 0) 
 				{
 					GLTF::Material& material = materials[primitive.materialIndex];
+					vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+						offsetof(PushConstants, uvTransform), sizeof(glm::vec4), &primitive.uvTransform);
 					// POI: Bind the pipeline for the node's material
 					vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material.pipeline);
 					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &material.descriptorSet, 0, nullptr);
 					vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, primitive.firstIndex, 0, 0);
+					RenderStats::CountDraw(primitive.indexCount);
 				}
 			}
 		}
@@ -326,6 +608,191 @@ namespace Tendou
 
 	}
 
+	void GLTF::RequestTextures(const glm::vec3& eye, float focalPixels)
+	{
+		for (auto& node : nodes)
+		{
+			RequestNode(node, glm::mat4(1.0f), eye, focalPixels);
+		}
+	}
+
+	void GLTF::RequestNode(const GLTF::Node& node, const glm::mat4& parentMatrix,
+		const glm::vec3& eye, float focalPixels)
+	{
+		if (!node.visible)
+		{
+			return;
+		}
+
+		glm::mat4 nodeMatrix = parentMatrix * node.matrix;
+
+		// Largest axis scale, so the sphere still bounds the primitive
+		float scale = std::max({ glm::length(glm::vec3(nodeMatrix[0])),
+			glm::length(glm::vec3(nodeMatrix[1])), glm::length(glm::vec3(nodeMatrix[2])) });
+
+		for (const GLTF::Primitive& primitive : node.mesh.primitives)
+		{
+			if (primitive.indexCount == 0 || primitive.materialIndex < 0)
+			{
+				continue;
+			}
+
+			glm::vec3 center = glm::vec3(nodeMatrix * glm::vec4(primitive.center, 1.0f));
+			float radius = primitive.radius * scale;
+
+			// Assumes the primitive's UVs span its texture once
+			float distance = std::max(glm::length(center - eye) - radius, 0.1f);
+			float pixels = 2.0f * radius / distance * focalPixels;
+
+			const Material& material = materials[primitive.materialIndex];
+			streamer.Request(images[material.baseColorTextureIndex].texture, pixels);
+			streamer.Request(images[material.normalTextureIndex].texture, pixels);
+		}
+
+		for (auto& child : node.children)
+		{
+			RequestNode(child, nodeMatrix, eye, focalPixels);
+		}
+	}
+
+	void GLTF::GatherNode(const GLTF::Node& node)
+	{
+		if (!node.visible)
+		{
+			return;
+		}
+
+		if (node.mesh.primitives.size() > 0)
+		{
+			// Same matrix as DrawNode
+			glm::mat4 nodeMatrix = node.matrix;
+			GLTF::Node* currentParent = node.parent;
+			while (currentParent) {
+				nodeMatrix = currentParent->matrix * nodeMatrix;
+				currentParent = currentParent->parent;
+			}
+			nodeMatrix *= node.mesh.dequantize;
+
+			for (const GLTF::Primitive& primitive : node.mesh.primitives)
+			{
+				if (primitive.indexCount > 0)
+				{
+					drawList.push_back({ nodeMatrix, &primitive, 0 });
+				}
+			}
+		}
+
+		for (auto& child : node.children)
+		{
+			GatherNode(child);
+		}
+	}
+
+	void GLTF::DrawParallel(const SecondaryContext& ctx, VkCommandBuffer primary,
+		VkPipelineLayout pipelineLayout, VkDescriptorSet sceneSet)
+	{
+		drawList.clear();
+		for (auto& node : nodes)
+		{
+			GatherNode(node);
+		}
+
+		// Everything the secondaries record, so frames where nothing moved replay them
+		uint64_t hash = Hash64(&sceneSet, sizeof(sceneSet), reinterpret_cast<uint64_t>(pipelineLayout));
+		for (const DrawItem& item : drawList)
+		{
+			const GLTF::Material& material = materials[item.primitive->materialIndex];
+			hash = Hash64(&item.matrix, sizeof(item.matrix), hash);
+			hash = Hash64(&item.primitive, sizeof(item.primitive), hash);
+			hash = Hash64(&material.pipeline, sizeof(material.pipeline), hash);
+			hash = Hash64(&material.descriptorSet, sizeof(material.descriptorSet), hash);
+		}
+
+		ctx.RecordCached(primary, "GLTF", hash, static_cast<uint32_t>(drawList.size()),
+			[&](VkCommandBuffer buf, uint32_t begin, uint32_t end)
+			{
+				VkBuffer buffers[] = { vertices.buffer->GetBuffer() };
+				VkDeviceSize offsets[1] = { 0 };
+				vkCmdBindVertexBuffers(buf, 0, 1, buffers, offsets);
+				vkCmdBindIndexBuffer(buf, indices.buffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+				vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &sceneSet, 0, nullptr);
+
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const DrawItem& item = drawList[i];
+					GLTF::Material& material = materials[item.primitive->materialIndex];
+
+					PushConstants push{ item.matrix, item.primitive->uvTransform };
+					vkCmdPushConstants(buf, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+					vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, material.pipeline);
+					vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &material.descriptorSet, 0, nullptr);
+					vkCmdDrawIndexed(buf, item.primitive->indexCount, 1, item.primitive->firstIndex, 0, 0);
+					RenderStats::CountDraw(item.primitive->indexCount);
+				}
+			}, 64);
+	}
+
+	void GLTF::DrawParallelBindless(const SecondaryContext& ctx, VkCommandBuffer primary,
+		VkPipelineLayout pipelineLayout, const std::array<VkDescriptorSet, 3>& sets, uint32_t materialOffset)
+	{
+		drawList.clear();
+		for (auto& node : nodes)
+		{
+			GatherNode(node);
+		}
+
+		// Pipelines are the only state left to switch, so keep each variant together
+		for (DrawItem& item : drawList)
+		{
+			uint32_t materialIndex = static_cast<uint32_t>(item.primitive->materialIndex);
+			item.sortKey = (materials[materialIndex].PipelineVariant() << 24) | (materialIndex & 0xffffff);
+		}
+		std::sort(drawList.begin(), drawList.end(),
+			[](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+
+		// Material data and texture slots are read from buffers, only the offset into them is recorded
+		uint64_t hash = Hash64(sets.data(), sizeof(VkDescriptorSet) * sets.size(), reinterpret_cast<uint64_t>(pipelineLayout));
+		hash = Hash64(&materialOffset, sizeof(materialOffset), hash);
+		hash = Hash64(bindlessPipelines.data(), sizeof(VkPipeline) * bindlessPipelines.size(), hash);
+		for (const DrawItem& item : drawList)
+		{
+			hash = Hash64(&item.matrix, sizeof(item.matrix), hash);
+			hash = Hash64(&item.primitive, sizeof(item.primitive), hash);
+			hash = Hash64(&item.sortKey, sizeof(item.sortKey), hash);
+		}
+
+		ctx.RecordCached(primary, "GLTFBindless", hash, static_cast<uint32_t>(drawList.size()),
+			[&](VkCommandBuffer buf, uint32_t begin, uint32_t end)
+			{
+				VkBuffer buffers[] = { vertices.buffer->GetBuffer() };
+				VkDeviceSize offsets[1] = { 0 };
+				vkCmdBindVertexBuffers(buf, 0, 1, buffers, offsets);
+				vkCmdBindIndexBuffer(buf, indices.buffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+				vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0,
+					static_cast<uint32_t>(sets.size()), sets.data(), 1, &materialOffset);
+
+				VkPipeline boundPipeline = VK_NULL_HANDLE;
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					const DrawItem& item = drawList[i];
+
+					VkPipeline pipeline = bindlessPipelines[item.sortKey >> 24];
+					if (pipeline != boundPipeline)
+					{
+						vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+						boundPipeline = pipeline;
+					}
+
+					BindlessPushConstants push{ item.matrix, item.primitive->uvTransform,
+						static_cast<uint32_t>(item.primitive->materialIndex) };
+					vkCmdPushConstants(buf, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+						0, sizeof(push), &push);
+					vkCmdDrawIndexed(buf, item.primitive->indexCount, 1, item.primitive->firstIndex, 0, 0);
+					RenderStats::CountDraw(item.primitive->indexCount);
+				}
+			}, 64);
+	}
+
 	GLTFScene::GLTFScene(Window& window, TendouDevice& device)
 		: Scene(window, device)
 		, glTFScene(device)
@@ -341,8 +808,32 @@ namespace Tendou
 
 	int GLTFScene::Init()
 	{
+		renderCamera = c;
 		PrepareUniformBuffers();
-		SetupDescriptors();
+
+		// Falls back to per-material sets when the bindless shaders haven't been built
+		bindless = device.SupportsBindless() &&
+			std::filesystem::exists("Materials/Shaders/GLTFBindless.vert.spv") &&
+			std::filesystem::exists("Materials/Shaders/GLTFBindless.frag.spv");
+
+		if (bindless)
+		{
+			bindlessTable = std::make_unique<BindlessTable>(device);
+			if (glTFScene.images.size() > bindlessTable->Capacity())
+			{
+				bindlessTable.reset();
+				bindless = false;
+			}
+		}
+
+		if (bindless)
+		{
+			SetupBindlessDescriptors();
+		}
+		else
+		{
+			SetupDescriptors();
+		}
 		PreparePipelines();
 
 		return 0;
@@ -371,178 +862,165 @@ namespace Tendou
 
 			ImGui::EndMenu();
 		}
+
+		if (ImGui::BeginMenu("Texture Streaming"))
+		{
+			glTFScene.streamer.DrawStats();
+			ImGui::EndMenu();
+		}
 		return 0;
 	}
 
 	int GLTFScene::Update()
 	{
-		UpdateUniformBuffers();
 		return 0;
 	}
 
-	int GLTFScene::PostUpdate()
+	void GLTFScene::ReadFramePacket(const FramePacket& packet)
 	{
-		return 0;
+		Scene::ReadFramePacket(packet);
+
+		// Streaming counts rendered frames for retiring sets and slots, so it
+		// runs here rather than once per fixed step in Update
+		UpdateUniformBuffers();
+		UpdateTextureStreaming();
 	}
 
-	int GLTFScene::Render(VkCommandBuffer buf, FrameInfo& f)
+	void GLTFScene::UpdateTextureStreaming()
 	{
-		// Render the actual scene (swapchain)
-		BeginSwapChainRenderPass(buf);
-		vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
-		glTFScene.Draw(buf, pipelineLayout);
+		TENDOU_PROFILE_FUNCTION();
 
-		return 0;
-	}
+		++frameCount;
+		while (!retiredSets.empty() && retiredSets.front().frame + SwapChain::MAX_FRAMES_IN_FLIGHT < frameCount)
+		{
+			std::vector<VkDescriptorSet> sets = { retiredSets.front().set };
+			globalPool->FreeDescriptors(sets);
+			retiredSets.pop_front();
+		}
 
-	void GLTFScene::LoadGLTFFile(std::string path)
-	{
-		tinygltf::Model glTFInput;
-		tinygltf::TinyGLTF gltfContext;
-		std::string error, warning;
+		float focalPixels = swapChain->Height() / (2.0f * std::tan(glm::radians(renderCamera.GetZoom()) * 0.5f));
+		glTFScene.RequestTextures(renderCamera.cameraPos, focalPixels);
+		glTFScene.streamer.Update();
 
-		bool fileLoaded = gltfContext.LoadASCIIFromFile(&glTFInput, &error, &warning, path);
+		if (bindless)
+		{
+			UpdateBindlessTextures();
+			return;
+		}
 
-		//// Pass some Vulkan resources required for setup and rendering to the glTF model loading class
-		//glTFScene.vulkanDevice = vulkanDevice;
-		//glTFScene.copyQueue = queue;
+		for (auto& material : glTFScene.materials)
+		{
+			uint32_t colorVersion = glTFScene.streamer.Version(glTFScene.images[material.baseColorTextureIndex].texture);
+			uint32_t normalVersion = glTFScene.streamer.Version(glTFScene.images[material.normalTextureIndex].texture);
+			if (colorVersion == material.colorVersion && normalVersion == material.normalVersion)
+			{
+				continue;
+			}
 
-		size_t pos = path.find_last_of('/');
-		glTFScene.path = path.substr(0, pos);
+			// Frames in flight may still use the current set, so write a fresh one
+			VkDescriptorSet set;
+			if (!globalPool->AllocateDescriptor(descriptorSetLayouts.textures, set))
+			{
+				throw std::runtime_error("Failed to allocate material descriptor set!");
+			}
+			WriteMaterialSet(material, set);
+			retiredSets.push_back({ material.descriptorSet, frameCount });
+			material.descriptorSet = set;
 
-		std::vector<uint32_t> indexBuffer;
-		std::vector<GLTF::Vertex> vertexBuffer;
+			material.colorVersion = colorVersion;
+			material.normalVersion = normalVersion;
+		}
+	}
 
-		if (fileLoaded) {
-			glTFScene.LoadTextures(glTFInput);
-			glTFScene.LoadImages(glTFInput);
-			glTFScene.LoadMaterials(glTFInput);
-			const tinygltf::Scene& scene = glTFInput.scenes[0];
+	void GLTFScene::UpdateBindlessTextures()
+	{
+		bindlessTable->NextFrame();
 
-			for (size_t i = 0; i < scene.nodes.size(); ++i) 
+		for (auto& image : glTFScene.images)
+		{
+			uint32_t version = glTFScene.streamer.Version(image.texture);
+			if (version == image.version)
 			{
-				const tinygltf::Node node = glTFInput.nodes[scene.nodes[i]];
-				glTFScene.LoadNode(node, glTFInput, nullptr, indexBuffer, vertexBuffer);
+				continue;
 			}
+
+			// Frames in flight may still sample the current slot, so write a fresh one
+			VkDescriptorImageInfo info = glTFScene.streamer.Get(image.texture).DescriptorInfo();
+			uint32_t slot = bindlessTable->Add(info);
+			if (slot != BindlessTable::INVALID_SLOT)
+			{
+				bindlessTable->Release(image.slot);
+				image.slot = slot;
+			}
+			else
+			{
+				// Table is full of released slots; rare enough to just wait it out
+				vkDeviceWaitIdle(device.Device());
+				bindlessTable->Update(image.slot, info);
+			}
+
+			image.version = version;
 		}
+	}
 
-		else 
+	void GLTFScene::UploadMaterials(uint32_t frameIdx)
+	{
+		// Slots move as textures stream, and each frame in flight reads its own region
+		for (size_t i = 0; i < glTFScene.materials.size(); ++i)
 		{
-			std::cout << "Uh oh!" << std::endl;
-			return;
+			const GLTF::Material& material = glTFScene.materials[i];
+			gpuMaterials[i].colorTexture = glTFScene.images[material.baseColorTextureIndex].slot;
+			gpuMaterials[i].normalTexture = glTFScene.images[material.normalTextureIndex].slot;
+			gpuMaterials[i].alphaCutOff = material.alphaCutOff;
+			gpuMaterials[i].pad = 0;
 		}
+		materialBuffer->WriteToIndex(gpuMaterials.data(), static_cast<int>(frameIdx));
+	}
 
-		// Create and upload vertex and index buffer
-		// We will be using one single vertex buffer and one single index buffer for the whole glTF scene
-		// Primitives (of the glTF model) will then index into these using index offsets
-
-		size_t vertexBufferSize = vertexBuffer.size() * sizeof(GLTF::Vertex);
-		size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-		glTFScene.indices.count = static_cast<uint32_t>(indexBuffer.size());
-
-		//struct StagingBuffer 
-		//{
-		//	VkBuffer buffer;
-		//	VkDeviceMemory memory;
-		//} vertexStaging, indexStaging;
+	int GLTFScene::PostUpdate()
+	{
+		return 0;
+	}
 
-		Buffer vertexStaging
+	int GLTFScene::Render(VkCommandBuffer buf, FrameInfo& f)
+	{
+		// Render the actual scene (swapchain)
+		// Primitives are recorded into secondaries across the job system
+		BeginSwapChainRenderPass(buf, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		if (bindless)
 		{
-			device,
-			sizeof(GLTF::Vertex),
-			static_cast<uint32_t>(vertexBuffer.size()),
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-		
-		vertexStaging.Map();
-		vertexStaging.WriteToBuffer((void*)vertexBuffer.data());
+			UploadMaterials(static_cast<uint32_t>(f.frameIdx));
+			uint32_t materialOffset = static_cast<uint32_t>(materialBuffer->GetAlignmentSize() * f.frameIdx);
+			glTFScene.DrawParallelBindless(*GetPassContext(), buf, pipelineLayout,
+				{ descriptorSet, bindlessTable->GetSet(), materialSet }, materialOffset);
+			return 0;
+		}
 
-		Buffer indexStaging
-		{
-			device,
-			sizeof(uint32_t),
-			static_cast<uint32_t>(indexBuffer.size()),
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-		
-		indexStaging.Map();
-		indexStaging.WriteToBuffer((void*)indexBuffer.data());
-		
-		//indexBuffer = std::make_unique<Buffer>(
-		//	device_,
-		//	indexSize,
-		//	indexCount,
-		//	VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		//	VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		//
-		//device_.CopyBuffer(stagingBuffer.GetBuffer(), indexBuffer->GetBuffer(), bufSize);
-
-		//// Create host visible staging buffers (source)
-		//VK_CHECK_RESULT(vulkanDevice->createBuffer(
-		//	VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		//	VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		//	vertexBufferSize,
-		//	&vertexStaging.buffer,
-		//	&vertexStaging.memory,
-		//	vertexBuffer.data()));
-		//// Index data
-		//VK_CHECK_RESULT(vulkanDevice->createBuffer(
-		//	VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		//	VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		//	indexBufferSize,
-		//	&indexStaging.buffer,
-		//	&indexStaging.memory,
-		//	indexBuffer.data()));
-
-		// Create device local buffers (target)
-
-		glTFScene.vertices.buffer = std::make_unique<Buffer>(
-			device,
-			sizeof(GLTF::Vertex),
-			static_cast<uint32_t>(vertexBuffer.size()),
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		glTFScene.DrawParallel(*GetPassContext(), buf, pipelineLayout, descriptorSet);
 
-		glTFScene.indices.buffer = std::make_unique<Buffer>(
-			device,
-			sizeof(uint32_t),
-			static_cast<uint32_t>(indexBuffer.size()),
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		return 0;
+	}
 
-		device.CopyBuffer(vertexStaging.GetBuffer(), glTFScene.vertices.buffer->GetBuffer(), vertexBufferSize);
-		device.CopyBuffer(indexStaging.GetBuffer(), glTFScene.indices.buffer->GetBuffer(), indexBufferSize);
+	void GLTFScene::LoadGLTFFile(std::string path)
+	{
+		TENDOU_PROFILE_FUNCTION();
 
-		//// Copy data from staging buffers (host) do device local buffer (gpu)
-		//VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-		//VkBufferCopy copyRegion = {};
-		//
-		//copyRegion.size = vertexBufferSize;
-		//vkCmdCopyBuffer(
-		//	copyCmd,
-		//	vertexStaging.buffer,
-		//	glTFScene.vertices.buffer,
-		//	1,
-		//	&copyRegion);
-		//
-		//copyRegion.size = indexBufferSize;
-		//vkCmdCopyBuffer(
-		//	copyCmd,
-		//	indexStaging.buffer,
-		//	glTFScene.indices.buffer,
-		//	1,
-		//	&copyRegion);
-		//
-		//vulkanDevice->flushCommandBuffer(copyCmd, queue, true);
+		// .gltf or .glb; buffers stay memory mapped until the geometry is converted
+		GLTFAsset glTFInput;
+		glTFInput.Load(path);
 
-		//// Free staging resources
-		//vkDestroyBuffer(device.Device(), vertexStaging.GetBuffer(), nullptr);
-		//vkFreeMemory(device, vertexStaging.GetBuffer(), nullptr);
-		//vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-		//vkFreeMemory(device, indexStaging.memory, nullptr);
+		size_t pos = path.find_last_of('/');
+		glTFScene.path = path.substr(0, pos);
+
+		glTFScene.LoadTextures(glTFInput);
+		glTFScene.LoadImages(glTFInput);
+		glTFScene.LoadMaterials(glTFInput);
 
+		std::vector<GLTF::Mesh> meshes = glTFScene.LoadMeshes(glTFInput);
+		for (int32_t node : glTFInput.sceneNodes)
+		{
+			glTFScene.LoadNode(glTFInput, node, nullptr, meshes);
+		}
 	}
 	
 	void GLTFScene::SetupDescriptors()
@@ -550,15 +1028,16 @@ namespace Tendou
 		/*
 			This sample uses separate descriptor sets (and layouts) for the matrices and materials (textures)
 		*/
-		const uint32_t maxSetCount = static_cast<uint32_t>(glTFScene.images.size()) + 1;
-		const uint32_t maxCount = maxSetCount > glTFScene.materials.size() * 2 ? maxSetCount : glTFScene.materials.size() * 4;
+		const uint32_t setCount = static_cast<uint32_t>(glTFScene.materials.size()) + 1;
 
 		// One ubo to pass dynamic data to the shader
-		// Two combined image samplers per material as each material uses color and normal maps
+		// Two combined image samplers per material as each material uses color and normal maps.
+		// Sets replaced by texture streaming are freed, and the pool grows if they pile up.
 		globalPool = DescriptorPool::Builder(device)
-			.SetMaxSets(maxCount)
+			.SetMaxSets(setCount)
+			.SetPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
 			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(glTFScene.materials.size()) * 2)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount * 2)
 			.Build();
 
 		//std::vector<VkDescriptorPoolSize> poolSizes = {
@@ -582,7 +1061,7 @@ namespace Tendou
 		descriptorSetLayoutCI.pBindings = &setLayoutBinding;
 		descriptorSetLayoutCI.bindingCount = 1;
 
-		vkCreateDescriptorSetLayout(device.Device(), &descriptorSetLayoutCI, nullptr, &descriptorSetLayouts.matrices);
+		descriptorSetLayouts.matrices = device.LayoutCache().CreateLayout(descriptorSetLayoutCI);
 
 		// Descriptor set layout for passing material textures
 		
@@ -608,7 +1087,7 @@ namespace Tendou
 
 		descriptorSetLayoutCI.pBindings = materialBindings.data();
 		descriptorSetLayoutCI.bindingCount = 2;
-		vkCreateDescriptorSetLayout(device.Device(), &descriptorSetLayoutCI, nullptr, &descriptorSetLayouts.textures);
+		descriptorSetLayouts.textures = device.LayoutCache().CreateLayout(descriptorSetLayoutCI);
 
 		// Pipeline layout using both descriptor sets (set 0 = matrices, set 1 = material)
 		std::array<VkDescriptorSetLayout, 2> setLayouts = { descriptorSetLayouts.matrices, descriptorSetLayouts.textures };
@@ -623,7 +1102,7 @@ namespace Tendou
 		VkPushConstantRange pushConstantRange{};
 		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(glm::mat4);
+		pushConstantRange.size = sizeof(GLTF::PushConstants);
 
 
 		// Push constant ranges are part of the pipeline layout
@@ -632,16 +1111,9 @@ namespace Tendou
 		vkCreatePipelineLayout(device.Device(), &pipelineLayoutCI, nullptr, &pipelineLayout);
 
 		// Descriptor set for scene matrices
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = globalPool->GetDescriptorPool();
-		allocInfo.pSetLayouts = &descriptorSetLayouts.matrices;
-		allocInfo.descriptorSetCount = 1;
-
-
 		auto bufInfo = shaderData.buffer->DescriptorInfo();
 
-		vkAllocateDescriptorSets(device.Device(), &allocInfo, &descriptorSet);
+		globalPool->AllocateDescriptor(descriptorSetLayouts.matrices, descriptorSet);
 		VkWriteDescriptorSet writeDescriptorSet{};
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
@@ -655,43 +1127,148 @@ namespace Tendou
 		// Descriptor sets for materials
 		for (auto& material : glTFScene.materials) 
 		{
-			VkDescriptorSetAllocateInfo allocInfo{};
-			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocInfo.descriptorPool = globalPool->GetDescriptorPool();
-			allocInfo.pSetLayouts = &descriptorSetLayouts.textures;
-			allocInfo.descriptorSetCount = 1;
-			
-			vkAllocateDescriptorSets(device.Device(), &allocInfo, &material.descriptorSet);
-
-			VkDescriptorImageInfo colorMap = glTFScene.GetTextureDescriptor(material.baseColorTextureIndex);
-			VkDescriptorImageInfo normalMap = glTFScene.GetTextureDescriptor(material.normalTextureIndex);
-
-			VkWriteDescriptorSet colorSet{};
-			colorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			colorSet.dstSet = material.descriptorSet;
-			colorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			colorSet.dstBinding = 0;
-			colorSet.pImageInfo = &colorMap;
-			colorSet.descriptorCount = 1;
-
-			VkWriteDescriptorSet normalSet{};
-			normalSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			normalSet.dstSet = material.descriptorSet;
-			normalSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			normalSet.dstBinding = 1;
-			normalSet.pImageInfo = &normalMap;
-			normalSet.descriptorCount = 1;
-
-			std::vector<VkWriteDescriptorSet> writeDescriptorSets = 
-			{
-				colorSet,
-				normalSet
-			};
-			vkUpdateDescriptorSets(device.Device(), static_cast<uint32_t>(writeDescriptorSets.size()), 
-				writeDescriptorSets.data(), 0, nullptr);
+			globalPool->AllocateDescriptor(descriptorSetLayouts.textures, material.descriptorSet);
+			WriteMaterialSet(material, material.descriptorSet);
+
+			material.colorVersion = glTFScene.streamer.Version(glTFScene.images[material.baseColorTextureIndex].texture);
+			material.normalVersion = glTFScene.streamer.Version(glTFScene.images[material.normalTextureIndex].texture);
+		}
+	}
+
+	void GLTFScene::SetupBindlessDescriptors()
+	{
+		// Scene ubo and material buffer only, the textures live in the bindless table's own pool
+		globalPool = DescriptorPool::Builder(device)
+			.SetMaxSets(2)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1)
+			.Build();
+
+		VkDescriptorSetLayoutBinding matrices{};
+		matrices.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		matrices.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		matrices.binding = 0;
+		matrices.descriptorCount = 1;
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+		descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutCI.pBindings = &matrices;
+		descriptorSetLayoutCI.bindingCount = 1;
+		descriptorSetLayouts.matrices = device.LayoutCache().CreateLayout(descriptorSetLayoutCI);
+
+		// Dynamic, so one set covers the region of every frame in flight
+		VkDescriptorSetLayoutBinding materials{};
+		materials.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		materials.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		materials.binding = 0;
+		materials.descriptorCount = 1;
+
+		descriptorSetLayoutCI.pBindings = &materials;
+		descriptorSetLayouts.materials = device.LayoutCache().CreateLayout(descriptorSetLayoutCI);
+
+		// set 0 = matrices, set 1 = every texture, set 2 = materials
+		std::array<VkDescriptorSetLayout, 3> setLayouts =
+		{
+			descriptorSetLayouts.matrices,
+			bindlessTable->GetLayout(),
+			descriptorSetLayouts.materials
+		};
+
+		// The fragment shader reads the material index from the same block
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(GLTF::BindlessPushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutCI.pSetLayouts = setLayouts.data();
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		vkCreatePipelineLayout(device.Device(), &pipelineLayoutCI, nullptr, &pipelineLayout);
+
+		gpuMaterials.resize(std::max<size_t>(glTFScene.materials.size(), 1));
+		VkDeviceSize tableSize = sizeof(GLTF::GPUMaterial) * gpuMaterials.size();
+
+		materialBuffer = std::make_unique<Buffer>(
+			device,
+			tableSize,
+			SwapChain::MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			device.properties.limits.minStorageBufferOffsetAlignment);
+		materialBuffer->Map();
+
+		globalPool->AllocateDescriptor(descriptorSetLayouts.matrices, descriptorSet);
+		globalPool->AllocateDescriptor(descriptorSetLayouts.materials, materialSet);
+
+		auto bufInfo = shaderData.buffer->DescriptorInfo();
+		auto materialInfo = materialBuffer->DescriptorInfo(tableSize, 0);
+
+		VkWriteDescriptorSet sceneWrite{};
+		sceneWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		sceneWrite.dstSet = descriptorSet;
+		sceneWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		sceneWrite.dstBinding = 0;
+		sceneWrite.pBufferInfo = &bufInfo;
+		sceneWrite.descriptorCount = 1;
+
+		VkWriteDescriptorSet materialWrite{};
+		materialWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		materialWrite.dstSet = materialSet;
+		materialWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		materialWrite.dstBinding = 0;
+		materialWrite.pBufferInfo = &materialInfo;
+		materialWrite.descriptorCount = 1;
+
+		std::array<VkWriteDescriptorSet, 2> writes = { sceneWrite, materialWrite };
+		vkUpdateDescriptorSets(device.Device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+		// One slot per image; materials refer to them through the material buffer
+		for (size_t i = 0; i < glTFScene.images.size(); ++i)
+		{
+			GLTF::Image& image = glTFScene.images[i];
+			image.slot = bindlessTable->Add(glTFScene.GetTextureDescriptor(i));
+			image.version = glTFScene.streamer.Version(image.texture);
+		}
+
+		for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; ++i)
+		{
+			UploadMaterials(i);
 		}
 	}
 
+	void GLTFScene::WriteMaterialSet(GLTF::Material& material, VkDescriptorSet set)
+	{
+		VkDescriptorImageInfo colorMap = glTFScene.GetTextureDescriptor(material.baseColorTextureIndex);
+		VkDescriptorImageInfo normalMap = glTFScene.GetTextureDescriptor(material.normalTextureIndex);
+
+		VkWriteDescriptorSet colorSet{};
+		colorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		colorSet.dstSet = set;
+		colorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		colorSet.dstBinding = 0;
+		colorSet.pImageInfo = &colorMap;
+		colorSet.descriptorCount = 1;
+
+		VkWriteDescriptorSet normalSet{};
+		normalSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		normalSet.dstSet = set;
+		normalSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		normalSet.dstBinding = 1;
+		normalSet.pImageInfo = &normalMap;
+		normalSet.descriptorCount = 1;
+
+		std::vector<VkWriteDescriptorSet> writeDescriptorSets = 
+		{
+			colorSet,
+			normalSet
+		};
+		vkUpdateDescriptorSets(device.Device(), static_cast<uint32_t>(writeDescriptorSets.size()), 
+			writeDescriptorSets.data(), 0, nullptr);
+	}
+
 	void GLTFScene::PreparePipelines()
 	{
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCI{};
@@ -767,11 +1344,11 @@ namespace Tendou
 
 		const std::vector<VkVertexInputAttributeDescription> vertexInputAttributes = 
 		{
-			VkVertexInputAttributeDescription{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GLTF::Vertex, pos) },
-			VkVertexInputAttributeDescription{ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GLTF::Vertex, normal) },
-			VkVertexInputAttributeDescription{ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GLTF::Vertex, uv) },
-			VkVertexInputAttributeDescription{ 3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GLTF::Vertex, color) },
-			VkVertexInputAttributeDescription{ 4, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(GLTF::Vertex, tangent) }
+			// Quantized attributes are expanded by the input assembler, see GLTF::Vertex
+			VkVertexInputAttributeDescription{ 0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(GLTF::Vertex, pos) },
+			VkVertexInputAttributeDescription{ 1, 0, VK_FORMAT_R8G8B8A8_SNORM, offsetof(GLTF::Vertex, normal) },
+			VkVertexInputAttributeDescription{ 2, 0, VK_FORMAT_R16G16_UNORM, offsetof(GLTF::Vertex, uv) },
+			VkVertexInputAttributeDescription{ 4, 0, VK_FORMAT_R8G8B8A8_SNORM, offsetof(GLTF::Vertex, tangent) }
 			//vks::initializers::vertexInputAttributeDescription(0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFScene::Vertex, pos)),
 			//vks::initializers::vertexInputAttributeDescription(0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFScene::Vertex, normal)),
 			//vks::initializers::vertexInputAttributeDescription(0, 2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFScene::Vertex, uv)),
@@ -806,6 +1383,12 @@ namespace Tendou
 		pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
 		pipelineCI.pStages = shaderStages.data();
 
+		if (bindless)
+		{
+			PrepareBindlessPipelines(pipelineCI, rasterizationStateCI);
+			return;
+		}
+
 		VkPipelineShaderStageCreateInfo vertShader = {};
 		vertShader.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		vertShader.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -887,6 +1470,67 @@ namespace Tendou
 		//vkDestroyPipelineCache(device.Device(), pipelineCache, nullptr);
 	}
 
+	void GLTFScene::PrepareBindlessPipelines(VkGraphicsPipelineCreateInfo& pipelineCI,
+		VkPipelineRasterizationStateCreateInfo& rasterizationStateCI)
+	{
+		auto createModule = [&](const std::string& path)
+		{
+			auto code = Pipeline::ReadFile(path);
+
+			VkShaderModuleCreateInfo moduleCreateInfo{};
+			moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleCreateInfo.codeSize = code.size();
+			moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+			VkShaderModule module;
+			if (vkCreateShaderModule(device.Device(), &moduleCreateInfo, nullptr, &module) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create shader module!");
+			}
+			return module;
+		};
+
+		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
+		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = createModule("Materials/Shaders/GLTFBindless.vert.spv");
+		shaderStages[0].pName = "main";
+		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[1].module = createModule("Materials/Shaders/GLTFBindless.frag.spv");
+		shaderStages[1].pName = "main";
+
+		pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineCI.pStages = shaderStages.data();
+
+		// Cutoffs are read from the material buffer; only whether to discard at all stays
+		// a constant, so opaque materials keep early depth testing
+		VkSpecializationMapEntry alphaMaskEntry{ 0, 0, sizeof(VkBool32) };
+
+		for (uint32_t variant = 0; variant < glTFScene.bindlessPipelines.size(); ++variant)
+		{
+			VkBool32 alphaMask = (variant & 1) ? VK_TRUE : VK_FALSE;
+
+			VkSpecializationInfo specializationInfo{};
+			specializationInfo.mapEntryCount = 1;
+			specializationInfo.pMapEntries = &alphaMaskEntry;
+			specializationInfo.dataSize = sizeof(alphaMask);
+			specializationInfo.pData = &alphaMask;
+			shaderStages[1].pSpecializationInfo = &specializationInfo;
+
+			rasterizationStateCI.cullMode = (variant & 2) ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+
+			if (vkCreateGraphicsPipelines(device.Device(), VK_NULL_HANDLE, 1, &pipelineCI, nullptr,
+				&glTFScene.bindlessPipelines[variant]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create bindless pipeline!");
+			}
+		}
+
+		vkDestroyShaderModule(device.Device(), shaderStages[0].module, nullptr);
+		vkDestroyShaderModule(device.Device(), shaderStages[1].module, nullptr);
+	}
+
 	void GLTFScene::PrepareUniformBuffers()
 	{
 		shaderData.buffer = std::make_unique<Buffer>(
@@ -901,11 +1545,17 @@ namespace Tendou
 		UpdateUniformBuffers();
 	}
 
+	void GLTFScene::LateLatch(const Camera& camera)
+	{
+		renderCamera = camera;
+		UpdateUniformBuffers();
+	}
+
 	void GLTFScene::UpdateUniformBuffers()
 	{
-		shaderData.values.projection = c.perspective();
-		shaderData.values.view = c.view();
-		shaderData.values.viewPos = glm::vec4(c.cameraPos, 1.0f);
+		shaderData.values.projection = renderCamera.perspective();
+		shaderData.values.view = renderCamera.view();
+		shaderData.values.viewPos = glm::vec4(renderCamera.cameraPos, 1.0f);
 		memcpy(shaderData.buffer->GetMappedMemory(), &shaderData.values, sizeof(shaderData.values));
 	}
 }
\ No newline at end of file
@@ -10,16 +10,20 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <tiny_gltf.h>
-
+#include "../../Rendering/GLTFAsset.h"
 #include "../../Rendering/Texture.h"
+#include "../../Rendering/TextureCache.h"
+#include "../../Rendering/TextureStreamer.h"
 #include "../../Rendering/UniformBuffer.hpp"
+#include "../../Vulkan/BindlessTable.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
+#include <array>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -33,13 +37,15 @@ namespace Tendou
 	public:
 		TendouDevice& device_;
 
+		// 20 bytes instead of 60. Positions are snorm16 inside the mesh's bounding
+		// cube, which Mesh::dequantize maps back, and uvs unorm16 over the primitive's
+		// UV range, undone by Primitive::uvTransform. Normals and tangents are snorm8.
 		struct Vertex
 		{
-			glm::vec3 pos;
-			glm::vec3 normal;
-			glm::vec2 uv;
-			glm::vec3 color;
-			glm::vec4 tangent;
+			int16_t pos[4];
+			int8_t normal[4];
+			uint16_t uv[2];
+			int8_t tangent[4];
 		};
 
 		// Single vertex buffer for all primitives
@@ -65,12 +71,22 @@ namespace Tendou
 			uint32_t firstIndex;
 			uint32_t indexCount;
 			int32_t materialIndex;
+
+			// Model space bounding sphere, drives texture streaming requests
+			glm::vec3 center = glm::vec3(0.0f);
+			float radius = 0.0f;
+
+			// uv = quantized * xy + zw, the material's texture transform included
+			glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
 		};
 
 		// Contains the node's (optional) geometry and can be made up of an arbitrary number of primitives
 		struct Mesh 
 		{
 			std::vector<Primitive> primitives;
+
+			// Quantized positions to model space. A uniform scale, so normals keep their direction.
+			glm::mat4 dequantize = glm::mat4(1.0f);
 		};
 
 
@@ -93,7 +109,38 @@ namespace Tendou
 			float alphaCutOff;
 			bool doubleSided = false;
 			VkDescriptorSet descriptorSet;
-			VkPipeline pipeline;
+			VkPipeline pipeline = VK_NULL_HANDLE;
+
+			// Streamer versions the descriptor set was written with
+			uint32_t colorVersion = 0;
+			uint32_t normalVersion = 0;
+
+			// Index into the bindless pipelines: bit 0 alpha mask, bit 1 double sided
+			__inline uint32_t PipelineVariant() const { return (alphaMode == "MASK" ? 1u : 0u) | (doubleSided ? 2u : 0u); }
+		};
+
+		// Bindless counterpart of a material, one std430 element of the material buffer
+		struct GPUMaterial
+		{
+			uint32_t colorTexture;
+			uint32_t normalTexture;
+			float alphaCutOff;
+			uint32_t pad;
+		};
+
+		// Push constants of the per-material pipelines
+		struct PushConstants
+		{
+			glm::mat4 model;
+			glm::vec4 uvTransform;
+		};
+
+		// Push constants of the bindless pipelines, visible to both stages
+		struct BindlessPushConstants
+		{
+			glm::mat4 model;
+			glm::vec4 uvTransform;
+			uint32_t materialIndex;
 		};
 
 		// Contains the texture for a single glTF image
@@ -101,7 +148,11 @@ namespace Tendou
 		struct Image 
 		{
 			std::string path;
-			std::unique_ptr<Texture> texture;
+			TextureStreamer::Handle texture;
+
+			// Bindless table slot and the streamer version it was written with
+			uint32_t slot = BindlessTable::INVALID_SLOT;
+			uint32_t version = 0;
 		};
 
 		// A glTF texture stores a reference to the image and a sampler
@@ -121,17 +172,56 @@ namespace Tendou
 
 		std::string path;
 
+		// Owns every image's texture; only the mips that are actually seen stay resident
+		TextureStreamer streamer;
+
+		// Pipelines of the bindless path, one per Material::PipelineVariant
+		std::array<VkPipeline, 4> bindlessPipelines = {};
+
 		GLTF(TendouDevice& d);
 
 		~GLTF();
 		VkDescriptorImageInfo GetTextureDescriptor(const size_t index);
-		void LoadImages(tinygltf::Model& input);
-		void LoadTextures(tinygltf::Model& input);
-		void LoadMaterials(tinygltf::Model& input);
-		void LoadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, 
-			GLTF::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<GLTF::Vertex>& vertexBuffer);
+		void LoadImages(const GLTFAsset& input);
+		void LoadTextures(const GLTFAsset& input);
+		void LoadMaterials(const GLTFAsset& input);
+
+		// Quantizes every mesh the scene uses into the vertex and index buffers, one
+		// job per primitive, and returns them by glTF mesh index for LoadNode
+		std::vector<Mesh> LoadMeshes(const GLTFAsset& input);
+		void LoadNode(const GLTFAsset& input, int32_t nodeIndex, GLTF::Node* parent, const std::vector<Mesh>& meshes);
 		void DrawNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, GLTF::Node node);
 		void Draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+
+		// Reports how large each visible primitive's textures appear on screen.
+		// focalPixels is the screen height over 2 * tan(fovY / 2).
+		void RequestTextures(const glm::vec3& eye, float focalPixels);
+
+		// Same as Draw, but split across the job system into secondaries.
+		// sceneSet is bound at set 0 in every secondary.
+		void DrawParallel(const SecondaryContext& ctx, VkCommandBuffer primary,
+			VkPipelineLayout pipelineLayout, VkDescriptorSet sceneSet);
+
+		// Bindless DrawParallel: sets 0-2 are bound once per secondary, primitives
+		// are sorted by pipeline variant and each draw only pushes its material index
+		void DrawParallelBindless(const SecondaryContext& ctx, VkCommandBuffer primary,
+			VkPipelineLayout pipelineLayout, const std::array<VkDescriptorSet, 3>& sets, uint32_t materialOffset);
+
+	private:
+		// Flattened list of visible primitives, rebuilt every DrawParallel
+		struct DrawItem
+		{
+			// Node matrix times the mesh's dequantization
+			glm::mat4 matrix;
+			const Primitive* primitive;
+			uint32_t sortKey;
+		};
+
+		void GatherNode(const GLTF::Node& node);
+		void RequestNode(const GLTF::Node& node, const glm::mat4& parentMatrix,
+			const glm::vec3& eye, float focalPixels);
+
+		std::vector<DrawItem> drawList;
 	};
 
 	class GLTFScene : public Scene
@@ -158,6 +248,7 @@ namespace Tendou
 		{
 			VkDescriptorSetLayout matrices;
 			VkDescriptorSetLayout textures;
+			VkDescriptorSetLayout materials;
 		} descriptorSetLayouts;
 
 
@@ -171,6 +262,9 @@ namespace Tendou
 
 		int Render(VkCommandBuffer buf, FrameInfo& f) override;
 
+		void LateLatch(const Camera& camera) override;
+		void ReadFramePacket(const FramePacket& packet) override;
+
 	private:
 		void LoadGLTFFile(std::string path);
 		void SetupDescriptors();
@@ -179,6 +273,35 @@ namespace Tendou
 		void UpdateUniformBuffers();
 
 		void ShowCheckbox(Tendou::GLTF::Node& node);
+
+		// Streams textures for the current view and rebinds materials whose textures changed
+		void UpdateTextureStreaming();
+		void WriteMaterialSet(GLTF::Material& material, VkDescriptorSet set);
+
+		// Bindless path: every texture lives in one table and materials in a storage
+		// buffer, so streaming only rewrites table slots. Used when the device supports
+		// descriptor indexing and the bindless shaders are built; the per-material
+		// sets above remain the fallback.
+		void SetupBindlessDescriptors();
+		void PrepareBindlessPipelines(VkGraphicsPipelineCreateInfo& pipelineCI,
+			VkPipelineRasterizationStateCreateInfo& rasterizationStateCI);
+		void UpdateBindlessTextures();
+		void UploadMaterials(uint32_t frameIdx);
+
+		bool bindless = false;
+		std::unique_ptr<BindlessTable> bindlessTable;
+		std::unique_ptr<Buffer> materialBuffer;
+		VkDescriptorSet materialSet = VK_NULL_HANDLE;
+		std::vector<GLTF::GPUMaterial> gpuMaterials;
+
+		// Material sets replaced by streaming, freed once no frame in flight uses them
+		struct RetiredSet
+		{
+			VkDescriptorSet set;
+			uint64_t frame;
+		};
+		std::deque<RetiredSet> retiredSets;
+		uint64_t frameCount = 0;
 	};
 }
 
@@ -1,48 +1,58 @@
 #include "LightingScene.h"
 
+#include <algorithm>
+
 namespace Tendou
 {
+	namespace
+	{
+		const uint32_t ALL_FACES = 0x3F;
+
+		// Faces are rendered at the cubemap's size with a square projection,
+		// so the capture doesn't depend on the window at all
+		const uint32_t CAPTURE_SIZE = 1024;
+
+		const glm::vec3 directionLookup[] =
+		{
+				{1.f, 0.f, 0.f},  // +x
+				{-1.f, 0.f, 0.f}, // -x
+				{0.f, 1.0f, 0.f}, // +y
+				{0.f, -1.0f, 0.f},// -y
+				{0.f, 0.f, 1.0f}, // +z
+				{0.f, 0.f, -1.0f} // -z
+		};
+		const glm::vec3 upLookup[] =
+		{
+				{0.f, -1.0f, 0.f},   // +x
+				{0.f, -1.0f, 0.f},   // -x
+				{0.f, 0.0f, 1.f},	// +y
+				{0.f, 0.0f, -1.f},   // -y
+				{0.f, -1.0f, 0.f},   // +z
+				{0.f, -1.0f, 0.f}    // -z
+		};
+	}
+
 	LightingScene::LightingScene(Window& window, TendouDevice& device)
 		: Scene(window, device)
 	{
 		globalPool = DescriptorPool::Builder(device)
 			.SetMaxSets(20)
 			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 20)
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 20)
 			.AddPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 20)
 			.Build();
 
 		LoadGameObjects();
-		CreateRenderPasses();
 	}
 
-	// TODO: More abstraction
 	LightingScene::~LightingScene()
 	{
-		// Frame buffer
-		for (int i = 0; i < 6; ++i)
-		{
-			std::string key = std::string("Offscreen") + std::to_string(i + 1);
-			// Color attachment
-			vkDestroyImageView(device.Device(), renderPasses[key].color.view, nullptr);
-			vkDestroyImage(device.Device(), renderPasses[key].color.image, nullptr);
-			vkFreeMemory(device.Device(), renderPasses[key].color.memory, nullptr);
-
-			// Depth attachment
-			vkDestroyImageView(device.Device(), renderPasses[key].depth.view, nullptr);
-			vkDestroyImage(device.Device(), renderPasses[key].depth.image, nullptr);
-			vkFreeMemory(device.Device(), renderPasses[key].depth.memory, nullptr);
-
-			vkDestroyRenderPass(device.Device(), renderPasses[key].renderPass, nullptr);
-			vkDestroySampler(device.Device(), renderPasses[key].sampler, nullptr);
-			vkDestroyFramebuffer(device.Device(), renderPasses[key].frameBuffer, nullptr);
-		}
 	}
 
 	int LightingScene::Init()
 	{
 		CreateUBOs();
 		CreateSetLayouts();
+		CreateRenderPasses();
 		CreateRenderSystems();
 
 		for (unsigned i = 0; i < 16; ++i)
@@ -66,6 +76,15 @@ namespace Tendou
 			ImGui::EndMenu();
 		}
 
+		if (ImGui::BeginMenu("Reflections"))
+		{
+			ImGui::SliderInt("Faces per Frame", &editorVars.captureFacesPerFrame, 1, 6);
+			ImGui::SliderInt("Frames Between Updates", &editorVars.captureInterval, 0, 120);
+			ImGui::Checkbox("Pause Capture", &editorVars.pauseCapture);
+
+			ImGui::EndMenu();
+		}
+
 		if (ImGui::BeginMenu("Global Values"))
 		{
 			ImGui::SliderFloat("Camera Near", &editorVars.nearFar.x, 0.1f, 100.0f);
@@ -109,34 +128,6 @@ namespace Tendou
 		static float angle = 0.0f;
 		int idx = 0;
 
-		LightsUBO lightUbo{};
-		lightUbo.eyePos = glm::vec4(c.cameraPos, 1.0f);
-
-		for (unsigned i = 0; i < editorVars.currLights; ++i)
-		{
-			lightUbo.lightColor[i] = glm::vec4(1.0f);
-
-			lightUbo.ambient[i] = glm::vec4(editorVars.ambient[i], 1.0f);
-			lightUbo.diffuse[i] = glm::vec4(editorVars.diffuse[i], 1.0f);
-			lightUbo.specular[i] = glm::vec4(editorVars.specular[i], 1.0f);
-
-			// x = outer, y = inner, z = falloff, w = type
-			lightUbo.lightInfo[i] = glm::vec4(80.0f, 45.0f, 10.0f, 0.0f);
-		}
-
-		lightUbo.emissive = glm::vec4(editorVars.emissive, 1.0f);
-		lightUbo.attenuation = editorVars.attenuation;
-
-		lightUbo.coefficients = glm::vec4(editorVars.lightCoeffs, 1.0f);
-		lightUbo.fogColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		lightUbo.numLights = editorVars.currLights;
-
-		// x = use gpu, y = use normals, z = uv type
-		lightUbo.modes = glm::ivec4(0, 0, 0, 0);
-
-		// TODO: IDs to string tags?
-		GameObject& mainObj = gameObjects.find(0)->second;
-
 		for (auto& a : gameObjects)
 		{
 			auto& obj = a.second;
@@ -155,8 +146,6 @@ namespace Tendou
 				obj.GetTransform().SetTranslation(glm::vec3(0.0f, 0.0f, editorVars.sphereLineRad));
 				obj.GetTransform().SetRotationAngle(res);
 				obj.GetTransform().Update(true);
-				lightUbo.lightPos[idx] = obj.GetTransform().PositionVec4();
-				lightUbo.lightDir[idx] = mainObj.GetTransform().PositionVec4() - lightUbo.lightPos[idx];
 				++idx;
 			}
 			else
@@ -165,29 +154,96 @@ namespace Tendou
 			}
 		}
 
+		if (editorVars.rotateSpheres)
+		{
+			angle += 0.01f;
+		}
+
+		if (angle > glm::pi<float>())
+		{
+			angle = 0.0f;
+		}
+
+		return 0;
+	}
+
+	void LightingScene::LateLatch(const Camera& camera)
+	{
+		renderCamera = camera;
+		WriteWorldUBO();
+	}
+
+	void LightingScene::ReadFramePacket(const FramePacket& packet)
+	{
+		Scene::ReadFramePacket(packet);
+
+		// Once per rendered frame, however many fixed steps Update ran
+		WriteWorldUBO();
+		WriteLightUBO(packet);
+		ScheduleCapture();
+	}
+
+	void LightingScene::WriteWorldUBO()
+	{
 		WorldUBO localUBO{};
-		localUBO.proj = c.perspective();
-		localUBO.view = c.view();
+		localUBO.proj = renderCamera.perspective();
+		localUBO.view = renderCamera.view();
 		localUBO.nearFar = glm::vec2(editorVars.nearFar.x, editorVars.nearFar.y);
 		worldUBO->WriteToBuffer(&localUBO);
 		worldUBO->Flush();
+	}
 
-		//lightUbo.lightColor[0] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		//lightUbo.lightPos[0] = glm::vec4(-2.0f, -1.0f, 1.0f, 1.0f);
-		lightUBO->WriteToBuffer(&lightUbo);
-		lightUBO->Flush();
+	void LightingScene::WriteLightUBO(const FramePacket& packet)
+	{
+		LightsUBO lightUbo{};
+		lightUbo.eyePos = glm::vec4(renderCamera.cameraPos, 1.0f);
 
-		if (editorVars.rotateSpheres)
+		for (unsigned i = 0; i < editorVars.currLights; ++i)
 		{
-			angle += 0.01f;
+			lightUbo.lightColor[i] = glm::vec4(1.0f);
+
+			lightUbo.ambient[i] = glm::vec4(editorVars.ambient[i], 1.0f);
+			lightUbo.diffuse[i] = glm::vec4(editorVars.diffuse[i], 1.0f);
+			lightUbo.specular[i] = glm::vec4(editorVars.specular[i], 1.0f);
+
+			// x = outer, y = inner, z = falloff, w = type
+			lightUbo.lightInfo[i] = glm::vec4(80.0f, 45.0f, 10.0f, 0.0f);
 		}
 
-		if (angle > glm::pi<float>())
+		lightUbo.emissive = glm::vec4(editorVars.emissive, 1.0f);
+		lightUbo.attenuation = editorVars.attenuation;
+
+		lightUbo.coefficients = glm::vec4(editorVars.lightCoeffs, 1.0f);
+		lightUbo.fogColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		lightUbo.numLights = editorVars.currLights;
+
+		// x = use gpu, y = use normals, z = uv type
+		lightUbo.modes = glm::ivec4(0, 0, 0, 0);
+
+		// Lights sit where their spheres are drawn, between the last two steps
+		const GameObject* mainObj = &gameObjects.find(0)->second;
+		glm::vec4 mainPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		for (const FramePacket::Object& o : packet.objects)
 		{
-			angle = 0.0f;
+			if (o.object == mainObj)
+			{
+				mainPos = o.state.modelMatrix[3];
+			}
 		}
 
-		return 0;
+		int idx = 0;
+		for (const FramePacket::Object& o : packet.objects)
+		{
+			if (idx < editorVars.currLights && o.object->GetTag() == "Light")
+			{
+				lightUbo.lightPos[idx] = o.state.modelMatrix[3];
+				lightUbo.lightDir[idx] = mainPos - lightUbo.lightPos[idx];
+				++idx;
+			}
+		}
+
+		lightUBO->WriteToBuffer(&lightUbo);
+		lightUBO->Flush();
 	}
 
 	int LightingScene::PostUpdate()
@@ -197,100 +253,11 @@ namespace Tendou
 
 	int LightingScene::Render(VkCommandBuffer buf, FrameInfo& f)
 	{
-		static glm::vec3 directionLookup[] =
-		{
-				{1.f, 0.f, 0.f},  // +x
-				{-1.f, 0.f, 0.f}, // -x
-				{0.f, 1.0f, 0.f}, // +y
-				{0.f, -1.0f, 0.f},// -y
-				{0.f, 0.f, 1.0f}, // +z
-				{0.f, 0.f, -1.0f} // -z
-		};
-		static glm::vec3 upLookup[] =
-		{
-				{0.f, -1.0f, 0.f},   // +x
-				{0.f, -1.0f, 0.f},   // -x
-				{0.f, 0.0f, 1.f},	// +y
-				{0.f, 0.0f, -1.f},   // -y
-				{0.f, -1.0f, 0.f},   // +z
-				{0.f, -1.0f, 0.f}    // -z
-		};
-
-		SceneInfo offscreen(GetDescriptorSet("Offscreen"), GetGameObjects());
 		SceneInfo global(GetDescriptorSet("Global"), GetGameObjects());
+		global.camera = &renderCamera;
 
-		// Offscreen render test
-		for (int i = 0; i < 6; ++i)
-		{
-			std::string name = std::string("Offscreen") + std::to_string(i + 1);
-			BeginRenderPass(buf, name);
-			glm::vec3 objPos = gameObjects.find(0)->second.GetTransform().PositionVec3();
-			WriteToCaptureUBO(glm::lookAt(objPos, directionLookup[i], -upLookup[i]), i);
-			f.dynamicOffset = testOffset * i;
-
-			renderSystems["Offscreen"][i].get()->Render(f, offscreen);
-			EndRenderPass(buf);
-
-			// BEGIN COPYING OF RENDER TEXTURE IMAGES TO SPECIFIC
-			// FACES OF THE EMPTY CUBEMAP
-
-			// Make sure color writes to the framebuffer are finished before using it as transfer source
-			device.TransitionImageLayout(renderPasses[name].color.image, VK_FORMAT_R8G8B8A8_SRGB,
-				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 1, buf);
-			
-			VkImageSubresourceRange cubeFaceSubresourceRange = {};
-			cubeFaceSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			cubeFaceSubresourceRange.baseMipLevel = 0;
-			cubeFaceSubresourceRange.levelCount = 1;
-			cubeFaceSubresourceRange.baseArrayLayer = i;
-			cubeFaceSubresourceRange.layerCount = 1;
-			
-			// Change image layout of one cubemap face to transfer destination
-			device.TransitionImageLayout(textures[3].get()->TextureImage(), VK_FORMAT_R8G8B8A8_SRGB,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, buf,
-				cubeFaceSubresourceRange);
-			
-			// Copy region for transfer from framebuffer to cube face
-			VkImageCopy copyRegion = {};
-			
-			copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.srcSubresource.baseArrayLayer = 0;
-			copyRegion.srcSubresource.mipLevel = 0;
-			copyRegion.srcSubresource.layerCount = 1;
-			copyRegion.srcOffset = { 0, 0, 0 };
-			
-			copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			copyRegion.dstSubresource.baseArrayLayer = i;
-			copyRegion.dstSubresource.mipLevel = 0;
-			copyRegion.dstSubresource.layerCount = 1;
-			copyRegion.dstOffset = { 0, 0, 0 };
-			
-			// temporary
-			copyRegion.extent.width = 1024;
-			copyRegion.extent.height = 720;
-			copyRegion.extent.depth = 1;
-			
-			// Put image copy into command buffer
-			vkCmdCopyImage(
-				buf,
-				renderPasses[name].color.image,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				textures[3].get()->TextureImage(),
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1,
-				&copyRegion);
-			
-			// Transform framebuffer color attachment back
-			device.TransitionImageLayout(renderPasses[name].color.image, VK_FORMAT_R8G8B8A8_SRGB,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 1, buf);
-			
-			// Change image layout of copied face to shader read
-			device.TransitionImageLayout(textures[3].get()->TextureImage(), VK_FORMAT_R8G8B8A8_SRGB,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, buf,
-				cubeFaceSubresourceRange);
-
-			// END COPYING
-		}
+		// Cubemap capture
+		graph->Execute(f);
 
 		// Render the actual scene (swapchain)
 		BeginSwapChainRenderPass(buf);
@@ -300,14 +267,45 @@ namespace Tendou
 		return 0;
 	}
 
-	void LightingScene::WriteToCaptureUBO(glm::mat4 view, int i)
+	void LightingScene::ScheduleCapture()
 	{
-		RenderUBO localUBO;
+		captureMask = 0;
+		if (editorVars.pauseCapture)
+		{
+			return;
+		}
+
+		if (idleFrames > 0)
+		{
+			--idleFrames;
+			return;
+		}
+
+		// A slice never wraps past the last face, so a finished cube always starts the wait
+		uint32_t faces = static_cast<uint32_t>(std::clamp(editorVars.captureFacesPerFrame, 1, 6));
+		for (uint32_t i = 0; i < faces; ++i)
+		{
+			captureMask |= 1u << nextFace;
+			nextFace = (nextFace + 1) % 6;
+
+			if (nextFace == 0)
+			{
+				idleFrames = std::max(editorVars.captureInterval, 0);
+				break;
+			}
+		}
+
+		// Every face's view is written, multiview and single face passes index the same array
+		CaptureUBO localUBO{};
 		localUBO.proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f);
-		localUBO.view = dynamic_cast<UniformBuffer<RenderUBO>*>(captureUBO.get())->GetData().view;
-		*localUBO.view = view;
-		captureUBO->WriteToBuffer(&localUBO.proj, sizeof(glm::mat4), (captureUBO->GetAlignmentSize() * i));
-		captureUBO->WriteToBuffer(localUBO.view, sizeof(glm::mat4), (captureUBO->GetAlignmentSize() * i) + sizeof(glm::mat4));
+
+		glm::vec3 objPos = gameObjects.find(0)->second.GetTransform().PositionVec3();
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			localUBO.views[i] = glm::lookAt(objPos, objPos + directionLookup[i], -upLookup[i]);
+		}
+
+		captureUBO->WriteToBuffer(&localUBO);
 		captureUBO->Flush();
 	}
 
@@ -371,21 +369,14 @@ namespace Tendou
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 		lightUBO->Map();
 
-		captureUBO = std::make_unique<UniformBuffer<RenderUBO>>(
+		captureUBO = std::make_unique<UniformBuffer<CaptureUBO>>(
 			UBO::Type::CAPTURE,
 			device,
 			UBO::SizeofUBO(UBO::Type::CAPTURE),
-			6,
+			1,
 			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			device.properties.limits.minUniformBufferOffsetAlignment
-			);
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 		captureUBO->Map();
-		captureUBO->GetData().view = (glm::mat4*)captureUBO->AlignedAlloc(captureUBO->GetBufferSize(), captureUBO->GetAlignmentSize());
-		assert(captureUBO->GetData().view && "Failed to allocate capture UBO view!");
-
-		testOffset = captureUBO->GetAlignmentSize();
-
 	}
 
 	void LightingScene::CreateSetLayouts()
@@ -401,10 +392,10 @@ namespace Tendou
 			path + std::string("back.png"),
 		};
 
-		textures.push_back(std::make_unique<Texture>(device, "Materials/Models/Shiroko/Texture2D/Shiroko_Original_Weapon.png"));
-		textures.push_back(std::make_unique<Texture>(device, "Materials/Textures/hoshino.png"));
+		textures.push_back(TextureCache::Load(device, "Materials/Models/Shiroko/Texture2D/Shiroko_Original_Weapon.png"));
+		textures.push_back(TextureCache::Load(device, "Materials/Textures/hoshino.png"));
 		textures.push_back(std::make_unique<Texture>(device, faces));
-		textures.push_back(std::make_unique<Texture>(device, 1024, 1024, true));
+		textures.push_back(std::make_unique<Texture>(device, CAPTURE_SIZE, CAPTURE_SIZE, true));
 
 		setLayouts["Global"] = DescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
@@ -416,14 +407,13 @@ namespace Tendou
 
 		setLayouts["Offscreen"] = DescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			.AddBinding(5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
+			.AddBinding(5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
 			.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
 			.Build();
 
 		auto worldBuf = worldUBO->DescriptorInfo();
 		auto lightBuf = lightUBO->DescriptorInfo();
 		auto captureBuf = captureUBO->DescriptorInfo();
-		captureBuf.range = captureUBO->GetAlignmentSize();
 
 		auto whiteFangTex = textures[0]->DescriptorInfo();
 		auto hoshino = textures[1]->DescriptorInfo();
@@ -464,35 +454,61 @@ namespace Tendou
 
 	void LightingScene::CreateRenderPasses()
 	{
-		renderPasses["Offscreen1"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
-
-		renderPasses["Offscreen2"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		// The capture shaders pick their face with gl_ViewIndex, which needs multiview even for single faces
+		if (!device.SupportsMultiview())
+		{
+			throw std::runtime_error("Failed to create cubemap capture, multiview isn't supported!");
+		}
 
-		renderPasses["Offscreen3"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		// Faces are rendered straight into the cubemap's layers, which the object
+		// set samples, so it starts and ends in shader read
+		RenderGraph::Handle cube = graph->ImportImage("Cubemap",
+			textures[3].get()->TextureImage(), textures[3].get()->TextureImageView(),
+			{ CAPTURE_SIZE, CAPTURE_SIZE, VK_FORMAT_R8G8B8A8_SRGB, 6 },
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		RenderGraph::Handle depth = graph->CreateImage("CubemapDepth", { CAPTURE_SIZE, CAPTURE_SIZE, graph->DepthFormat(), 6 });
+
+		// Whole cube: one pass, every draw broadcast to all six layers
+		graph->AddPass("CubeCapture")
+			.WriteColor(cube, { { 0.0f, 0.0f, 0.0f, 0.0f } }, RenderGraph::Load::Clear, 0, 6)
+			.WriteDepth(depth, 1.0f, RenderGraph::Load::Clear, 0, 6)
+			.Multiview()
+			.Condition([this]() { return captureMask == ALL_FACES; })
+			.Execute([this](FrameInfo& f)
+				{
+					SceneInfo offscreen(GetDescriptorSet("Offscreen"), GetGameObjects());
 
-		renderPasses["Offscreen4"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+					OffscreenSystem* system = static_cast<OffscreenSystem*>(renderSystems["Offscreen"][0].get());
+					system->faceBase = 0;
+					system->Render(f, offscreen);
+				});
 
-		renderPasses["Offscreen5"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		// Time sliced updates render the faces due this frame one at a time
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			graph->AddPass(std::string("CubeFace") + std::to_string(i))
+				.WriteColor(cube, { { 0.0f, 0.0f, 0.0f, 0.0f } }, RenderGraph::Load::Clear, i, 1)
+				.WriteDepth(depth, 1.0f, RenderGraph::Load::Clear, i, 1)
+				.Condition([this, i]() { return captureMask != ALL_FACES && (captureMask & (1u << i)); })
+				.Execute([this, i](FrameInfo& f)
+					{
+						SceneInfo offscreen(GetDescriptorSet("Offscreen"), GetGameObjects());
+
+						OffscreenSystem* system = static_cast<OffscreenSystem*>(renderSystems["Offscreen"][1].get());
+						system->faceBase = i;
+						system->Render(f, offscreen);
+					});
+		}
 
-		renderPasses["Offscreen6"] = device.CreateRenderPass(
-			swapChain.get()->GetSwapChainExtent().width,
-			swapChain.get()->GetSwapChainExtent().height);
+		graph->Compile();
+		graph->ExportRenderPasses(renderPasses);
 	}
 
 	void LightingScene::CreateRenderSystems()
 	{
 		renderSystems["Global"].reserve(1);
-		renderSystems["Offscreen"].reserve(6);
+		renderSystems["Offscreen"].reserve(2);
 
 		renderSystems["Global"].emplace_back(std::make_unique<DefaultSystem>(
 			device,
@@ -500,15 +516,20 @@ namespace Tendou
 			GetSetLayout("Global")->GetDescriptorSetLayout()
 		));
 
-		for (unsigned i = 0; i < 6; ++i)
-		{
-			std::string name = std::string("Offscreen") + std::to_string(i + 1);
-			renderSystems["Offscreen"].emplace_back(std::make_unique<OffscreenSystem>
-			(
-				device,
-				renderPasses[name].renderPass,
-				GetSetLayout("Offscreen")->GetDescriptorSetLayout()
-			));
-		}
+		// Multiview pipelines only work in passes with the same view mask, so the whole
+		// cube pass and the single face passes (which share a render pass) each get one
+		renderSystems["Offscreen"].emplace_back(std::make_unique<OffscreenSystem>
+		(
+			device,
+			renderPasses["CubeCapture"].renderPass,
+			GetSetLayout("Offscreen")->GetDescriptorSetLayout()
+		));
+
+		renderSystems["Offscreen"].emplace_back(std::make_unique<OffscreenSystem>
+		(
+			device,
+			renderPasses["CubeFace0"].renderPass,
+			GetSetLayout("Offscreen")->GetDescriptorSetLayout()
+		));
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Scene.h"
 
 #include "../../Rendering/Texture.h"
+#include "../../Rendering/TextureCache.h"
 #include "../../Rendering/UniformBuffer.hpp"
 
 #include <memory>
@@ -29,6 +30,12 @@ namespace Tendou
 			glm::vec3 diffuse[16] = {};
 			glm::vec3 specular[16] = {};
 
+			// Reflection capture: 6 faces a frame renders the whole cube in one
+			// multiview pass, fewer spreads it over several frames
+			int captureFacesPerFrame = 6;
+			int captureInterval = 0; // frames to wait after a full cube before the next
+			bool pauseCapture = false;
+
 		} editorVars;
 
 		LightingScene(Window& window, TendouDevice& device);
@@ -39,6 +46,9 @@ namespace Tendou
 		int Update() override;
 		int PostUpdate() override;
 
+		void LateLatch(const Camera& camera) override;
+		void ReadFramePacket(const FramePacket& packet) override;
+
 		int Render(VkCommandBuffer buf, FrameInfo& f) override;
 
 
@@ -46,20 +56,26 @@ namespace Tendou
 
 	private:
 		void LoadGameObjects();
+		void WriteWorldUBO();
+		void WriteLightUBO(const FramePacket& packet);
 
 		void CreateUBOs();
 		void CreateSetLayouts();
 		void CreateRenderPasses();
 		void CreateRenderSystems();
 
-		void WriteToCaptureUBO(glm::mat4 view, int i);
+		// Picks the cubemap faces rendered this frame and writes their views
+		void ScheduleCapture();
 
 		std::unique_ptr<UniformBuffer<WorldUBO>> worldUBO;
 		std::unique_ptr<UniformBuffer<LightsUBO>> lightUBO;
-		std::unique_ptr<UniformBuffer<RenderUBO>> captureUBO;
+		std::unique_ptr<UniformBuffer<CaptureUBO>> captureUBO;
 		std::vector<std::unique_ptr<Texture>> textures;
 
-		size_t testOffset;
+		// Bit per cubemap face captured this frame
+		uint32_t captureMask = 0;
+		uint32_t nextFace = 0;
+		int idleFrames = 0;
 	};
 }
 
@@ -1,5 +1,6 @@
 #include "Scene.h"
 #include "../../Core/Application.h"
+#include "../../Core/Profiler.h"
 
 #include "../../IO/Mouse.h"
 #include "../../IO/Keyboard.h"
@@ -14,8 +15,24 @@ namespace Tendou
 		: appWindow(window)
 		, device(device_)
 	{
+		pacer = std::make_unique<FramePacer>(device);
+
 		RecreateSwapChain();
 		CreateCommandBuffers();
+
+		threadPools = std::make_unique<ThreadCommandPools>(device,
+			SwapChain::MAX_FRAMES_IN_FLIGHT, JobSystem::ThreadCount());
+
+		commandCache = std::make_unique<CommandCache>(device,
+			SwapChain::MAX_FRAMES_IN_FLIGHT, JobSystem::ThreadCount());
+
+		graph = std::make_unique<RenderGraph>(device);
+		graph->SetCommandPools(threadPools.get());
+		graph->SetCommandCache(commandCache.get());
+
+		gpuProfiler = std::make_unique<GPUProfiler>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
+		gpuProfiler->SetFramesInFlight(swapChain->FramesInFlight());
+		dynamicResolution = std::make_unique<DynamicResolution>(device, SwapChain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	Scene::~Scene()
@@ -83,26 +100,82 @@ namespace Tendou
 
 		vkDeviceWaitIdle(device.Device());
 
+		// Everything has finished, and the fences are about to go away with the old swap chain
+		pacer->Poll();
+
+		// Cached secondaries may point at the render pass that's being replaced
+		if (commandCache)
+		{
+			commandCache->Clear();
+		}
+
+		const SwapChainConfig& config = pacer->GetConfig().swapChain;
 		if (swapChain == nullptr)
 		{
-			swapChain = std::make_unique<SwapChain>(device, ext);
+			swapChain = std::make_unique<SwapChain>(device, ext, config);
 		}
 		else
 		{
 			std::shared_ptr<SwapChain> oldSwapChain = std::move(swapChain);
-			swapChain = std::make_unique<SwapChain>(device, ext, std::move(swapChain));
+			swapChain = std::make_unique<SwapChain>(device, ext, oldSwapChain, config);
 
 			if (!oldSwapChain->CompareSwapFormats(*swapChain.get()))
 			{
 				throw std::runtime_error("Swap chain image (or depth) format has changed!");
 			}
 		}
+
+		// The new swap chain starts over at its first frame slot
+		currFrameIdx = 0;
+
+		// The device is idle, so every pending timestamp can still be read back
+		if (gpuProfiler)
+		{
+			gpuProfiler->SetFramesInFlight(swapChain->FramesInFlight());
+		}
+	}
+
+	void Scene::SetFramePacing(const FramePacingConfig& config)
+	{
+		pacer->SetConfig(config);
+		if (pacer->SwapChainDirty())
+		{
+			pacer->ClearSwapChainDirty();
+			RecreateSwapChain();
+		}
+	}
+
+	void Scene::LateLatch(const Camera&)
+	{
+	}
+
+	void Scene::WriteFramePacket(FramePacket& packet)
+	{
+		packet.camera = c;
+		packet.Capture(gameObjects);
+	}
+
+	void Scene::ReadFramePacket(const FramePacket& packet)
+	{
+		renderCamera = packet.camera;
+		packet.Apply();
 	}
 
 	VkCommandBuffer Scene::BeginFrame()
 	{
 		assert(!isFrameStarted && "Can't call BeginFrame while already in progress!");
 
+		// Frame boundary goes before the fence wait so stalls land inside the frame
+		TENDOU_PROFILE_FRAME();
+		TENDOU_PROFILE_SCOPE("Scene::BeginFrame");
+
+		// Pacing was changed from the editor
+		if (pacer->SwapChainDirty())
+		{
+			pacer->ClearSwapChainDirty();
+			RecreateSwapChain();
+		}
+
 		auto res = swapChain->AcquireNextImage(&currImageIdx);
 		if (res == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -117,6 +190,13 @@ namespace Tendou
 
 		isFrameStarted = true;
 
+		// This slot's fence has signaled by now, so its latency sample can't be lost to the reset
+		pacer->Poll();
+
+		// The fence for this frame was waited on in AcquireNextImage,
+		// so its secondaries are free to be recycled
+		threadPools->ResetFrame(currFrameIdx);
+
 		auto cmdBuf = GetCurrentCommandBuffer();
 
 		VkCommandBufferBeginInfo beginInfo{};
@@ -126,6 +206,13 @@ namespace Tendou
 		{
 			throw std::runtime_error("Failed to begin recording command buffer!");
 		}
+
+		gpuProfiler->BeginFrame(cmdBuf, static_cast<uint32_t>(currFrameIdx));
+		frameZone = gpuProfiler->BeginZone(cmdBuf, "Frame");
+
+		dynamicResolution->BeginFrame(cmdBuf, static_cast<uint32_t>(currFrameIdx), swapChain->GetSwapChainExtent());
+		graph->SetRenderArea(dynamicResolution->GetRenderExtent());
+
 		return cmdBuf;
 	}
 
@@ -133,14 +220,27 @@ namespace Tendou
 	{
 		assert(isFrameStarted && "Can't call EndFrame while already in progress!");
 
+		TENDOU_PROFILE_SCOPE("Scene::EndFrame");
+
 		auto cmdBuf = GetCurrentCommandBuffer();
 
+		gpuProfiler->EndZone(cmdBuf, frameZone);
+		frameZone = GPUProfiler::INVALID_ZONE;
+
+		dynamicResolution->EndFrame(cmdBuf);
+
 		if (vkEndCommandBuffer(cmdBuf) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
+		VkFence fence = swapChain->CurrentFence();
 		auto res = swapChain->SubmitCommandBuffers(&cmdBuf, &currImageIdx);
+		pacer->FrameSubmitted(static_cast<uint32_t>(currFrameIdx), fence);
+
+		isFrameStarted = false;
+		currFrameIdx = (currFrameIdx + 1) % swapChain->FramesInFlight();
+
 		if (res == VK_ERROR_OUT_OF_DATE_KHR || res == VK_SUBOPTIMAL_KHR || appWindow.WasWindowResized())
 		{
 			appWindow.ResetWindowResizedFlag();
@@ -150,9 +250,6 @@ namespace Tendou
 		{
 			throw std::runtime_error("Failed to present swap chain image!");
 		}
-
-		isFrameStarted = false;
-		currFrameIdx = (currFrameIdx + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
 	void Scene::ProcessInput(float dt, Camera& c)
@@ -190,7 +287,30 @@ namespace Tendou
 		c.UpdateCameraDir(x, y);
 	}
 
-	void Scene::BeginRenderPass(VkCommandBuffer cmdBuf, std::string key, std::vector<VkClearValue> clearValues)
+	void Scene::LatchInput(float dt, Camera& c)
+	{
+		if (Keyboard::Key(GLFW_KEY_W))
+			c.UpdateCameraPos(CameraDirection::FORWARD, dt);
+		if (Keyboard::Key(GLFW_KEY_S))
+			c.UpdateCameraPos(CameraDirection::BACKWARDS, dt);
+		if (Keyboard::Key(GLFW_KEY_A))
+			c.UpdateCameraPos(CameraDirection::LEFT, dt);
+		if (Keyboard::Key(GLFW_KEY_D))
+			c.UpdateCameraPos(CameraDirection::RIGHT, dt);
+		if (Keyboard::Key(GLFW_KEY_Q))
+			c.UpdateCameraPos(CameraDirection::UP, dt);
+		if (Keyboard::Key(GLFW_KEY_E))
+			c.UpdateCameraPos(CameraDirection::DOWN, dt);
+
+		double dx = Mouse::PeekDX(); double dy = Mouse::PeekDY();
+		if (dx != 0 || dy != 0)
+		{
+			c.UpdateCameraDir(dx, dy);
+		}
+	}
+
+	void Scene::BeginRenderPass(VkCommandBuffer cmdBuf, std::string key, std::vector<VkClearValue> clearValues,
+		VkSubpassContents contents)
 	{
 		std::vector<VkClearValue> clearCopy = clearValues;
 
@@ -213,7 +333,21 @@ namespace Tendou
 		renderPassInfo.clearValueCount = clearCopy.size();
 		renderPassInfo.pClearValues = clearCopy.data();
 
-		vkCmdBeginRenderPass(commandBuffers[currFrameIdx], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		passZone = gpuProfiler->BeginZone(cmdBuf, key);
+		vkCmdBeginRenderPass(commandBuffers[currFrameIdx], &renderPassInfo, contents);
+
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			// Only vkCmdExecuteCommands is allowed in the primary now;
+			// the secondaries set their own viewport/scissor
+			passContext.pools = threadPools.get();
+			passContext.cache = commandCache.get();
+			passContext.frameIdx = static_cast<uint32_t>(currFrameIdx);
+			passContext.renderPass = renderPasses[key].renderPass;
+			passContext.frameBuffer = renderPasses[key].frameBuffer;
+			passContext.extent = { static_cast<uint32_t>(renderPasses[key].width), static_cast<uint32_t>(renderPasses[key].height) };
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -232,9 +366,12 @@ namespace Tendou
 	void Scene::EndRenderPass(VkCommandBuffer cmdBuf)
 	{
 		vkCmdEndRenderPass(cmdBuf);
+
+		gpuProfiler->EndZone(cmdBuf, passZone);
+		passZone = GPUProfiler::INVALID_ZONE;
 	}
 
-	void Scene::BeginSwapChainRenderPass(VkCommandBuffer cmdBuf)
+	void Scene::BeginSwapChainRenderPass(VkCommandBuffer cmdBuf, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Can't call BeginSwapChainRenderPass while not in progress!");
 		assert(cmdBuf == GetCurrentCommandBuffer() && "Can't begin render pass on command buffer from different frame!");
@@ -254,7 +391,22 @@ namespace Tendou
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(cmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		swapChainZone = gpuProfiler->BeginZone(cmdBuf, "SwapChain");
+		vkCmdBeginRenderPass(cmdBuf, &renderPassInfo, contents);
+
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			swapChainContext.pools = threadPools.get();
+			swapChainContext.cache = commandCache.get();
+			swapChainContext.frameIdx = static_cast<uint32_t>(currFrameIdx);
+			swapChainContext.renderPass = swapChain->GetRenderPass();
+			swapChainContext.frameBuffer = swapChain->GetFrameBuffer(currImageIdx);
+			swapChainContext.extent = swapChain->GetSwapChainExtent();
+			passContext = swapChainContext;
+			return;
+		}
+
+		swapChainContext.pools = nullptr;
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -272,8 +424,32 @@ namespace Tendou
 	{
 		assert(isFrameStarted && "Can't call EndSwapChainRenderPass while not in progress!");
 		assert(cmdBuf == GetCurrentCommandBuffer() && "Can't end render pass on command buffer from different frame!");
+
+		if (overlayBuffer)
+		{
+			swapChainContext.End(overlayBuffer);
+			vkCmdExecuteCommands(cmdBuf, 1, &overlayBuffer);
+			overlayBuffer = nullptr;
+		}
 	
 		vkCmdEndRenderPass(cmdBuf);
+
+		gpuProfiler->EndZone(cmdBuf, swapChainZone);
+		swapChainZone = GPUProfiler::INVALID_ZONE;
+	}
+
+	VkCommandBuffer Scene::GetOverlayCommandBuffer(VkCommandBuffer cmdBuf)
+	{
+		if (swapChainContext.pools == nullptr)
+		{
+			return cmdBuf;
+		}
+
+		if (!overlayBuffer)
+		{
+			overlayBuffer = swapChainContext.Begin();
+		}
+		return overlayBuffer;
 	}
 
 }
\ No newline at end of file
@@ -5,14 +5,22 @@
 #include "../../Vulkan/SwapChain.h"
 #include "../../Vulkan/TendouDevice.h"
 #include "../../Vulkan/Descriptor.h"
+#include "../../Vulkan/CommandCache.h"
+#include "../../Vulkan/CommandPools.h"
+#include "../../Vulkan/RenderGraph.h"
+#include "../../Vulkan/GPUProfiler.h"
 
 #include "../../Vulkan/Systems/Default.h"
 #include "../../Vulkan/Systems/Offscreen.h"
 #include "../../Vulkan/Systems/Deferred.h"
 #include "../../Vulkan/Systems/Geometry.h"
 #include "../../Vulkan/Systems/LocalLights.h"
+#include "../../Vulkan/Systems/Upscale.h"
 
 #include "../../Rendering/Camera.h"
+#include "../../Rendering/DynamicResolution.h"
+#include "../../Rendering/FramePacer.h"
+#include "../../Rendering/FramePacket.h"
 
 #include "../../Components/GameObject.h"
 
@@ -49,6 +57,23 @@ namespace Tendou
 
 		virtual int Render(VkCommandBuffer buf, FrameInfo& f);
 
+		// Called right before submit after input was sampled again; rewrites
+		// whatever the camera feeds so the frame is seen from camera
+		virtual void LateLatch(const Camera& camera);
+
+		// Update stage: copies everything Render reads into packet. Runs on the
+		// update thread, concurrently with the previous frame's Render, when the
+		// application pipelines frames.
+		virtual void WriteFramePacket(FramePacket& packet);
+
+		// Render stage: publishes packet to the render systems before recording.
+		// The update thread is idle while this runs.
+		virtual void ReadFramePacket(const FramePacket& packet);
+
+		// Whether Update and WriteFramePacket leave everything Render touches
+		// alone, so they may overlap the previous frame's recording
+		virtual bool CanPipelineUpdate() const { return false; }
+
 		__inline bool IsFrameInProgress() const { return isFrameStarted; }
 		__inline VkRenderPass GetSwapChainRenderPass() const { return swapChain->GetRenderPass(); }
 		__inline SwapChain* GetSwapChain()  { return swapChain.get(); }
@@ -66,12 +91,26 @@ namespace Tendou
 			return currFrameIdx;
 		}
 
+		GPUProfiler* GetGPUProfiler() { return gpuProfiler.get(); }
+
+		FramePacer* GetFramePacer() { return pacer.get(); }
+
+		DynamicResolution* GetDynamicResolution() { return dynamicResolution.get(); }
+
+		CommandCache* GetCommandCache() { return commandCache.get(); }
+
+		// Rebuilds the swap chain if the frames in flight or present mode changed
+		void SetFramePacing(const FramePacingConfig& config);
+
 		DescriptorPool* GetGlobalPool() { return globalPool.get(); }
 		DescriptorSetLayout* GetSetLayout(std::string key) { return setLayouts[key].get(); }
 
 		GameObject::Map& GetGameObjects() { return gameObjects; }
 		Camera& GetCamera() { return c; }
 
+		// The camera of the packet being rendered; GetCamera is the one being simulated
+		const Camera& GetRenderCamera() const { return renderCamera; }
+
 		std::vector<VkDescriptorSet> GetDescriptorSet(std::string key) { return descriptorSets[key]; }
 
 		VkDescriptorSet GetDescriptorSet(int idx, std::string key)
@@ -89,12 +128,24 @@ namespace Tendou
 		void ProcessInput(float dt, Camera& c);
 		void ProcessMouse(float x, float y, Camera& c);
 
-		void BeginRenderPass(VkCommandBuffer cmdBuf, std::string key, std::vector<VkClearValue> clearValues = std::vector<VkClearValue>());
+		// Moves c by the keys held for dt and the mouse movement no update has read
+		// yet, leaving both for the next ProcessInput. Late latching predicts with it.
+		void LatchInput(float dt, Camera& c);
+
+		void BeginRenderPass(VkCommandBuffer cmdBuf, std::string key, std::vector<VkClearValue> clearValues = std::vector<VkClearValue>(),
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void EndRenderPass(VkCommandBuffer cmdBuf);
 
-		void BeginSwapChainRenderPass(VkCommandBuffer cmdBuf);
+		void BeginSwapChainRenderPass(VkCommandBuffer cmdBuf, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void EndSwapChainRenderPass(VkCommandBuffer cmdBuf);
 
+		// Valid after beginning a pass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+		SecondaryContext* GetPassContext() { return &passContext; }
+
+		// Where the editor should draw into the swapchain pass. Returns cmdBuf when the
+		// pass is recorded inline, otherwise a secondary that EndSwapChainRenderPass executes.
+		VkCommandBuffer GetOverlayCommandBuffer(VkCommandBuffer cmdBuf);
+
 	protected:
 		void CreateCommandBuffers();
 		void FreeCommandBuffers();
@@ -109,6 +160,30 @@ namespace Tendou
 		std::unique_ptr<SwapChain> swapChain;
 		std::vector<VkCommandBuffer> commandBuffers;
 
+		// Per-thread pools for secondaries recorded on the job system
+		std::unique_ptr<ThreadCommandPools> threadPools;
+
+		// Secondaries of passes recorded with RecordCached, kept across frames
+		std::unique_ptr<CommandCache> commandCache;
+		SecondaryContext passContext;
+		SecondaryContext swapChainContext;
+		VkCommandBuffer overlayBuffer = nullptr;
+
+		// Offscreen passes; scenes declare them in Init/CreateRenderPasses
+		// and everything up to the swapchain pass is recorded by Execute
+		std::unique_ptr<RenderGraph> graph;
+
+		// GPU timings for the whole frame, each render pass and each render system
+		std::unique_ptr<GPUProfiler> gpuProfiler;
+		uint32_t frameZone = GPUProfiler::INVALID_ZONE;
+		uint32_t passZone = GPUProfiler::INVALID_ZONE;
+		uint32_t swapChainZone = GPUProfiler::INVALID_ZONE;
+
+		std::unique_ptr<FramePacer> pacer;
+
+		// Scenes that render through scaled graph passes give it a max extent in CreateRenderPasses
+		std::unique_ptr<DynamicResolution> dynamicResolution;
+
 		uint32_t currImageIdx;
 		int currFrameIdx = 0;
 		bool isFrameStarted = false;
@@ -121,6 +196,7 @@ namespace Tendou
 		std::unique_ptr<DescriptorPool> globalPool{};
 		GameObject::Map gameObjects;
 		Camera c;
+		Camera renderCamera;
 
 		friend class Application;
 		friend class Editor;
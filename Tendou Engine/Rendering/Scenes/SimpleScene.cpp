@@ -38,8 +38,8 @@ namespace Tendou
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 		lightUBO->Map();
 
-		textures.push_back(std::make_unique<Texture>(device, "Materials/Models/Shiroko/Texture2D/Shiroko_Original_Weapon.png"));
-		textures.push_back(std::make_unique<Texture>(device, "Materials/Textures/c.png"));
+		textures.push_back(TextureCache::Load(device, "Materials/Models/Shiroko/Texture2D/Shiroko_Original_Weapon.png"));
+		textures.push_back(TextureCache::Load(device, "Materials/Textures/c.png"));
 
 		setLayouts["Global"] = DescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
@@ -79,8 +79,58 @@ namespace Tendou
 		static float angle = 0.0f;
 		int idx = 0;
 
+		for (auto& a : gameObjects)
+		{
+			auto& obj = a.second;
+			if (obj.GetTag() == "Sphere")
+			{
+				float res = angle + (glm::pi<float>() / 1.0f) * idx;
+				obj.GetTransform().SetRotationAngle(res);
+				obj.GetTransform().Update(true);
+				++idx;
+			}
+			else
+			{
+				obj.GetTransform().Update();
+			}
+		}
+
+		angle += 0.01f;
+		if (angle > glm::pi<float>())
+		{
+			angle = 0.0f;
+		}
+
+		return 0;
+	}
+
+	void SimpleScene::LateLatch(const Camera& camera)
+	{
+		renderCamera = camera;
+		WriteWorldUBO();
+	}
+
+	void SimpleScene::ReadFramePacket(const FramePacket& packet)
+	{
+		Scene::ReadFramePacket(packet);
+		WriteWorldUBO();
+		WriteLightUBO(packet);
+	}
+
+	void SimpleScene::WriteWorldUBO()
+	{
+		WorldUBO localUBO{};
+		localUBO.proj = renderCamera.perspective();
+		localUBO.view = renderCamera.view();
+		localUBO.nearFar = glm::vec2(0.1f, 20.0f);
+		worldUBO->WriteToBuffer(&localUBO);
+		worldUBO->Flush();
+	}
+
+	void SimpleScene::WriteLightUBO(const FramePacket& packet)
+	{
 		LightsUBO lightUbo{};
-		lightUbo.eyePos = glm::vec4(c.cameraPos, 1.0f);
+		lightUbo.eyePos = glm::vec4(renderCamera.cameraPos, 1.0f);
 
 		for (unsigned i = 0; i < 1; ++i)
 		{
@@ -103,47 +153,30 @@ namespace Tendou
 		// x = use gpu, y = use normals, z = uv type
 		lightUbo.modes = glm::ivec4(0, 0, 0, 0);
 
-		// TODO: IDs to string tags?
-		GameObject& mainObj = gameObjects.find(0)->second;
-
-		for (auto& a : gameObjects)
+		// Lights sit where their spheres are drawn, between the last two steps
+		const GameObject* mainObj = &gameObjects.find(0)->second;
+		glm::vec4 mainPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		for (const FramePacket::Object& o : packet.objects)
 		{
-			auto& obj = a.second;
-			if (obj.GetTag() == "Sphere")
+			if (o.object == mainObj)
 			{
-				float res = angle + (glm::pi<float>() / 1.0f) * idx;
-				obj.GetTransform().SetRotationAngle(res);
-				obj.GetTransform().Update(true);
-				lightUbo.lightPos[idx] = obj.GetTransform().PositionVec4();
-				lightUbo.lightDir[idx] = mainObj.GetTransform().PositionVec4() - lightUbo.lightPos[idx];
-				++idx;
+				mainPos = o.state.modelMatrix[3];
 			}
-			else
+		}
+
+		int idx = 0;
+		for (const FramePacket::Object& o : packet.objects)
+		{
+			if (idx < 1 && o.object->GetTag() == "Sphere")
 			{
-				obj.GetTransform().Update();
+				lightUbo.lightPos[idx] = o.state.modelMatrix[3];
+				lightUbo.lightDir[idx] = mainPos - lightUbo.lightPos[idx];
+				++idx;
 			}
 		}
 
-		WorldUBO localUBO{};
-		localUBO.proj = c.perspective();
-		localUBO.view = c.view();
-		localUBO.nearFar = glm::vec2(0.1f, 20.0f);
-		worldUBO->WriteToBuffer(&localUBO);
-		worldUBO->Flush();
-
-		
-		//lightUbo.lightColor[0] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		//lightUbo.lightPos[0] = glm::vec4(-2.0f, -1.0f, 1.0f, 1.0f);
 		lightUBO->WriteToBuffer(&lightUbo);
 		lightUBO->Flush();
-
-		angle += 0.01f;
-		if (angle > glm::pi<float>())
-		{
-			angle = 0.0f;
-		}
-
-		return 0;
 	}
 
 	int SimpleScene::PostUpdate()
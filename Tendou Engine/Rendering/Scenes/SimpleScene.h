@@ -4,6 +4,7 @@
 #include "Scene.h"
 
 #include "../../Rendering/Texture.h"
+#include "../../Rendering/TextureCache.h"
 #include "../../Rendering/UniformBuffer.hpp"
 
 #include <memory>
@@ -21,8 +22,13 @@ namespace Tendou
 		int PreUpdate() override;
 		int Update() override;
 		int PostUpdate() override;
+
+		void LateLatch(const Camera& camera) override;
+		void ReadFramePacket(const FramePacket& packet) override;
 	private:
 		void LoadGameObjects();
+		void WriteWorldUBO();
+		void WriteLightUBO(const FramePacket& packet);
 
 		std::unique_ptr<UniformBuffer<WorldUBO>> worldUBO;
 		std::unique_ptr<UniformBuffer<LightsUBO>> lightUBO;
@@ -0,0 +1,149 @@
+#include "StaticBatcher.h"
+
+#include "../Core/Profiler.h"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+namespace Tendou
+{
+	namespace
+	{
+		// Tag, render flag and grid cell
+		using BatchKey = std::tuple<std::string, bool, int, int, int>;
+
+		struct PendingBatch
+		{
+			Model::Builder<Model::Vertex> builder;
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ -std::numeric_limits<float>::max() };
+			std::vector<GameObject::id_t> sources;
+		};
+
+		__inline int Cell(float coordinate, float chunkSize)
+		{
+			return chunkSize > 0.0f ? static_cast<int>(std::floor(coordinate / chunkSize)) : 0;
+		}
+	}
+
+	std::vector<StaticBatch> StaticBatcher::Build(TendouDevice& device, GameObject::Map& objects,
+		const StaticBatchConfig& config)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		// Instanced models are read back from the arena once
+		std::unordered_map<const Model*, Model::Builder<Model::Vertex>> sources;
+		std::map<BatchKey, PendingBatch> pending;
+
+		std::vector<Model::Vertex> baked;
+
+		for (auto& kv : objects)
+		{
+			GameObject& obj = kv.second;
+			std::shared_ptr<Model> model = obj.GetModel();
+			if (!obj.GetStatic() || model == nullptr)
+			{
+				continue;
+			}
+
+			auto source = sources.find(model.get());
+			if (source == sources.end())
+			{
+				source = sources.emplace(model.get(), Model::Builder<Model::Vertex>()).first;
+				model->ReadBack(source->second);
+			}
+			const Model::Builder<Model::Vertex>& mesh = source->second;
+
+			// Same matrices the vertex shaders build from the push constants
+			glm::mat4 modelMat = obj.GetTransform().ModelMat();
+			glm::mat3 normalMat = glm::mat3(glm::transpose(glm::inverse(modelMat)));
+
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ -std::numeric_limits<float>::max() };
+
+			baked.resize(mesh.vertices.size());
+			for (size_t i = 0; i < mesh.vertices.size(); ++i)
+			{
+				baked[i] = mesh.vertices[i];
+				baked[i].position = glm::vec3(modelMat * glm::vec4(mesh.vertices[i].position, 1.0f));
+				baked[i].normal = normalMat * mesh.vertices[i].normal;
+
+				boundsMin = glm::min(boundsMin, baked[i].position);
+				boundsMax = glm::max(boundsMax, baked[i].position);
+			}
+
+			// Objects straddling cells go to the one holding their centre
+			glm::vec3 centre = 0.5f * (boundsMin + boundsMax);
+			BatchKey key{ obj.GetTag(), obj.GetRender(),
+				Cell(centre.x, config.chunkSize), Cell(centre.y, config.chunkSize), Cell(centre.z, config.chunkSize) };
+
+			PendingBatch& batch = pending[key];
+			std::vector<Model::Vertex>& vertices = batch.builder.vertices;
+			std::vector<uint32_t>& indices = batch.builder.indices;
+
+			uint32_t base = static_cast<uint32_t>(vertices.size());
+			vertices.insert(vertices.end(), baked.begin(), baked.end());
+
+			if (mesh.indices.empty())
+			{
+				for (uint32_t i = 0; i < static_cast<uint32_t>(baked.size()); ++i)
+				{
+					indices.push_back(base + i);
+				}
+			}
+			else
+			{
+				for (uint32_t index : mesh.indices)
+				{
+					indices.push_back(base + index);
+				}
+			}
+
+			batch.boundsMin = glm::min(batch.boundsMin, boundsMin);
+			batch.boundsMax = glm::max(batch.boundsMax, boundsMax);
+			batch.sources.push_back(obj.GetID());
+		}
+
+		std::vector<StaticBatch> result;
+		result.reserve(pending.size());
+
+		size_t merged = 0;
+		for (auto& kv : pending)
+		{
+			PendingBatch& batch = kv.second;
+
+			for (GameObject::id_t id : batch.sources)
+			{
+				objects.erase(id);
+			}
+			merged += batch.sources.size();
+
+			auto obj = GameObject::CreateGameObject(std::get<0>(kv.first), "StaticBatch");
+			obj.SetModel(std::make_shared<Model>(device, batch.builder));
+			obj.SetRender(std::get<1>(kv.first));
+			obj.SetStatic(true);
+
+			StaticBatch info{};
+			info.id = obj.GetID();
+			info.sourceCount = static_cast<uint32_t>(batch.sources.size());
+			if (config.keepBounds)
+			{
+				info.boundsMin = batch.boundsMin;
+				info.boundsMax = batch.boundsMax;
+			}
+			result.push_back(info);
+
+			objects.emplace(obj.GetID(), std::move(obj));
+		}
+
+		std::cout << "Static batching: " << merged << " objects into " << result.size() << " batches" << std::endl;
+
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef STATICBATCHER_H
+#define STATICBATCHER_H
+
+#include "../Components/GameObject.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Tendou
+{
+	struct StaticBatchConfig
+	{
+		// Edge of the world space grid cells batches are split by, 0 merges a whole material
+		float chunkSize = 32.0f;
+
+		// Record every batch's world bounds in the result for culling
+		bool keepBounds = true;
+	};
+
+	struct StaticBatch
+	{
+		GameObject::id_t id = 0;
+		uint32_t sourceCount = 0;
+
+		// Only filled in with StaticBatchConfig::keepBounds
+		glm::vec3 boundsMin{ 0.0f };
+		glm::vec3 boundsMax{ 0.0f };
+	};
+
+	// Bakes the world transforms of every object flagged static into its
+	// vertices and merges them into a few combined meshes, one per material
+	// and grid cell. Objects with the same tag and render flag go down the
+	// same pipeline and descriptor sets, so the tag stands in for the
+	// material. The sources are replaced in the map by one object per batch
+	// with an identity transform, which every render system draws unchanged.
+	//
+	// Transforms have to be up to date (Transform::Update) before building.
+	class StaticBatcher
+	{
+	public:
+		static std::vector<StaticBatch> Build(TendouDevice& device, GameObject::Map& objects,
+			const StaticBatchConfig& config = StaticBatchConfig());
+	};
+}
+
+#endif
\ No newline at end of file
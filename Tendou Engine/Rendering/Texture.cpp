@@ -1,7 +1,12 @@
 #include "Texture.h"
 #include "Buffer.h"
 
+#include "../Core/Profiler.h"
+
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,6 +15,138 @@
 
 namespace Tendou
 {
+	namespace
+	{
+		// Fine enough that round tripping every 8 bit value is exact
+		constexpr uint32_t ENCODE_STEPS = 4096;
+
+		float SRGBToLinear(float c)
+		{
+			return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSRGB(float c)
+		{
+			return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		}
+
+		const std::array<float, 256>& DecodeTable()
+		{
+			static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> t{};
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					t[i] = SRGBToLinear(i / 255.0f);
+				}
+				return t;
+			}();
+			return table;
+		}
+
+		const std::array<uint8_t, ENCODE_STEPS + 1>& EncodeTable()
+		{
+			static const std::array<uint8_t, ENCODE_STEPS + 1> table = []()
+			{
+				std::array<uint8_t, ENCODE_STEPS + 1> t{};
+				for (uint32_t i = 0; i <= ENCODE_STEPS; ++i)
+				{
+					float c = LinearToSRGB(static_cast<float>(i) / ENCODE_STEPS);
+					t[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+				}
+				return t;
+			}();
+			return table;
+		}
+
+		// One 2x2 box filter step; odd edges repeat their last row/column
+		void Downsample(const uint8_t* src, uint32_t srcW, uint32_t srcH,
+			uint8_t* dst, uint32_t dstW, uint32_t dstH, bool srgb)
+		{
+			const std::array<float, 256>& decode = DecodeTable();
+			const std::array<uint8_t, ENCODE_STEPS + 1>& encode = EncodeTable();
+
+			for (uint32_t y = 0; y < dstH; ++y)
+			{
+				const uint8_t* row0 = src + static_cast<size_t>(std::min(y * 2, srcH - 1)) * srcW * 4;
+				const uint8_t* row1 = src + static_cast<size_t>(std::min(y * 2 + 1, srcH - 1)) * srcW * 4;
+				uint8_t* out = dst + static_cast<size_t>(y) * dstW * 4;
+
+				for (uint32_t x = 0; x < dstW; ++x)
+				{
+					uint32_t x0 = std::min(x * 2, srcW - 1) * 4;
+					uint32_t x1 = std::min(x * 2 + 1, srcW - 1) * 4;
+
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						if (srgb && c < 3)
+						{
+							float sum = decode[row0[x0 + c]] + decode[row0[x1 + c]] +
+								decode[row1[x0 + c]] + decode[row1[x1 + c]];
+							out[x * 4 + c] = encode[static_cast<uint32_t>(sum * 0.25f * ENCODE_STEPS + 0.5f)];
+						}
+						else
+						{
+							uint32_t sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+							out[x * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	uint32_t MipChain::FullLevelCount(uint32_t w, uint32_t h)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(w, h); size > 1; size >>= 1)
+		{
+			++levels;
+		}
+		return levels;
+	}
+
+	MipChain MipChain::Build(const uint8_t* rgba, uint32_t w, uint32_t h, bool srgb)
+	{
+		MipChain mips;
+		mips.width = w;
+		mips.height = h;
+		mips.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+
+		uint32_t levels = FullLevelCount(w, h);
+		mips.offsets.resize(levels);
+
+		VkDeviceSize total = 0;
+		for (uint32_t i = 0; i < levels; ++i)
+		{
+			mips.offsets[i] = total;
+			total += static_cast<VkDeviceSize>(std::max(w >> i, 1u)) * std::max(h >> i, 1u) * 4;
+		}
+
+		mips.data.resize(static_cast<size_t>(total));
+		std::copy(rgba, rgba + static_cast<size_t>(w) * h * 4, mips.data.begin());
+
+		for (uint32_t i = 1; i < levels; ++i)
+		{
+			Downsample(mips.data.data() + mips.offsets[i - 1], std::max(w >> (i - 1), 1u), std::max(h >> (i - 1), 1u),
+				mips.data.data() + mips.offsets[i], std::max(w >> i, 1u), std::max(h >> i, 1u), srgb);
+		}
+
+		return mips;
+	}
+
+	MipChainView MipChain::View() const
+	{
+		MipChainView view;
+		view.width = width;
+		view.height = height;
+		view.format = format;
+		view.data = data.data();
+		view.size = static_cast<VkDeviceSize>(data.size());
+		view.offsets = offsets;
+		return view;
+	}
+
 	Texture::Texture(TendouDevice& d, int w, int h, bool cubemap)
 		: device_(d)
 	{
@@ -44,24 +181,38 @@ namespace Tendou
 		CreateTextureSampler(VK_FILTER_NEAREST);
 	}
 
-	void Texture::CreateEmptyTexture(int width, int height, bool cubemap)
+	Texture::Texture(TendouDevice& d, const MipChain& mips)
+		: Texture(d, mips.View())
+	{
+	}
+
+	Texture::Texture(TendouDevice& d, const MipChainView& mips)
+		: device_(d)
 	{
-		// 32 bit float format for higher precision
-		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		assert(!mips.offsets.empty() && "Texture error: Mip chain is empty!");
+		UploadMipChain(mips);
+		CreateTextureImageView();
+		CreateTextureSampler();
+	}
 
+	void Texture::CreateEmptyTexture(int width, int height, bool cubemap)
+	{
 		uint32_t layerCount = !cubemap ? 1 : 6;
 		VkImageViewType viewType = !cubemap ? VK_IMAGE_VIEW_TYPE_2D : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 
+		// Empty textures are render targets, e.g. cubemap captures render straight into their layers
 		device_.CreateImage(width, height, format, VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, layerCount);
 
-		device_.TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 6);
+		device_.TransitionImageLayout(textureImage, format,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layerCount);
 	}
 
 	void Texture::CreateCubemap(std::vector<std::string> faces)
 	{
+		TENDOU_PROFILE_FUNCTION();
+
 		int width, height, channels;
 		stbi_uc* imageBuffers[6];
 		for (unsigned i = 0; i < 6; ++i)
@@ -101,19 +252,33 @@ namespace Tendou
 		
 		// TODO: Fix pls (4/3 channels - RGBA/RGB)
 		VkFormat bitFormat = channels == 4 ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_SRGB;
+		format = bitFormat;
+
+		// Faces only get mips where the GPU can blit them
+		bool blit = device_.SupportsLinearBlit(bitFormat);
+		mipLevels = blit ? MipChain::FullLevelCount(width, height) : 1;
 
 		device_.CreateImage(width, height, bitFormat,
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 6);
+			VK_IMAGE_TILING_OPTIMAL, 
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 6, mipLevels);
 
 		device_.TransitionImageLayout(textureImage, bitFormat,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 6);
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 6, nullptr,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 6 });
 
 		device_.CopyBufferToImage(stagingBuf.GetBuffer(), textureImage, 
 			static_cast<uint32_t>(width), static_cast<uint32_t>(height), 6);
 
-		device_.TransitionImageLayout(textureImage, bitFormat,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 6);
+		if (blit)
+		{
+			device_.GenerateMipmaps(textureImage, width, height, mipLevels, 6);
+		}
+		else
+		{
+			device_.TransitionImageLayout(textureImage, bitFormat,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 6);
+		}
 	}
 
 	Texture::~Texture()
@@ -126,6 +291,8 @@ namespace Tendou
 
 	void Texture::CreateTextureImage(std::string f)
 	{
+		TENDOU_PROFILE_FUNCTION();
+
 		int width, height, channels;
 		stbi_uc* res = stbi_load(f.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 		VkDeviceSize imageSize = width * height * 4;
@@ -135,6 +302,18 @@ namespace Tendou
 			throw std::runtime_error("Failed to load texture image!");
 		}
 
+		// No linear blits for this format, so build the chain on the CPU instead
+		if (!device_.SupportsLinearBlit(format))
+		{
+			MipChain mips = MipChain::Build(res, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+			stbi_image_free(res);
+
+			UploadMipChain(mips.View());
+			return;
+		}
+
+		mipLevels = MipChain::FullLevelCount(width, height);
+
 		Buffer stagingBuf
 		{
 			device_,
@@ -150,25 +329,79 @@ namespace Tendou
 
 		stbi_image_free(res);
 
-		device_.CreateImage(width, height, VK_FORMAT_R8G8B8A8_SRGB,
-			VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory);
+		device_.CreateImage(width, height, format, VK_IMAGE_TILING_OPTIMAL, 
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1, mipLevels);
 		
-		device_.TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		device_.TransitionImageLayout(textureImage, format,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, nullptr,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 });
 
 		device_.CopyBufferToImage(stagingBuf.GetBuffer(), textureImage, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
 
-		device_.TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// Leaves every level in SHADER_READ_ONLY_OPTIMAL
+		device_.GenerateMipmaps(textureImage, width, height, mipLevels);
+	}
+
+	void Texture::UploadMipChain(const MipChainView& mips)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		format = mips.format;
+		mipLevels = static_cast<uint32_t>(mips.offsets.size());
+
+		Buffer stagingBuf
+		{
+			device_,
+			mips.size,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+
+		stagingBuf.Map();
+		stagingBuf.WriteToBuffer(const_cast<uint8_t*>(mips.data), mips.size);
+		stagingBuf.Unmap();
+
+		device_.CreateImage(mips.width, mips.height, format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1, mipLevels);
+
+		VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+
+		device_.TransitionImageLayout(textureImage, format,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, nullptr, range);
+
+		// Every level in one submit, straight out of the packed buffer.
+		// Tightly packed rows work for block formats too, extents stay in texels.
+		std::vector<VkBufferImageCopy> regions(mipLevels);
+		for (uint32_t i = 0; i < mipLevels; ++i)
+		{
+			VkBufferImageCopy& region = regions[i];
+			region.bufferOffset = mips.offsets[i];
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = i;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { std::max(mips.width >> i, 1u), std::max(mips.height >> i, 1u), 1 };
+		}
+
+		VkCommandBuffer commandBuffer = device_.BeginSingleTimeCommands();
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuf.GetBuffer(), textureImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, regions.data());
+		device_.EndSingleTimeCommands(commandBuffer);
 
-		//vkDestroyBuffer(device_.Device(), stagingBuf, nullptr);
-		//vkFreeMemory(device_.Device(), stagingBufMemory, nullptr);
+		device_.TransitionImageLayout(textureImage, format,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, nullptr, range);
 	}
 
 	void Texture::CreateTextureImageView(uint32_t layers, VkImageViewType t)
 	{
-		textureImageView = device_.CreateImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, layers, t);
+		textureImageView = device_.CreateImageView(textureImage, format, layers, t,
+			VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
 	}
 
 	void Texture::CreateTextureSampler(VkFilter filter)
@@ -190,6 +423,9 @@ namespace Tendou
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = static_cast<float>(mipLevels);
 
 		if (vkCreateSampler(device_.Device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) 
 		{
@@ -3,8 +3,46 @@
 
 #include "../Vulkan/TendouDevice.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace Tendou
 {
+	// Non-owning packed mip levels, e.g. straight out of a mapped cache file
+	struct MipChainView
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+
+		const uint8_t* data = nullptr;
+		VkDeviceSize size = 0;
+		std::vector<VkDeviceSize> offsets; // start of each level in data, largest first
+	};
+
+	// Pixels of every mip level of a texture, largest first, packed back to back
+	struct MipChain
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+
+		std::vector<uint8_t> data;
+		std::vector<VkDeviceSize> offsets; // start of each level in data
+
+		__inline uint32_t LevelCount() const { return static_cast<uint32_t>(offsets.size()); }
+
+		MipChainView View() const;
+
+		// floor(log2(max(w, h))) + 1
+		static uint32_t FullLevelCount(uint32_t w, uint32_t h);
+
+		// Box filters a tightly packed RGBA8 image down to 1x1. sRGB color
+		// is averaged in linear space, alpha is always linear.
+		static MipChain Build(const uint8_t* rgba, uint32_t w, uint32_t h, bool srgb = true);
+	};
+
 	class Texture
 	{
 	public:
@@ -19,6 +57,9 @@ namespace Tendou
 		// --------
 		Texture(TendouDevice& device, std::vector<std::string> faces); // strings to file paths
 		
+		// Precomputed mips, uncompressed or BCn; uploaded as is
+		Texture(TendouDevice& device, const MipChain& mips);
+		Texture(TendouDevice& device, const MipChainView& mips);
 
 		~Texture();
 
@@ -26,6 +67,7 @@ namespace Tendou
 		VkImageView TextureImageView() { return textureImageView; }
 		VkSampler TextureSampler() { return textureSampler; }
 		VkDeviceMemory TextureMemory() { return textureImageMemory; }
+		uint32_t MipLevels() const { return mipLevels; }
 
 		VkDescriptorImageInfo DescriptorInfo(VkImageLayout out = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
@@ -34,6 +76,7 @@ namespace Tendou
 
 		void CreateTextureImage(std::string f);
 		void CreateCubemap(std::vector<std::string> faces);
+		void UploadMipChain(const MipChainView& mips);
 
 		void CreateTextureImageView(uint32_t layers = 1, VkImageViewType t = VK_IMAGE_VIEW_TYPE_2D);
 		void CreateTextureSampler(VkFilter filter = VK_FILTER_LINEAR);
@@ -43,6 +86,9 @@ namespace Tendou
 		VkDeviceMemory textureImageMemory;
 		VkImageView textureImageView;
 		VkSampler textureSampler;
+
+		VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+		uint32_t mipLevels = 1;
 	};
 }
 
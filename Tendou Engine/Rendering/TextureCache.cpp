@@ -0,0 +1,333 @@
+#include "TextureCache.h"
+#include "BlockCompressor.h"
+
+#include "../Core/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <stb_image.h>
+
+namespace Tendou
+{
+	namespace
+	{
+		const char MAGIC[8] = { 'T', 'K', 'T', 'X', '2', '\r', '\n', '\x1A' };
+
+		// Every level starts on a block boundary of the biggest block size
+		constexpr uint64_t LEVEL_ALIGNMENT = 16;
+
+		// Mip levels a 2^31 texture could ever have
+		constexpr uint32_t MAX_LEVELS = 32;
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t levelCount;
+			uint32_t role;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+		};
+
+		// One per level, largest first; offsets are from the start of the file
+		struct LevelIndex
+		{
+			uint64_t offset;
+			uint64_t length;
+		};
+
+		__inline uint64_t Align(uint64_t v)
+		{
+			return (v + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+		}
+
+		// Size and modification time of the source, to tell stale entries apart
+		bool SourceStamp(const std::string& path, uint64_t& size, int64_t& time)
+		{
+			std::error_code ec;
+			size = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+			if (ec)
+			{
+				return false;
+			}
+
+			time = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+			return !ec;
+		}
+
+		// 64-bit FNV-1a, fixed across runs and standard libraries unlike std::hash
+		uint64_t Fnv1a(const std::string& s)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (unsigned char ch : s)
+			{
+				hash ^= ch;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		MipChain CookChain(const std::string& path, TextureRole role, bool compress)
+		{
+			TENDOU_PROFILE_SCOPE("TextureCache::CookChain");
+
+			int width, height, channels;
+			stbi_uc* res = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+			if (!res)
+			{
+				throw std::runtime_error("Failed to load texture image!");
+			}
+
+			size_t texels = static_cast<size_t>(width) * height;
+			bool hasAlpha = false;
+			for (size_t i = 0; i < texels && !hasAlpha; ++i)
+			{
+				hasAlpha = res[i * 4 + 3] != 255;
+			}
+
+			MipChain mips = MipChain::Build(res, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+				role == TextureRole::Color);
+			stbi_image_free(res);
+
+			VkFormat format = TextureCache::CookedFormat(role, hasAlpha, compress);
+			if (BlockCompressor::IsCompressed(format))
+			{
+				return BlockCompressor::Compress(mips, format);
+			}
+
+			// Linear roles stay RGBA8 but must not be sRGB decoded
+			mips.format = format;
+			return mips;
+		}
+
+		bool WriteContainer(const std::string& cachePath, const MipChain& mips, TextureRole role,
+			uint64_t sourceSize, int64_t sourceTime)
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), ec);
+
+			uint32_t levelCount = mips.LevelCount();
+
+			FileHeader header{};
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = TextureCache::VERSION;
+			header.format = static_cast<uint32_t>(mips.format);
+			header.width = mips.width;
+			header.height = mips.height;
+			header.levelCount = levelCount;
+			header.role = static_cast<uint32_t>(role);
+			header.sourceSize = sourceSize;
+			header.sourceTime = sourceTime;
+
+			// Smallest level first, so the low mips sit together at the front
+			std::vector<LevelIndex> index(levelCount);
+			uint64_t cursor = Align(sizeof(FileHeader) + sizeof(LevelIndex) * levelCount);
+			for (uint32_t i = levelCount; i-- > 0;)
+			{
+				VkDeviceSize end = i + 1 < levelCount ? mips.offsets[i + 1] : mips.data.size();
+				index[i].offset = cursor;
+				index[i].length = end - mips.offsets[i];
+				cursor = Align(cursor + index[i].length);
+			}
+
+			// Written aside and renamed, so an interrupted cook never leaves a truncated entry
+			std::string tempPath = cachePath + ".tmp";
+			{
+				std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					return false;
+				}
+
+				file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				file.write(reinterpret_cast<const char*>(index.data()), sizeof(LevelIndex) * levelCount);
+
+				const char padding[LEVEL_ALIGNMENT] = {};
+				for (uint32_t i = levelCount; i-- > 0;)
+				{
+					uint64_t pos = static_cast<uint64_t>(file.tellp());
+					file.write(padding, static_cast<std::streamsize>(index[i].offset - pos));
+					file.write(reinterpret_cast<const char*>(mips.data.data() + mips.offsets[i]),
+						static_cast<std::streamsize>(index[i].length));
+				}
+
+				if (!file.good())
+				{
+					return false;
+				}
+			}
+
+			std::filesystem::rename(tempPath, cachePath, ec);
+			return !ec;
+		}
+
+		// Validates a mapped container and points view at its levels
+		bool ReadContainer(const MappedFile& file, TextureRole role, bool checkSource,
+			uint64_t sourceSize, int64_t sourceTime, MipChainView& view)
+		{
+			if (file.Size() < sizeof(FileHeader))
+			{
+				return false;
+			}
+
+			FileHeader header;
+			std::memcpy(&header, file.Data(), sizeof(header));
+
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+				header.version != TextureCache::VERSION ||
+				header.role != static_cast<uint32_t>(role) ||
+				header.levelCount == 0 || header.levelCount > MAX_LEVELS)
+			{
+				return false;
+			}
+
+			if (checkSource && (header.sourceSize != sourceSize || header.sourceTime != sourceTime))
+			{
+				return false;
+			}
+
+			uint64_t indexEnd = sizeof(FileHeader) + sizeof(LevelIndex) * header.levelCount;
+			if (file.Size() < indexEnd)
+			{
+				return false;
+			}
+
+			std::vector<LevelIndex> index(header.levelCount);
+			std::memcpy(index.data(), file.Data() + sizeof(FileHeader), sizeof(LevelIndex) * header.levelCount);
+
+			VkFormat format = static_cast<VkFormat>(header.format);
+			uint64_t dataStart = ~0ull;
+			for (uint32_t i = 0; i < header.levelCount; ++i)
+			{
+				uint64_t expected = BlockCompressor::LevelSize(format,
+					std::max(header.width >> i, 1u), std::max(header.height >> i, 1u));
+
+				if (index[i].length != expected || index[i].offset < indexEnd ||
+					index[i].offset + index[i].length > file.Size())
+				{
+					return false;
+				}
+				dataStart = std::min(dataStart, index[i].offset);
+			}
+
+			view.width = header.width;
+			view.height = header.height;
+			view.format = format;
+			view.data = file.Data() + dataStart;
+			view.size = file.Size() - dataStart;
+			view.offsets.resize(header.levelCount);
+			for (uint32_t i = 0; i < header.levelCount; ++i)
+			{
+				view.offsets[i] = index[i].offset - dataStart;
+			}
+
+			return true;
+		}
+	}
+
+	std::unique_ptr<Texture> TextureCache::Load(TendouDevice& device, const std::string& path, TextureRole role)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		bool compress = device.SupportsBCCompression();
+
+		{
+			MappedFile file;
+			MipChainView view;
+			if (Open(path, role, compress, file, view))
+			{
+				return std::make_unique<Texture>(device, view);
+			}
+		}
+
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		SourceStamp(path, sourceSize, sourceTime);
+
+		MipChain mips = CookChain(path, role, compress);
+
+		// A failed write only costs the next run another cook
+		WriteContainer(CachePath(path, role, compress), mips, role, sourceSize, sourceTime);
+
+		return std::make_unique<Texture>(device, mips);
+	}
+
+	bool TextureCache::Open(const std::string& path, TextureRole role, bool compress,
+		MappedFile& file, MipChainView& view)
+	{
+		// Without the source around (shipped cooked only) any valid entry will do
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		bool hasSource = SourceStamp(path, sourceSize, sourceTime);
+
+		if (!file.Open(CachePath(path, role, compress)))
+		{
+			return false;
+		}
+
+		if (!ReadContainer(file, role, hasSource, sourceSize, sourceTime, view))
+		{
+			file.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TextureCache::Cook(const std::string& path, TextureRole role, bool compress)
+	{
+		uint64_t sourceSize = 0;
+		int64_t sourceTime = 0;
+		if (!SourceStamp(path, sourceSize, sourceTime))
+		{
+			return false;
+		}
+
+		MipChain mips = CookChain(path, role, compress);
+		return WriteContainer(CachePath(path, role, compress), mips, role, sourceSize, sourceTime);
+	}
+
+	VkFormat TextureCache::CookedFormat(TextureRole role, bool hasAlpha, bool compress)
+	{
+		switch (role)
+		{
+		case TextureRole::Color:
+			if (!compress)
+			{
+				return VK_FORMAT_R8G8B8A8_SRGB;
+			}
+			return hasAlpha ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		case TextureRole::Normal:
+			return compress ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+		case TextureRole::ORM:
+			return compress ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+		case TextureRole::Mask:
+			return compress ? VK_FORMAT_BC4_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+		default:
+			return VK_FORMAT_R8G8B8A8_SRGB;
+		}
+	}
+
+	std::string TextureCache::CachePath(const std::string& path, TextureRole role, bool compress)
+	{
+		static const char* roleNames[] = { "color", "normal", "orm", "mask" };
+
+		// Stem keeps the cache browsable, the hash keeps same-named files apart.
+		// The normalized path is hashed so "a/./b.png" and "a/b.png" share an entry
+		std::filesystem::path normalized = std::filesystem::path(path).lexically_normal();
+		std::ostringstream name;
+		name << DIRECTORY << "/" << normalized.stem().string()
+			<< "_" << std::hex << Fnv1a(normalized.generic_string()) << std::dec
+			<< "_" << roleNames[static_cast<uint32_t>(role)]
+			<< (compress ? "_bc" : "_rgba8") << ".tktx";
+		return name.str();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include "Texture.h"
+
+#include "../Core/MappedFile.h"
+
+#include <memory>
+#include <string>
+
+namespace Tendou
+{
+	// What a texture holds decides its mip filter and compressed format
+	enum class TextureRole : uint32_t
+	{
+		Color,	// sRGB albedo/emissive, BC1 (opaque) or BC7 (with alpha)
+		Normal,	// tangent space normals, BC5 - only XY survives, rebuild Z in the shader
+		ORM,	// occlusion/roughness/metallic or any other linear data, BC7
+		Mask,	// single channel, BC4
+	};
+
+	// First-run texture cooker. Source images are decoded once, mipped,
+	// block compressed for their role and written to a KTX2-style container
+	// (level index up front, smallest level first). Later runs map the
+	// container and copy the levels straight into the staging buffer.
+	class TextureCache
+	{
+	public:
+		// Bump whenever the encoders or the file layout change
+		static constexpr uint32_t VERSION = 1;
+
+		static constexpr const char* DIRECTORY = "Cache/Textures";
+
+		// Loads the cooked texture for path, cooking it first if there
+		// is no up to date cache entry. Falls back to uncompressed RGBA8
+		// mips when the device can't sample BCn.
+		static std::unique_ptr<Texture> Load(TendouDevice& device, const std::string& path,
+			TextureRole role = TextureRole::Color);
+
+		// Cooks into the cache without a device, for doing it ahead of time
+		static bool Cook(const std::string& path, TextureRole role, bool compress = true);
+
+		// Maps the up to date entry for path and points view at its levels.
+		// view stays valid for as long as file is open. False if there is none.
+		static bool Open(const std::string& path, TextureRole role, bool compress,
+			MappedFile& file, MipChainView& view);
+
+		static VkFormat CookedFormat(TextureRole role, bool hasAlpha, bool compress);
+		static std::string CachePath(const std::string& path, TextureRole role, bool compress);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "TextureStreamer.h"
+#include "BlockCompressor.h"
+
+#include "../Core/Profiler.h"
+#include "../Vulkan/SwapChain.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tendou
+{
+	namespace
+	{
+		constexpr size_t PAGE_SIZE = 4096;
+	}
+
+	TextureStreamer::TextureStreamer(TendouDevice& d, const TextureStreamerConfig& c)
+		: device(d)
+		, config(c)
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		// Reads point into the mapped files
+		for (auto& e : entries)
+		{
+			JobSystem::Wait(e->reads);
+		}
+	}
+
+	TextureStreamer::Handle TextureStreamer::Register(const std::string& path, TextureRole role)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		auto e = std::make_unique<Entry>();
+		bool compress = device.SupportsBCCompression();
+
+		if (!TextureCache::Open(path, role, compress, e->file, e->levels))
+		{
+			// Cook it now; if the cache isn't writable the texture just doesn't stream
+			TextureCache::Cook(path, role, compress);
+			if (!TextureCache::Open(path, role, compress, e->file, e->levels))
+			{
+				e->base = TextureCache::Load(device, path, role);
+				e->baseLevel = 0;
+				e->residentLevel = 0;
+				entries.push_back(std::move(e));
+				return static_cast<Handle>(entries.size() - 1);
+			}
+		}
+
+		uint32_t levelCount = static_cast<uint32_t>(e->levels.offsets.size());
+
+		e->baseLevel = levelCount - 1;
+		while (e->baseLevel > 0 &&
+			std::max(e->levels.width >> (e->baseLevel - 1), e->levels.height >> (e->baseLevel - 1)) <= config.baseSize)
+		{
+			--e->baseLevel;
+		}
+
+		e->residentLevel = e->baseLevel;
+		e->base = std::make_unique<Texture>(device, SubChain(*e, e->baseLevel));
+		e->baseBytes = LevelBytes(*e, e->baseLevel, levelCount);
+		residentBytes += e->baseBytes;
+
+		entries.push_back(std::move(e));
+		return static_cast<Handle>(entries.size() - 1);
+	}
+
+	void TextureStreamer::Request(Handle h, float screenPixels)
+	{
+		Entry& e = *entries[h];
+		e.requestedPixels = std::max(e.requestedPixels, screenPixels);
+	}
+
+	Texture& TextureStreamer::Get(Handle h)
+	{
+		Entry& e = *entries[h];
+		return e.streamed ? *e.streamed : *e.base;
+	}
+
+	VkDeviceSize TextureStreamer::LevelBytes(const Entry& e, uint32_t first, uint32_t last) const
+	{
+		VkDeviceSize bytes = 0;
+		for (uint32_t i = first; i < last; ++i)
+		{
+			bytes += BlockCompressor::LevelSize(e.levels.format,
+				std::max(e.levels.width >> i, 1u), std::max(e.levels.height >> i, 1u));
+		}
+		return bytes;
+	}
+
+	MipChainView TextureStreamer::SubChain(const Entry& e, uint32_t first) const
+	{
+		MipChainView view;
+		view.width = std::max(e.levels.width >> first, 1u);
+		view.height = std::max(e.levels.height >> first, 1u);
+		view.format = e.levels.format;
+		view.data = e.levels.data;
+		view.size = e.levels.offsets[first] + LevelBytes(e, first, first + 1);
+		view.offsets.assign(e.levels.offsets.begin() + first, e.levels.offsets.end());
+		return view;
+	}
+
+	uint32_t TextureStreamer::WantedLevel(const Entry& e) const
+	{
+		if (e.requestedPixels <= 0.0f)
+		{
+			return e.baseLevel;
+		}
+
+		// One texel per pixel: every halving of the on-screen size drops a level
+		float size = static_cast<float>(std::max(e.levels.width, e.levels.height));
+		float level = std::floor(std::log2(std::max(size / e.requestedPixels, 1.0f)));
+		return std::min(static_cast<uint32_t>(level), e.baseLevel);
+	}
+
+	void TextureStreamer::Retire(std::unique_ptr<Texture> texture)
+	{
+		if (texture)
+		{
+			retired.push_back({ std::move(texture), frame });
+		}
+	}
+
+	void TextureStreamer::Evict(Entry& e)
+	{
+		residentBytes -= e.streamedBytes;
+		e.streamedBytes = 0;
+		e.residentLevel = e.baseLevel;
+		Retire(std::move(e.streamed));
+		++e.version;
+		++evictionsLastFrame;
+	}
+
+	bool TextureStreamer::MakeRoom(VkDeviceSize bytes, const Entry* keep)
+	{
+		while (residentBytes + bytes > config.budgetBytes)
+		{
+			// Least recently used texture that wasn't asked for this frame
+			Entry* victim = nullptr;
+			for (auto& e : entries)
+			{
+				if (e.get() == keep || !e->streamed || e->loading || e->lastUsed == frame)
+				{
+					continue;
+				}
+				if (!victim || e->lastUsed < victim->lastUsed)
+				{
+					victim = e.get();
+				}
+			}
+
+			if (!victim)
+			{
+				return false;
+			}
+
+			Evict(*victim);
+		}
+		return true;
+	}
+
+	void TextureStreamer::Update()
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		++frame;
+		uploadsLastFrame = 0;
+		evictionsLastFrame = 0;
+
+		// Old images may still be bound by frames in flight
+		while (!retired.empty() && retired.front().frame + SwapChain::MAX_FRAMES_IN_FLIGHT < frame)
+		{
+			retired.pop_front();
+		}
+
+		// Finished reads become GPU textures
+		for (auto& ptr : entries)
+		{
+			Entry& e = *ptr;
+			if (!e.loading || !e.reads.IsDone() || uploadsLastFrame >= config.maxUploadsPerFrame)
+			{
+				continue;
+			}
+
+			Retire(std::move(e.streamed));
+			e.streamed = std::make_unique<Texture>(device, SubChain(e, e.loadingLevel));
+			e.residentLevel = e.loadingLevel;
+			e.loading = false;
+			++e.version;
+			++uploadsLastFrame;
+		}
+
+		// The budget may have been lowered since
+		MakeRoom(0, nullptr);
+
+		// Most starved textures go first
+		std::vector<Entry*> wanted;
+		for (auto& ptr : entries)
+		{
+			Entry& e = *ptr;
+			if (e.requestedPixels > 0.0f)
+			{
+				e.lastUsed = frame;
+			}
+
+			uint32_t level = WantedLevel(e);
+			e.requestedPixels = 0.0f;
+
+			if (!e.loading && e.file.IsOpen() && level < e.residentLevel)
+			{
+				e.loadingLevel = level;
+				wanted.push_back(&e);
+			}
+		}
+
+		std::sort(wanted.begin(), wanted.end(), [](const Entry* a, const Entry* b)
+			{
+				return a->residentLevel - a->loadingLevel > b->residentLevel - b->loadingLevel;
+			});
+
+		for (Entry* e : wanted)
+		{
+			VkDeviceSize bytes = LevelBytes(*e, e->loadingLevel, e->baseLevel);
+			VkDeviceSize extra = bytes - e->streamedBytes;
+
+			if (!MakeRoom(extra, e))
+			{
+				continue;
+			}
+
+			// Reserved now so reads in flight count against the budget
+			residentBytes += extra;
+			e->streamedBytes = bytes;
+			e->loading = true;
+
+			// Page the new levels in off the main thread, the upload is then a plain memcpy
+			const uint8_t* begin = e->levels.data + e->levels.offsets[e->baseLevel - 1];
+			const uint8_t* end = e->levels.data + e->levels.offsets[e->loadingLevel] + LevelBytes(*e, e->loadingLevel, e->loadingLevel + 1);
+			JobSystem::Run([begin, end]()
+				{
+					volatile uint8_t sink = 0;
+					for (const uint8_t* p = begin; p < end; p += PAGE_SIZE)
+					{
+						sink += *p;
+					}
+				}, &e->reads, "TextureStream");
+		}
+	}
+
+	void TextureStreamer::DrawStats()
+	{
+		uint32_t streaming = 0;
+		for (auto& e : entries)
+		{
+			streaming += e->loading ? 1 : 0;
+		}
+
+		ImGui::Text("Textures: %zu (%u loading)", entries.size(), streaming);
+		ImGui::Text("Resident: %.1f / %.1f MB", residentBytes / (1024.0 * 1024.0), config.budgetBytes / (1024.0 * 1024.0));
+		ImGui::Text("Uploads: %u  Evictions: %u", uploadsLastFrame, evictionsLastFrame);
+
+		int budgetMB = static_cast<int>(config.budgetBytes >> 20);
+		if (ImGui::SliderInt("Budget (MB)", &budgetMB, 16, 2048))
+		{
+			config.budgetBytes = static_cast<VkDeviceSize>(budgetMB) << 20;
+		}
+	}
+}
\ No newline at end of file
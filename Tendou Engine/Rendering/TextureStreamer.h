@@ -0,0 +1,124 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include "TextureCache.h"
+
+#include "../Core/JobSystem.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tendou
+{
+	struct TextureStreamerConfig
+	{
+		// Streamed levels are evicted least recently used first to stay under this
+		VkDeviceSize budgetBytes = 256ull << 20;
+
+		// Levels this size and smaller are loaded up front and never evicted
+		uint32_t baseSize = 64;
+
+		// Finished reads turned into GPU textures per frame; each is a blocking copy
+		uint32_t maxUploadsPerFrame = 2;
+	};
+
+	// Keeps cooked textures resident at the detail they're actually seen at.
+	// Every texture starts with only its small tail levels. Scenes report how
+	// many pixels each one covers on screen, and the missing levels are paged
+	// in from the mapped cache file on the job system, then uploaded as a new
+	// image. Users rebind whenever Version() changes; the image they replace
+	// is destroyed once no frame in flight can still reference it.
+	class TextureStreamer
+	{
+	public:
+		using Handle = uint32_t;
+
+		TextureStreamer(TendouDevice& device, const TextureStreamerConfig& config = TextureStreamerConfig());
+		~TextureStreamer();
+
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// Cooks path if needed and loads its base levels
+		Handle Register(const std::string& path, TextureRole role = TextureRole::Color);
+
+		// Asks for enough detail to cover screenPixels pixels across on screen.
+		// The largest request since the last Update wins.
+		void Request(Handle h, float screenPixels);
+
+		// Retires, evicts, starts reads for new requests and uploads finished ones.
+		// Call once per frame, outside of command buffer recording.
+		void Update();
+
+		Texture& Get(Handle h);
+		__inline uint32_t Version(Handle h) const { return entries[h]->version; }
+
+		// Finest level currently on the GPU
+		__inline uint32_t ResidentLevel(Handle h) const { return entries[h]->residentLevel; }
+
+		__inline VkDeviceSize ResidentBytes() const { return residentBytes; }
+		__inline VkDeviceSize GetBudget() const { return config.budgetBytes; }
+		__inline void SetBudget(VkDeviceSize bytes) { config.budgetBytes = bytes; }
+		__inline size_t Count() const { return entries.size(); }
+
+		void DrawStats();
+
+	private:
+		struct Entry
+		{
+			MappedFile file;
+			MipChainView levels;
+
+			// Tail levels, always resident; also the fallback when nothing is cached
+			std::unique_ptr<Texture> base;
+			std::unique_ptr<Texture> streamed;
+
+			uint32_t baseLevel = 0;
+			uint32_t residentLevel = 0;
+			uint32_t loadingLevel = 0;
+			bool loading = false;
+
+			VkDeviceSize baseBytes = 0;
+			VkDeviceSize streamedBytes = 0;
+
+			float requestedPixels = 0.0f;
+			uint64_t lastUsed = 0;
+			uint32_t version = 0;
+
+			JobCounter reads;
+		};
+
+		struct Retired
+		{
+			std::unique_ptr<Texture> texture;
+			uint64_t frame;
+		};
+
+		// Bytes of levels [first, last) of e
+		VkDeviceSize LevelBytes(const Entry& e, uint32_t first, uint32_t last) const;
+
+		// Levels [first, end) as one upload; they're contiguous since files store smallest first
+		MipChainView SubChain(const Entry& e, uint32_t first) const;
+
+		uint32_t WantedLevel(const Entry& e) const;
+		bool MakeRoom(VkDeviceSize bytes, const Entry* keep);
+		void Evict(Entry& e);
+		void Retire(std::unique_ptr<Texture> texture);
+
+		TendouDevice& device;
+		TextureStreamerConfig config;
+
+		std::vector<std::unique_ptr<Entry>> entries;
+		std::deque<Retired> retired;
+
+		VkDeviceSize residentBytes = 0;
+		uint64_t frame = 0;
+
+		uint32_t uploadsLastFrame = 0;
+		uint32_t evictionsLastFrame = 0;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -13,11 +13,12 @@ namespace Tendou
 		glm::vec2 nearFar = glm::vec2(0.0f);
 	};
 
-	class RenderUBO
+	// One view per cubemap face, indexed by gl_ViewIndex in capture passes
+	class CaptureUBO
 	{
 	public:
 		glm::mat4 proj = glm::mat4(1.0f);
-		glm::mat4* view = nullptr;
+		glm::mat4 views[6] = {};
 	};
 
 	class LightsUBO
@@ -92,7 +93,7 @@ namespace Tendou
 				return sizeof(LightsUBO);
 				break;
 			case Type::CAPTURE:
-				return sizeof(glm::mat4) * 2;
+				return sizeof(CaptureUBO);
 				break;
 			case Type::LIGHTPASS:
 				return sizeof(LightPassUBO);
@@ -0,0 +1,50 @@
+#include "../../Core/MicroBench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// Same options as the engine's --microbench
+//   --filter str          only cases whose name contains str
+//   --save out.json       write the results
+//   --baseline in.json    compare against saved results, exit code 1 on a regression
+//   --tolerance 0.1       slowdown allowed before a case counts as regressed
+int main(int argc, char** argv)
+{
+	Tendou::MicroBenchConfig config{};
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			config.filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+		{
+			config.outputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+		{
+			config.baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+		{
+			config.tolerance = strtod(argv[++i], nullptr);
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	try
+	{
+		return Tendou::MicroBench::Run(config);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef HASHER_H
 #define HASHER_H
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace Tendou
@@ -12,6 +14,46 @@ namespace Tendou
 		seed ^= std::hash<T>{}(v)+0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(HashCombine(seed, rest), ...);
 	};
+
+	// MurmurHash64A over raw bytes, for keys that are compared bytewise anyway
+	inline uint64_t Hash64(const void* key, size_t size, uint64_t seed = 0)
+	{
+		const uint64_t m = 0xc6a4a7935bd1e995ull;
+		const int r = 47;
+
+		uint64_t h = seed ^ (size * m);
+
+		const uint8_t* data = static_cast<const uint8_t*>(key);
+		const uint8_t* end = data + (size & ~size_t(7));
+
+		for (; data != end; data += 8)
+		{
+			uint64_t k;
+			memcpy(&k, data, sizeof(k));
+
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+
+			h ^= k;
+			h *= m;
+		}
+
+		size_t tail = size & 7;
+		if (tail)
+		{
+			uint64_t k = 0;
+			memcpy(&k, data, tail);
+			h ^= k;
+			h *= m;
+		}
+
+		h ^= h >> r;
+		h *= m;
+		h ^= h >> r;
+
+		return h;
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef VERTEXWELDER_H
+#define VERTEXWELDER_H
+
+#include "Hasher.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace Tendou
+{
+	// Deduplicates vertices into an index buffer. Open addressing with linear
+	// probing over a power of two table; vertices are hashed and compared as
+	// raw bytes, so T must not have padding (and -0.0 and 0.0 stay distinct).
+	template <typename T>
+	class VertexWelder
+	{
+	public:
+		static_assert(std::is_trivially_copyable<T>::value, "Welded vertices are compared bytewise!");
+
+		VertexWelder(std::vector<T>& vertices_, size_t expected = 0)
+			: vertices(vertices_)
+		{
+			Rehash(expected);
+		}
+
+		// Index of v in the vertex list, appending it if it's new
+		uint32_t Weld(const T& v)
+		{
+			if ((vertices.size() + 1) * 10 > slots.size() * 7)
+			{
+				Rehash(slots.size());
+			}
+
+			uint64_t h = Hash64(&v, sizeof(T));
+			uint32_t tag = static_cast<uint32_t>(h >> 32);
+			size_t mask = slots.size() - 1;
+
+			for (size_t i = static_cast<size_t>(h) & mask;; i = (i + 1) & mask)
+			{
+				Slot& s = slots[i];
+				if (s.index == EMPTY)
+				{
+					s.index = static_cast<uint32_t>(vertices.size());
+					s.tag = tag;
+					vertices.push_back(v);
+					return s.index;
+				}
+
+				if (s.tag == tag && memcmp(&vertices[s.index], &v, sizeof(T)) == 0)
+				{
+					return s.index;
+				}
+			}
+		}
+
+	private:
+		static constexpr uint32_t EMPTY = ~0u;
+
+		struct Slot
+		{
+			uint32_t index = EMPTY;
+
+			// Upper hash bits, so most mismatches skip the vertex compare
+			uint32_t tag = 0;
+		};
+
+		void Rehash(size_t expected)
+		{
+			size_t size = 64;
+			while (size * 7 < expected * 10 + 10)
+			{
+				size *= 2;
+			}
+
+			slots.assign(size, Slot{});
+			size_t mask = size - 1;
+
+			for (uint32_t idx = 0; idx < vertices.size(); ++idx)
+			{
+				uint64_t h = Hash64(&vertices[idx], sizeof(T));
+
+				size_t i = static_cast<size_t>(h) & mask;
+				while (slots[i].index != EMPTY)
+				{
+					i = (i + 1) & mask;
+				}
+				slots[i].index = idx;
+				slots[i].tag = static_cast<uint32_t>(h >> 32);
+			}
+		}
+
+		std::vector<T>& vertices;
+		std::vector<Slot> slots;
+	};
+}
+
+#endif
\ No newline at end of file
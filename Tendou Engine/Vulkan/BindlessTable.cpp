@@ -0,0 +1,136 @@
+#include "BindlessTable.h"
+
+#include "SwapChain.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Tendou
+{
+	BindlessTable::BindlessTable(TendouDevice& device_, uint32_t maxTextures)
+		: device(device_)
+	{
+		assert(device.SupportsBindless() && "Descriptor indexing is not enabled!");
+
+		// The update-after-bind limits are at least as large as these
+		const VkPhysicalDeviceLimits& limits = device.properties.limits;
+		capacity = std::min({ maxTextures, limits.maxPerStageDescriptorSamplers,
+			limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSamplers,
+			limits.maxDescriptorSetSampledImages });
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = capacity;
+		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// Unused slots may hold anything, and slots nobody samples can change mid-frame
+		VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = 1;
+		flagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &flagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		if (vkCreateDescriptorSetLayout(device.Device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create bindless descriptor set layout!");
+		}
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = capacity;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+
+		if (vkCreateDescriptorPool(device.Device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create bindless descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		if (vkAllocateDescriptorSets(device.Device(), &allocInfo, &set) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate bindless descriptor set!");
+		}
+
+		// Hand out low slots first
+		freeSlots.reserve(capacity);
+		for (uint32_t i = capacity; i > 0; --i)
+		{
+			freeSlots.push_back(i - 1);
+		}
+	}
+
+	BindlessTable::~BindlessTable()
+	{
+		vkDestroyDescriptorPool(device.Device(), pool, nullptr);
+		vkDestroyDescriptorSetLayout(device.Device(), layout, nullptr);
+	}
+
+	uint32_t BindlessTable::Add(const VkDescriptorImageInfo& image)
+	{
+		if (freeSlots.empty())
+		{
+			return INVALID_SLOT;
+		}
+
+		uint32_t slot = freeSlots.back();
+		freeSlots.pop_back();
+		Update(slot, image);
+		return slot;
+	}
+
+	void BindlessTable::Update(uint32_t slot, const VkDescriptorImageInfo& image)
+	{
+		assert(slot < capacity && "Bindless slot out of range!");
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = set;
+		write.dstBinding = 0;
+		write.dstArrayElement = slot;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1;
+		write.pImageInfo = &image;
+
+		vkUpdateDescriptorSets(device.Device(), 1, &write, 0, nullptr);
+	}
+
+	void BindlessTable::Release(uint32_t slot)
+	{
+		if (slot != INVALID_SLOT)
+		{
+			released.push_back({ slot, frameCount });
+		}
+	}
+
+	void BindlessTable::NextFrame()
+	{
+		++frameCount;
+		while (!released.empty() && released.front().frame + SwapChain::MAX_FRAMES_IN_FLIGHT < frameCount)
+		{
+			freeSlots.push_back(released.front().slot);
+			released.pop_front();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef BINDLESSTABLE_H
+#define BINDLESSTABLE_H
+
+#include "TendouDevice.h"
+
+#include <deque>
+#include <vector>
+
+namespace Tendou
+{
+	// One descriptor set holding a large, partially bound array of combined
+	// image samplers at binding 0. Textures take a slot and shaders index the
+	// array with it, so swapping a texture is a single descriptor write instead
+	// of a new set. Needs TendouDevice::SupportsBindless().
+	class BindlessTable
+	{
+	public:
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		static constexpr uint32_t INVALID_SLOT = ~0u;
+
+		BindlessTable(TendouDevice& device, uint32_t maxTextures = MAX_TEXTURES);
+		~BindlessTable();
+
+		BindlessTable(const BindlessTable&) = delete;
+		BindlessTable& operator=(const BindlessTable&) = delete;
+
+		// Writes image into a free slot; INVALID_SLOT when the table is full
+		uint32_t Add(const VkDescriptorImageInfo& image);
+
+		// Overwrites a slot in place. Only safe while no frame in flight samples it.
+		void Update(uint32_t slot, const VkDescriptorImageInfo& image);
+
+		// The slot is reused once every frame that could still sample it has finished
+		void Release(uint32_t slot);
+
+		// Call once per frame, recycles slots released long enough ago
+		void NextFrame();
+
+		__inline VkDescriptorSetLayout GetLayout() const { return layout; }
+		__inline VkDescriptorSet GetSet() const { return set; }
+		__inline uint32_t Capacity() const { return capacity; }
+		__inline uint32_t Count() const { return capacity - static_cast<uint32_t>(freeSlots.size() + released.size()); }
+
+	private:
+		struct ReleasedSlot
+		{
+			uint32_t slot;
+			uint64_t frame;
+		};
+
+		TendouDevice& device;
+
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		uint32_t capacity = 0;
+
+		std::vector<uint32_t> freeSlots;
+		std::deque<ReleasedSlot> released;
+		uint64_t frameCount = 0;
+	};
+}
+
+#endif
\ No newline at end of file
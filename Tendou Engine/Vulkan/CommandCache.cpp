@@ -0,0 +1,221 @@
+#include "CommandCache.h"
+
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+#include "../Rendering/RenderStats.h"
+#include "../Utilities/Hasher.hpp"
+
+#include "imgui.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace Tendou
+{
+	CommandCache::CommandCache(TendouDevice& device_, uint32_t framesInFlight_, uint32_t threadCount_)
+		: device(device_)
+		, framesInFlight(framesInFlight_)
+		, threadCount(threadCount_)
+	{
+		assert(threadCount > 0 && "Need at least one thread to record on!");
+
+		QueueFamilyIndices indices = device.FindPhysicalQueueFamilies();
+
+		// Buffers are freed one by one when their pass changes, never reset
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = indices.graphicsFamily;
+		poolInfo.flags = 0;
+
+		pools.resize(framesInFlight * threadCount, VK_NULL_HANDLE);
+		for (auto& p : pools)
+		{
+			if (vkCreateCommandPool(device.Device(), &poolInfo, nullptr, &p) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create command cache pool!");
+			}
+		}
+	}
+
+	CommandCache::~CommandCache()
+	{
+		// Destroying the pool frees its buffers
+		for (auto& p : pools)
+		{
+			vkDestroyCommandPool(device.Device(), p, nullptr);
+		}
+	}
+
+	void CommandCache::Execute(const SecondaryContext& ctx, VkCommandBuffer primary, const char* name, uint64_t hash,
+		uint32_t drawCount, const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record,
+		uint32_t minBatch)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		assert(ctx.frameIdx < framesInFlight && "Frame slot out of range!");
+
+		// The same system may draw into several passes, each gets its own entry
+		uint64_t key = Hash64(name, strlen(name), reinterpret_cast<uint64_t>(ctx.renderPass));
+
+		Entry& entry = entries[key];
+		if (entry.slots.empty())
+		{
+			entry.name = name;
+			entry.slots.resize(framesInFlight);
+		}
+
+		// Viewport and scissor are recorded into the secondaries too
+		size_t seed = static_cast<size_t>(hash);
+		HashCombine(seed, ctx.extent.width, ctx.extent.height, drawCount);
+
+		Slot& slot = entry.slots[ctx.frameIdx];
+		if (slot.valid && slot.hash == seed)
+		{
+			++entry.hits;
+
+			if (!slot.order.empty())
+			{
+				vkCmdExecuteCommands(primary, static_cast<uint32_t>(slot.order.size()), slot.order.data());
+			}
+
+			RenderStats::drawCalls.fetch_add(slot.drawCalls, std::memory_order_relaxed);
+			RenderStats::triangles.fetch_add(slot.triangles, std::memory_order_relaxed);
+			return;
+		}
+
+		++entry.misses;
+
+		// This frame slot's fence has signalled, nothing still reads the old buffers
+		FreeSlot(slot);
+
+		uint32_t drawsBefore = RenderStats::drawCalls.load(std::memory_order_relaxed);
+		uint64_t trianglesBefore = RenderStats::triangles.load(std::memory_order_relaxed);
+
+		slot.order = ctx.RecordBatches(drawCount, record, minBatch,
+			[&]()
+			{
+				// Threads outside the job system record on the main thread's pool
+				uint32_t threadIdx = JobSystem::ThreadIndex();
+				if (threadIdx >= threadCount)
+				{
+					threadIdx = 0;
+				}
+				uint32_t poolIdx = ctx.frameIdx * threadCount + threadIdx;
+
+				VkCommandBufferAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandPool = pools[poolIdx];
+				allocInfo.commandBufferCount = 1;
+
+				VkCommandBuffer buf;
+				if (vkAllocateCommandBuffers(device.Device(), &allocInfo, &buf) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to allocate cached secondary command buffer!");
+				}
+
+				std::lock_guard<std::mutex> guard(lock);
+				slot.buffers.emplace_back(buf, poolIdx);
+				return buf;
+			}, 0, false);
+
+		slot.drawCalls = RenderStats::drawCalls.load(std::memory_order_relaxed) - drawsBefore;
+		slot.triangles = RenderStats::triangles.load(std::memory_order_relaxed) - trianglesBefore;
+		slot.hash = seed;
+		slot.valid = true;
+
+		if (!slot.order.empty())
+		{
+			vkCmdExecuteCommands(primary, static_cast<uint32_t>(slot.order.size()), slot.order.data());
+		}
+	}
+
+	void CommandCache::FreeSlot(Slot& slot)
+	{
+		for (const auto& b : slot.buffers)
+		{
+			vkFreeCommandBuffers(device.Device(), pools[b.second], 1, &b.first);
+		}
+
+		slot.buffers.clear();
+		slot.order.clear();
+		slot.valid = false;
+	}
+
+	void CommandCache::Clear()
+	{
+		for (auto& kv : entries)
+		{
+			for (Slot& slot : kv.second.slots)
+			{
+				FreeSlot(slot);
+			}
+		}
+	}
+
+	void CommandCache::SetEnabled(bool enable)
+	{
+		if (enable && !enabled)
+		{
+			// Inputs weren't tracked while disabled, so nothing cached is trustworthy
+			vkDeviceWaitIdle(device.Device());
+			Clear();
+		}
+		enabled = enable;
+	}
+
+	void CommandCache::DrawPanel(bool* open)
+	{
+		if (!ImGui::Begin("Command Cache", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		bool enable = enabled;
+		if (ImGui::Checkbox("Reuse recorded passes", &enable))
+		{
+			SetEnabled(enable);
+		}
+
+		uint64_t totalHits = 0;
+		uint64_t totalMisses = 0;
+		for (const auto& kv : entries)
+		{
+			totalHits += kv.second.hits;
+			totalMisses += kv.second.misses;
+		}
+
+		uint64_t total = totalHits + totalMisses;
+		ImGui::Text("Hit rate: %.1f%% (%llu / %llu)", total > 0 ? 100.0 * totalHits / total : 0.0,
+			static_cast<unsigned long long>(totalHits), static_cast<unsigned long long>(total));
+
+		ImGui::Separator();
+		for (const auto& kv : entries)
+		{
+			const Entry& e = kv.second;
+			uint64_t n = e.hits + e.misses;
+
+			size_t secondaries = 0;
+			for (const Slot& slot : e.slots)
+			{
+				secondaries += slot.order.size();
+			}
+
+			ImGui::Text("%-20s %6.1f%% hits, %zu secondaries", e.name.c_str(),
+				n > 0 ? 100.0 * e.hits / n : 0.0, secondaries);
+		}
+
+		if (ImGui::Button("Reset counters"))
+		{
+			for (auto& kv : entries)
+			{
+				kv.second.hits = 0;
+				kv.second.misses = 0;
+			}
+		}
+
+		ImGui::End();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef COMMANDCACHE_H
+#define COMMANDCACHE_H
+
+#include "CommandPools.h"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Tendou
+{
+	// Keeps the secondaries of passes recorded through SecondaryContext::RecordCached
+	// and executes them again while the hash of their inputs stays the same.
+	// Every frame in flight has its own copy, so one is only re-recorded once
+	// the GPU is done with it, and dynamic offsets that differ per frame slot
+	// still hit. Anything that changes every frame (camera, lights, streamed
+	// texture slots) has to come from buffers the commands only point at.
+	//
+	// Cached secondaries don't inherit a framebuffer, so they replay into any
+	// framebuffer of the render pass they were recorded for.
+	class CommandCache
+	{
+	public:
+		CommandCache(TendouDevice& device, uint32_t framesInFlight, uint32_t threadCount);
+		~CommandCache();
+
+		CommandCache(const CommandCache&) = delete;
+		CommandCache& operator=(const CommandCache&) = delete;
+
+		void Execute(const SecondaryContext& ctx, VkCommandBuffer primary, const char* name, uint64_t hash,
+			uint32_t drawCount, const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record,
+			uint32_t minBatch);
+
+		// Drops every cached secondary. The GPU must be done with all of them.
+		void Clear();
+
+		__inline bool IsEnabled() const { return enabled; }
+		void SetEnabled(bool enable);
+
+		void DrawPanel(bool* open);
+
+	private:
+		struct Slot
+		{
+			uint64_t hash = 0;
+			bool valid = false;
+
+			// Pool index alongside each buffer, they're freed back to it
+			std::vector<std::pair<VkCommandBuffer, uint32_t>> buffers;
+			std::vector<VkCommandBuffer> order;
+
+			// What recording counted in RenderStats, replayed on hits
+			uint32_t drawCalls = 0;
+			uint64_t triangles = 0;
+		};
+
+		struct Entry
+		{
+			std::string name;
+			std::vector<Slot> slots;
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+		};
+
+		void FreeSlot(Slot& slot);
+
+		TendouDevice& device;
+		uint32_t framesInFlight;
+		uint32_t threadCount;
+
+		// One per (frame in flight, thread), recording never shares a pool between threads
+		std::vector<VkCommandPool> pools;
+
+		std::unordered_map<uint64_t, Entry> entries;
+		bool enabled = true;
+
+		std::mutex lock;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "CommandPools.h"
+
+#include "CommandCache.h"
+
+#include "../Core/JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Tendou
+{
+	ThreadCommandPools::ThreadCommandPools(TendouDevice& device_, uint32_t framesInFlight, uint32_t threadCount_)
+		: device(device_)
+		, threadCount(threadCount_)
+	{
+		assert(threadCount > 0 && "Need at least one thread to record on!");
+
+		QueueFamilyIndices indices = device.FindPhysicalQueueFamilies();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = indices.graphicsFamily;
+		// No per-buffer reset, the whole pool is reset once per frame
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		pools.resize(framesInFlight * threadCount);
+		for (auto& p : pools)
+		{
+			if (vkCreateCommandPool(device.Device(), &poolInfo, nullptr, &p.pool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create thread command pool!");
+			}
+		}
+	}
+
+	ThreadCommandPools::~ThreadCommandPools()
+	{
+		// Destroying the pool frees its buffers
+		for (auto& p : pools)
+		{
+			vkDestroyCommandPool(device.Device(), p.pool, nullptr);
+		}
+	}
+
+	void ThreadCommandPools::ResetFrame(uint32_t frameIdx)
+	{
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			Pool& p = GetPool(frameIdx, i);
+			if (p.used == 0)
+			{
+				continue;
+			}
+
+			vkResetCommandPool(device.Device(), p.pool, 0);
+			p.used = 0;
+		}
+	}
+
+	VkCommandBuffer ThreadCommandPools::AcquireSecondary(uint32_t frameIdx, uint32_t threadIdx)
+	{
+		assert(threadIdx < threadCount && "Thread index out of range!");
+
+		Pool& p = GetPool(frameIdx, threadIdx);
+		if (p.used == p.secondaries.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = p.pool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer buf;
+			if (vkAllocateCommandBuffers(device.Device(), &allocInfo, &buf) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate secondary command buffer!");
+			}
+			p.secondaries.push_back(buf);
+		}
+
+		return p.secondaries[p.used++];
+	}
+
+	VkCommandBuffer SecondaryContext::Begin() const
+	{
+		assert(pools != nullptr && "No command pools to record secondaries from!");
+
+		// Threads outside the job system record on the main thread's pool
+		uint32_t threadIdx = JobSystem::ThreadIndex();
+		if (threadIdx >= pools->ThreadCount())
+		{
+			threadIdx = 0;
+		}
+
+		VkCommandBuffer buf = pools->AcquireSecondary(frameIdx, threadIdx);
+		Begin(buf, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, true);
+
+		return buf;
+	}
+
+	void SecondaryContext::Begin(VkCommandBuffer buf, VkCommandBufferUsageFlags flags, bool inheritFrameBuffer) const
+	{
+		VkCommandBufferInheritanceInfo inheritance{};
+		inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritance.renderPass = renderPass;
+		inheritance.subpass = 0;
+		inheritance.framebuffer = inheritFrameBuffer ? frameBuffer : VK_NULL_HANDLE;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags;
+		beginInfo.pInheritanceInfo = &inheritance;
+
+		if (vkBeginCommandBuffer(buf, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording secondary command buffer!");
+		}
+
+		// Dynamic state isn't inherited from the primary
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(buf, 0, 1, &viewport);
+
+		VkRect2D scissor{ {0, 0}, extent };
+		vkCmdSetScissor(buf, 0, 1, &scissor);
+	}
+
+	void SecondaryContext::End(VkCommandBuffer buf) const
+	{
+		if (vkEndCommandBuffer(buf) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record secondary command buffer!");
+		}
+	}
+
+	void SecondaryContext::RecordParallel(VkCommandBuffer primary, uint32_t drawCount,
+		const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record, uint32_t minBatch) const
+	{
+		assert(pools != nullptr && "No command pools to record secondaries from!");
+
+		std::vector<VkCommandBuffer> secondaries = RecordBatches(drawCount, record, minBatch,
+			[this]()
+			{
+				// Threads outside the job system record on the main thread's pool
+				uint32_t threadIdx = JobSystem::ThreadIndex();
+				if (threadIdx >= pools->ThreadCount())
+				{
+					threadIdx = 0;
+				}
+				return pools->AcquireSecondary(frameIdx, threadIdx);
+			}, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, true);
+
+		if (!secondaries.empty())
+		{
+			vkCmdExecuteCommands(primary, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+		}
+	}
+
+	void SecondaryContext::RecordCached(VkCommandBuffer primary, const char* name, uint64_t hash, uint32_t drawCount,
+		const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record, uint32_t minBatch) const
+	{
+		if (cache == nullptr || !cache->IsEnabled())
+		{
+			RecordParallel(primary, drawCount, record, minBatch);
+			return;
+		}
+
+		cache->Execute(*this, primary, name, hash, drawCount, record, minBatch);
+	}
+
+	std::vector<VkCommandBuffer> SecondaryContext::RecordBatches(uint32_t drawCount,
+		const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record, uint32_t minBatch,
+		const std::function<VkCommandBuffer()>& acquire, VkCommandBufferUsageFlags flags, bool inheritFrameBuffer) const
+	{
+		if (drawCount == 0)
+		{
+			return {};
+		}
+
+		// A couple of batches per thread evens out uneven draws without
+		// flooding the primary with tiny secondaries
+		minBatch = std::max(minBatch, 1u);
+		uint32_t threads = pools ? pools->ThreadCount() : JobSystem::ThreadCount();
+		uint32_t maxBatches = std::max(threads * 2, 1u);
+		uint32_t batches = std::min((drawCount + minBatch - 1) / minBatch, maxBatches);
+		uint32_t batchSize = (drawCount + batches - 1) / batches;
+		batches = (drawCount + batchSize - 1) / batchSize;
+
+		std::vector<VkCommandBuffer> secondaries(batches, VK_NULL_HANDLE);
+
+		JobSystem::ParallelFor(drawCount, batchSize, [&](uint32_t begin, uint32_t end)
+			{
+				// ParallelFor may hand out several batches at once when it runs inline
+				for (uint32_t b = begin; b < end; b += batchSize)
+				{
+					VkCommandBuffer buf = acquire();
+					Begin(buf, flags, inheritFrameBuffer);
+					record(buf, b, std::min(b + batchSize, end));
+					End(buf);
+					secondaries[b / batchSize] = buf;
+				}
+			}, "RecordSecondaries");
+
+		return secondaries;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef COMMANDPOOLS_H
+#define COMMANDPOOLS_H
+
+#include "TendouDevice.h"
+
+#include <functional>
+#include <vector>
+
+namespace Tendou
+{
+	class CommandCache;
+
+	// One VkCommandPool per (frame in flight, thread), so any job system
+	// worker can record secondaries without synchronizing with the others.
+	// Pools for a frame are reset in bulk once that frame's fence has signalled.
+	class ThreadCommandPools
+	{
+	public:
+		ThreadCommandPools(TendouDevice& device, uint32_t framesInFlight, uint32_t threadCount);
+		~ThreadCommandPools();
+
+		ThreadCommandPools(const ThreadCommandPools&) = delete;
+		ThreadCommandPools& operator=(const ThreadCommandPools&) = delete;
+
+		// Must only be called once the GPU is done with frameIdx
+		void ResetFrame(uint32_t frameIdx);
+
+		// Hands out an unused secondary buffer from threadIdx's pool;
+		// only threadIdx may record into buffers from that pool
+		VkCommandBuffer AcquireSecondary(uint32_t frameIdx, uint32_t threadIdx);
+
+		__inline uint32_t ThreadCount() const { return threadCount; }
+
+	private:
+		struct Pool
+		{
+			VkCommandPool pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> secondaries;
+			uint32_t used = 0;
+		};
+
+		__inline Pool& GetPool(uint32_t frameIdx, uint32_t threadIdx)
+		{
+			return pools[frameIdx * threadCount + threadIdx];
+		}
+
+		TendouDevice& device;
+		uint32_t threadCount;
+		std::vector<Pool> pools;
+	};
+
+	// Everything a render system needs to record secondaries for the
+	// render pass that's currently open on the frame's primary buffer
+	struct SecondaryContext
+	{
+		ThreadCommandPools* pools = nullptr;
+		uint32_t frameIdx = 0;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer frameBuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+
+		// Where RecordCached keeps its secondaries, null records them every frame
+		CommandCache* cache = nullptr;
+
+		// Acquires a secondary for the calling job system thread, begins it
+		// with render pass continuation and sets viewport/scissor
+		VkCommandBuffer Begin() const;
+		void End(VkCommandBuffer buf) const;
+
+		// Begin for a buffer from anywhere. Buffers that outlive the frame pass
+		// no ONE_TIME_SUBMIT in flags and inherit no framebuffer.
+		void Begin(VkCommandBuffer buf, VkCommandBufferUsageFlags flags, bool inheritFrameBuffer) const;
+
+		// Splits [0, drawCount) into batches of at least minBatch draws, records
+		// each batch into its own secondary on the job system and executes them
+		// on primary in order. record(buf, begin, end) must bind everything it uses.
+		void RecordParallel(VkCommandBuffer primary, uint32_t drawCount,
+			const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record,
+			uint32_t minBatch = 256) const;
+
+		// RecordParallel for passes whose commands only change with their inputs.
+		// hash covers everything record reads; while it matches, the secondaries
+		// cached under name are executed again instead of being recorded.
+		void RecordCached(VkCommandBuffer primary, const char* name, uint64_t hash, uint32_t drawCount,
+			const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record,
+			uint32_t minBatch = 256) const;
+
+		// The batching RecordParallel does, with secondaries coming from acquire.
+		// Returns them in draw order.
+		std::vector<VkCommandBuffer> RecordBatches(uint32_t drawCount,
+			const std::function<void(VkCommandBuffer, uint32_t, uint32_t)>& record, uint32_t minBatch,
+			const std::function<VkCommandBuffer()>& acquire, VkCommandBufferUsageFlags flags, bool inheritFrameBuffer) const;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,12 +1,109 @@
 #include "Descriptor.h"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <stdexcept>
 
 namespace Tendou
 {
 
+    // *************** Descriptor Layout Cache *********************
+
+    DescriptorLayoutCache::DescriptorLayoutCache(VkDevice d)
+        : device_{ d }
+    {
+    }
+
+    DescriptorLayoutCache::~DescriptorLayoutCache()
+    {
+        for (auto& kv : layouts)
+        {
+            vkDestroyDescriptorSetLayout(device_, kv.second, nullptr);
+        }
+
+        for (VkDescriptorSetLayout layout : uncached)
+        {
+            vkDestroyDescriptorSetLayout(device_, layout, nullptr);
+        }
+    }
+
+    VkDescriptorSetLayout DescriptorLayoutCache::CreateLayout(const VkDescriptorSetLayoutCreateInfo& info)
+    {
+        LayoutKey key{};
+        key.flags = info.flags;
+        key.bindings.assign(info.pBindings, info.pBindings + info.bindingCount);
+
+        // Sampler handles and extension structs aren't part of the key
+        bool shareable = info.pNext == nullptr && std::none_of(key.bindings.begin(), key.bindings.end(),
+            [](const VkDescriptorSetLayoutBinding& b) { return b.pImmutableSamplers != nullptr; });
+
+        // Binding order doesn't change the layout
+        std::sort(key.bindings.begin(), key.bindings.end(),
+            [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (shareable)
+        {
+            auto it = layouts.find(key);
+            if (it != layouts.end())
+            {
+                return it->second;
+            }
+        }
+
+        VkDescriptorSetLayout layout;
+        if (vkCreateDescriptorSetLayout(device_, &info, nullptr, &layout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+
+        if (shareable)
+        {
+            layouts.emplace(std::move(key), layout);
+        }
+        else
+        {
+            uncached.push_back(layout);
+        }
+        return layout;
+    }
+
+    bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const
+    {
+        if (flags != other.flags || bindings.size() != other.bindings.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < bindings.size(); ++i)
+        {
+            const VkDescriptorSetLayoutBinding& a = bindings[i];
+            const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+                a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+    {
+        size_t hash = std::hash<uint32_t>()(key.flags);
+        for (const VkDescriptorSetLayoutBinding& b : key.bindings)
+        {
+            // Every field fits in its own bits, so pack them into one value per binding
+            uint64_t packed = static_cast<uint64_t>(b.binding) | (static_cast<uint64_t>(b.descriptorType) << 8) |
+                (static_cast<uint64_t>(b.stageFlags) << 16) | (static_cast<uint64_t>(b.descriptorCount) << 32);
+            hash ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+
     // *************** Descriptor Set Layout Builder *********************
     DescriptorSetLayout::Builder& DescriptorSetLayout::Builder::AddBinding(
         uint32_t binding, VkDescriptorType descriptorType, VkShaderStageFlags stageFlags, uint32_t count) 
@@ -44,19 +141,12 @@ namespace Tendou
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
-        if (vkCreateDescriptorSetLayout(
-            device_.Device(),
-            &descriptorSetLayoutInfo,
-            nullptr,
-            &descriptorSetLayout) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("failed to create descriptor set layout!");
-        }
+        descriptorSetLayout = device_.LayoutCache().CreateLayout(descriptorSetLayoutInfo);
     }
 
+    // The handle belongs to the device's layout cache
     DescriptorSetLayout::~DescriptorSetLayout() 
     {
-        vkDestroyDescriptorSetLayout(device_.Device(), descriptorSetLayout, nullptr);
     }
 
     // *************** Descriptor Pool Builder *********************
@@ -93,56 +183,119 @@ namespace Tendou
         VkDescriptorPoolCreateFlags poolFlags,
         const std::vector<VkDescriptorPoolSize>& poolSizes)
         : device_{ d } 
+        , maxSets{ std::max(maxSets, 1u) }
+        , poolFlags{ poolFlags }
+        , poolSizes{ poolSizes }
+    {
+        blocks.push_back(CreateBlock(this->maxSets));
+        nextBlockSets = std::min(this->maxSets * 2, std::max(this->maxSets, MAX_SETS_PER_BLOCK));
+    }
+
+    DescriptorPool::~DescriptorPool() 
+    {
+        for (VkDescriptorPool block : blocks)
+        {
+            vkDestroyDescriptorPool(device_.Device(), block, nullptr);
+        }
+    }
+
+    VkDescriptorPool DescriptorPool::CreateBlock(uint32_t setCount)
     {
+        // Keep the builder's ratio of descriptors per set
+        std::vector<VkDescriptorPoolSize> sizes = poolSizes;
+        for (auto& size : sizes)
+        {
+            uint64_t scaled = static_cast<uint64_t>(size.descriptorCount) * setCount / maxSets;
+            size.descriptorCount = static_cast<uint32_t>(std::max<uint64_t>(scaled, 1));
+        }
+
         VkDescriptorPoolCreateInfo descriptorPoolInfo{};
         descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        descriptorPoolInfo.pPoolSizes = poolSizes.data();
-        descriptorPoolInfo.maxSets = maxSets;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(sizes.size());
+        descriptorPoolInfo.pPoolSizes = sizes.data();
+        descriptorPoolInfo.maxSets = setCount;
         descriptorPoolInfo.flags = poolFlags;
 
-        if (vkCreateDescriptorPool(device_.Device(), &descriptorPoolInfo, nullptr, &descriptorPool) !=
+        VkDescriptorPool block;
+        if (vkCreateDescriptorPool(device_.Device(), &descriptorPoolInfo, nullptr, &block) !=
             VK_SUCCESS) 
         {
             throw std::runtime_error("failed to create descriptor pool!");
         }
-    }
-
-    DescriptorPool::~DescriptorPool() 
-    {
-        vkDestroyDescriptorPool(device_.Device(), descriptorPool, nullptr);
+        return block;
     }
 
     bool DescriptorPool::AllocateDescriptor(
-        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const 
+        const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor)
     {
+        std::lock_guard<std::mutex> lock(mutex);
+
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
-        if (vkAllocateDescriptorSets(device_.Device(), &allocInfo, &descriptor) != VK_SUCCESS) 
+        bool freshBlock = false;
+        while (true)
         {
-            return false;
+            allocInfo.descriptorPool = blocks[currBlock];
+            VkResult result = vkAllocateDescriptorSets(device_.Device(), &allocInfo, &descriptor);
+            if (result == VK_SUCCESS)
+            {
+                if (poolFlags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+                {
+                    owners[descriptor] = currBlock;
+                }
+                return true;
+            }
+
+            // A set that doesn't fit into an empty block never will
+            if (freshBlock || (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL))
+            {
+                return false;
+            }
+
+            // Block is full; try the next one, or chain on a bigger block
+            if (currBlock + 1 == blocks.size())
+            {
+                blocks.push_back(CreateBlock(nextBlockSets));
+                nextBlockSets = std::min(nextBlockSets * 2, std::max(maxSets, MAX_SETS_PER_BLOCK));
+                freshBlock = true;
+            }
+            ++currBlock;
         }
-        return true;
     }
 
-    void DescriptorPool::FreeDescriptors(std::vector<VkDescriptorSet>& descriptors) const 
+    void DescriptorPool::FreeDescriptors(std::vector<VkDescriptorSet>& descriptors)
     {
-        vkFreeDescriptorSets(
-            device_.Device(),
-            descriptorPool,
-            static_cast<uint32_t>(descriptors.size()),
-            descriptors.data());
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (VkDescriptorSet set : descriptors)
+        {
+            auto it = owners.find(set);
+            if (it == owners.end())
+            {
+                continue;
+            }
+
+            vkFreeDescriptorSets(device_.Device(), blocks[it->second], 1, &set);
+
+            // The block has room again, start looking from there
+            currBlock = std::min(currBlock, it->second);
+            owners.erase(it);
+        }
     }
 
     void DescriptorPool::ResetPool() 
     {
-        vkResetDescriptorPool(device_.Device(), descriptorPool, 0);
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (VkDescriptorPool block : blocks)
+        {
+            vkResetDescriptorPool(device_.Device(), block, 0);
+        }
+        currBlock = 0;
+        owners.clear();
     }
 
     // *************** Descriptor Writer *********************
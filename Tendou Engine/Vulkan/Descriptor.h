@@ -5,11 +5,48 @@
 
 // std
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 namespace Tendou {
 
+    // Hands out one VkDescriptorSetLayout per distinct list of bindings, so identical
+    // layouts built by different scenes and systems share a handle. Owned by the device,
+    // every layout lives until the device is destroyed.
+    class DescriptorLayoutCache
+    {
+    public:
+        DescriptorLayoutCache(VkDevice d);
+        ~DescriptorLayoutCache();
+        DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+        DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+        // Layouts with a pNext chain or immutable samplers are created but never shared
+        VkDescriptorSetLayout CreateLayout(const VkDescriptorSetLayoutCreateInfo& info);
+
+        size_t Size() const { return layouts.size(); }
+
+    private:
+        struct LayoutKey
+        {
+            VkDescriptorSetLayoutCreateFlags flags;
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+            bool operator==(const LayoutKey& other) const;
+        };
+
+        struct LayoutKeyHash
+        {
+            size_t operator()(const LayoutKey& key) const;
+        };
+
+        VkDevice device_;
+        std::mutex mutex;
+        std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+        std::vector<VkDescriptorSetLayout> uncached;
+    };
+
     class DescriptorSetLayout 
     {
     public:
@@ -49,8 +86,14 @@ namespace Tendou {
         friend class DescriptorWriter;
     };
 
+    // Chain of VkDescriptorPools that grows instead of failing. The builder's sizes
+    // describe the first block; whenever a block runs out another one, twice as large,
+    // is chained on, so scenes don't need to count their sets up front.
     class DescriptorPool {
     public:
+        // Blocks stop growing at this many sets
+        static constexpr uint32_t MAX_SETS_PER_BLOCK = 4096;
+
         class Builder 
         {
         public:
@@ -80,18 +123,36 @@ namespace Tendou {
         DescriptorPool(const DescriptorPool&) = delete;
         DescriptorPool& operator=(const DescriptorPool&) = delete;
 
-        VkDescriptorPool GetDescriptorPool() { return descriptorPool; }
+        // Block new sets are currently allocated from
+        VkDescriptorPool GetDescriptorPool() { return blocks[currBlock]; }
 
+        // Only fails if the set can't fit even into an empty block
         bool AllocateDescriptor(
-            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor) const;
+            const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor);
 
-        void FreeDescriptors(std::vector<VkDescriptorSet>& descriptors) const;
+        // Needs VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+        void FreeDescriptors(std::vector<VkDescriptorSet>& descriptors);
 
+        // Resets every block at once; all sets from this pool become invalid
         void ResetPool();
 
+        size_t BlockCount() const { return blocks.size(); }
+
     private:
+        VkDescriptorPool CreateBlock(uint32_t setCount);
+
         TendouDevice& device_;
-        VkDescriptorPool descriptorPool;
+        uint32_t maxSets;
+        VkDescriptorPoolCreateFlags poolFlags;
+        std::vector<VkDescriptorPoolSize> poolSizes;
+
+        std::vector<VkDescriptorPool> blocks;
+        size_t currBlock = 0;
+        uint32_t nextBlockSets;
+
+        // Block each set came from, only tracked when sets can be freed
+        std::unordered_map<VkDescriptorSet, size_t> owners;
+        std::mutex mutex;
 
         friend class DescriptorWriter;
     };
@@ -0,0 +1,199 @@
+#include "DrawQueue.h"
+
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+#include "../Rendering/GeometryArena.h"
+#include "../Rendering/RenderStats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace Tendou
+{
+	namespace
+	{
+		constexpr uint32_t RADIX = 256;
+
+		// Below this many packets per thread a single pass is quicker than fanning out
+		constexpr uint32_t PACKETS_PER_JOB = 2048;
+
+		__inline uint64_t Field(uint32_t value, uint32_t bits)
+		{
+			return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+		}
+	}
+
+	uint64_t DrawQueue::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+	{
+		// Non-negative floats order the same as their bit patterns, keep the top 24 below the sign
+		uint32_t depthBits = 0;
+		if (depth > 0.0f)
+		{
+			memcpy(&depthBits, &depth, sizeof(depthBits));
+			depthBits >>= 31 - DEPTH_BITS;
+		}
+
+		uint64_t key = Field(pass, PASS_BITS);
+		key = (key << PIPELINE_BITS) | Field(pipeline, PIPELINE_BITS);
+		key = (key << MATERIAL_BITS) | Field(material, MATERIAL_BITS);
+		key = (key << MESH_BITS) | Field(mesh, MESH_BITS);
+		key = (key << DEPTH_BITS) | Field(depthBits, DEPTH_BITS);
+
+		return key;
+	}
+
+	void DrawQueue::Clear()
+	{
+		packets.clear();
+		entries.clear();
+	}
+
+	DrawQueue::Packet& DrawQueue::Push(uint64_t key)
+	{
+		entries.push_back({ key, static_cast<uint32_t>(packets.size()) });
+		return packets.emplace_back();
+	}
+
+	void DrawQueue::Sort()
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		uint32_t count = static_cast<uint32_t>(entries.size());
+		if (count < 2)
+		{
+			return;
+		}
+
+		// Digits every key agrees on would be a pass that moves nothing
+		uint64_t anySet = 0;
+		uint64_t allSet = ~0ull;
+		for (const SortEntry& e : entries)
+		{
+			anySet |= e.key;
+			allSet &= e.key;
+		}
+		uint64_t varying = anySet ^ allSet;
+
+		uint32_t chunkCount = std::max(1u, std::min(JobSystem::ThreadCount(), count / PACKETS_PER_JOB));
+		uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+		chunkCount = (count + chunkSize - 1) / chunkSize;
+
+		scratch.resize(count);
+		histograms.resize(static_cast<size_t>(chunkCount) * RADIX);
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			if (((varying >> shift) & (RADIX - 1)) == 0)
+			{
+				continue;
+			}
+
+			JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t c = begin; c < end; ++c)
+					{
+						uint32_t* histogram = &histograms[static_cast<size_t>(c) * RADIX];
+						std::fill(histogram, histogram + RADIX, 0u);
+
+						uint32_t last = std::min(count, (c + 1) * chunkSize);
+						for (uint32_t i = c * chunkSize; i < last; ++i)
+						{
+							++histogram[(entries[i].key >> shift) & (RADIX - 1)];
+						}
+					}
+				}, "DrawQueue::Histogram");
+
+			// Digit major, chunk minor, so every chunk scatters into its own slots and the sort stays stable
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RADIX; ++digit)
+			{
+				for (uint32_t c = 0; c < chunkCount; ++c)
+				{
+					uint32_t& slot = histograms[static_cast<size_t>(c) * RADIX + digit];
+					uint32_t n = slot;
+					slot = offset;
+					offset += n;
+				}
+			}
+
+			JobSystem::ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t c = begin; c < end; ++c)
+					{
+						uint32_t* histogram = &histograms[static_cast<size_t>(c) * RADIX];
+
+						uint32_t last = std::min(count, (c + 1) * chunkSize);
+						for (uint32_t i = c * chunkSize; i < last; ++i)
+						{
+							scratch[histogram[(entries[i].key >> shift) & (RADIX - 1)]++] = entries[i];
+						}
+					}
+				}, "DrawQueue::Scatter");
+
+			entries.swap(scratch);
+		}
+	}
+
+	void DrawQueue::Replay(TendouDevice& device, VkCommandBuffer commandBuffer)
+	{
+		TENDOU_PROFILE_FUNCTION();
+
+		Pipeline* boundPipeline = nullptr;
+		VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+		VkDescriptorSet boundSet = VK_NULL_HANDLE;
+		bool geometryBound = false;
+
+		// What recording every packet's state would have cost, against what was recorded
+		uint32_t requested = 0;
+		uint32_t issued = 0;
+
+		for (const SortEntry& e : entries)
+		{
+			Packet& p = packets[e.packet];
+			assert(p.pipeline != nullptr && p.model != nullptr && "Draw packet wasn't filled in!");
+
+			++requested;
+			if (p.pipeline != boundPipeline)
+			{
+				p.pipeline->Bind(commandBuffer);
+				boundPipeline = p.pipeline;
+				++issued;
+			}
+
+			// Packets without a set draw with whatever the last one left bound
+			if (p.descriptorSet != VK_NULL_HANDLE)
+			{
+				++requested;
+				if (p.descriptorSet != boundSet || p.layout != boundLayout)
+				{
+					vkCmdBindDescriptorSets(commandBuffer,
+						VK_PIPELINE_BIND_POINT_GRAPHICS,
+						p.layout, 0, 1, &p.descriptorSet,
+						0, nullptr);
+					boundSet = p.descriptorSet;
+					boundLayout = p.layout;
+					++issued;
+				}
+			}
+
+			// Every model lives in the geometry arena
+			++requested;
+			if (!geometryBound)
+			{
+				device.Geometry().Bind(commandBuffer);
+				geometryBound = true;
+				++issued;
+			}
+
+			if (p.pushSize > 0)
+			{
+				vkCmdPushConstants(commandBuffer, p.layout, p.pushStages, 0, p.pushSize, p.push);
+			}
+
+			p.model->Draw(commandBuffer);
+		}
+
+		RenderStats::CountBinds(requested, issued);
+	}
+}
\ No newline at end of file
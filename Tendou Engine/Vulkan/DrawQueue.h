@@ -0,0 +1,73 @@
+#ifndef DRAWQUEUE_H
+#define DRAWQUEUE_H
+
+#include "Pipeline.h"
+#include "../Rendering/Model.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tendou
+{
+	// Render systems push compact draw packets instead of recording while
+	// they walk the scene. Each packet carries a 64 bit key, most significant
+	// field first:
+	//
+	//   pass 4 | pipeline 8 | material 12 | mesh 16 | depth 24
+	//
+	// Sort() radix sorts the keys across the job system, so packets come out
+	// grouped by pass, then state, then front to back. Replay() records them
+	// and skips any pipeline, descriptor set or geometry bind that matches
+	// what the previous packet left bound.
+	class DrawQueue
+	{
+	public:
+		static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
+
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 8;
+		static constexpr uint32_t MATERIAL_BITS = 12;
+		static constexpr uint32_t MESH_BITS = 16;
+		static constexpr uint32_t DEPTH_BITS = 24;
+
+		// depth is any non-negative distance, smaller draws first
+		static uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+		struct Packet
+		{
+			Pipeline* pipeline = nullptr;
+			VkPipelineLayout layout = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			Model* model = nullptr;
+
+			VkShaderStageFlags pushStages = 0;
+			uint32_t pushSize = 0;
+			uint8_t push[MAX_PUSH_CONSTANT_SIZE];
+		};
+
+		void Clear();
+
+		// Reserves a packet under key, the caller fills it in
+		Packet& Push(uint64_t key);
+
+		void Sort();
+
+		void Replay(TendouDevice& device, VkCommandBuffer commandBuffer);
+
+		__inline uint32_t Size() const { return static_cast<uint32_t>(packets.size()); }
+
+	private:
+		struct SortEntry
+		{
+			uint64_t key;
+			uint32_t packet;
+		};
+
+		std::vector<Packet> packets;
+		std::vector<SortEntry> entries;
+		std::vector<SortEntry> scratch;
+		std::vector<uint32_t> histograms;
+	};
+}
+
+#endif
\ No newline at end of file
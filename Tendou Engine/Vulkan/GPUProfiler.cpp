@@ -0,0 +1,429 @@
+#include "GPUProfiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <stdexcept>
+
+namespace Tendou
+{
+	GPUProfiler::GPUProfiler(TendouDevice& device_, uint32_t framesInFlight_)
+		: device(device_)
+		, framesInFlight(framesInFlight_)
+	{
+		slots.resize(framesInFlight);
+		results.resize(MAX_ZONES * 2 * 2);
+
+		// Timestamps are only meaningful if the graphics queue supports them
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.PhysicalDevice(), &familyCount, families.data());
+
+		uint32_t validBits = families[device.FindPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+		supported = validBits > 0 && device.properties.limits.timestampPeriod > 0.0f;
+
+		if (!supported)
+		{
+			return;
+		}
+
+		timestampPeriod = static_cast<double>(device.properties.limits.timestampPeriod);
+		timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = framesInFlight * MAX_ZONES * 2;
+
+		if (vkCreateQueryPool(device.Device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool!");
+		}
+	}
+
+	GPUProfiler::~GPUProfiler()
+	{
+		if (queryPool)
+		{
+			vkDestroyQueryPool(device.Device(), queryPool, nullptr);
+		}
+	}
+
+	void GPUProfiler::BeginFrame(VkCommandBuffer cmdBuf, uint32_t frameIdx)
+	{
+		assert(frameIdx < framesInFlight && "Frame index out of range!");
+
+		currSlot = frameIdx;
+		openDepth = 0;
+
+		FrameSlot& slot = slots[frameIdx];
+		if (slot.active && slot.queryCount > 0)
+		{
+			Collect(slot, frameIdx);
+		}
+
+		slot.zones.clear();
+		slot.queryCount = 0;
+		slot.frameNumber = frameCounter++;
+		slot.active = supported && enabled;
+
+		if (slot.active)
+		{
+			vkCmdResetQueryPool(cmdBuf, queryPool, frameIdx * MAX_ZONES * 2, MAX_ZONES * 2);
+		}
+	}
+
+	uint32_t GPUProfiler::BeginZone(VkCommandBuffer cmdBuf, const std::string& name)
+	{
+		FrameSlot& slot = slots[currSlot];
+		if (!slot.active || slot.zones.size() >= MAX_ZONES)
+		{
+			return INVALID_ZONE;
+		}
+
+		Zone z{};
+		z.nameId = GetNameId(name);
+		z.depth = openDepth++;
+		z.query = slot.queryCount;
+		slot.queryCount += 2;
+
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool,
+			currSlot * MAX_ZONES * 2 + z.query);
+
+		slot.zones.push_back(z);
+		return static_cast<uint32_t>(slot.zones.size() - 1);
+	}
+
+	void GPUProfiler::EndZone(VkCommandBuffer cmdBuf, uint32_t zone)
+	{
+		if (zone == INVALID_ZONE)
+		{
+			return;
+		}
+
+		FrameSlot& slot = slots[currSlot];
+		assert(zone < slot.zones.size() && "Zone doesn't belong to this frame!");
+
+		vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool,
+			currSlot * MAX_ZONES * 2 + slot.zones[zone].query + 1);
+
+		--openDepth;
+	}
+
+	uint32_t GPUProfiler::GetNameId(const std::string& name)
+	{
+		auto found = nameIds.find(name);
+		if (found != nameIds.end())
+		{
+			return found->second;
+		}
+
+		uint32_t id = static_cast<uint32_t>(stats.size());
+		nameIds.emplace(name, id);
+
+		ZoneStats s{};
+		s.name = name;
+		s.samples.reserve(HISTORY);
+		stats.push_back(std::move(s));
+
+		return id;
+	}
+
+	void GPUProfiler::Collect(FrameSlot& slot, uint32_t frameIdx)
+	{
+		// No WAIT flag - this slot's fence has already signalled, and if a
+		// query somehow isn't ready we'd rather drop the frame than block
+		VkResult res = vkGetQueryPoolResults(device.Device(), queryPool,
+			frameIdx * MAX_ZONES * 2, slot.queryCount,
+			slot.queryCount * 2 * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (res != VK_SUCCESS && res != VK_NOT_READY)
+		{
+			return;
+		}
+
+		for (uint32_t q = 0; q < slot.queryCount; ++q)
+		{
+			if (results[q * 2 + 1] == 0)
+			{
+				return;
+			}
+		}
+
+		TraceFrame frame{};
+		frame.frameNumber = slot.frameNumber;
+		frame.events.reserve(slot.zones.size());
+
+		double frameMs = 0.0;
+
+		for (auto& z : slot.zones)
+		{
+			uint64_t begin = results[z.query * 2] & timestampMask;
+			uint64_t end = results[(z.query + 1) * 2] & timestampMask;
+			if (end < begin)
+			{
+				continue;
+			}
+
+			if (!hasOrigin)
+			{
+				traceOrigin = begin;
+				hasOrigin = true;
+			}
+
+			double durationNs = static_cast<double>(end - begin) * timestampPeriod;
+			float ms = static_cast<float>(durationNs / 1e6);
+
+			if (z.depth == 0)
+			{
+				frameMs += durationNs / 1e6;
+			}
+
+			ZoneStats& s = stats[z.nameId];
+			s.last = ms;
+			if (s.samples.size() < HISTORY)
+			{
+				s.samples.push_back(ms);
+			}
+			else
+			{
+				s.samples[s.next] = ms;
+			}
+			s.next = (s.next + 1) % HISTORY;
+
+			if (begin >= traceOrigin)
+			{
+				TraceEvent e{};
+				e.nameId = z.nameId;
+				e.depth = z.depth;
+				e.startUs = static_cast<double>(begin - traceOrigin) * timestampPeriod / 1e3;
+				e.durationUs = durationNs / 1e3;
+				frame.events.push_back(e);
+			}
+		}
+
+		if (recordFrames && slot.frameNumber >= recordFrom)
+		{
+			frameTimes.push_back(static_cast<float>(frameMs));
+		}
+
+		trace.push_back(std::move(frame));
+		while (trace.size() > TRACE_FRAMES)
+		{
+			trace.pop_front();
+		}
+	}
+
+	void GPUProfiler::RecordFrameTimes(uint64_t firstFrame)
+	{
+		recordFrames = true;
+		recordFrom = firstFrame;
+		frameTimes.clear();
+	}
+
+	void GPUProfiler::Flush()
+	{
+		// Oldest first, so recorded frame times stay in frame order
+		std::vector<uint32_t> pending;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(slots.size()); ++i)
+		{
+			if (slots[i].active && slots[i].queryCount > 0)
+			{
+				pending.push_back(i);
+			}
+		}
+
+		std::sort(pending.begin(), pending.end(), [this](uint32_t a, uint32_t b)
+			{
+				return slots[a].frameNumber < slots[b].frameNumber;
+			});
+
+		for (uint32_t i : pending)
+		{
+			Collect(slots[i], i);
+			slots[i].active = false;
+		}
+	}
+
+	void GPUProfiler::SetFramesInFlight(uint32_t count)
+	{
+		assert(count > 0 && count <= slots.size() && "More frames in flight than query slots!");
+
+		if (count == framesInFlight)
+		{
+			return;
+		}
+
+		// Slot indices are about to map to different frames
+		Flush();
+		for (auto& slot : slots)
+		{
+			slot.zones.clear();
+			slot.queryCount = 0;
+		}
+		framesInFlight = count;
+	}
+
+	void GPUProfiler::DrawPanel(bool* open)
+	{
+		if (!ImGui::Begin("GPU Profiler", open))
+		{
+			ImGui::End();
+			return;
+		}
+
+		if (!supported)
+		{
+			ImGui::Text("Timestamp queries aren't supported on the graphics queue.");
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Checkbox("Enabled", &enabled);
+		ImGui::SameLine();
+		if (ImGui::Button("Export CSV"))
+		{
+			exportStatus = ExportCSV("gpu_profile.csv") ? "Wrote gpu_profile.csv" : "Failed to write gpu_profile.csv";
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Export Trace"))
+		{
+			exportStatus = ExportChromeTrace("gpu_trace.json") ? "Wrote gpu_trace.json" : "Failed to write gpu_trace.json";
+		}
+
+		if (!exportStatus.empty())
+		{
+			ImGui::Text("%s", exportStatus.c_str());
+		}
+
+		ImGui::Text("Times in ms over the last %u frames", HISTORY);
+
+		if (ImGui::BeginTable("Zones", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+		{
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Last");
+			ImGui::TableSetupColumn("Avg");
+			ImGui::TableSetupColumn("P50");
+			ImGui::TableSetupColumn("P95");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableSetupColumn("Max");
+			ImGui::TableHeadersRow();
+
+			std::vector<float> sorted;
+			for (auto& s : stats)
+			{
+				if (s.samples.empty())
+				{
+					continue;
+				}
+
+				sorted = s.samples;
+				std::sort(sorted.begin(), sorted.end());
+
+				float sum = 0.0f;
+				for (float v : sorted)
+				{
+					sum += v;
+				}
+
+				auto percentile = [&sorted](float p)
+				{
+					return sorted[static_cast<size_t>(p * static_cast<float>(sorted.size() - 1))];
+				};
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::Text("%s", s.name.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", s.last);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", sum / static_cast<float>(sorted.size()));
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", percentile(0.50f));
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", percentile(0.95f));
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", percentile(0.99f));
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", sorted.back());
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+	bool GPUProfiler::ExportCSV(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file << "frame,zone,depth,start_ms,duration_ms\n";
+		for (auto& f : trace)
+		{
+			for (auto& e : f.events)
+			{
+				file << f.frameNumber << ","
+					<< stats[e.nameId].name << ","
+					<< e.depth << ","
+					<< e.startUs / 1e3 << ","
+					<< e.durationUs / 1e3 << "\n";
+			}
+		}
+
+		return file.good();
+	}
+
+	bool GPUProfiler::ExportChromeTrace(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		// chrome://tracing / Perfetto "complete" events, one track for the GPU
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+		file.setf(std::ios::fixed);
+		file.precision(3);
+
+		for (auto& f : trace)
+		{
+			for (auto& e : f.events)
+			{
+				file << ",\n{\"name\":\"" << stats[e.nameId].name
+					<< "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+					<< ",\"ts\":" << e.startUs
+					<< ",\"dur\":" << e.durationUs
+					<< ",\"args\":{\"frame\":" << f.frameNumber << "}}";
+			}
+		}
+
+		file << "\n]}\n";
+		return file.good();
+	}
+
+	GPUZone::GPUZone(FrameInfo& frame, const std::string& name)
+	{
+		// Primary buffers can only execute commands inside a secondary-contents pass
+		if (!frame.profiler || frame.secondary)
+		{
+			return;
+		}
+
+		profiler = frame.profiler;
+		cmdBuf = frame.commandBuffer;
+		zone = profiler->BeginZone(cmdBuf, name);
+	}
+
+	GPUZone::~GPUZone()
+	{
+		if (profiler)
+		{
+			profiler->EndZone(cmdBuf, zone);
+		}
+	}
+}
\ No newline at end of file
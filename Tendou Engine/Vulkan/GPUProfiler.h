@@ -0,0 +1,161 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include "TendouDevice.h"
+
+#include "../Rendering/FrameInfo.h"
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tendou
+{
+	// Timestamp query profiler for the frame's primary command buffer.
+	// Zones are written with vkCmdWriteTimestamp and read back when the
+	// same frame slot comes around again - its fence has been waited on
+	// by then, so collecting results never stalls.
+	class GPUProfiler
+	{
+	public:
+		static constexpr uint32_t INVALID_ZONE = ~0u;
+
+		// Zones per frame, each one uses two queries
+		static constexpr uint32_t MAX_ZONES = 128;
+
+		// Samples per zone used for the rolling average and percentiles
+		static constexpr uint32_t HISTORY = 240;
+
+		// Frames kept around for CSV/trace export
+		static constexpr uint32_t TRACE_FRAMES = 300;
+
+		GPUProfiler(TendouDevice& device, uint32_t framesInFlight);
+		~GPUProfiler();
+
+		GPUProfiler(const GPUProfiler&) = delete;
+		GPUProfiler& operator=(const GPUProfiler&) = delete;
+
+		// Collects the results last recorded for frameIdx and resets its queries.
+		// Call right after vkBeginCommandBuffer, outside of any render pass.
+		void BeginFrame(VkCommandBuffer cmdBuf, uint32_t frameIdx);
+
+		// Returns INVALID_ZONE when profiling is off or the frame is out of queries;
+		// EndZone ignores it, so callers don't need to check
+		uint32_t BeginZone(VkCommandBuffer cmdBuf, const std::string& name);
+		void EndZone(VkCommandBuffer cmdBuf, uint32_t zone);
+
+		void DrawPanel(bool* open = nullptr);
+
+		// Keeps the total GPU time of every collected frame numbered >= firstFrame,
+		// in frame order, for offline statistics (benchmark reports)
+		void RecordFrameTimes(uint64_t firstFrame);
+		__inline const std::vector<float>& GetFrameTimes() const { return frameTimes; }
+
+		// Collects every frame still pending. Only call once the device is idle.
+		void Flush();
+
+		// Frame slots in use, at most the count given to the constructor. A change
+		// flushes every slot, so ones past the new count don't keep stale queries
+		// around until the count grows again. Only call once the device is idle.
+		void SetFramesInFlight(uint32_t count);
+
+		bool ExportCSV(const std::string& path) const;
+		bool ExportChromeTrace(const std::string& path) const;
+
+		__inline bool IsSupported() const { return supported; }
+		__inline bool IsEnabled() const { return enabled; }
+		__inline void SetEnabled(bool e) { enabled = e; }
+
+	private:
+		struct Zone
+		{
+			uint32_t nameId;
+			uint32_t depth;
+			uint32_t query;
+		};
+
+		struct FrameSlot
+		{
+			std::vector<Zone> zones;
+			uint32_t queryCount = 0;
+			uint64_t frameNumber = 0;
+			bool active = false;
+		};
+
+		struct ZoneStats
+		{
+			std::string name;
+			std::vector<float> samples;
+			uint32_t next = 0;
+			float last = 0.0f;
+		};
+
+		struct TraceEvent
+		{
+			uint32_t nameId;
+			uint32_t depth;
+			double startUs;
+			double durationUs;
+		};
+
+		struct TraceFrame
+		{
+			uint64_t frameNumber;
+			std::vector<TraceEvent> events;
+		};
+
+		uint32_t GetNameId(const std::string& name);
+		void Collect(FrameSlot& slot, uint32_t frameIdx);
+
+		TendouDevice& device;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+
+		std::vector<FrameSlot> slots;
+		uint32_t framesInFlight = 0;
+		uint32_t currSlot = 0;
+		uint32_t openDepth = 0;
+		uint64_t frameCounter = 0;
+
+		// Nanoseconds per tick, and which bits of a timestamp are meaningful
+		double timestampPeriod = 1.0;
+		uint64_t timestampMask = ~0ull;
+		uint64_t traceOrigin = 0;
+		bool hasOrigin = false;
+
+		bool supported = false;
+		bool enabled = true;
+
+		std::unordered_map<std::string, uint32_t> nameIds;
+		std::vector<ZoneStats> stats;
+		std::deque<TraceFrame> trace;
+
+		// Scratch for vkGetQueryPoolResults: {timestamp, availability} per query
+		std::vector<uint64_t> results;
+
+		std::string exportStatus;
+
+		std::vector<float> frameTimes;
+		uint64_t recordFrom = 0;
+		bool recordFrames = false;
+	};
+
+	// Times its scope on frame.commandBuffer. Does nothing without a profiler,
+	// or while the open render pass takes its contents from secondaries.
+	class GPUZone
+	{
+	public:
+		GPUZone(FrameInfo& frame, const std::string& name);
+		~GPUZone();
+
+		GPUZone(const GPUZone&) = delete;
+		GPUZone& operator=(const GPUZone&) = delete;
+
+	private:
+		GPUProfiler* profiler = nullptr;
+		VkCommandBuffer cmdBuf = VK_NULL_HANDLE;
+		uint32_t zone = GPUProfiler::INVALID_ZONE;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,1014 @@
+#include "RenderGraph.h"
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Tendou
+{
+	static constexpr VkAccessFlags WRITE_ACCESS =
+		VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT |
+		VK_ACCESS_HOST_WRITE_BIT |
+		VK_ACCESS_MEMORY_WRITE_BIT;
+
+	// PassBuilder
+	// -----
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteColor(Handle res, VkClearColorValue clear, Load load,
+		uint32_t baseLayer, uint32_t layerCount)
+	{
+		Usage& u = graph.AddUsage(passIdx, res, UsageType::Color, baseLayer, layerCount);
+		u.state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		u.state.stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		u.state.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+			(load == Load::Load ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0);
+		u.load = load;
+		u.clear.color = clear;
+
+		graph.passes[passIdx].raster = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteDepth(Handle res, float clearDepth, Load load,
+		uint32_t baseLayer, uint32_t layerCount)
+	{
+		Usage& u = graph.AddUsage(passIdx, res, UsageType::Depth, baseLayer, layerCount);
+		u.state.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		u.state.stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		u.state.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		u.load = load;
+		u.clear.depthStencil = { clearDepth, 0 };
+
+		graph.passes[passIdx].raster = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::ReadTexture(Handle res, VkPipelineStageFlags stages)
+	{
+		Usage& u = graph.AddUsage(passIdx, res, UsageType::Sampled, 0, ALL_LAYERS);
+		u.state.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		u.state.stages = stages;
+		u.state.access = VK_ACCESS_SHADER_READ_BIT;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::CopySrc(Handle res, uint32_t baseLayer, uint32_t layerCount)
+	{
+		Usage& u = graph.AddUsage(passIdx, res, UsageType::TransferSrc, baseLayer, layerCount);
+		u.state.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		u.state.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		u.state.access = VK_ACCESS_TRANSFER_READ_BIT;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::CopyDst(Handle res, uint32_t baseLayer, uint32_t layerCount)
+	{
+		Usage& u = graph.AddUsage(passIdx, res, UsageType::TransferDst, baseLayer, layerCount);
+		u.state.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		u.state.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		u.state.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::RecordSecondary()
+	{
+		graph.passes[passIdx].secondary = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::SideEffect()
+	{
+		graph.passes[passIdx].sideEffect = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::ScaleToRenderArea()
+	{
+		graph.passes[passIdx].scaled = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::Multiview()
+	{
+		graph.passes[passIdx].multiview = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::Condition(std::function<bool()> enabled)
+	{
+		graph.passes[passIdx].condition = std::move(enabled);
+		return *this;
+	}
+
+	void RenderGraph::PassBuilder::Execute(std::function<void(FrameInfo&)> func)
+	{
+		graph.passes[passIdx].execute = std::move(func);
+	}
+
+	bool RenderGraph::Usage::Writes() const
+	{
+		return type == UsageType::Color || type == UsageType::Depth || type == UsageType::TransferDst;
+	}
+
+	bool RenderGraph::Usage::Reads() const
+	{
+		return type == UsageType::Sampled || type == UsageType::TransferSrc ||
+			((type == UsageType::Color || type == UsageType::Depth) && load == Load::Load);
+	}
+
+	// RenderGraph
+	// -----
+
+	RenderGraph::RenderGraph(TendouDevice& device_)
+		: device(device_)
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		if (vkCreateSampler(device.Device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph sampler!");
+		}
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		for (auto& p : passes)
+		{
+			if (p.frameBuffer)
+			{
+				vkDestroyFramebuffer(device.Device(), p.frameBuffer, nullptr);
+			}
+			for (VkImageView v : p.views)
+			{
+				vkDestroyImageView(device.Device(), v, nullptr);
+			}
+		}
+
+		for (auto& kv : renderPassCache)
+		{
+			vkDestroyRenderPass(device.Device(), kv.second, nullptr);
+		}
+
+		for (auto& r : resources)
+		{
+			if (r.imported)
+			{
+				continue;
+			}
+
+			if (r.view)
+			{
+				vkDestroyImageView(device.Device(), r.view, nullptr);
+			}
+			if (r.image)
+			{
+				vkDestroyImage(device.Device(), r.image, nullptr);
+			}
+		}
+
+		for (auto& b : blocks)
+		{
+			vkFreeMemory(device.Device(), b.memory, nullptr);
+		}
+
+		vkDestroySampler(device.Device(), sampler, nullptr);
+	}
+
+	RenderGraph::Handle RenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+	{
+		assert(!compiled && "Can't add resources to a compiled render graph!");
+
+		Resource r{};
+		r.name = name;
+		r.desc = desc;
+		r.layers.resize(desc.layers);
+
+		resources.push_back(r);
+		return static_cast<Handle>(resources.size() - 1);
+	}
+
+	RenderGraph::Handle RenderGraph::ImportImage(const std::string& name, VkImage image, VkImageView view,
+		const RenderGraphImageDesc& desc, VkImageLayout initialLayout, VkImageLayout finalLayout)
+	{
+		assert(!compiled && "Can't add resources to a compiled render graph!");
+
+		Resource r{};
+		r.name = name;
+		r.desc = desc;
+		r.imported = true;
+		r.image = image;
+		r.view = view;
+		r.finalLayout = finalLayout;
+		r.layers.resize(desc.layers);
+		for (auto& l : r.layers)
+		{
+			l.layout = initialLayout;
+		}
+
+		resources.push_back(r);
+		return static_cast<Handle>(resources.size() - 1);
+	}
+
+	void RenderGraph::MarkOutput(Handle res, VkImageLayout layout, VkPipelineStageFlags stages)
+	{
+		assert(res < resources.size() && "Invalid render graph resource!");
+
+		Resource& r = resources[res];
+		r.output = true;
+		r.outputState.layout = layout;
+		r.outputState.stages = stages;
+		r.outputState.access = layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_MEMORY_READ_BIT;
+	}
+
+	RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name)
+	{
+		assert(!compiled && "Can't add passes to a compiled render graph!");
+
+		Pass p{};
+		p.name = name;
+		passes.push_back(p);
+
+		return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+	}
+
+	RenderGraph::Usage& RenderGraph::AddUsage(uint32_t passIdx, Handle res, UsageType type, uint32_t baseLayer, uint32_t layerCount)
+	{
+		assert(res < resources.size() && "Invalid render graph resource!");
+
+		const Resource& r = resources[res];
+		if (layerCount == ALL_LAYERS)
+		{
+			layerCount = r.desc.layers - baseLayer;
+		}
+		assert(baseLayer + layerCount <= r.desc.layers && "Layer range out of bounds!");
+
+		Usage u{};
+		u.res = res;
+		u.type = type;
+		u.baseLayer = baseLayer;
+		u.layerCount = layerCount;
+
+		passes[passIdx].usages.push_back(u);
+		return passes[passIdx].usages.back();
+	}
+
+	VkFormat RenderGraph::DepthFormat()
+	{
+		if (depthFormat == VK_FORMAT_UNDEFINED)
+		{
+			depthFormat = device.FindSupportedFormat(
+				{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+				VK_IMAGE_TILING_OPTIMAL,
+				VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		}
+		return depthFormat;
+	}
+
+	bool RenderGraph::IsPassCulled(const std::string& name) const
+	{
+		for (auto& p : passes)
+		{
+			if (p.name == name)
+			{
+				return !p.alive;
+			}
+		}
+		return true;
+	}
+
+	void RenderGraph::Compile()
+	{
+		assert(!compiled && "Render graph already compiled!");
+
+		CullPasses();
+		CreateTransientImages();
+
+		for (uint32_t i = 0; i < passes.size(); ++i)
+		{
+			if (passes[i].alive && passes[i].raster)
+			{
+				CreatePassObjects(passes[i], i);
+			}
+		}
+
+		compiled = true;
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Anything that leaves the graph keeps its writers alive
+		std::vector<bool> needed(resources.size(), false);
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			needed[i] = resources[i].imported || resources[i].output;
+		}
+
+		// Passes only depend on earlier passes, so one backwards sweep is enough
+		for (int i = static_cast<int>(passes.size()) - 1; i >= 0; --i)
+		{
+			Pass& p = passes[i];
+
+			p.alive = p.sideEffect;
+			for (auto& u : p.usages)
+			{
+				if (u.Writes() && needed[u.res])
+				{
+					p.alive = true;
+				}
+			}
+
+			if (!p.alive)
+			{
+				continue;
+			}
+
+			for (auto& u : p.usages)
+			{
+				if (u.Reads())
+				{
+					needed[u.res] = true;
+				}
+			}
+		}
+
+		// Lifetimes, in pass indices
+		for (int i = 0; i < static_cast<int>(passes.size()); ++i)
+		{
+			if (!passes[i].alive)
+			{
+				continue;
+			}
+
+			for (auto& u : passes[i].usages)
+			{
+				Resource& r = resources[u.res];
+				if (r.firstUse < 0)
+				{
+					r.firstUse = i;
+				}
+				r.lastUse = i;
+
+				switch (u.type)
+				{
+				case UsageType::Color:
+					r.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+					break;
+				case UsageType::Depth:
+					r.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+					break;
+				case UsageType::Sampled:
+					r.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+					break;
+				case UsageType::TransferSrc:
+					r.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+					break;
+				case UsageType::TransferDst:
+					r.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+					break;
+				}
+			}
+		}
+
+		// Outputs live until the end of the frame
+		for (auto& r : resources)
+		{
+			if (r.output && r.firstUse >= 0)
+			{
+				r.lastUse = static_cast<int>(passes.size());
+				if (r.outputState.layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+				{
+					r.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::CreateTransientImages()
+	{
+		struct Placement
+		{
+			Handle res;
+			VkMemoryRequirements req;
+		};
+		std::vector<Placement> placements;
+
+		for (Handle h = 0; h < resources.size(); ++h)
+		{
+			Resource& r = resources[h];
+			if (r.imported || r.firstUse < 0)
+			{
+				continue;
+			}
+
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent.width = r.desc.width;
+			imageInfo.extent.height = r.desc.height;
+			imageInfo.extent.depth = 1;
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = r.desc.layers;
+			imageInfo.format = r.desc.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = r.usage;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (vkCreateImage(device.Device(), &imageInfo, nullptr, &r.image) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create render graph image!");
+			}
+
+			VkMemoryRequirements req;
+			vkGetImageMemoryRequirements(device.Device(), r.image, &req);
+			placements.push_back({ h, req });
+			transientMemoryUnaliased += req.size;
+		}
+
+		// Greedy placement in order of first use: reuse a block whose
+		// previous tenant is dead before this image is born
+		std::sort(placements.begin(), placements.end(), [this](const Placement& a, const Placement& b)
+			{
+				return resources[a.res].firstUse < resources[b.res].firstUse;
+			});
+
+		for (auto& p : placements)
+		{
+			Resource& r = resources[p.res];
+
+			int chosen = -1;
+			for (int b = 0; b < static_cast<int>(blocks.size()); ++b)
+			{
+				if (blocks[b].lastUse < r.firstUse && (blocks[b].typeBits & p.req.memoryTypeBits) != 0)
+				{
+					chosen = b;
+					break;
+				}
+			}
+
+			if (chosen < 0)
+			{
+				blocks.push_back(MemoryBlock{});
+				chosen = static_cast<int>(blocks.size() - 1);
+			}
+
+			MemoryBlock& block = blocks[chosen];
+			block.size = std::max(block.size, p.req.size);
+			block.typeBits &= p.req.memoryTypeBits;
+			block.lastUse = r.lastUse;
+			r.block = chosen;
+		}
+
+		for (auto& b : blocks)
+		{
+			VkMemoryAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = b.size;
+			allocInfo.memoryTypeIndex = device.FindMemoryType(b.typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			if (vkAllocateMemory(device.Device(), &allocInfo, nullptr, &b.memory) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate render graph memory!");
+			}
+			transientMemory += b.size;
+		}
+
+		for (auto& p : placements)
+		{
+			Resource& r = resources[p.res];
+			vkBindImageMemory(device.Device(), r.image, blocks[r.block].memory, 0);
+
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = r.image;
+			viewInfo.viewType = r.desc.layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = r.desc.format;
+			viewInfo.subresourceRange.aspectMask = AspectFor(r.desc.format) & ~VK_IMAGE_ASPECT_STENCIL_BIT;
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = r.desc.layers;
+
+			if (vkCreateImageView(device.Device(), &viewInfo, nullptr, &r.view) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create render graph image view!");
+			}
+		}
+	}
+
+	void RenderGraph::CreatePassObjects(Pass& pass, uint32_t passIdx)
+	{
+		if (pass.multiview)
+		{
+			uint32_t viewCount = 0;
+			for (auto& u : pass.usages)
+			{
+				if (u.type == UsageType::Color || u.type == UsageType::Depth)
+				{
+					assert((viewCount == 0 || viewCount == u.layerCount) && "Multiview attachments need matching layer counts!");
+					viewCount = u.layerCount;
+				}
+			}
+
+			if (viewCount > device.properties.limits.maxImageArrayLayers || viewCount > 32)
+			{
+				throw std::runtime_error("Too many views for a multiview pass!");
+			}
+			pass.viewMask = viewCount >= 32 ? ~0u : ((1u << viewCount) - 1);
+		}
+
+		pass.renderPass = GetOrCreateRenderPass(pass, passIdx);
+
+		std::vector<VkImageView> views;
+		for (auto& u : pass.usages)
+		{
+			if (u.type != UsageType::Color && u.type != UsageType::Depth)
+			{
+				continue;
+			}
+
+			const Resource& r = resources[u.res];
+			views.push_back(GetAttachmentView(pass, u));
+			pass.clearValues.push_back(u.clear);
+
+			// All attachments of a pass share its extent
+			pass.width = r.desc.width;
+			pass.height = r.desc.height;
+		}
+
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = pass.renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = pass.width;
+		framebufferInfo.height = pass.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(device.Device(), &framebufferInfo, nullptr, &pass.frameBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph framebuffer!");
+		}
+	}
+
+	VkImageView RenderGraph::GetAttachmentView(Pass& pass, const Usage& u)
+	{
+		const Resource& r = resources[u.res];
+		if (u.baseLayer == 0 && u.layerCount == r.desc.layers)
+		{
+			return r.view;
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = r.image;
+		viewInfo.viewType = u.layerCount > 1 || pass.multiview ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = r.desc.format;
+		viewInfo.subresourceRange.aspectMask = AspectFor(r.desc.format) & ~VK_IMAGE_ASPECT_STENCIL_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = u.baseLayer;
+		viewInfo.subresourceRange.layerCount = u.layerCount;
+
+		VkImageView view;
+		if (vkCreateImageView(device.Device(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph attachment view!");
+		}
+
+		pass.views.push_back(view);
+		return view;
+	}
+
+	VkRenderPass RenderGraph::GetOrCreateRenderPass(const Pass& pass, uint32_t passIdx)
+	{
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorRefs;
+		VkAttachmentReference depthRef{};
+		bool hasDepth = false;
+
+		std::string key;
+
+		for (auto& u : pass.usages)
+		{
+			if (u.type != UsageType::Color && u.type != UsageType::Depth)
+			{
+				continue;
+			}
+
+			const Resource& r = resources[u.res];
+
+			// Nothing downstream reads it, so don't bother writing it back
+			bool store = IsReadLater(u.res, passIdx);
+
+			VkAttachmentDescription desc{};
+			desc.format = r.desc.format;
+			desc.samples = VK_SAMPLE_COUNT_1_BIT;
+			desc.loadOp = u.load == Load::Clear ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+				u.load == Load::Load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			desc.storeOp = store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			// Layout changes are done by the graph's barriers, never by the render pass
+			desc.initialLayout = u.state.layout;
+			desc.finalLayout = u.state.layout;
+
+			VkAttachmentReference ref{ static_cast<uint32_t>(attachments.size()), u.state.layout };
+			if (u.type == UsageType::Color)
+			{
+				colorRefs.push_back(ref);
+			}
+			else
+			{
+				depthRef = ref;
+				hasDepth = true;
+			}
+
+			attachments.push_back(desc);
+
+			key += std::to_string(desc.format) + ":" + std::to_string(desc.loadOp) + ":" +
+				std::to_string(desc.storeOp) + ":" + std::to_string(static_cast<int>(u.type)) + ";";
+		}
+
+		// Pipelines are only compatible with render passes that have the same view mask
+		key += "views:" + std::to_string(pass.viewMask);
+
+		auto found = renderPassCache.find(key);
+		if (found != renderPassCache.end())
+		{
+			return found->second;
+		}
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+		subpass.pColorAttachments = colorRefs.data();
+		subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		// All views are rendered together, so they're also worth correlating
+		VkRenderPassMultiviewCreateInfo multiviewInfo{};
+		multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+		multiviewInfo.subpassCount = 1;
+		multiviewInfo.pViewMasks = &pass.viewMask;
+		multiviewInfo.correlationMaskCount = 1;
+		multiviewInfo.pCorrelationMasks = &pass.viewMask;
+
+		if (pass.viewMask != 0)
+		{
+			renderPassInfo.pNext = &multiviewInfo;
+		}
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(device.Device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create render graph render pass!");
+		}
+
+		renderPassCache[key] = renderPass;
+		return renderPass;
+	}
+
+	bool RenderGraph::IsReadLater(Handle res, uint32_t passIdx) const
+	{
+		const Resource& r = resources[res];
+		if (r.imported || r.output)
+		{
+			return true;
+		}
+
+		for (uint32_t i = passIdx + 1; i < passes.size(); ++i)
+		{
+			if (!passes[i].alive)
+			{
+				continue;
+			}
+
+			for (auto& u : passes[i].usages)
+			{
+				if (u.res == res && u.Reads())
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	VkImageAspectFlags RenderGraph::AspectFor(VkFormat format) const
+	{
+		switch (format)
+		{
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_D32_SFLOAT:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	void RenderGraph::Transition(Handle res, uint32_t baseLayer, uint32_t layerCount, const Access& want,
+		std::vector<VkImageMemoryBarrier>& barriers, VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages)
+	{
+		Resource& r = resources[res];
+
+		// First use this frame: contents are garbage, and whatever image shared
+		// the memory before has to be done with it
+		if (!r.imported && !r.touched)
+		{
+			const MemoryBlock& block = blocks[r.block];
+			for (auto& l : r.layers)
+			{
+				l.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+				l.stages = block.lastStages;
+				l.access = block.lastAccess;
+			}
+			r.touched = true;
+		}
+
+		for (uint32_t layer = baseLayer; layer < baseLayer + layerCount; ++layer)
+		{
+			Access& curr = r.layers[layer];
+
+			bool layoutChange = curr.layout != want.layout;
+			bool hazard = (curr.access & WRITE_ACCESS) || (want.access & WRITE_ACCESS);
+
+			// Read after read in the same layout - no barrier, just widen the state
+			if (!layoutChange && !hazard)
+			{
+				curr.stages |= want.stages;
+				curr.access |= want.access;
+				continue;
+			}
+
+			srcStages |= curr.stages;
+			dstStages |= want.stages;
+
+			// Extend the previous barrier if this is the next layer with the same transition
+			if (!barriers.empty())
+			{
+				VkImageMemoryBarrier& last = barriers.back();
+				if (last.image == r.image && last.oldLayout == curr.layout && last.newLayout == want.layout &&
+					last.subresourceRange.baseArrayLayer + last.subresourceRange.layerCount == layer)
+				{
+					last.srcAccessMask |= curr.access & WRITE_ACCESS;
+					++last.subresourceRange.layerCount;
+					curr = want;
+					continue;
+				}
+			}
+
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = curr.layout;
+			barrier.newLayout = want.layout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = r.image;
+			barrier.subresourceRange.aspectMask = AspectFor(r.desc.format);
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = layer;
+			barrier.subresourceRange.layerCount = 1;
+			barrier.srcAccessMask = curr.access & WRITE_ACCESS;
+			barrier.dstAccessMask = want.access;
+			barriers.push_back(barrier);
+
+			curr = want;
+		}
+
+		if (!r.imported)
+		{
+			blocks[r.block].lastStages = want.stages;
+			blocks[r.block].lastAccess = want.access;
+		}
+	}
+
+	void RenderGraph::FlushBarriers(VkCommandBuffer cmdBuf, std::vector<VkImageMemoryBarrier>& barriers,
+		VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages)
+	{
+		if (!barriers.empty())
+		{
+			vkCmdPipelineBarrier(cmdBuf,
+				srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				dstStages ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0,
+				0, nullptr,
+				0, nullptr,
+				static_cast<uint32_t>(barriers.size()), barriers.data());
+		}
+
+		barriers.clear();
+		srcStages = 0;
+		dstStages = 0;
+	}
+
+	void RenderGraph::Execute(FrameInfo& frame)
+	{
+		assert(compiled && "Render graph must be compiled before executing!");
+
+		VkCommandBuffer cmdBuf = frame.commandBuffer;
+
+		std::vector<VkImageMemoryBarrier> barriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+
+		for (auto& r : resources)
+		{
+			r.touched = false;
+		}
+
+		for (auto& p : passes)
+		{
+			if (!p.alive || (p.condition && !p.condition()))
+			{
+				continue;
+			}
+
+			// One barrier call per pass covering every resource it touches
+			for (auto& u : p.usages)
+			{
+				Transition(u.res, u.baseLayer, u.layerCount, u.state, barriers, srcStages, dstStages);
+			}
+			FlushBarriers(cmdBuf, barriers, srcStages, dstStages);
+
+			uint32_t zone = frame.profiler ? frame.profiler->BeginZone(cmdBuf, p.name) : GPUProfiler::INVALID_ZONE;
+
+			if (!p.raster)
+			{
+				if (p.execute)
+				{
+					p.execute(frame);
+				}
+
+				if (frame.profiler)
+				{
+					frame.profiler->EndZone(cmdBuf, zone);
+				}
+				continue;
+			}
+
+			VkExtent2D extent{ p.width, p.height };
+			if (p.scaled && renderArea.width > 0 && renderArea.height > 0)
+			{
+				extent.width = std::min(extent.width, renderArea.width);
+				extent.height = std::min(extent.height, renderArea.height);
+			}
+
+			// Clears and stores only cover the render area; whatever is outside it is stale
+			VkRenderPassBeginInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = p.renderPass;
+			renderPassInfo.framebuffer = p.frameBuffer;
+			renderPassInfo.renderArea.offset = { 0, 0 };
+			renderPassInfo.renderArea.extent = extent;
+			renderPassInfo.clearValueCount = static_cast<uint32_t>(p.clearValues.size());
+			renderPassInfo.pClearValues = p.clearValues.data();
+
+			SecondaryContext secondary{};
+
+			if (p.secondary && commandPools)
+			{
+				vkCmdBeginRenderPass(cmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+				secondary.pools = commandPools;
+				secondary.cache = commandCache;
+				secondary.frameIdx = static_cast<uint32_t>(frame.frameIdx);
+				secondary.renderPass = p.renderPass;
+				secondary.frameBuffer = p.frameBuffer;
+				secondary.extent = extent;
+				frame.secondary = &secondary;
+			}
+			else
+			{
+				vkCmdBeginRenderPass(cmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+				VkViewport viewport{};
+				viewport.x = 0.0f;
+				viewport.y = 0.0f;
+				viewport.width = static_cast<float>(extent.width);
+				viewport.height = static_cast<float>(extent.height);
+				viewport.minDepth = 0.0f;
+				viewport.maxDepth = 1.0f;
+				vkCmdSetViewport(cmdBuf, 0, 1, &viewport);
+
+				VkRect2D scissor{ { 0, 0 }, extent };
+				vkCmdSetScissor(cmdBuf, 0, 1, &scissor);
+			}
+
+			if (p.execute)
+			{
+				p.execute(frame);
+			}
+			frame.secondary = nullptr;
+
+			vkCmdEndRenderPass(cmdBuf);
+
+			if (frame.profiler)
+			{
+				frame.profiler->EndZone(cmdBuf, zone);
+			}
+		}
+
+		// Hand imported images and outputs back in the layout the rest of the frame expects
+		for (Handle h = 0; h < resources.size(); ++h)
+		{
+			Resource& r = resources[h];
+			if (r.imported && r.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				Access want{};
+				want.layout = r.finalLayout;
+				want.stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				want.access = VK_ACCESS_SHADER_READ_BIT;
+
+				// Only touch layers that aren't already there
+				for (uint32_t l = 0; l < r.desc.layers; ++l)
+				{
+					if (r.layers[l].layout != want.layout)
+					{
+						Transition(h, l, 1, want, barriers, srcStages, dstStages);
+					}
+				}
+			}
+			else if (r.output && r.firstUse >= 0)
+			{
+				Transition(h, 0, r.desc.layers, r.outputState, barriers, srcStages, dstStages);
+			}
+		}
+		FlushBarriers(cmdBuf, barriers, srcStages, dstStages);
+	}
+
+	void RenderGraph::ExportRenderPasses(std::unordered_map<std::string, RenderPass>& renderPasses)
+	{
+		assert(compiled && "Render graph must be compiled before exporting render passes!");
+
+		for (auto& p : passes)
+		{
+			if (!p.alive || !p.raster)
+			{
+				continue;
+			}
+
+			RenderPass rp{};
+			rp.width = static_cast<int32_t>(p.width);
+			rp.height = static_cast<int32_t>(p.height);
+			rp.renderPass = p.renderPass;
+			rp.frameBuffer = p.frameBuffer;
+			rp.sampler = sampler;
+
+			// Graph-owned memory, so leave .memory empty - nobody outside should free it
+			bool hasColor = false;
+			for (auto& u : p.usages)
+			{
+				const Resource& r = resources[u.res];
+				FrameBufferAttachment a{ r.image, VK_NULL_HANDLE, r.view, r.desc.format };
+
+				if (u.type == UsageType::Color && !hasColor)
+				{
+					rp.color = a;
+					hasColor = true;
+				}
+				else if (u.type == UsageType::Depth)
+				{
+					rp.depth = a;
+				}
+			}
+
+			rp.descriptor.sampler = sampler;
+			rp.descriptor.imageView = rp.color.view;
+			rp.descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			renderPasses[p.name] = rp;
+		}
+	}
+}
\ No newline at end of file
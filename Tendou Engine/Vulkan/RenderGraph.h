@@ -0,0 +1,265 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include "TendouDevice.h"
+#include "CommandPools.h"
+
+#include "../Rendering/FrameInfo.h"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tendou
+{
+	struct RenderGraphImageDesc
+	{
+		uint32_t width;
+		uint32_t height;
+		VkFormat format;
+		uint32_t layers = 1;
+	};
+
+	// Frame graph for everything that happens before the swapchain pass.
+	// Passes declare what they read and write; Compile() culls passes nobody
+	// consumes, creates the render passes/framebuffers, and places transient
+	// images with non-overlapping lifetimes in the same memory. Execute() then
+	// records each live pass with one batched barrier in front of it.
+	//
+	// Passes run in declaration order. Layouts are tracked per array layer,
+	// so a pass can write a single face of a cubemap, or all six at once
+	// with multiview.
+	//
+	// Passes marked ScaleToRenderArea only render the top-left SetRenderArea()
+	// part of their attachments, which lets targets be allocated once at their
+	// largest size and rendered at whatever resolution the frame can afford.
+	class RenderGraph
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = ~0u;
+		static constexpr uint32_t ALL_LAYERS = ~0u;
+
+		enum class Load
+		{
+			Clear = 0,
+			Load,
+			DontCare
+		};
+
+		class PassBuilder
+		{
+		public:
+			PassBuilder(RenderGraph& graph, uint32_t passIdx) : graph(graph), passIdx(passIdx) {}
+
+			// Attachments can be a layer range of an array image; the pass then gets its own view of it
+			PassBuilder& WriteColor(Handle res, VkClearColorValue clear = { { 0.0f, 0.0f, 0.0f, 0.0f } }, Load load = Load::Clear,
+				uint32_t baseLayer = 0, uint32_t layerCount = ALL_LAYERS);
+			PassBuilder& WriteDepth(Handle res, float clearDepth = 1.0f, Load load = Load::Clear,
+				uint32_t baseLayer = 0, uint32_t layerCount = ALL_LAYERS);
+			PassBuilder& ReadTexture(Handle res, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			PassBuilder& CopySrc(Handle res, uint32_t baseLayer = 0, uint32_t layerCount = ALL_LAYERS);
+			PassBuilder& CopyDst(Handle res, uint32_t baseLayer = 0, uint32_t layerCount = ALL_LAYERS);
+
+			// Render pass contents come from secondaries; FrameInfo::secondary is set during Execute
+			PassBuilder& RecordSecondary();
+
+			// Never culled, even if nothing reads what it writes
+			PassBuilder& SideEffect();
+
+			// Render area, viewport and scissor follow SetRenderArea instead of the attachment size
+			PassBuilder& ScaleToRenderArea();
+
+			// Every draw is broadcast to all layers of the attachments, which must
+			// all have the same layer count; shaders tell them apart by gl_ViewIndex
+			PassBuilder& Multiview();
+
+			// Checked every Execute; the pass and its barriers are skipped while it returns false
+			PassBuilder& Condition(std::function<bool()> enabled);
+
+			void Execute(std::function<void(FrameInfo&)> func);
+
+		private:
+			RenderGraph& graph;
+			uint32_t passIdx;
+		};
+
+		RenderGraph(TendouDevice& device);
+		~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		// Graph-owned image, only valid between its first and last use in a frame
+		Handle CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+
+		// Image owned by someone else. It's expected in initialLayout on the first
+		// frame and is left in finalLayout at the end of every Execute.
+		Handle ImportImage(const std::string& name, VkImage image, VkImageView view,
+			const RenderGraphImageDesc& desc, VkImageLayout initialLayout, VkImageLayout finalLayout);
+
+		// Marks a transient image as consumed outside the graph (e.g. sampled in the
+		// swapchain pass). It's kept alive and left in the given layout.
+		void MarkOutput(Handle res, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+		PassBuilder AddPass(const std::string& name);
+
+		void Compile();
+		void Execute(FrameInfo& frame);
+
+		// Extent scaled passes render at from now on, clamped to their attachments.
+		// { 0, 0 } renders them at full size.
+		__inline void SetRenderArea(VkExtent2D extent) { renderArea = extent; }
+		__inline VkExtent2D GetRenderArea() const { return renderArea; }
+
+		// Fills in a Tendou::RenderPass for every live raster pass, keyed by pass name,
+		// so render systems can build their pipelines against it
+		void ExportRenderPasses(std::unordered_map<std::string, RenderPass>& renderPasses);
+
+		__inline void SetCommandPools(ThreadCommandPools* pools) { commandPools = pools; }
+
+		// Lets secondary passes reuse their recordings through SecondaryContext::RecordCached
+		__inline void SetCommandCache(CommandCache* cache) { commandCache = cache; }
+
+		VkImage GetImage(Handle res) const { return resources[res].image; }
+		VkImageView GetImageView(Handle res) const { return resources[res].view; }
+		VkSampler GetSampler() const { return sampler; }
+		VkFormat DepthFormat();
+
+		bool IsPassCulled(const std::string& name) const;
+
+		// Bytes actually allocated for transient images vs. what they'd need without aliasing
+		__inline VkDeviceSize TransientMemory() const { return transientMemory; }
+		__inline VkDeviceSize TransientMemoryUnaliased() const { return transientMemoryUnaliased; }
+
+	private:
+		enum class UsageType
+		{
+			Color = 0,
+			Depth,
+			Sampled,
+			TransferSrc,
+			TransferDst
+		};
+
+		struct Access
+		{
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags stages = 0;
+			VkAccessFlags access = 0;
+		};
+
+		struct Usage
+		{
+			Handle res;
+			UsageType type;
+			uint32_t baseLayer;
+			uint32_t layerCount;
+			Access state;
+			Load load = Load::Clear;
+			VkClearValue clear{};
+
+			bool Writes() const;
+			bool Reads() const;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<Usage> usages;
+			std::function<void(FrameInfo&)> execute;
+			std::function<bool()> condition;
+
+			bool raster = false;
+			bool secondary = false;
+			bool sideEffect = false;
+			bool scaled = false;
+			bool multiview = false;
+			bool alive = false;
+
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkFramebuffer frameBuffer = VK_NULL_HANDLE;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t viewMask = 0;
+			std::vector<VkClearValue> clearValues;
+
+			// Views of attachment layer ranges, owned by the pass
+			std::vector<VkImageView> views;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			RenderGraphImageDesc desc;
+			bool imported = false;
+			bool output = false;
+			Access outputState;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			VkImageUsageFlags usage = 0;
+
+			int firstUse = -1;
+			int lastUse = -1;
+			int block = -1;
+
+			// Per array layer state, carried across frames
+			std::vector<Access> layers;
+			bool touched = false;
+		};
+
+		// Device memory shared by transient images whose lifetimes don't overlap
+		struct MemoryBlock
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			uint32_t typeBits = ~0u;
+			int lastUse = -1;
+
+			// Last access to whichever image lived here, so the next tenant waits on it
+			VkPipelineStageFlags lastStages = 0;
+			VkAccessFlags lastAccess = 0;
+		};
+
+		Usage& AddUsage(uint32_t passIdx, Handle res, UsageType type, uint32_t baseLayer, uint32_t layerCount);
+
+		void CullPasses();
+		void CreateTransientImages();
+		void CreatePassObjects(Pass& pass, uint32_t passIdx);
+		VkRenderPass GetOrCreateRenderPass(const Pass& pass, uint32_t passIdx);
+		VkImageView GetAttachmentView(Pass& pass, const Usage& u);
+
+		void Transition(Handle res, uint32_t baseLayer, uint32_t layerCount, const Access& want,
+			std::vector<VkImageMemoryBarrier>& barriers, VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages);
+		void FlushBarriers(VkCommandBuffer cmdBuf, std::vector<VkImageMemoryBarrier>& barriers,
+			VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages);
+
+		VkImageAspectFlags AspectFor(VkFormat format) const;
+		bool IsReadLater(Handle res, uint32_t passIdx) const;
+
+		TendouDevice& device;
+		ThreadCommandPools* commandPools = nullptr;
+		CommandCache* commandCache = nullptr;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		std::vector<MemoryBlock> blocks;
+
+		// Passes with identical attachment setups share one VkRenderPass
+		std::unordered_map<std::string, VkRenderPass> renderPassCache;
+
+		VkSampler sampler = VK_NULL_HANDLE;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		VkExtent2D renderArea{};
+		bool compiled = false;
+
+		VkDeviceSize transientMemory = 0;
+		VkDeviceSize transientMemoryUnaliased = 0;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "SwapChain.h"
 
+#include "../Core/Profiler.h"
+
 // std
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <cstring>
@@ -12,16 +15,19 @@
 namespace Tendou
 {
 
-    SwapChain::SwapChain(TendouDevice& deviceRef, VkExtent2D extent)
+    SwapChain::SwapChain(TendouDevice& deviceRef, VkExtent2D extent, const SwapChainConfig& config_)
         : device{ deviceRef }
         , windowExtent{ extent } 
+        , config{ config_ }
     {
         Init();
     }
 
-    SwapChain::SwapChain(TendouDevice& deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> prev)
+    SwapChain::SwapChain(TendouDevice& deviceRef, VkExtent2D extent, std::shared_ptr<SwapChain> prev,
+        const SwapChainConfig& config_)
         : device{ deviceRef }
         , windowExtent{ extent }
+        , config{ config_ }
         , oldSwapChain(prev)
     {
         Init();
@@ -31,6 +37,9 @@ namespace Tendou
 
     void SwapChain::Init()
     {
+        config.framesInFlight = std::min(std::max(config.framesInFlight, 1u),
+            static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
+
         CreateSwapChain();
         CreateImageViews();
         CreateRenderPass();
@@ -53,6 +62,13 @@ namespace Tendou
             swapChain = nullptr;
         }
 
+        // Headless images are ours to free, swapchain images belong to the swapchain
+        for (size_t i = 0; i < offscreenImageMemorys.size(); ++i)
+        {
+            vkDestroyImage(device.Device(), swapChainImages[i], nullptr);
+            vkFreeMemory(device.Device(), offscreenImageMemorys[i], nullptr);
+        }
+
         for (int i = 0; i < depthImages.size(); ++i) 
         {
             vkDestroyImageView(device.Device(), depthImageViews[i], nullptr);
@@ -68,7 +84,7 @@ namespace Tendou
         vkDestroyRenderPass(device.Device(), renderPass, nullptr);
 
         // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+        for (size_t i = 0; i < inFlightFences.size(); ++i)
         {
             vkDestroySemaphore(device.Device(), renderFinishedSemaphores[i], nullptr);
             vkDestroySemaphore(device.Device(), imageAvailableSemaphores[i], nullptr);
@@ -78,13 +94,26 @@ namespace Tendou
 
     VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex) 
     {
-        vkWaitForFences(
-            device.Device(),
-            1,
-            &inFlightFences[currentFrame],
-            VK_TRUE,
-            std::numeric_limits<uint64_t>::max());
+        {
+            // CPU is ahead of the GPU by FramesInFlight() if this shows up on the timeline
+            TENDOU_PROFILE_SCOPE("vkWaitForFences");
+            vkWaitForFences(
+                device.Device(),
+                1,
+                &inFlightFences[currentFrame],
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max());
+        }
 
+        if (device.IsHeadless())
+        {
+            // Nothing to acquire from - just hand out the offscreen images in order
+            *imageIndex = nextOffscreen;
+            nextOffscreen = (nextOffscreen + 1) % static_cast<uint32_t>(ImageCount());
+            return VK_SUCCESS;
+        }
+
+        TENDOU_PROFILE_SCOPE("vkAcquireNextImageKHR");
         VkResult result = vkAcquireNextImageKHR(
             device.Device(),
             swapChain,
@@ -98,18 +127,24 @@ namespace Tendou
 
     VkResult SwapChain::SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex) 
     {
+        TENDOU_PROFILE_FUNCTION();
+
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) 
         {
+            TENDOU_PROFILE_SCOPE("vkWaitForFences (image)");
             vkWaitForFences(device.Device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
         }
         imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
+        bool headless = device.IsHeadless();
+
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        // Headless frames have no acquire to wait on and no present to signal
         VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.waitSemaphoreCount = headless ? 0 : 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
 
@@ -117,7 +152,7 @@ namespace Tendou
         submitInfo.pCommandBuffers = buffers;
 
         VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.signalSemaphoreCount = headless ? 0 : 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.Device(), 1, &inFlightFences[currentFrame]);
@@ -127,6 +162,14 @@ namespace Tendou
             throw std::runtime_error("failed to submit draw command buffer!");
         }
 
+        lastPresented = *imageIndex;
+
+        if (headless)
+        {
+            currentFrame = (currentFrame + 1) % config.framesInFlight;
+            return VK_SUCCESS;
+        }
+
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -139,18 +182,28 @@ namespace Tendou
 
         presentInfo.pImageIndices = imageIndex;
 
-        auto result = vkQueuePresentKHR(device.PresentQueue(), &presentInfo);
+        VkResult result;
+        {
+            TENDOU_PROFILE_SCOPE("vkQueuePresentKHR");
+            result = vkQueuePresentKHR(device.PresentQueue(), &presentInfo);
+        }
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        currentFrame = (currentFrame + 1) % config.framesInFlight;
 
         return result;
     }
 
     void SwapChain::CreateSwapChain() {
+        if (device.IsHeadless())
+        {
+            CreateOffscreenImages();
+            return;
+        }
+
         SwapChainSupportDetails swapChainSupport = device.GetSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -212,6 +265,84 @@ namespace Tendou
         swapChainExtent = extent;
     }
 
+    void SwapChain::CreateOffscreenImages()
+    {
+        swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        swapChainExtent = windowExtent;
+
+        swapChainImages.resize(HEADLESS_IMAGE_COUNT);
+        offscreenImageMemorys.resize(HEADLESS_IMAGE_COUNT);
+
+        for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; ++i)
+        {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.flags = 0;
+
+            device.CreateImageWithInfo(
+                imageInfo,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                swapChainImages[i],
+                offscreenImageMemorys[i]);
+        }
+    }
+
+    bool SwapChain::ReadbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels)
+    {
+        if (!device.IsHeadless() || imageIndex >= ImageCount())
+        {
+            return false;
+        }
+
+        if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+        {
+            vkWaitForFences(device.Device(), 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+        }
+
+        VkDeviceSize size = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingMemory;
+        device.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer, stagingMemory);
+
+        // The render pass leaves headless images in TRANSFER_SRC_OPTIMAL
+        VkCommandBuffer cmdBuf = device.BeginSingleTimeCommands();
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+        vkCmdCopyImageToBuffer(cmdBuf, swapChainImages[imageIndex],
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+        device.EndSingleTimeCommands(cmdBuf);
+
+        pixels.resize(static_cast<size_t>(size));
+
+        void* data;
+        vkMapMemory(device.Device(), stagingMemory, 0, size, 0, &data);
+        memcpy(pixels.data(), data, static_cast<size_t>(size));
+        vkUnmapMemory(device.Device(), stagingMemory);
+
+        vkDestroyBuffer(device.Device(), stagingBuffer, nullptr);
+        vkFreeMemory(device.Device(), stagingMemory, nullptr);
+
+        return true;
+    }
+
     void SwapChain::CreateImageViews() 
     {
         swapChainImageViews.resize(swapChainImages.size());
@@ -258,7 +389,8 @@ namespace Tendou
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        colorAttachment.finalLayout = device.IsHeadless() ?
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -376,9 +508,9 @@ namespace Tendou
     }
 
     void SwapChain::CreateSyncObjects() {
-        imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-        inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+        imageAvailableSemaphores.resize(config.framesInFlight);
+        renderFinishedSemaphores.resize(config.framesInFlight);
+        inFlightFences.resize(config.framesInFlight);
         imagesInFlight.resize(ImageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -388,7 +520,7 @@ namespace Tendou
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+        for (size_t i = 0; i < config.framesInFlight; ++i) {
             if (vkCreateSemaphore(device.Device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
                 vkCreateSemaphore(device.Device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
@@ -419,20 +551,20 @@ namespace Tendou
     {
         for (const auto& availablePresentMode : availablePresentModes) 
         {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) 
+            if (availablePresentMode == config.presentMode && availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) 
             {
                 std::cout << "Present mode: Mailbox" << std::endl;
                 return availablePresentMode;
             }
-        }
 
-        //for (const auto &availablePresentMode : availablePresentModes) {
-        //  if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-        //    std::cout << "Present mode: Immediate" << std::endl;
-        //    return availablePresentMode;
-        //  }
-        //}
+            if (availablePresentMode == config.presentMode && availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) 
+            {
+                std::cout << "Present mode: Immediate" << std::endl;
+                return availablePresentMode;
+            }
+        }
 
+        // Always supported
         std::cout << "Present mode: V-Sync" << std::endl;
         return VK_PRESENT_MODE_FIFO_KHR;
     }
@@ -14,13 +14,27 @@
 namespace Tendou
 {
 
+    struct SwapChainConfig
+    {
+        // Frame slots actually cycled through, 1..SwapChain::MAX_FRAMES_IN_FLIGHT
+        uint32_t framesInFlight = 2;
+
+        // Used when the surface supports it, FIFO otherwise
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    };
+
     class SwapChain 
     {
     public:
+        // Upper bound for SwapChainConfig::framesInFlight; per-frame resources are sized by it
         static constexpr int MAX_FRAMES_IN_FLIGHT = 20;
 
-        SwapChain(TendouDevice& deviceRef, VkExtent2D windowExtent);
-        SwapChain(TendouDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> prev);
+        // Offscreen images cycled through when the device is headless
+        static constexpr uint32_t HEADLESS_IMAGE_COUNT = 3;
+
+        SwapChain(TendouDevice& deviceRef, VkExtent2D windowExtent, const SwapChainConfig& config = SwapChainConfig());
+        SwapChain(TendouDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> prev,
+            const SwapChainConfig& config = SwapChainConfig());
         ~SwapChain();
 
         SwapChain(const SwapChain&) = delete;
@@ -34,6 +48,12 @@ namespace Tendou
         __inline VkExtent2D GetSwapChainExtent() { return swapChainExtent; }
         __inline uint32_t Width() { return swapChainExtent.width; }
         __inline uint32_t Height() { return swapChainExtent.height; }
+        __inline uint32_t FramesInFlight() { return config.framesInFlight; }
+        __inline VkPresentModeKHR PresentMode() { return presentMode; }
+        __inline const SwapChainConfig& GetConfig() { return config; }
+
+        // Signaled when the frame submitted next has finished on the GPU
+        __inline VkFence CurrentFence() { return inFlightFences[currentFrame]; }
 
         float ExtentAspectRatio() 
         {
@@ -44,6 +64,11 @@ namespace Tendou
         VkResult AcquireNextImage(uint32_t* imageIndex);
         VkResult SubmitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
+        // Headless only: copies a presented image back to the host as tightly packed RGBA8.
+        // Waits for the frame that last rendered into it.
+        bool ReadbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels);
+        __inline uint32_t LastPresentedImage() { return lastPresented; }
+
         bool CompareSwapFormats(const SwapChain& swapChain) const
         {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -53,6 +78,7 @@ namespace Tendou
     private:
         void Init();
         void CreateSwapChain();
+        void CreateOffscreenImages();
         void CreateImageViews();
         void CreateDepthResources();
         void CreateRenderPass();
@@ -78,11 +104,14 @@ namespace Tendou
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
+        std::vector<VkDeviceMemory> offscreenImageMemorys;
 
         TendouDevice& device;
         VkExtent2D windowExtent;
+        SwapChainConfig config;
+        VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
         std::shared_ptr<SwapChain> oldSwapChain;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -90,6 +119,9 @@ namespace Tendou
         std::vector<VkFence> inFlightFences;
         std::vector<VkFence> imagesInFlight;
         size_t currentFrame = 0;
+
+        uint32_t nextOffscreen = 0;
+        uint32_t lastPresented = 0;
     };
 
 }  // namespace lve
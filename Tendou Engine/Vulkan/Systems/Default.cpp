@@ -8,6 +8,7 @@
 #include <stdexcept>
 #include <array>
 #include <cassert>
+#include <cstring>
 
 namespace Tendou
 {
@@ -17,6 +18,8 @@ namespace Tendou
 		glm::mat4 normalMatrix{ 1.0f };
 	};
 
+	static_assert(sizeof(PushConstantData) <= DrawQueue::MAX_PUSH_CONSTANT_SIZE, "Push constants don't fit a draw packet!");
+
 	DefaultSystem::DefaultSystem(TendouDevice& device, VkRenderPass pass, VkDescriptorSetLayout set)
 		: RenderSystem(device)
 	{
@@ -73,7 +76,12 @@ namespace Tendou
 
 	void DefaultSystem::Render(FrameInfo& frame, SceneInfo& scene)
 	{
-		int count = 0;
+		TENDOU_PROFILE_SCOPE("DefaultSystem::Render");
+		GPUZone zone(frame, "DefaultSystem");
+
+		glm::vec3 eye = scene.camera ? scene.camera->cameraPos : glm::vec3(0.0f);
+
+		queue.Clear();
 
 		for (auto& kv : scene.gameObjects)
 		{
@@ -83,69 +91,45 @@ namespace Tendou
 				continue;
 			}
 
-			PushConstantData push{};
-			push.modelMatrix = obj.GetTransform().ModelMat();
-			push.normalMatrix = obj.GetTransform().NormalMatrix();
-
-			vkCmdPushConstants(frame.commandBuffer,
-				layout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PushConstantData),
-				&push);
-
 			// TODO: Make this a switch statement (tagging optimizations)
-			if (obj.GetTag() == "Light" && obj.GetRender())
-			{
-				RenderSpheres(obj, scene, frame.commandBuffer);
-			}
-			else if (obj.GetTag() != "Light")
+			uint32_t pass = PASS_OPAQUE;
+			uint32_t pipelineIdx = 0;
+			uint32_t material = 1;
+			if (obj.GetTag() == "Light")
 			{
-				//RenderObject(obj, frame);
-				if (obj.GetTag() == "Skybox")
-				{
-					RenderSkybox(obj, scene, frame.commandBuffer);
-				}
-				else
+				if (!obj.GetRenderState().render)
 				{
-					RenderObject(obj, scene, frame.commandBuffer);
+					continue;
 				}
-				
-			}
-		}
-	}
-
-	void DefaultSystem::RenderObject(GameObject& obj, SceneInfo& f, VkCommandBuffer buf)
-	{
-		pipeline[0]->Bind(buf);
-
-		vkCmdBindDescriptorSets(buf,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			layout, 0, 1, &f.descriptorSets[0],
-			0, nullptr);
-
-		obj.GetModel()->Bind(buf);
-		obj.GetModel()->Draw(buf);
-	}
-
-	void DefaultSystem::RenderSpheres(GameObject& obj, SceneInfo& f, VkCommandBuffer buf)
-	{
-		pipeline[1]->Bind(buf);
-
-		obj.GetModel()->Bind(buf);
-		obj.GetModel()->Draw(buf);
-	}
 
-	void DefaultSystem::RenderSkybox(GameObject& obj, SceneInfo& f, VkCommandBuffer buf)
-	{
-		pipeline[2]->Bind(buf);
+				pipelineIdx = 1;
+				material = 0;
+			}
+			else if (obj.GetTag() == "Skybox")
+			{
+				pass = PASS_BACKGROUND;
+				pipelineIdx = 2;
+				material = 2;
+			}
 
-		vkCmdBindDescriptorSets(buf,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			layout, 0, 1, &f.descriptorSets[1],
-			0, nullptr);
+			PushConstantData push{};
+			push.modelMatrix = obj.GetRenderState().modelMatrix;
+			push.normalMatrix = obj.GetRenderState().normalMatrix;
+
+			float depth = glm::length(glm::vec3(push.modelMatrix[3]) - eye);
+
+			DrawQueue::Packet& packet = queue.Push(DrawQueue::MakeKey(pass, pipelineIdx, material,
+				obj.GetModel()->GetHandle(), depth));
+			packet.pipeline = pipeline[pipelineIdx].get();
+			packet.layout = layout;
+			packet.descriptorSet = material > 0 ? scene.descriptorSets[material - 1] : VK_NULL_HANDLE;
+			packet.model = obj.GetModel().get();
+			packet.pushStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+			packet.pushSize = sizeof(PushConstantData);
+			memcpy(packet.push, &push, sizeof(PushConstantData));
+		}
 
-		obj.GetModel()->Bind(buf);
-		obj.GetModel()->Draw(buf);
+		queue.Sort();
+		queue.Replay(device, frame.commandBuffer);
 	}
 }
\ No newline at end of file
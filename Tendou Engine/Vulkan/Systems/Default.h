@@ -2,6 +2,7 @@
 #define DEFAULT_H
 
 #include "RenderSystem.h"
+#include "../DrawQueue.h"
 
 namespace Tendou
 {
@@ -20,9 +21,14 @@ namespace Tendou
 		void CreatePipeline(VkRenderPass pass) override;
 	
 	private:
-		void RenderObject(GameObject& obj, SceneInfo& s, VkCommandBuffer buf);
-		void RenderSpheres(GameObject& obj, SceneInfo& s, VkCommandBuffer buf);
-		void RenderSkybox(GameObject& obj, SceneInfo& s, VkCommandBuffer buf);
+		// Draw passes inside the queue, the skybox goes down first
+		enum Pass : uint32_t
+		{
+			PASS_BACKGROUND = 0,
+			PASS_OPAQUE
+		};
+
+		DrawQueue queue;
 	};
 }
 
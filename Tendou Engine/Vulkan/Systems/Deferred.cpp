@@ -1,5 +1,7 @@
 #include "Deferred.h"
 
+#include "../../Rendering/RenderStats.h"
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
@@ -63,6 +65,9 @@ namespace Tendou
 
 	void DeferredSystem::Render(FrameInfo& frame, SceneInfo& scene)
 	{
+		TENDOU_PROFILE_SCOPE("DeferredSystem::Render");
+		GPUZone zone(frame, "DeferredSystem");
+
 		vkCmdBindDescriptorSets(frame.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			layout, 0, 1, &scene.descriptorSets[0],
@@ -71,5 +76,6 @@ namespace Tendou
 		pipeline[0]->Bind(frame.commandBuffer);
 
 		vkCmdDraw(frame.commandBuffer, 3, 1, 0, 0);
+		RenderStats::CountDraw(3);
 	}
 }
\ No newline at end of file
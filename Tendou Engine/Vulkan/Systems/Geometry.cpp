@@ -1,4 +1,6 @@
 #include "Geometry.h"
+#include "../CommandPools.h"
+#include "../../Utilities/Hasher.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -75,11 +77,23 @@ namespace Tendou
 
 	void GeometrySystem::Render(FrameInfo& frame, SceneInfo& scene)
 	{
+		TENDOU_PROFILE_SCOPE("GeometrySystem::Render");
+		GPUZone zone(frame, "GeometrySystem");
+
+		if (frame.secondary)
+		{
+			RenderParallel(frame, scene);
+			return;
+		}
+
 		vkCmdBindDescriptorSets(frame.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			layout, 0, 1, &scene.descriptorSets[0],
 			0, nullptr);
 
+		// Every model draws out of the same two buffers
+		device.Geometry().Bind(frame.commandBuffer);
+
 		for (auto& kv : scene.gameObjects)
 		{
 			auto& obj = kv.second;
@@ -88,23 +102,71 @@ namespace Tendou
 				continue;
 			}
 
-			PushConstantData push{};
-			push.modelMatrix = obj.GetTransform().ModelMat();
-			push.normalMatrix = obj.GetTransform().NormalMatrix();
-
-			// NOTE: RenderDoc push constant calls are coming from
-			// the unrenderable lights
-			vkCmdPushConstants(frame.commandBuffer,
-				layout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PushConstantData),
-				&push);
+			RecordDraw(frame.commandBuffer, obj);
+		}
+	}
 
-			pipeline[0]->Bind(frame.commandBuffer);
+	void GeometrySystem::RenderParallel(FrameInfo& frame, SceneInfo& scene)
+	{
+		// The map can't be split up between threads, flatten it first
+		drawList.clear();
+		for (auto& kv : scene.gameObjects)
+		{
+			if (kv.second.GetModel() != nullptr)
+			{
+				drawList.push_back(&kv.second);
+			}
+		}
 
-			obj.GetModel()->Bind(frame.commandBuffer);
-			obj.GetModel()->Draw(frame.commandBuffer);
+		// Everything RecordDraw reads; the camera lives in the world UBO, so
+		// static objects replay last frame's secondaries however it moves
+		Pipeline* geometryPipeline = pipeline[0].get();
+		uint64_t hash = Hash64(&scene.descriptorSets[0], sizeof(VkDescriptorSet), device.Geometry().Generation());
+		hash = Hash64(&geometryPipeline, sizeof(geometryPipeline), hash);
+		for (GameObject* obj : drawList)
+		{
+			Model* model = obj->GetModel().get();
+			glm::mat4 modelMatrix = obj->GetRenderState().modelMatrix;
+			glm::mat3 normalMatrix = obj->GetRenderState().normalMatrix;
+			hash = Hash64(&model, sizeof(model), hash);
+			hash = Hash64(&modelMatrix, sizeof(modelMatrix), hash);
+			hash = Hash64(&normalMatrix, sizeof(normalMatrix), hash);
 		}
+
+		frame.secondary->RecordCached(frame.commandBuffer, "GeometrySystem", hash, static_cast<uint32_t>(drawList.size()),
+			[&](VkCommandBuffer buf, uint32_t begin, uint32_t end)
+			{
+				// Secondaries don't inherit bindings from the primary
+				vkCmdBindDescriptorSets(buf,
+					VK_PIPELINE_BIND_POINT_GRAPHICS,
+					layout, 0, 1, &scene.descriptorSets[0],
+					0, nullptr);
+				device.Geometry().Bind(buf);
+
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					RecordDraw(buf, *drawList[i]);
+				}
+			});
+	}
+
+	void GeometrySystem::RecordDraw(VkCommandBuffer buf, GameObject& obj)
+	{
+		PushConstantData push{};
+		push.modelMatrix = obj.GetRenderState().modelMatrix;
+		push.normalMatrix = obj.GetRenderState().normalMatrix;
+
+		// NOTE: RenderDoc push constant calls are coming from
+		// the unrenderable lights
+		vkCmdPushConstants(buf,
+			layout,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(PushConstantData),
+			&push);
+
+		pipeline[0]->Bind(buf);
+
+		obj.GetModel()->Draw(buf);
 	}
 }
\ No newline at end of file
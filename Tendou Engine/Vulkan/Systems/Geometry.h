@@ -20,6 +20,12 @@ namespace Tendou
 	protected:
 		void CreatePipelineLayout(VkDescriptorSetLayout v) override;
 		void CreatePipeline(VkRenderPass pass) override;
+
+	private:
+		void RenderParallel(FrameInfo& frame, SceneInfo& scene);
+		void RecordDraw(VkCommandBuffer buf, GameObject& obj);
+
+		std::vector<GameObject*> drawList;
 	};
 }
 
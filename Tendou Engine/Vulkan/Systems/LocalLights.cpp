@@ -70,10 +70,17 @@ namespace Tendou
 
 	void LocalLightSystem::Render(FrameInfo& frame, SceneInfo& scene)
 	{
+		TENDOU_PROFILE_SCOPE("LocalLightSystem::Render");
+		GPUZone zone(frame, "LocalLightSystem");
+
 		vkCmdBindDescriptorSets(frame.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			layout, 0, 1, &scene.descriptorSets[0],
 			0, nullptr);
+
+		// Every model draws out of the same two buffers
+		device.Geometry().Bind(frame.commandBuffer);
+
 		int i = 1;
 		for (auto& kv : scene.gameObjects)
 		{
@@ -84,7 +91,7 @@ namespace Tendou
 			}
 
 			LocalLightData push{};
-			push.modelMatrix = obj.GetTransform().ModelMat();
+			push.modelMatrix = obj.GetRenderState().modelMatrix;
 			push.position = glm::vec4(1.0f * i);
 			push.color = glm::vec3(0.1f * i);
 			push.range = 10.0f;
@@ -100,7 +107,6 @@ namespace Tendou
 
 			pipeline[0]->Bind(frame.commandBuffer);
 
-			obj.GetModel()->Bind(frame.commandBuffer);
 			obj.GetModel()->Draw(frame.commandBuffer);
 		}
 	}
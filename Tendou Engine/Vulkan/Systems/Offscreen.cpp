@@ -15,6 +15,7 @@ namespace Tendou
 	{
 		glm::mat4 modelMatrix{ 1.0f };
 		glm::mat4 normalMatrix{ 1.0f };
+		uint32_t faceBase = 0;
 	};
 
 	OffscreenSystem::OffscreenSystem(TendouDevice& device, VkRenderPass pass, VkDescriptorSetLayout set)
@@ -68,12 +69,16 @@ namespace Tendou
 
 	void OffscreenSystem::Render(FrameInfo& frame, SceneInfo& scene)
 	{
-		int count = 0;
+		TENDOU_PROFILE_SCOPE("OffscreenSystem::Render");
+		GPUZone zone(frame, "OffscreenSystem");
+
 		vkCmdBindDescriptorSets(frame.commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			layout, 0, 1, &scene.descriptorSets[0],
-			1, &frame.dynamicOffset);
+			0, nullptr);
 
+		// Every model draws out of the same two buffers
+		device.Geometry().Bind(frame.commandBuffer);
 
 		for (auto& kv : scene.gameObjects)
 		{
@@ -84,8 +89,9 @@ namespace Tendou
 			}
 
 			PushConstantData push{};
-			push.modelMatrix = obj.GetTransform().ModelMat();
-			push.normalMatrix = obj.GetTransform().NormalMatrix();
+			push.modelMatrix = obj.GetRenderState().modelMatrix;
+			push.normalMatrix = obj.GetRenderState().normalMatrix;
+			push.faceBase = faceBase;
 
 			// NOTE: RenderDoc push constant calls are coming from
 			// the unrenderable lights
@@ -99,7 +105,7 @@ namespace Tendou
 			// TODO: Make this a switch statement (tagging optimizations)
 			// NOTE: Do not render the object from which we are doing
 			// dynamic reflections
-			if (obj.GetTag() == "Light" && obj.GetRender())
+			if (obj.GetTag() == "Light" && obj.GetRenderState().render)
 			{
 				RenderSpheres(obj, frame.commandBuffer);
 			}
@@ -114,7 +120,6 @@ namespace Tendou
 	{
 		pipeline[0]->Bind(buf);
 
-		obj.GetModel()->Bind(buf);
 		obj.GetModel()->Draw(buf);
 	}
 
@@ -122,7 +127,6 @@ namespace Tendou
 	{
 		pipeline[1]->Bind(buf);
 
-		obj.GetModel()->Bind(buf);
 		obj.GetModel()->Draw(buf);
 	}
 }
\ No newline at end of file
@@ -15,7 +15,8 @@ namespace Tendou
 
 		void Render(FrameInfo& frame, SceneInfo& scene) override;
 
-		uint32_t offset;
+		// Cubemap face drawn as view 0; multiview passes draw the faces after it as further views
+		uint32_t faceBase = 0;
 
 	protected:
 		void CreatePipelineLayout(VkDescriptorSetLayout v) override;
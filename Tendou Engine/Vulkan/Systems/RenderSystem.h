@@ -1,6 +1,8 @@
 #ifndef RENDERSYSTEM_H
 #define RENDERSYSTEM_H
 
+#include "../GPUProfiler.h"
+#include "../../Core/Profiler.h"
 #include "../Pipeline.h"
 #include "../TendouDevice.h"
 
@@ -0,0 +1,99 @@
+#include "Upscale.h"
+
+#include "../../Rendering/RenderStats.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <stdexcept>
+#include <cassert>
+
+namespace Tendou
+{
+	struct UpscalePushConstants
+	{
+		glm::vec2 uvScale;
+		glm::vec2 uvMax;
+	};
+
+	UpscaleSystem::UpscaleSystem(TendouDevice& device, VkRenderPass pass, VkDescriptorSetLayout set)
+		: RenderSystem(device)
+	{
+		CreatePipelineLayout(set);
+		CreatePipeline(pass);
+	}
+
+	void UpscaleSystem::SetSourceRect(VkExtent2D renderExtent, VkExtent2D targetExtent)
+	{
+		uvScale = glm::vec2(
+			static_cast<float>(renderExtent.width) / static_cast<float>(targetExtent.width),
+			static_cast<float>(renderExtent.height) / static_cast<float>(targetExtent.height));
+
+		// Keep the bilinear footprint off the stale texels right of/below the rendered rect
+		uvMax = glm::vec2(
+			(static_cast<float>(renderExtent.width) - 0.5f) / static_cast<float>(targetExtent.width),
+			(static_cast<float>(renderExtent.height) - 0.5f) / static_cast<float>(targetExtent.height));
+	}
+
+	void UpscaleSystem::CreatePipelineLayout(VkDescriptorSetLayout v)
+	{
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(UpscalePushConstants);
+
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ v };
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(device.Device(), &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline layout!");
+		}
+	}
+
+	void UpscaleSystem::CreatePipeline(VkRenderPass pass)
+	{
+		assert(layout != nullptr && "Cannot create pipeline before layout!");
+
+		PipelineConfigInfo pipelineConfig{};
+		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+		pipelineConfig.renderPass = pass;
+		pipelineConfig.pipelineLayout = layout;
+
+		pipeline.push_back(std::make_shared<Pipeline>(device,
+			"Materials/Shaders/Upscale.vert.spv",
+			"Materials/Shaders/Upscale.frag.spv",
+			pipelineConfig));
+	}
+
+	void UpscaleSystem::Render(FrameInfo& frame, SceneInfo& scene)
+	{
+		TENDOU_PROFILE_SCOPE("UpscaleSystem::Render");
+		GPUZone zone(frame, "UpscaleSystem");
+
+		vkCmdBindDescriptorSets(frame.commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			layout, 0, 1, &scene.descriptorSets[0],
+			0, nullptr);
+
+		pipeline[0]->Bind(frame.commandBuffer);
+
+		UpscalePushConstants push{ uvScale, uvMax };
+		vkCmdPushConstants(frame.commandBuffer,
+			layout,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(UpscalePushConstants),
+			&push);
+
+		vkCmdDraw(frame.commandBuffer, 3, 1, 0, 0);
+		RenderStats::CountDraw(3);
+	}
+}
\ No newline at end of file
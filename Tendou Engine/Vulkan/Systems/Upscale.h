@@ -0,0 +1,33 @@
+#ifndef UPSCALE_H
+#define UPSCALE_H
+
+#include "RenderSystem.h"
+
+namespace Tendou
+{
+	// Stretches the rendered part of a dynamic resolution target over the
+	// whole pass with a fullscreen triangle and bilinear filtering
+	class UpscaleSystem : public RenderSystem
+	{
+	public:
+		UpscaleSystem(TendouDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+
+		UpscaleSystem(const UpscaleSystem&) = delete;
+		UpscaleSystem& operator=(const UpscaleSystem&) = delete;
+
+		void Render(FrameInfo& frame, SceneInfo& scene) override;
+
+		// What part of the source holds this frame's image; set before Render
+		void SetSourceRect(VkExtent2D renderExtent, VkExtent2D targetExtent);
+
+	protected:
+		void CreatePipelineLayout(VkDescriptorSetLayout v) override;
+		void CreatePipeline(VkRenderPass pass) override;
+
+	private:
+		glm::vec2 uvScale{ 1.0f };
+		glm::vec2 uvMax{ 1.0f };
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "TendouDevice.h"
+#include "Descriptor.h"
+#include "../Rendering/GeometryArena.h"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -58,16 +61,26 @@ namespace Tendou
     TendouDevice::TendouDevice(Window& window)
         : window{ window }
     {
+        if (window.IsHeadless())
+        {
+            deviceExtensions.clear();
+        }
+
         CreateInstance();
         SetupDebugMessenger();
         CreateSurface();
         PickPhysicalDevice();
         CreateLogicalDevice();
         CreateCommandPool();
+
+        layoutCache = std::make_unique<DescriptorLayoutCache>(device_);
+        geometryArena = std::make_unique<GeometryArena>(*this);
     }
 
     TendouDevice::~TendouDevice()
     {
+        geometryArena.reset();
+        layoutCache.reset();
         vkDestroyCommandPool(device_, commandPool, nullptr);
         vkDestroyDevice(device_, nullptr);
 
@@ -75,7 +88,10 @@ namespace Tendou
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -91,7 +107,16 @@ namespace Tendou
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.2 for descriptor indexing when the loader knows it, 1.0 loaders reject anything newer
+        auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+            vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+        if (enumerateInstanceVersion && enumerateInstanceVersion(&apiVersion) == VK_SUCCESS) {
+            apiVersion = std::min(apiVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+        }
+        else {
+            apiVersion = VK_API_VERSION_1_0;
+        }
+        appInfo.apiVersion = apiVersion;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -162,11 +187,62 @@ namespace Tendou
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        bcCompression = supportedFeatures.textureCompressionBC == VK_TRUE;
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.textureCompressionBC = bcCompression ? VK_TRUE : VK_FALSE;
+
+        // Bindless materials need runtime sized, partially bound sampler arrays
+        // that can be updated while the frames using other slots are in flight
+        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+        indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+        // Cubemap captures render all six faces in one pass with multiview, core since 1.1
+        VkPhysicalDeviceMultiviewFeatures multiviewFeatures = {};
+        multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+        if (apiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1) {
+            VkPhysicalDeviceFeatures2 features2 = {};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &multiviewFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+            multiview = multiviewFeatures.multiview == VK_TRUE;
+        }
+
+        if (apiVersion >= VK_API_VERSION_1_2 && properties.apiVersion >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceFeatures2 features2 = {};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &indexingFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+            bindless = supportedFeatures.shaderSampledImageArrayDynamicIndexing &&
+                indexingFeatures.runtimeDescriptorArray &&
+                indexingFeatures.descriptorBindingPartiallyBound &&
+                indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+                indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingFeatures enabledIndexing = {};
+        enabledIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        if (bindless) {
+            deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+            enabledIndexing.runtimeDescriptorArray = VK_TRUE;
+            enabledIndexing.descriptorBindingPartiallyBound = VK_TRUE;
+            enabledIndexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            enabledIndexing.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        }
+
+        VkPhysicalDeviceMultiviewFeatures enabledMultiview = {};
+        enabledMultiview.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+        enabledMultiview.multiview = multiview ? VK_TRUE : VK_FALSE;
+        enabledMultiview.pNext = bindless ? &enabledIndexing : nullptr;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = multiview ? static_cast<void*>(&enabledMultiview) : (bindless ? &enabledIndexing : nullptr);
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -209,6 +285,11 @@ namespace Tendou
 
     void TendouDevice::CreateSurface()
     { 
+        if (IsHeadless())
+        {
+            return;
+        }
+
         window.CreateWindowSurface(instance, &surface_);
     }
 
@@ -217,8 +298,9 @@ namespace Tendou
 
         bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // Headless devices never present, so any surface queries are moot
+        bool swapChainAdequate = IsHeadless();
+        if (extensionsSupported && !IsHeadless()) {
             SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -278,11 +360,15 @@ namespace Tendou
     }
 
     std::vector<const char*> TendouDevice::GetRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        std::vector<const char*> extensions;
+
+        if (!IsHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -349,8 +435,14 @@ namespace Tendou
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
+            // Headless "presents" by submitting to the graphics queue
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (IsHeadless()) {
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -448,6 +540,7 @@ namespace Tendou
         if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate vertex buffer memory!");
         }
+        allocatedBytes.fetch_add(memRequirements.size, std::memory_order_relaxed);
 
         vkBindBufferMemory(device_, buffer, bufferMemory, 0);
     }
@@ -864,7 +957,7 @@ namespace Tendou
 
     // Create a VkImageView
     VkImageView TendouDevice::CreateImageView(VkImage image, VkFormat format,
-        uint32_t layerCount, VkImageViewType viewType, VkImageAspectFlagBits aspectMask)
+        uint32_t layerCount, VkImageViewType viewType, VkImageAspectFlagBits aspectMask, uint32_t mipLevels)
     {
         VkImageViewCreateInfo viewInfo{};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -873,7 +966,7 @@ namespace Tendou
         viewInfo.format = format;
         viewInfo.subresourceRange.aspectMask = aspectMask;
         viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.levelCount = mipLevels;
         viewInfo.subresourceRange.baseArrayLayer = 0;
         viewInfo.subresourceRange.layerCount = layerCount;
 
@@ -889,7 +982,7 @@ namespace Tendou
     void TendouDevice::CreateImage(uint32_t width, uint32_t height,
         VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
         VkMemoryPropertyFlags properties, VkImage& image,
-        VkDeviceMemory& imageMemory, uint32_t layerCount)
+        VkDeviceMemory& imageMemory, uint32_t layerCount, uint32_t mipLevels)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -897,7 +990,7 @@ namespace Tendou
         imageInfo.extent.width = width;
         imageInfo.extent.height = height;
         imageInfo.extent.depth = 1;
-        imageInfo.mipLevels = 1;
+        imageInfo.mipLevels = mipLevels;
         imageInfo.arrayLayers = layerCount;
         imageInfo.format = format;
         imageInfo.tiling = tiling;
@@ -929,6 +1022,7 @@ namespace Tendou
         if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate image memory!");
         }
+        allocatedBytes.fetch_add(memRequirements.size, std::memory_order_relaxed);
 
         vkBindImageMemory(device_, image, imageMemory, 0);
     }
@@ -953,12 +1047,106 @@ namespace Tendou
         if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate image memory!");
         }
+        allocatedBytes.fetch_add(memRequirements.size, std::memory_order_relaxed);
 
         if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
 
+    // Whether optimal tiling images of format can be blitted with linear filtering
+    bool TendouDevice::SupportsLinearBlit(VkFormat format)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+        return (props.optimalTilingFeatures & required) == required;
+    }
+
+    void TendouDevice::GenerateMipmaps(VkImage image, int32_t width, int32_t height,
+        uint32_t mipLevels, uint32_t layerCount)
+    {
+        VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        barrier.subresourceRange.levelCount = 1;
+
+        int32_t mipWidth = width;
+        int32_t mipHeight = height;
+
+        for (uint32_t i = 1; i < mipLevels; ++i)
+        {
+            // Previous level has just been written, read from it
+            barrier.subresourceRange.baseMipLevel = i - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+
+            int32_t nextWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+            int32_t nextHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+
+            VkImageBlit blit{};
+            blit.srcOffsets[0] = { 0, 0, 0 };
+            blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = i - 1;
+            blit.srcSubresource.baseArrayLayer = 0;
+            blit.srcSubresource.layerCount = layerCount;
+            blit.dstOffsets[0] = { 0, 0, 0 };
+            blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+            blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.dstSubresource.mipLevel = i;
+            blit.dstSubresource.baseArrayLayer = 0;
+            blit.dstSubresource.layerCount = layerCount;
+
+            vkCmdBlitImage(commandBuffer,
+                image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit, VK_FILTER_LINEAR);
+
+            // Previous level is done
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+
+            mipWidth = nextWidth;
+            mipHeight = nextHeight;
+        }
+
+        // The last level is only ever written to
+        barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        EndSingleTimeCommands(commandBuffer);
+    }
+
     // Change an image's layout. Can have its subresource range and buffer
     // specified, but new textures will typically not be using those parameters.
     // buf and range are primarily for render to texture targets
@@ -4,11 +4,15 @@
 #include "../Core/Window.h"
 
 // std lib headers
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace Tendou 
 {
+    class DescriptorLayoutCache;
+    class GeometryArena;
 
     struct SwapChainSupportDetails 
     {
@@ -70,9 +74,29 @@ namespace Tendou
         VkQueue GraphicsQueue() { return graphicsQueue_; }
         VkQueue PresentQueue() { return presentQueue_; }
 
+        // No surface, no swapchain extension - the swap chain renders into offscreen images
+        bool IsHeadless() { return window.IsHeadless(); }
+
+        // textureCompressionBC was available and is enabled
+        bool SupportsBCCompression() { return bcCompression; }
+
+        // Shared by every DescriptorSetLayout, identical bindings get the same handle
+        DescriptorLayoutCache& LayoutCache() { return *layoutCache; }
+
+        // Every Model's vertices and indices live in its two buffers
+        GeometryArena& Geometry() { return *geometryArena; }
+
+        // Descriptor indexing is enabled: partially bound, update-after-bind sampler arrays
+        bool SupportsBindless() { return bindless; }
+
+        // Render passes can broadcast draws to several layers with a view mask
+        bool SupportsMultiview() { return multiview; }
+
         SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(physicalDevice); }
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(physicalDevice); }
+        // Bytes allocated through the buffer/image helpers over the device's lifetime
+        VkDeviceSize AllocatedBytes() { return allocatedBytes.load(std::memory_order_relaxed); }
         VkFormat FindSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -96,16 +120,25 @@ namespace Tendou
         // Texture/Image Helper Functions
         VkImageView CreateImageView(VkImage image, VkFormat format, 
             uint32_t layerCount = 1, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D,
-            VkImageAspectFlagBits aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+            VkImageAspectFlagBits aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, uint32_t mipLevels = 1);
         void CreateImage(uint32_t width, uint32_t height,
             VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
             VkMemoryPropertyFlags properties, VkImage& image,
-            VkDeviceMemory& imageMemory, uint32_t layerCount = 1);
+            VkDeviceMemory& imageMemory, uint32_t layerCount = 1, uint32_t mipLevels = 1);
         void CreateImageWithInfo(
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
             VkDeviceMemory& imageMemory);
+
+        // Whether vkCmdBlitImage can filter format linearly, i.e. GenerateMipmaps works
+        bool SupportsLinearBlit(VkFormat format);
+
+        // Fills levels 1..mipLevels-1 by blitting down from level 0.
+        // Every level must be in TRANSFER_DST_OPTIMAL; all end up SHADER_READ_ONLY_OPTIMAL.
+        void GenerateMipmaps(VkImage image, int32_t width, int32_t height,
+            uint32_t mipLevels, uint32_t layerCount = 1);
+
         void TransitionImageLayout(VkImage image, VkFormat format,
             VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t layerCount = 1, 
             VkCommandBuffer buf = nullptr, VkImageSubresourceRange range = 
@@ -138,12 +171,20 @@ namespace Tendou
         VkCommandPool commandPool;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
 
+        std::atomic<VkDeviceSize> allocatedBytes{ 0 };
+        std::unique_ptr<DescriptorLayoutCache> layoutCache;
+        std::unique_ptr<GeometryArena> geometryArena;
+        bool bcCompression = false;
+        bool bindless = false;
+        bool multiview = false;
+        uint32_t apiVersion = VK_API_VERSION_1_0;
+
         const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-        const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
         friend class Application;
         friend class Editor;